@@ -361,6 +361,70 @@ namespace BinaryNinjaDebuggerAPI {
 	};
 
 
+	typedef BNDebugWatchpointType DebugWatchpointType;
+
+	struct DebugWatchpoint
+	{
+		uint64_t address;
+		size_t size;
+		DebugWatchpointType type;
+		bool software;
+	};
+
+
+	struct DebugTracepoint
+	{
+		uint64_t address;
+		std::string format;
+		uint64_t hitCount;
+	};
+
+
+	struct DebugCallTreeNode
+	{
+		uint32_t tid;
+		uint64_t function;
+		// Index of the caller node, or InvalidIndex for the outermost traced calls of the thread
+		uint32_t parent;
+		uint64_t count;
+		uint64_t inclusiveCalls;
+
+		static constexpr uint32_t InvalidIndex = 0xffffffff;
+	};
+
+
+	struct DebugSyscallRecord
+	{
+		uint32_t tid;
+		// Address of the syscall instruction
+		uint64_t address;
+		uint64_t number;
+		// Empty if the syscall is unknown to the platform of the target
+		std::string name;
+		uint64_t args[6];
+		uint64_t result;
+		// False if the syscall did not return while it was traced
+		bool returned;
+	};
+
+
+	struct DebugProfilerFunctionHits
+	{
+		uint64_t function;
+		std::string name;
+		uint64_t selfSamples;
+		uint64_t totalSamples;
+	};
+
+
+	struct DebugExprValueCacheStats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t entries;
+	};
+
+
 	struct ModuleNameAndOffset
 	{
 		std::string module;
@@ -391,6 +455,17 @@ namespace BinaryNinjaDebuggerAPI {
 
 	typedef BNDebuggerEventType DebuggerEventType;
 	typedef BNDebugStopReason DebugStopReason;
+	typedef BNDebuggerEventDelivery DebuggerEventDelivery;
+
+	// Bit n of an event mask selects the DebuggerEventType n
+	static constexpr uint64_t AllDebuggerEventsMask = ~0ULL;
+	inline uint64_t DebuggerEventMask(std::initializer_list<DebuggerEventType> types)
+	{
+		uint64_t mask = 0;
+		for (const auto type : types)
+			mask |= 1ULL << type;
+		return mask;
+	}
 
 	struct TargetStoppedEventData
 	{
@@ -470,6 +545,8 @@ namespace BinaryNinjaDebuggerAPI {
 
 		DataBuffer ReadMemory(std::uintptr_t address, std::size_t size);
 		bool WriteMemory(std::uintptr_t address, const DataBuffer& buffer);
+		// Returns 0 if the memory at the address is not a valid instruction
+		size_t GetInstructionLength(uint64_t address);
 
 		std::vector<DebugProcess> GetProcessList();
 
@@ -515,11 +592,23 @@ namespace BinaryNinjaDebuggerAPI {
 		bool RunTo(uint64_t remoteAddresses);
 		bool RunTo(const std::vector<uint64_t>& remoteAddresses);
 		void Pause();
+		// The commands above are queued behind the running one. Pause, quit and detach cancel the queued ones too.
+		size_t CancelPendingCommands();
+		size_t GetPendingCommandCount();
+		// Bounds the wait for the adapter in every operation, after which it returns OperationTimedOut. 0 means no
+		// timeout.
+		void SetOperationTimeout(uint64_t milliseconds);
+		uint64_t GetOperationTimeout();
+		// The running operation returns UserRequestedBreak
+		bool CancelOperation();
 
 		DebugStopReason GoAndWait();
 		DebugStopReason GoReverseAndWait();
 		DebugStopReason StepIntoAndWait(BNFunctionGraphType il = NormalFunctionGraph);
 		DebugStopReason StepIntoReverseAndWait(BNFunctionGraphType il = NormalFunctionGraph);
+		DebugStopReason StepIntoNAndWait(uint64_t count);
+		// maxSteps of 0 means no limit
+		DebugStopReason StepUntilAndWait(const std::string& condition, uint64_t maxSteps = 0);
 		DebugStopReason StepOverAndWait(BNFunctionGraphType il = NormalFunctionGraph);
 		DebugStopReason StepOverReverseAndWait(BNFunctionGraphType il);
 		DebugStopReason StepReturnAndWait();
@@ -553,6 +642,11 @@ namespace BinaryNinjaDebuggerAPI {
 		void SetRequestTerminalEmulator(bool requested);
 		void SetPIDAttach(int32_t pid);
 
+		// Whether a signal stops the target, or is passed to it or discarded without stopping, e.g.,
+		// "SIGUSR1=pass SIGPROF=ignore". Returns false if the policies cannot be parsed.
+		std::string GetSignalPolicies();
+		bool SetSignalPolicies(const std::string& policies);
+
 		std::vector<DebugBreakpoint> GetBreakpoints();
 		void DeleteBreakpoint(uint64_t address);
 		void DeleteBreakpoint(const ModuleNameAndOffset& breakpoint);
@@ -560,6 +654,58 @@ namespace BinaryNinjaDebuggerAPI {
 		void AddBreakpoint(const ModuleNameAndOffset& breakpoint);
 		bool ContainsBreakpoint(uint64_t address);
 		bool ContainsBreakpoint(const ModuleNameAndOffset& breakpoint);
+		bool AddWatchpoint(
+			uint64_t address, size_t size, DebugWatchpointType type = WriteWatchpoint, bool software = false);
+		bool RemoveWatchpoint(uint64_t address);
+		bool ContainsWatchpoint(uint64_t address);
+		std::vector<DebugWatchpoint> GetWatchpoints();
+		bool SetBreakpointCondition(uint64_t address, const std::string& condition);
+		bool SetBreakpointCondition(const ModuleNameAndOffset& breakpoint, const std::string& condition);
+		std::string GetBreakpointCondition(uint64_t address);
+		std::string GetBreakpointCondition(const ModuleNameAndOffset& breakpoint);
+		uint64_t GetBreakpointHitCount(uint64_t address);
+
+		bool StartCoverage(const std::vector<uint64_t>& functions, const std::vector<std::string>& modules = {});
+		void StopCoverage();
+		bool IsCoverageActive();
+		std::vector<uint64_t> GetCoverageBlocks(bool coveredOnly = false);
+		DataBuffer GetCoverageBitmap();
+		bool ExportCoverageDrcov(const std::string& path);
+
+		bool AddTracepoint(uint64_t address, const std::string& format = "");
+		bool RemoveTracepoint(uint64_t address);
+		std::vector<DebugTracepoint> GetTracepoints();
+		uint64_t GetTracepointHitCount(uint64_t address);
+		bool SetTracepointOutputFile(const std::string& path);
+		std::string GetTracepointOutputFile();
+
+		DebugStopReason TraceInstructions(uint64_t maxSteps, uint64_t stopAddress = 0, bool recordRegisters = false,
+			bool recordMemory = false);
+		std::vector<uint64_t> GetInstructionTrace();
+		uint64_t GetInstructionTraceDroppedCount();
+		bool ExportInstructionTrace(const std::string& path);
+
+		bool StartCallTrace(const std::vector<std::string>& modules = {});
+		void StopCallTrace();
+		bool IsCallTraceActive();
+		std::vector<DebugCallTreeNode> GetCallTree();
+		bool ExportCallTrace(const std::string& path);
+
+		// Traces the syscalls made by a local Linux target, from the syscall instructions in the analyzed functions and
+		// in the loaded modules, e.g., libc and ld.so. All the loaded modules are searched when none is given.
+		bool StartSyscallTrace(const std::vector<std::string>& modules = {});
+		void StopSyscallTrace();
+		bool IsSyscallTraceActive();
+		std::vector<DebugSyscallRecord> GetSyscallTrace();
+		uint64_t GetSyscallTraceDroppedCount();
+		bool ExportSyscallTrace(const std::string& path);
+
+		// The duration is in milliseconds. 0 means no limit for it or for maxSamples.
+		DebugStopReason Profile(uint32_t sampleRate, uint64_t maxSamples, uint64_t duration, size_t maxDepth = 128);
+		uint64_t GetProfilerSampleCount();
+		std::vector<DebugProfilerFunctionHits> GetProfilerFunctionHits();
+		bool ExportProfilerFoldedStacks(const std::string& path);
+		void AnnotateProfilerSamples();
 
 		uint64_t IP();
 		uint64_t GetLastIP();
@@ -569,12 +715,16 @@ namespace BinaryNinjaDebuggerAPI {
 		uint64_t RelativeAddressToAbsolute(const ModuleNameAndOffset& address);
 		ModuleNameAndOffset AbsoluteAddressToRelative(uint64_t address);
 
-		size_t RegisterEventCallback(
-			std::function<void(const DebuggerEvent& event)> callback, const std::string& name = "");
+		// The callback only receives the events selected by eventMask, see DebuggerEventMask()
+		size_t RegisterEventCallback(std::function<void(const DebuggerEvent& event)> callback,
+			const std::string& name = "", DebuggerEventDelivery delivery = SynchronousEventDelivery,
+			uint64_t eventMask = AllDebuggerEventsMask);
 		void RecordTrace();
 		static void DebuggerEventCallback(void* ctxt, BNDebuggerEvent* view);
 
 		void RemoveEventCallback(size_t index);
+		// Waits until the queued and coalesced callbacks have received all the events posted so far
+		void FlushEventCallbacks();
 
 		void WriteStdin(const std::string& msg);
 
@@ -606,6 +756,11 @@ namespace BinaryNinjaDebuggerAPI {
 		bool ComputeExprValue(const Ref<HighLevelILFunction>& func, const HighLevelILInstruction& expr,
 							  uint64_t & value);
 		bool GetVariableValue(Variable& var, uint64_t address, size_t size, uint64_t& value);
+		// The expression values are cached until the target resumes, or its registers or memory are changed
+		DebugExprValueCacheStats GetExprValueCacheStats();
+		// The number of native instructions that were interpreted locally rather than run on the target, see the
+		// debugger.interpretStraightLineCode setting
+		uint64_t GetInterpretedInstructionCount();
 	};
 
 
@@ -132,6 +132,12 @@ bool DebuggerController::WriteMemory(std::uintptr_t address, const DataBuffer& b
 	return BNDebuggerWriteMemory(m_object, address, buffer.GetBufferObject());
 }
 
+
+size_t DebuggerController::GetInstructionLength(uint64_t address)
+{
+	return BNDebuggerGetInstructionLength(m_object, address);
+}
+
 std::vector<DebugProcess> DebuggerController::GetProcessList()
 {
 	size_t count;
@@ -383,6 +389,36 @@ void DebuggerController::Pause()
 }
 
 
+size_t DebuggerController::CancelPendingCommands()
+{
+	return BNDebuggerCancelPendingCommands(m_object);
+}
+
+
+size_t DebuggerController::GetPendingCommandCount()
+{
+	return BNDebuggerGetPendingCommandCount(m_object);
+}
+
+
+void DebuggerController::SetOperationTimeout(uint64_t milliseconds)
+{
+	BNDebuggerSetOperationTimeout(m_object, milliseconds);
+}
+
+
+uint64_t DebuggerController::GetOperationTimeout()
+{
+	return BNDebuggerGetOperationTimeout(m_object);
+}
+
+
+bool DebuggerController::CancelOperation()
+{
+	return BNDebuggerCancelOperation(m_object);
+}
+
+
 // Convenience function, either launch the target process or connect to a remote, depending on the selected adapter
 void DebuggerController::LaunchOrConnect()
 {
@@ -463,6 +499,18 @@ DebugStopReason DebuggerController::StepIntoReverseAndWait(BNFunctionGraphType i
 }
 
 
+DebugStopReason DebuggerController::StepIntoNAndWait(uint64_t count)
+{
+	return BNDebuggerStepIntoNAndWait(m_object, count);
+}
+
+
+DebugStopReason DebuggerController::StepUntilAndWait(const std::string& condition, uint64_t maxSteps)
+{
+	return BNDebuggerStepUntilAndWait(m_object, condition.c_str(), maxSteps);
+}
+
+
 DebugStopReason DebuggerController::StepOverAndWait(BNFunctionGraphType il)
 {
 	return BNDebuggerStepOverAndWait(m_object, il);
@@ -643,6 +691,24 @@ void DebuggerController::SetCommandLineArguments(const std::string& arguments)
 }
 
 
+std::string DebuggerController::GetSignalPolicies()
+{
+	char* policies = BNDebuggerGetSignalPolicies(m_object);
+	if (!policies)
+		return "";
+
+	std::string result = policies;
+	BNDebuggerFreeString(policies);
+	return result;
+}
+
+
+bool DebuggerController::SetSignalPolicies(const std::string& policies)
+{
+	return BNDebuggerSetSignalPolicies(m_object, policies.c_str());
+}
+
+
 void DebuggerController::SetRemoteHost(const std::string& host)
 {
 	BNDebuggerSetRemoteHost(m_object, host.c_str());
@@ -726,6 +792,370 @@ bool DebuggerController::ContainsBreakpoint(const ModuleNameAndOffset& breakpoin
 }
 
 
+bool DebuggerController::AddWatchpoint(uint64_t address, size_t size, DebugWatchpointType type, bool software)
+{
+	return BNDebuggerAddWatchpoint(m_object, address, size, type, software);
+}
+
+
+bool DebuggerController::RemoveWatchpoint(uint64_t address)
+{
+	return BNDebuggerRemoveWatchpoint(m_object, address);
+}
+
+
+bool DebuggerController::ContainsWatchpoint(uint64_t address)
+{
+	return BNDebuggerContainsWatchpoint(m_object, address);
+}
+
+
+std::vector<DebugWatchpoint> DebuggerController::GetWatchpoints()
+{
+	size_t count;
+	BNDebugWatchpoint* watchpoints = BNDebuggerGetWatchpoints(m_object, &count);
+
+	std::vector<DebugWatchpoint> result;
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		DebugWatchpoint watchpoint;
+		watchpoint.address = watchpoints[i].address;
+		watchpoint.size = watchpoints[i].size;
+		watchpoint.type = watchpoints[i].type;
+		watchpoint.software = watchpoints[i].software;
+		result.push_back(watchpoint);
+	}
+
+	BNDebuggerFreeWatchpoints(watchpoints);
+	return result;
+}
+
+
+bool DebuggerController::SetBreakpointCondition(uint64_t address, const std::string& condition)
+{
+	return BNDebuggerSetAbsoluteBreakpointCondition(m_object, address, condition.c_str());
+}
+
+
+bool DebuggerController::SetBreakpointCondition(const ModuleNameAndOffset& breakpoint, const std::string& condition)
+{
+	return BNDebuggerSetRelativeBreakpointCondition(
+		m_object, breakpoint.module.c_str(), breakpoint.offset, condition.c_str());
+}
+
+
+std::string DebuggerController::GetBreakpointCondition(uint64_t address)
+{
+	char* condition = BNDebuggerGetAbsoluteBreakpointCondition(m_object, address);
+	std::string result = condition;
+	BNDebuggerFreeString(condition);
+	return result;
+}
+
+
+std::string DebuggerController::GetBreakpointCondition(const ModuleNameAndOffset& breakpoint)
+{
+	char* condition = BNDebuggerGetRelativeBreakpointCondition(m_object, breakpoint.module.c_str(), breakpoint.offset);
+	std::string result = condition;
+	BNDebuggerFreeString(condition);
+	return result;
+}
+
+
+uint64_t DebuggerController::GetBreakpointHitCount(uint64_t address)
+{
+	return BNDebuggerGetBreakpointHitCount(m_object, address);
+}
+
+
+bool DebuggerController::StartCoverage(const std::vector<uint64_t>& functions, const std::vector<std::string>& modules)
+{
+	std::vector<const char*> moduleList;
+	moduleList.reserve(modules.size());
+	for (const auto& module : modules)
+		moduleList.push_back(module.c_str());
+
+	return BNDebuggerStartCoverage(m_object, functions.data(), functions.size(), moduleList.data(), moduleList.size());
+}
+
+
+void DebuggerController::StopCoverage()
+{
+	BNDebuggerStopCoverage(m_object);
+}
+
+
+bool DebuggerController::IsCoverageActive()
+{
+	return BNDebuggerIsCoverageActive(m_object);
+}
+
+
+std::vector<uint64_t> DebuggerController::GetCoverageBlocks(bool coveredOnly)
+{
+	size_t count;
+	uint64_t* blocks = BNDebuggerGetCoverageBlocks(m_object, coveredOnly, &count);
+	std::vector<uint64_t> result(blocks, blocks + count);
+	BNDebuggerFreeCoverageBlocks(blocks);
+	return result;
+}
+
+
+DataBuffer DebuggerController::GetCoverageBitmap()
+{
+	return DataBuffer(BNDebuggerGetCoverageBitmap(m_object));
+}
+
+
+bool DebuggerController::ExportCoverageDrcov(const std::string& path)
+{
+	return BNDebuggerExportCoverageDrcov(m_object, path.c_str());
+}
+
+
+bool DebuggerController::AddTracepoint(uint64_t address, const std::string& format)
+{
+	return BNDebuggerAddTracepoint(m_object, address, format.c_str());
+}
+
+
+bool DebuggerController::RemoveTracepoint(uint64_t address)
+{
+	return BNDebuggerRemoveTracepoint(m_object, address);
+}
+
+
+std::vector<DebugTracepoint> DebuggerController::GetTracepoints()
+{
+	size_t count;
+	BNDebugTracepoint* tracepoints = BNDebuggerGetTracepoints(m_object, &count);
+
+	std::vector<DebugTracepoint> result;
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		DebugTracepoint tracepoint;
+		tracepoint.address = tracepoints[i].address;
+		tracepoint.format = tracepoints[i].format;
+		tracepoint.hitCount = tracepoints[i].hitCount;
+		result.push_back(tracepoint);
+	}
+
+	BNDebuggerFreeTracepoints(tracepoints, count);
+	return result;
+}
+
+
+uint64_t DebuggerController::GetTracepointHitCount(uint64_t address)
+{
+	return BNDebuggerGetTracepointHitCount(m_object, address);
+}
+
+
+bool DebuggerController::SetTracepointOutputFile(const std::string& path)
+{
+	return BNDebuggerSetTracepointOutputFile(m_object, path.c_str());
+}
+
+
+std::string DebuggerController::GetTracepointOutputFile()
+{
+	char* path = BNDebuggerGetTracepointOutputFile(m_object);
+	std::string result = path;
+	BNDebuggerFreeString(path);
+	return result;
+}
+
+
+DebugStopReason DebuggerController::TraceInstructions(
+	uint64_t maxSteps, uint64_t stopAddress, bool recordRegisters, bool recordMemory)
+{
+	return BNDebuggerTraceInstructions(m_object, maxSteps, stopAddress, recordRegisters, recordMemory);
+}
+
+
+std::vector<uint64_t> DebuggerController::GetInstructionTrace()
+{
+	size_t count;
+	uint64_t* addresses = BNDebuggerGetInstructionTrace(m_object, &count);
+	std::vector<uint64_t> result(addresses, addresses + count);
+	BNDebuggerFreeInstructionTrace(addresses);
+	return result;
+}
+
+
+uint64_t DebuggerController::GetInstructionTraceDroppedCount()
+{
+	return BNDebuggerGetInstructionTraceDroppedCount(m_object);
+}
+
+
+bool DebuggerController::ExportInstructionTrace(const std::string& path)
+{
+	return BNDebuggerExportInstructionTrace(m_object, path.c_str());
+}
+
+
+bool DebuggerController::StartCallTrace(const std::vector<std::string>& modules)
+{
+	std::vector<const char*> moduleList;
+	moduleList.reserve(modules.size());
+	for (const auto& module : modules)
+		moduleList.push_back(module.c_str());
+
+	return BNDebuggerStartCallTrace(m_object, moduleList.data(), moduleList.size());
+}
+
+
+void DebuggerController::StopCallTrace()
+{
+	BNDebuggerStopCallTrace(m_object);
+}
+
+
+bool DebuggerController::IsCallTraceActive()
+{
+	return BNDebuggerIsCallTraceActive(m_object);
+}
+
+
+std::vector<DebugCallTreeNode> DebuggerController::GetCallTree()
+{
+	size_t count;
+	BNDebugCallTreeNode* nodes = BNDebuggerGetCallTree(m_object, &count);
+
+	std::vector<DebugCallTreeNode> result;
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		DebugCallTreeNode node;
+		node.tid = nodes[i].tid;
+		node.function = nodes[i].function;
+		node.parent = nodes[i].parent;
+		node.count = nodes[i].count;
+		node.inclusiveCalls = nodes[i].inclusiveCalls;
+		result.push_back(node);
+	}
+
+	BNDebuggerFreeCallTree(nodes);
+	return result;
+}
+
+
+bool DebuggerController::ExportCallTrace(const std::string& path)
+{
+	return BNDebuggerExportCallTrace(m_object, path.c_str());
+}
+
+
+bool DebuggerController::StartSyscallTrace(const std::vector<std::string>& modules)
+{
+	std::vector<const char*> moduleList;
+	moduleList.reserve(modules.size());
+	for (const auto& module : modules)
+		moduleList.push_back(module.c_str());
+
+	return BNDebuggerStartSyscallTrace(m_object, moduleList.data(), moduleList.size());
+}
+
+
+void DebuggerController::StopSyscallTrace()
+{
+	BNDebuggerStopSyscallTrace(m_object);
+}
+
+
+bool DebuggerController::IsSyscallTraceActive()
+{
+	return BNDebuggerIsSyscallTraceActive(m_object);
+}
+
+
+std::vector<DebugSyscallRecord> DebuggerController::GetSyscallTrace()
+{
+	size_t count;
+	BNDebugSyscallRecord* records = BNDebuggerGetSyscallTrace(m_object, &count);
+
+	std::vector<DebugSyscallRecord> result;
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		DebugSyscallRecord record;
+		record.tid = records[i].tid;
+		record.address = records[i].address;
+		record.number = records[i].number;
+		record.name = records[i].name;
+		for (size_t j = 0; j < 6; j++)
+			record.args[j] = records[i].args[j];
+		record.result = records[i].result;
+		record.returned = records[i].returned;
+		result.push_back(record);
+	}
+
+	BNDebuggerFreeSyscallTrace(records, count);
+	return result;
+}
+
+
+uint64_t DebuggerController::GetSyscallTraceDroppedCount()
+{
+	return BNDebuggerGetSyscallTraceDroppedCount(m_object);
+}
+
+
+bool DebuggerController::ExportSyscallTrace(const std::string& path)
+{
+	return BNDebuggerExportSyscallTrace(m_object, path.c_str());
+}
+
+
+DebugStopReason DebuggerController::Profile(uint32_t sampleRate, uint64_t maxSamples, uint64_t duration, size_t maxDepth)
+{
+	return BNDebuggerProfile(m_object, sampleRate, maxSamples, duration, maxDepth);
+}
+
+
+uint64_t DebuggerController::GetProfilerSampleCount()
+{
+	return BNDebuggerGetProfilerSampleCount(m_object);
+}
+
+
+std::vector<DebugProfilerFunctionHits> DebuggerController::GetProfilerFunctionHits()
+{
+	size_t count;
+	BNDebugProfilerFunctionHits* hits = BNDebuggerGetProfilerFunctionHits(m_object, &count);
+
+	std::vector<DebugProfilerFunctionHits> result;
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		DebugProfilerFunctionHits entry;
+		entry.function = hits[i].function;
+		entry.name = hits[i].name;
+		entry.selfSamples = hits[i].selfSamples;
+		entry.totalSamples = hits[i].totalSamples;
+		result.push_back(entry);
+	}
+
+	BNDebuggerFreeProfilerFunctionHits(hits, count);
+	return result;
+}
+
+
+bool DebuggerController::ExportProfilerFoldedStacks(const std::string& path)
+{
+	return BNDebuggerExportProfilerFoldedStacks(m_object, path.c_str());
+}
+
+
+void DebuggerController::AnnotateProfilerSamples()
+{
+	BNDebuggerAnnotateProfilerSamples(m_object);
+}
+
+
 uint64_t DebuggerController::RelativeAddressToAbsolute(const ModuleNameAndOffset& address)
 {
 	return BNDebuggerRelativeAddressToAbsolute(m_object, address.module.c_str(), address.offset);
@@ -767,12 +1197,13 @@ uint32_t DebuggerController::GetExitCode()
 }
 
 
-size_t DebuggerController::RegisterEventCallback(
-	std::function<void(const DebuggerEvent& event)> callback, const std::string& name)
+size_t DebuggerController::RegisterEventCallback(std::function<void(const DebuggerEvent& event)> callback,
+	const std::string& name, DebuggerEventDelivery delivery, uint64_t eventMask)
 {
 	DebuggerEventCallbackObject* object = new DebuggerEventCallbackObject;
 	object->action = callback;
-	return BNDebuggerRegisterEventCallback(GetObject(), DebuggerEventCallback, name.c_str(), object);
+	return BNDebuggerRegisterEventCallback(
+		GetObject(), DebuggerEventCallback, name.c_str(), object, delivery, eventMask);
 }
 
 
@@ -809,6 +1240,12 @@ void DebuggerController::RemoveEventCallback(size_t index)
 }
 
 
+void DebuggerController::FlushEventCallbacks()
+{
+	BNDebuggerFlushEventCallbacks(m_object);
+}
+
+
 void DebuggerController::WriteStdin(const std::string& msg)
 {
 	BNDebuggerWriteStdin(m_object, msg.c_str(), msg.length());
@@ -958,3 +1395,22 @@ bool DebuggerController::GetVariableValue(BinaryNinja::Variable &var, uint64_t a
 {
 	return BNDebuggerGetVariableValue(m_object, &var, address, size, value);
 }
+
+
+DebugExprValueCacheStats DebuggerController::GetExprValueCacheStats()
+{
+	BNDebugExprValueCacheStats stats;
+	BNDebuggerGetExprValueCacheStats(m_object, &stats);
+
+	DebugExprValueCacheStats result;
+	result.hits = stats.hits;
+	result.misses = stats.misses;
+	result.entries = stats.entries;
+	return result;
+}
+
+
+uint64_t DebuggerController::GetInterpretedInstructionCount()
+{
+	return BNDebuggerGetInterpretedInstructionCount(m_object);
+}
@@ -134,6 +134,55 @@ extern "C"
 	} BNDebugBreakpoint;
 
 
+	typedef struct BNDebugTracepoint
+	{
+		uint64_t address;
+		char* format;
+		uint64_t hitCount;
+	} BNDebugTracepoint;
+
+
+	typedef struct BNDebugCallTreeNode
+	{
+		uint32_t tid;
+		uint64_t function;
+		// Index of the caller node, or 0xffffffff for the outermost traced calls of the thread
+		uint32_t parent;
+		uint64_t count;
+		uint64_t inclusiveCalls;
+	} BNDebugCallTreeNode;
+
+
+	typedef struct BNDebugSyscallRecord
+	{
+		uint32_t tid;
+		uint64_t address;
+		uint64_t number;
+		// Empty if the syscall is unknown to the platform of the target
+		char* name;
+		uint64_t args[6];
+		uint64_t result;
+		bool returned;
+	} BNDebugSyscallRecord;
+
+
+	typedef struct BNDebugProfilerFunctionHits
+	{
+		uint64_t function;
+		char* name;
+		uint64_t selfSamples;
+		uint64_t totalSamples;
+	} BNDebugProfilerFunctionHits;
+
+
+	typedef struct BNDebugExprValueCacheStats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t entries;
+	} BNDebugExprValueCacheStats;
+
+
 	typedef struct BNModuleNameAndOffset
 	{
 		char* module;
@@ -196,10 +245,32 @@ extern "C"
 
 		UserRequestedBreak,
 
-		OperationNotSupported
+		OperationNotSupported,
+
+		Watchpoint,
+
+		// The operation did not finish within the operation timeout of the controller
+		OperationTimedOut
 	} BNDebugStopReason;
 
 
+	typedef enum BNDebugWatchpointType
+	{
+		ReadWatchpoint = 1,
+		WriteWatchpoint = 2,
+		AccessWatchpoint = 3
+	} BNDebugWatchpointType;
+
+
+	typedef struct BNDebugWatchpoint
+	{
+		uint64_t address;
+		size_t size;
+		BNDebugWatchpointType type;
+		bool software;
+	} BNDebugWatchpoint;
+
+
 	typedef enum BNDebugAdapterConnectionStatus
 	{
 		DebugAdapterNotConnectedStatus,
@@ -267,6 +338,18 @@ extern "C"
 	} BNDebuggerEventType;
 
 
+	typedef enum BNDebuggerEventDelivery
+	{
+		// Called before the event is posted, in the order of registration. When the UI is enabled, the callbacks are
+		// called on the main thread.
+		SynchronousEventDelivery,
+		// Called on the event dispatcher thread with every event, in order
+		QueuedEventDelivery,
+		// Like QueuedEventDelivery, except that consecutive events which carry no new information are merged
+		CoalescedEventDelivery,
+	} BNDebuggerEventDelivery;
+
+
 	typedef struct BNTargetStoppedEventData
 	{
 		BNDebugStopReason reason;
@@ -314,23 +397,24 @@ extern "C"
 		BNDebuggerEventData data;
 	} BNDebuggerEvent;
 
-    typedef enum BNDebuggerAdapterOperation
-    {
+	typedef enum BNDebuggerAdapterOperation
+	{
 		DebugAdapterLaunch,
 		DebugAdapterAttach,
 		DebugAdapterConnect,
-        DebugAdapterGo,
-        DebugAdapterStepInto,
-        DebugAdapterStepOver,
-        DebugAdapterStepReturn,
-        DebugAdapterPause,
-        DebugAdapterQuit,
-        DebugAdapterDetach,
+		DebugAdapterGo,
+		DebugAdapterStepInto,
+		DebugAdapterStepOver,
+		DebugAdapterStepReturn,
+		DebugAdapterPause,
+		DebugAdapterQuit,
+		DebugAdapterDetach,
 		DebugAdapterStepIntoReverse,
-    	DebugAdapterStepOverReverse,
-    	DebugAdapterGoReverse,
-    	DebugAdapterStepReturnReverse,
-    } BNDebuggerAdapterOperation;
+		DebugAdapterStepOverReverse,
+		DebugAdapterGoReverse,
+		DebugAdapterStepReturnReverse,
+		DebugAdapterTraceInstructions,
+	} BNDebuggerAdapterOperation;
 
 
 	DEBUGGER_FFI_API char* BNDebuggerAllocString(const char* string);
@@ -359,6 +443,8 @@ extern "C"
 		BNDebuggerController* controller, uint64_t address, size_t size);
 	DEBUGGER_FFI_API bool BNDebuggerWriteMemory(
 		BNDebuggerController* controller, uint64_t address, BNDataBuffer* buffer);
+	// Returns 0 if the memory at the address is not a valid instruction
+	DEBUGGER_FFI_API size_t BNDebuggerGetInstructionLength(BNDebuggerController* controller, uint64_t address);
 
 	DEBUGGER_FFI_API BNDebugProcess* BNDebuggerGetProcessList(BNDebuggerController* controller, size_t* count);
 	DEBUGGER_FFI_API void BNDebuggerFreeProcessList(BNDebugProcess* processes, size_t count);
@@ -413,6 +499,15 @@ extern "C"
 	DEBUGGER_FFI_API bool BNDebuggerRunTo(
 		BNDebuggerController* controller, const uint64_t* remoteAddresses, size_t count);
 	DEBUGGER_FFI_API void BNDebuggerPause(BNDebuggerController* controller);
+	// The asynchronous target control functions above queue their command behind the running one. These drop the
+	// queued commands that have not started yet, or count them.
+	DEBUGGER_FFI_API size_t BNDebuggerCancelPendingCommands(BNDebuggerController* controller);
+	DEBUGGER_FFI_API size_t BNDebuggerGetPendingCommandCount(BNDebuggerController* controller);
+	// Bounds the wait for the adapter in every operation, in milliseconds. 0 means no timeout.
+	DEBUGGER_FFI_API void BNDebuggerSetOperationTimeout(BNDebuggerController* controller, uint64_t milliseconds);
+	DEBUGGER_FFI_API uint64_t BNDebuggerGetOperationTimeout(BNDebuggerController* controller);
+	// Cancels the running command and the pending ones. Returns false if no command was running.
+	DEBUGGER_FFI_API bool BNDebuggerCancelOperation(BNDebuggerController* controller);
 
 	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerGoAndWait(BNDebuggerController* controller);
 	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerGoReverseAndWait(BNDebuggerController* controller);
@@ -420,6 +515,10 @@ extern "C"
 		BNDebuggerController* controller, BNFunctionGraphType il);
 	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerStepIntoReverseAndWait(
 		BNDebuggerController* controller, BNFunctionGraphType il);
+	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerStepIntoNAndWait(BNDebuggerController* controller, uint64_t count);
+	// A maxSteps of 0 means no limit
+	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerStepUntilAndWait(
+		BNDebuggerController* controller, const char* condition, uint64_t maxSteps);
 	
 	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerStepOverAndWait(
 		BNDebuggerController* controller, BNFunctionGraphType il);
@@ -455,6 +554,8 @@ extern "C"
 	DEBUGGER_FFI_API void BNDebuggerSetWorkingDirectory(BNDebuggerController* controller, const char* path);
 	DEBUGGER_FFI_API void BNDebuggerSetRequestTerminalEmulator(BNDebuggerController* controller, bool requestEmulator);
 	DEBUGGER_FFI_API void BNDebuggerSetCommandLineArguments(BNDebuggerController* controller, const char* args);
+	DEBUGGER_FFI_API char* BNDebuggerGetSignalPolicies(BNDebuggerController* controller);
+	DEBUGGER_FFI_API bool BNDebuggerSetSignalPolicies(BNDebuggerController* controller, const char* policies);
 
 	DEBUGGER_FFI_API BNDebugBreakpoint* BNDebuggerGetBreakpoints(BNDebuggerController* controller, size_t* count);
 	DEBUGGER_FFI_API void BNDebuggerFreeBreakpoints(BNDebugBreakpoint* breakpoints, size_t count);
@@ -468,6 +569,20 @@ extern "C"
 	DEBUGGER_FFI_API bool BNDebuggerContainsAbsoluteBreakpoint(BNDebuggerController* controller, uint64_t address);
 	DEBUGGER_FFI_API bool BNDebuggerContainsRelativeBreakpoint(
 		BNDebuggerController* controller, const char* module, uint64_t offset);
+	DEBUGGER_FFI_API bool BNDebuggerAddWatchpoint(
+		BNDebuggerController* controller, uint64_t address, size_t size, BNDebugWatchpointType type, bool software);
+	DEBUGGER_FFI_API bool BNDebuggerRemoveWatchpoint(BNDebuggerController* controller, uint64_t address);
+	DEBUGGER_FFI_API bool BNDebuggerContainsWatchpoint(BNDebuggerController* controller, uint64_t address);
+	DEBUGGER_FFI_API BNDebugWatchpoint* BNDebuggerGetWatchpoints(BNDebuggerController* controller, size_t* count);
+	DEBUGGER_FFI_API void BNDebuggerFreeWatchpoints(BNDebugWatchpoint* watchpoints);
+	DEBUGGER_FFI_API bool BNDebuggerSetAbsoluteBreakpointCondition(
+		BNDebuggerController* controller, uint64_t address, const char* condition);
+	DEBUGGER_FFI_API bool BNDebuggerSetRelativeBreakpointCondition(
+		BNDebuggerController* controller, const char* module, uint64_t offset, const char* condition);
+	DEBUGGER_FFI_API char* BNDebuggerGetAbsoluteBreakpointCondition(BNDebuggerController* controller, uint64_t address);
+	DEBUGGER_FFI_API char* BNDebuggerGetRelativeBreakpointCondition(
+		BNDebuggerController* controller, const char* module, uint64_t offset);
+	DEBUGGER_FFI_API uint64_t BNDebuggerGetBreakpointHitCount(BNDebuggerController* controller, uint64_t address);
 
 	DEBUGGER_FFI_API uint64_t BNDebuggerGetIP(BNDebuggerController* controller);
 	DEBUGGER_FFI_API uint64_t BNDebuggerGetLastIP(BNDebuggerController* controller);
@@ -500,6 +615,63 @@ extern "C"
 
 	DEBUGGER_FFI_API uint64_t BNDebuggerGetViewFileSegmentsStart(BNDebuggerController* controller);
 
+	// Coverage
+	DEBUGGER_FFI_API bool BNDebuggerStartCoverage(BNDebuggerController* controller, const uint64_t* functions,
+		size_t functionCount, const char** modules, size_t moduleCount);
+	DEBUGGER_FFI_API void BNDebuggerStopCoverage(BNDebuggerController* controller);
+	DEBUGGER_FFI_API bool BNDebuggerIsCoverageActive(BNDebuggerController* controller);
+	DEBUGGER_FFI_API uint64_t* BNDebuggerGetCoverageBlocks(
+		BNDebuggerController* controller, bool coveredOnly, size_t* count);
+	DEBUGGER_FFI_API void BNDebuggerFreeCoverageBlocks(uint64_t* blocks);
+	DEBUGGER_FFI_API BNDataBuffer* BNDebuggerGetCoverageBitmap(BNDebuggerController* controller);
+	DEBUGGER_FFI_API bool BNDebuggerExportCoverageDrcov(BNDebuggerController* controller, const char* path);
+
+	// Tracepoints
+	DEBUGGER_FFI_API bool BNDebuggerAddTracepoint(
+		BNDebuggerController* controller, uint64_t address, const char* format);
+	DEBUGGER_FFI_API bool BNDebuggerRemoveTracepoint(BNDebuggerController* controller, uint64_t address);
+	DEBUGGER_FFI_API BNDebugTracepoint* BNDebuggerGetTracepoints(BNDebuggerController* controller, size_t* count);
+	DEBUGGER_FFI_API void BNDebuggerFreeTracepoints(BNDebugTracepoint* tracepoints, size_t count);
+	DEBUGGER_FFI_API uint64_t BNDebuggerGetTracepointHitCount(BNDebuggerController* controller, uint64_t address);
+	DEBUGGER_FFI_API bool BNDebuggerSetTracepointOutputFile(BNDebuggerController* controller, const char* path);
+	DEBUGGER_FFI_API char* BNDebuggerGetTracepointOutputFile(BNDebuggerController* controller);
+
+	// Instruction trace. A stopAddress of 0 means the trace only ends after maxSteps steps.
+	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerTraceInstructions(BNDebuggerController* controller,
+		uint64_t maxSteps, uint64_t stopAddress, bool recordRegisters, bool recordMemory);
+	DEBUGGER_FFI_API uint64_t* BNDebuggerGetInstructionTrace(BNDebuggerController* controller, size_t* count);
+	DEBUGGER_FFI_API void BNDebuggerFreeInstructionTrace(uint64_t* addresses);
+	DEBUGGER_FFI_API uint64_t BNDebuggerGetInstructionTraceDroppedCount(BNDebuggerController* controller);
+	DEBUGGER_FFI_API bool BNDebuggerExportInstructionTrace(BNDebuggerController* controller, const char* path);
+
+	// Call trace. No modules means all the functions in the binary view are traced.
+	DEBUGGER_FFI_API bool BNDebuggerStartCallTrace(
+		BNDebuggerController* controller, const char** modules, size_t moduleCount);
+	DEBUGGER_FFI_API void BNDebuggerStopCallTrace(BNDebuggerController* controller);
+	DEBUGGER_FFI_API bool BNDebuggerIsCallTraceActive(BNDebuggerController* controller);
+	DEBUGGER_FFI_API BNDebugCallTreeNode* BNDebuggerGetCallTree(BNDebuggerController* controller, size_t* count);
+	DEBUGGER_FFI_API void BNDebuggerFreeCallTree(BNDebugCallTreeNode* nodes);
+	DEBUGGER_FFI_API bool BNDebuggerExportCallTrace(BNDebuggerController* controller, const char* path);
+
+	DEBUGGER_FFI_API bool BNDebuggerStartSyscallTrace(
+		BNDebuggerController* controller, const char** modules, size_t moduleCount);
+	DEBUGGER_FFI_API void BNDebuggerStopSyscallTrace(BNDebuggerController* controller);
+	DEBUGGER_FFI_API bool BNDebuggerIsSyscallTraceActive(BNDebuggerController* controller);
+	DEBUGGER_FFI_API BNDebugSyscallRecord* BNDebuggerGetSyscallTrace(BNDebuggerController* controller, size_t* count);
+	DEBUGGER_FFI_API void BNDebuggerFreeSyscallTrace(BNDebugSyscallRecord* records, size_t count);
+	DEBUGGER_FFI_API uint64_t BNDebuggerGetSyscallTraceDroppedCount(BNDebuggerController* controller);
+	DEBUGGER_FFI_API bool BNDebuggerExportSyscallTrace(BNDebuggerController* controller, const char* path);
+
+	// Sampling profiler. The duration is in milliseconds, and 0 means no limit for it or for maxSamples.
+	DEBUGGER_FFI_API BNDebugStopReason BNDebuggerProfile(BNDebuggerController* controller, uint32_t sampleRate,
+		uint64_t maxSamples, uint64_t duration, size_t maxDepth);
+	DEBUGGER_FFI_API uint64_t BNDebuggerGetProfilerSampleCount(BNDebuggerController* controller);
+	DEBUGGER_FFI_API BNDebugProfilerFunctionHits* BNDebuggerGetProfilerFunctionHits(
+		BNDebuggerController* controller, size_t* count);
+	DEBUGGER_FFI_API void BNDebuggerFreeProfilerFunctionHits(BNDebugProfilerFunctionHits* hits, size_t count);
+	DEBUGGER_FFI_API bool BNDebuggerExportProfilerFoldedStacks(BNDebuggerController* controller, const char* path);
+	DEBUGGER_FFI_API void BNDebuggerAnnotateProfilerSamples(BNDebuggerController* controller);
+
 	// DebugAdapterType
 	DEBUGGER_FFI_API BNDebugAdapterType* BNGetDebugAdapterTypeByName(const char* name);
 	DEBUGGER_FFI_API bool BNDebugAdapterTypeCanExecute(BNDebugAdapterType* adapter, BNBinaryView* data);
@@ -512,9 +684,15 @@ extern "C"
 
 
 	// Debugger events
+	// The event and its strings are only valid during the callback, and must be copied if they are needed later.
+	// Bit n of eventMask selects the BNDebuggerEventType n. The callback is not called for the other events, and they
+	// are not converted for it either.
 	DEBUGGER_FFI_API size_t BNDebuggerRegisterEventCallback(BNDebuggerController* controller,
-		void (*callback)(void* ctx, BNDebuggerEvent* event), const char* name, void* ctx);
+		void (*callback)(void* ctx, BNDebuggerEvent* event), const char* name, void* ctx,
+		BNDebuggerEventDelivery delivery, uint64_t eventMask);
 	DEBUGGER_FFI_API void BNDebuggerRemoveEventCallback(BNDebuggerController* controller, size_t index);
+	// Waits until the queued and coalesced callbacks have received all the events posted so far
+	DEBUGGER_FFI_API void BNDebuggerFlushEventCallbacks(BNDebuggerController* controller);
 
 	DEBUGGER_FFI_API BNMetadata* BNDebuggerGetAdapterProperty(BNDebuggerController* controller, const char* name);
 	DEBUGGER_FFI_API bool BNDebuggerSetAdapterProperty(
@@ -529,6 +707,9 @@ extern "C"
 		 BNHighLevelILFunction* function, size_t expr, uint64_t& value);
 	DEBUGGER_FFI_API bool BNDebuggerGetVariableValue(BNDebuggerController* controller,
 		BNVariable* variable, uint64_t address, size_t size, uint64_t& value);
+	DEBUGGER_FFI_API void BNDebuggerGetExprValueCacheStats(
+		BNDebuggerController* controller, BNDebugExprValueCacheStats* stats);
+	DEBUGGER_FFI_API uint64_t BNDebuggerGetInterpretedInstructionCount(BNDebuggerController* controller);
 
 #ifdef __cplusplus
 }
@@ -20,7 +20,7 @@ import binaryninja
 # import debugger
 from . import _debuggercore as dbgcore
 from .debugger_enums import *
-from typing import Callable, List, Union
+from typing import Callable, List, Optional, Union
 
 
 class DebugProcess:
@@ -258,6 +258,173 @@ class DebugBreakpoint:
         return f"<DebugBreakpoint: {self.module}:{self.offset:#x}, {self.address:#x}>"
 
 
+class DebugWatchpoint:
+    """
+    DebugWatchpoint represents a watchpoint in the target. It has the following fields:
+
+    * ``address``: the absolute address of the watched memory
+    * ``size``: the size of the watched memory, in bytes
+    * ``type``: whether the watchpoint triggers on read, write, or both (``DebugWatchpointType``)
+    * ``software``: whether the watchpoint is implemented with page protection rather than the debug registers
+
+    """
+    def __init__(self, address, size, type, software=False):
+        self.address = address
+        self.size = size
+        self.type = type
+        self.software = software
+
+    def __eq__(self, other):
+        if not isinstance(other, self.__class__):
+            return NotImplemented
+        return self.address == other.address and self.size == other.size and self.type == other.type \
+            and self.software == other.software
+
+    def __ne__(self, other):
+        if not isinstance(other, self.__class__):
+            return NotImplemented
+        return not (self == other)
+
+    def __hash__(self):
+        return hash((self.address, self.size, self.type, self.software))
+
+    def __setattr__(self, name, value):
+        try:
+            object.__setattr__(self, name, value)
+        except AttributeError:
+            raise AttributeError(f"attribute '{name}' is read only")
+
+    def __repr__(self):
+        kind = 'software' if self.software else 'hardware'
+        return f"<DebugWatchpoint: {self.address:#x}, {self.size} bytes, {self.type.name}, {kind}>"
+
+
+class DebugTracepoint:
+    """
+    DebugTracepoint represents a tracepoint in the target. It has the following fields:
+
+    * ``address``: the absolute address of the tracepoint
+    * ``format``: the log format of the tracepoint, or an empty string if it only counts hits
+    * ``hit_count``: the number of times the tracepoint is hit
+
+    """
+    def __init__(self, address, format, hit_count):
+        self.address = address
+        self.format = format
+        self.hit_count = hit_count
+
+    def __eq__(self, other):
+        if not isinstance(other, self.__class__):
+            return NotImplemented
+        return self.address == other.address and self.format == other.format and self.hit_count == other.hit_count
+
+    def __ne__(self, other):
+        if not isinstance(other, self.__class__):
+            return NotImplemented
+        return not (self == other)
+
+    def __hash__(self):
+        return hash((self.address, self.format, self.hit_count))
+
+    def __setattr__(self, name, value):
+        try:
+            object.__setattr__(self, name, value)
+        except AttributeError:
+            raise AttributeError(f"attribute '{name}' is read only")
+
+    def __repr__(self):
+        return f"<DebugTracepoint: {self.address:#x}, {self.hit_count} hits>"
+
+
+class DebugCallTreeNode:
+    """
+    DebugCallTreeNode is a node in the call tree of a thread, which aggregates the calls to a function along the same
+    call path. It has the following fields:
+
+    * ``tid``: the thread that made the calls
+    * ``function``: the absolute address of the called function
+    * ``parent``: the index of the caller node in the list of nodes, or None for the outermost traced calls
+    * ``count``: the number of calls
+    * ``inclusive_calls``: the number of traced calls made while the function is on the stack, including its own calls
+
+    """
+    def __init__(self, tid, function, parent, count, inclusive_calls):
+        self.tid = tid
+        self.function = function
+        self.parent = parent
+        self.count = count
+        self.inclusive_calls = inclusive_calls
+
+    def __repr__(self):
+        return f"<DebugCallTreeNode: tid {self.tid}, {self.function:#x}, {self.count} calls>"
+
+
+class DebugSyscallRecord:
+    """
+    DebugSyscallRecord is a syscall made by the target while syscall tracing is active. It has the following fields:
+
+    * ``tid``: the thread that made the syscall
+    * ``address``: the absolute address of the syscall instruction
+    * ``number``: the syscall number
+    * ``name``: the name of the syscall, or an empty string if it is unknown to the platform of the target
+    * ``args``: the six argument registers, whether the syscall uses them or not
+    * ``result``: the return value, or None if the syscall did not return while it was traced
+
+    """
+    def __init__(self, tid, address, number, name, args, result):
+        self.tid = tid
+        self.address = address
+        self.number = number
+        self.name = name
+        self.args = args
+        self.result = result
+
+    def __repr__(self):
+        name = self.name if self.name else f'syscall_{self.number}'
+        result = '?' if self.result is None else f'{self.result:#x}'
+        return f"<DebugSyscallRecord: tid {self.tid}, {name}({', '.join(f'{arg:#x}' for arg in self.args)}) = {result}>"
+
+
+class DebugProfilerFunctionHits:
+    """
+    DebugProfilerFunctionHits is the number of stacks captured by the sampling profiler that are in a function. Every
+    sample captures the stack of every thread. It has the following fields:
+
+    * ``function``: the absolute address of the function
+    * ``name``: the name of the function
+    * ``self_samples``: the number of stacks whose innermost frame is in the function
+    * ``total_samples``: the number of stacks that have the function in any frame
+
+    """
+    def __init__(self, function, name, self_samples, total_samples):
+        self.function = function
+        self.name = name
+        self.self_samples = self_samples
+        self.total_samples = total_samples
+
+    def __repr__(self):
+        return f"<DebugProfilerFunctionHits: {self.name}, {self.self_samples} self, {self.total_samples} total>"
+
+
+class DebugExprValueCacheStats:
+    """
+    DebugExprValueCacheStats describes the cache of the IL expression values computed by the debugger. The values are
+    cached until the target resumes, or its registers or memory are changed. It has the following fields:
+
+    * ``hits``: the number of values found in the cache
+    * ``misses``: the number of values that had to be computed
+    * ``entries``: the number of values currently in the cache
+
+    """
+    def __init__(self, hits, misses, entries):
+        self.hits = hits
+        self.misses = misses
+        self.entries = entries
+
+    def __repr__(self):
+        return f"<DebugExprValueCacheStats: {self.hits} hits, {self.misses} misses, {self.entries} entries>"
+
+
 class ModuleNameAndOffset:
     """
     ModuleNameAndOffset represents an address that is relative to the start of module. It is useful when ASLR is on.
@@ -456,10 +623,17 @@ class DebuggerEventWrapper:
     _debugger_events = {}
 
     @classmethod
-    def register(cls, controller: 'DebuggerController', callback: DebuggerEventCallback, name: Union[str, bytes]) -> int:
+    def register(cls, controller: 'DebuggerController', callback: DebuggerEventCallback, name: Union[str, bytes],
+                 delivery: DebuggerEventDelivery = DebuggerEventDelivery.SynchronousEventDelivery,
+                 event_types: Optional[List[DebuggerEventType]] = None) -> int:
         callback_obj = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.POINTER(dbgcore.BNDebuggerEvent))\
                                         (lambda ctxt, event: cls._notify(event[0], callback))
-        handle = dbgcore.BNDebuggerRegisterEventCallback(controller.handle, callback_obj, name, None)
+        mask = 0xffffffffffffffff
+        if event_types is not None:
+            mask = 0
+            for event_type in event_types:
+                mask |= 1 << int(event_type)
+        handle = dbgcore.BNDebuggerRegisterEventCallback(controller.handle, callback_obj, name, None, delivery, mask)
         cls._debugger_events[handle] = callback_obj
         return handle
 
@@ -618,6 +792,16 @@ class DebuggerController:
         buffer_obj = ctypes.cast(buffer.handle, ctypes.POINTER(dbgcore.BNDataBuffer))
         return dbgcore.BNDebuggerWriteMemory(self.handle, address, buffer_obj)
 
+    def get_instruction_length(self, address: int) -> int:
+        """
+        Get the length of the instruction at the address of the target. The decoded instructions are cached until the
+        memory they are decoded from changes.
+
+        :param address: address of the instruction
+        :return: the length of the instruction, or 0 if the memory at the address is not a valid instruction
+        """
+        return dbgcore.BNDebuggerGetInstructionLength(self.handle, address)
+
     @property
     def processes(self) -> List[DebugProcess]:
         """
@@ -791,10 +975,53 @@ class DebuggerController:
 
     def pause(self) -> None:
         """
-        Pause a running target
+        Pause a running target. This also cancels the pending commands, see ``cancel_pending_commands``.
         """
         dbgcore.BNDebuggerPause(self.handle)
 
+    def cancel_pending_commands(self) -> int:
+        """
+        Cancel the target control commands that are queued but have not started yet.
+
+        The asynchronous functions, e.g., ``go``, ``step_into``, and ``step_over``, queue their command behind the one
+        that is running, rather than failing while the target is busy. Consecutive step commands of the same kind are
+        merged into one that steps several times. ``pause``, ``quit``, and ``detach`` cancel the pending commands.
+
+        :return: the number of cancelled commands
+        """
+        return dbgcore.BNDebuggerCancelPendingCommands(self.handle)
+
+    @property
+    def pending_command_count(self) -> int:
+        """
+        The number of target control commands that are queued but have not started yet (read-only)
+        """
+        return dbgcore.BNDebuggerGetPendingCommandCount(self.handle)
+
+    @property
+    def operation_timeout(self) -> float:
+        """
+        The longest time, in seconds, that an operation waits for the debug adapter. When it elapses, the target is
+        broken into and the operation returns ``DebugStopReason.OperationTimedOut``. 0 means no timeout.
+
+        This bounds every call, e.g., ``go_and_wait``, ``step_over_and_wait``, and ``pause_and_wait``, which is useful
+        when driving the debugger from a script that must not hang.
+        """
+        return dbgcore.BNDebuggerGetOperationTimeout(self.handle) / 1000
+
+    @operation_timeout.setter
+    def operation_timeout(self, seconds: float) -> None:
+        dbgcore.BNDebuggerSetOperationTimeout(self.handle, int(seconds * 1000))
+
+    def cancel_operation(self) -> bool:
+        """
+        Cancel the running operation, e.g., a ``go_and_wait`` called on another thread, as well as the pending ones.
+        The target is broken into, and the running operation returns ``DebugStopReason.UserRequestedBreak``.
+
+        :return: False if no operation was running
+        """
+        return dbgcore.BNDebuggerCancelOperation(self.handle)
+
     def launch_or_connect(self) -> None:
         """
         Launch or connect to the target. Intended for internal use. Ordinary users do not need to call it.
@@ -1028,6 +1255,34 @@ class DebuggerController:
         """
         return DebugStopReason(dbgcore.BNDebuggerStepIntoAndWait(self.handle, il))
 
+    def step_into_n_and_wait(self, count: int) -> DebugStopReason:
+        """
+        Step into ``count`` instructions on the target. The steps are handled inside the debug adapter when it supports
+        it, and only the final stop is reported, so this is much faster than calling ``step_into_and_wait`` in a loop.
+
+        The stepping ends early if the target stops for another reason, e.g., a breakpoint or a signal.
+
+        The call is blocking and only returns when the target stops.
+
+        :param count: the number of instructions to step into
+        :return: the reason for the stop
+        """
+        return DebugStopReason(dbgcore.BNDebuggerStepIntoNAndWait(self.handle, count))
+
+    def step_until_and_wait(self, condition: str, max_steps: int = 0) -> DebugStopReason:
+        """
+        Step into instructions on the target until ``condition`` evaluates to non-zero. The condition is a debugger
+        expression over the registers and memory, e.g., ``$rip == 0x401000`` or ``$rax > 5 && [$rsp] == 0``. It is
+        evaluated after every step. Like ``step_into_n_and_wait``, only the final stop is reported.
+
+        The call is blocking and only returns when the target stops.
+
+        :param condition: the condition to stop at
+        :param max_steps: stop after this many instructions even if the condition does not hold, 0 means no limit
+        :return: the reason for the stop
+        """
+        return DebugStopReason(dbgcore.BNDebuggerStepUntilAndWait(self.handle, condition, max_steps))
+
 
     def step_into_reverse_and_wait(self, il: binaryninja.FunctionGraphType =
     binaryninja.FunctionGraphType.NormalFunctionGraph) -> DebugStopReason:
@@ -1320,6 +1575,28 @@ class DebuggerController:
     def cmd_line(self, arguments: Union[str, bytes]) -> None:
         dbgcore.BNDebuggerSetCommandLineArguments(self.handle, arguments)
 
+    @property
+    def signal_policies(self) -> str:
+        """
+        How the signals received by the target are handled. (read/write)
+
+        The policies are separated by spaces or commas, each in the form of ``NAME=stop|pass|ignore``, e.g.,
+        ``SIGUSR1=pass SIGPROF=ignore``. ``stop`` reports the signal as a stop, ``pass`` delivers it to the target
+        without stopping, and ``ignore`` discards it without stopping. The signals not listed keep the default behavior
+        of the adapter. The policies are handled within the adapter, so a signal that is passed or ignored does not
+        cost a round trip to the UI.
+
+        Setting invalid policies logs a warning and keeps the current ones. This is only supported by the LLDB adapter.
+
+        :getter: returns the signal policies
+        :setter: sets the signal policies
+        """
+        return dbgcore.BNDebuggerGetSignalPolicies(self.handle)
+
+    @signal_policies.setter
+    def signal_policies(self, policies: Union[str, bytes]) -> None:
+        dbgcore.BNDebuggerSetSignalPolicies(self.handle, policies)
+
     @property
     def breakpoints(self) -> List[DebugBreakpoint]:
         """
@@ -1383,6 +1660,505 @@ class DebuggerController:
         else:
             raise NotImplementedError
 
+    @property
+    def watchpoints(self) -> List[DebugWatchpoint]:
+        """
+        The list of watchpoints
+        """
+        count = ctypes.c_ulonglong()
+        watchpoints = dbgcore.BNDebuggerGetWatchpoints(self.handle, count)
+        result = []
+        for i in range(0, count.value):
+            watchpoint = DebugWatchpoint(watchpoints[i].address, watchpoints[i].size,
+                                         DebugWatchpointType(watchpoints[i].type), watchpoints[i].software)
+            result.append(watchpoint)
+
+        dbgcore.BNDebuggerFreeWatchpoints(watchpoints)
+        return result
+
+    def add_watchpoint(self, address: int, size: int = 8,
+                       type: DebugWatchpointType = DebugWatchpointType.WriteWatchpoint, software: bool = False) -> bool:
+        """
+        Add a watchpoint
+
+        The target stops with ``DebugStopReason.Watchpoint`` after it accesses the watched memory. The number of
+        hardware watchpoints is limited by the debug registers of the CPU, e.g., four on x86_64, and the address must be
+        aligned to the size. Read-only watchpoints are not supported on x86, use ``AccessWatchpoint`` instead.
+
+        Software watchpoints have no such limits, and are currently only supported on x86_64 Linux. They protect the
+        pages that contain the watched memory, so the target slows down if other data on these pages is accessed
+        frequently. Executable pages cannot be watched, and syscalls that access the protected pages fail with EFAULT.
+        So a hardware watchpoint is used instead when a debug register is free and can watch the range, i.e., the size
+        is 1, 2, 4, or 8 and the address is aligned to it. A software watchpoint can be removed while the target is
+        running, and its pages are restored when the target next stops.
+
+        The target must be paused when this is called. Watchpoints are removed when the target exits.
+
+        :param address: the absolute address of the memory to watch
+        :param size: the size of the memory to watch, which must be 1, 2, 4, or 8 for hardware watchpoints
+        :param type: whether to stop on read, write, or both
+        :param software: use page protection rather than the debug registers
+        :return: True on success, False on failure
+        """
+        return dbgcore.BNDebuggerAddWatchpoint(self.handle, address, size, type, software)
+
+    def remove_watchpoint(self, address: int) -> bool:
+        """
+        Remove the watchpoint at the absolute address
+
+        :param address: the address of the watchpoint to remove
+        :return: True if a watchpoint is removed
+        """
+        return dbgcore.BNDebuggerRemoveWatchpoint(self.handle, address)
+
+    def has_watchpoint(self, address: int) -> bool:
+        """
+        Checks whether a watchpoint exists at the absolute address
+
+        :param address: the address of the watchpoint to query
+        """
+        return dbgcore.BNDebuggerContainsWatchpoint(self.handle, address)
+
+    def set_breakpoint_condition(self, address, condition: str) -> bool:
+        """
+        Set the condition of a breakpoint
+
+        The condition is an expression over the registers and memory of the thread that hits the breakpoint, e.g.,
+        ``rdi == 0x10 && [rsp + 8].d != 0``. Registers can be prefixed with ``$``. ``[expr]`` reads a pointer-sized value
+        from memory, and ``[expr].b``, ``[expr].w``, ``[expr].d``, ``[expr].q`` read 1, 2, 4, and 8 bytes. All operators
+        of C integer arithmetic are supported, and all values are unsigned 64-bit integers.
+
+        The condition is evaluated in the debug adapter when the breakpoint is hit while the target is resumed with
+        ``go()``, or during a step over or a step return. If it evaluates to zero, the target, or the step, is resumed
+        right away without notifying the UI. If it cannot be
+        evaluated, the target stops.
+
+        The input can be either an absolute address, or a ModuleNameAndOffset, which specifies a relative address to the
+        start of a module. The latter is useful for ASLR.
+
+        :param address: the address of the breakpoint
+        :param condition: the condition, or an empty string to make the breakpoint unconditional
+        :return: False if there is no breakpoint at the address, or the condition is invalid
+        """
+        if isinstance(address, int):
+            return dbgcore.BNDebuggerSetAbsoluteBreakpointCondition(self.handle, address, condition)
+        elif isinstance(address, ModuleNameAndOffset):
+            return dbgcore.BNDebuggerSetRelativeBreakpointCondition(self.handle, address.module, address.offset,
+                                                                    condition)
+        else:
+            raise NotImplementedError
+
+    def get_breakpoint_condition(self, address) -> str:
+        """
+        Get the condition of a breakpoint, or an empty string if the breakpoint is unconditional
+
+        :param address: the address of the breakpoint, either an absolute address or a ModuleNameAndOffset
+        """
+        if isinstance(address, int):
+            return dbgcore.BNDebuggerGetAbsoluteBreakpointCondition(self.handle, address)
+        elif isinstance(address, ModuleNameAndOffset):
+            return dbgcore.BNDebuggerGetRelativeBreakpointCondition(self.handle, address.module, address.offset)
+        else:
+            raise NotImplementedError
+
+    def get_breakpoint_hit_count(self, address: int) -> int:
+        """
+        Get the number of times the breakpoint at the absolute address is hit since the target is launched
+
+        This includes the hits whose condition does not hold. Only the hits while the target is resumed with ``go()``,
+        or during a step over or a step return, are counted.
+
+        :param address: the absolute address of the breakpoint
+        """
+        return dbgcore.BNDebuggerGetBreakpointHitCount(self.handle, address)
+
+    def start_coverage(self, functions: Optional[List[int]] = None, modules: Optional[List[str]] = None) -> bool:
+        """
+        Start collecting basic block coverage
+
+        The debugger places a one-shot breakpoint on the start of every basic block of the selected functions and
+        modules. Each breakpoint is removed the first time it is hit, and the target is resumed right away without
+        notifying the UI, so the target runs at close to native speed once most blocks are covered.
+
+        The target must be paused when this is called. Coverage is collected while the target is resumed with ``go()``,
+        and during a step over or a step return.
+
+        :param functions: list of function start addresses
+        :param modules: list of module names, all functions in these modules are selected
+        :return: True on success, False on failure
+        """
+        if functions is None:
+            functions = []
+        if modules is None:
+            modules = []
+
+        func_list = (ctypes.c_uint64 * len(functions))()
+        for i in range(len(functions)):
+            func_list[i] = functions[i]
+
+        module_list = (ctypes.c_char_p * len(modules))()
+        for i in range(len(modules)):
+            module = modules[i]
+            module_list[i] = module.encode('utf-8') if isinstance(module, str) else module
+
+        return dbgcore.BNDebuggerStartCoverage(self.handle, func_list, len(functions), module_list, len(modules))
+
+    def stop_coverage(self) -> None:
+        """
+        Stop collecting coverage, and remove the breakpoints on the blocks that have not been covered.
+        The collected coverage is kept until coverage collection is started again.
+        """
+        dbgcore.BNDebuggerStopCoverage(self.handle)
+
+    @property
+    def coverage_active(self) -> bool:
+        """Whether coverage collection is active (read-only)"""
+        return dbgcore.BNDebuggerIsCoverageActive(self.handle)
+
+    def _get_coverage_blocks(self, covered_only: bool) -> List[int]:
+        count = ctypes.c_ulonglong()
+        blocks = dbgcore.BNDebuggerGetCoverageBlocks(self.handle, covered_only, count)
+        result = []
+        for i in range(0, count.value):
+            result.append(blocks[i])
+
+        dbgcore.BNDebuggerFreeCoverageBlocks(blocks)
+        return result
+
+    @property
+    def coverage_blocks(self) -> List[int]:
+        """Start addresses of all basic blocks tracked by coverage collection, sorted (read-only)"""
+        return self._get_coverage_blocks(False)
+
+    @property
+    def covered_blocks(self) -> List[int]:
+        """Start addresses of the basic blocks that have been executed, sorted (read-only)"""
+        return self._get_coverage_blocks(True)
+
+    @property
+    def coverage_bitmap(self) -> binaryninja.DataBuffer:
+        """
+        The coverage bitmap (read-only). Bit ``i`` (``bitmap[i // 8] & (1 << (i % 8))``) is set if the i-th block in
+        ``coverage_blocks`` has been executed.
+        """
+        result = dbgcore.BNDebuggerGetCoverageBitmap(self.handle)
+        buffer = ctypes.cast(result, ctypes.POINTER(binaryninja.core.BNDataBuffer))
+        return binaryninja.DataBuffer(handle=buffer)
+
+    def export_coverage_drcov(self, path: Union[str, bytes]) -> bool:
+        """
+        Export the collected coverage in the drcov format, which can be loaded by Lighthouse, bncov, etc.
+
+        :param path: path of the output file
+        :return: True on success, False on failure
+        """
+        return dbgcore.BNDebuggerExportCoverageDrcov(self.handle, path)
+
+    def add_tracepoint(self, address: int, format: str = '') -> bool:
+        """
+        Add a tracepoint at the absolute address
+
+        A tracepoint counts its hits, and optionally logs a line, and then lets the target continue right away without
+        notifying the UI. The log format is literal text with expressions in braces, e.g.,
+        ``"strlen({rdi}), first byte {[rdi].b:d}"``. The expressions use the same syntax as the breakpoint conditions
+        (see ``set_breakpoint_condition``), and are printed in hex, or in decimal with the ``:d`` suffix. Use ``{{`` and
+        ``}}`` for literal braces. The log lines are written to the debugger console, or to the file set by
+        ``tracepoint_output_file``, in batches.
+
+        Tracepoints are hit while the target is resumed with ``go()``, and during a step over or a step return, which
+        goes on to where it would end without the tracepoint.
+
+        The target must be paused when this is called. Tracepoints are removed when the target exits.
+
+        :param address: the absolute address of the tracepoint
+        :param format: the log format, or an empty string to only count the hits
+        :return: True on success, False on failure
+        """
+        return dbgcore.BNDebuggerAddTracepoint(self.handle, address, format)
+
+    def remove_tracepoint(self, address: int) -> bool:
+        """
+        Remove the tracepoint at the absolute address
+
+        :param address: the absolute address of the tracepoint
+        :return: True if a tracepoint is removed
+        """
+        return dbgcore.BNDebuggerRemoveTracepoint(self.handle, address)
+
+    @property
+    def tracepoints(self) -> List[DebugTracepoint]:
+        """
+        The list of tracepoints
+        """
+        count = ctypes.c_ulonglong()
+        tracepoints = dbgcore.BNDebuggerGetTracepoints(self.handle, count)
+        result = []
+        for i in range(0, count.value):
+            tracepoint = DebugTracepoint(tracepoints[i].address, tracepoints[i].format, tracepoints[i].hitCount)
+            result.append(tracepoint)
+
+        dbgcore.BNDebuggerFreeTracepoints(tracepoints, count.value)
+        return result
+
+    def get_tracepoint_hit_count(self, address: int) -> int:
+        """
+        Get the number of times the tracepoint at the absolute address is hit
+
+        :param address: the absolute address of the tracepoint
+        """
+        return dbgcore.BNDebuggerGetTracepointHitCount(self.handle, address)
+
+    @property
+    def tracepoint_output_file(self) -> str:
+        """
+        The file that the tracepoint logs are appended to. An empty string means the debugger console. (read/write)
+
+        :getter: returns the output file of the tracepoint logs
+        :setter: sets the output file of the tracepoint logs
+        """
+        return dbgcore.BNDebuggerGetTracepointOutputFile(self.handle)
+
+    @tracepoint_output_file.setter
+    def tracepoint_output_file(self, path: Union[str, bytes]) -> None:
+        dbgcore.BNDebuggerSetTracepointOutputFile(self.handle, path)
+
+    def trace_instructions(self, max_steps: int, stop_address: Optional[int] = None, registers: bool = False,
+                           memory: bool = False) -> DebugStopReason:
+        """
+        Single-step the target and record the executed instructions, until ``max_steps`` instructions are executed, or
+        the target reaches ``stop_address``. The steps are handled inside the debug adapter, and only the final stop is
+        reported to the UI, so this is much faster than calling ``step_into_and_wait`` in a loop.
+
+        The trace is kept in a ring buffer until the next trace starts, see ``instruction_trace`` and
+        ``export_instruction_trace``. This function blocks until the tracing ends.
+
+        :param max_steps: the maximum number of instructions to trace, 0 means no limit
+        :param stop_address: stop tracing when the target reaches this address
+        :param registers: record the registers changed by every instruction
+        :param memory: record the memory loaded or stored by every instruction
+        :return: the reason the target stops
+        """
+        if stop_address is None:
+            stop_address = 0
+        return DebugStopReason(dbgcore.BNDebuggerTraceInstructions(self.handle, max_steps, stop_address, registers,
+                                                                    memory))
+
+    @property
+    def instruction_trace(self) -> List[int]:
+        """The addresses of the instructions executed during the last instruction trace, oldest first (read-only)"""
+        count = ctypes.c_ulonglong()
+        addresses = dbgcore.BNDebuggerGetInstructionTrace(self.handle, count)
+        result = []
+        for i in range(0, count.value):
+            result.append(addresses[i])
+
+        dbgcore.BNDebuggerFreeInstructionTrace(addresses)
+        return result
+
+    @property
+    def instruction_trace_dropped_count(self) -> int:
+        """The number of the oldest records dropped because the ring buffer is full (read-only)"""
+        return dbgcore.BNDebuggerGetInstructionTraceDroppedCount(self.handle)
+
+    def export_instruction_trace(self, path: Union[str, bytes]) -> bool:
+        """
+        Export the last instruction trace, including the recorded registers and memory, to a compact binary file.
+        The file has an index of every 1024th record for random access. See ``core/debuggerinstructiontrace.h`` for
+        the format.
+
+        :param path: path of the output file
+        :return: True on success, False on failure
+        """
+        return dbgcore.BNDebuggerExportInstructionTrace(self.handle, path)
+
+    def start_call_trace(self, modules: Optional[List[str]] = None) -> bool:
+        """
+        Start tracing the calls to and the returns from the functions of the selected modules
+
+        The debugger places a breakpoint on the entry of every function, and on the return address of every call that
+        is in progress. The hits are handled inside the debug adapter, which keeps a shadow stack for every thread and
+        resumes the target right away without notifying the UI.
+
+        The target must be paused when this is called. Calls are traced while the target is resumed with ``go()``, and
+        during a step over or a step return.
+
+        :param modules: list of module names. When it is empty, all functions in the binary view are traced.
+        :return: True on success, False on failure
+        """
+        if modules is None:
+            modules = []
+
+        module_list = (ctypes.c_char_p * len(modules))()
+        for i in range(len(modules)):
+            module = modules[i]
+            module_list[i] = module.encode('utf-8') if isinstance(module, str) else module
+
+        return dbgcore.BNDebuggerStartCallTrace(self.handle, module_list, len(modules))
+
+    def stop_call_trace(self) -> None:
+        """
+        Stop tracing calls, and remove the breakpoints of the call tracer. The call tree is kept until call tracing is
+        started again.
+        """
+        dbgcore.BNDebuggerStopCallTrace(self.handle)
+
+    @property
+    def call_trace_active(self) -> bool:
+        """Whether call tracing is active (read-only)"""
+        return dbgcore.BNDebuggerIsCallTraceActive(self.handle)
+
+    @property
+    def call_tree(self) -> List[DebugCallTreeNode]:
+        """
+        The nodes of the call trees of all threads. The ``parent`` of a node is an index into this list. (read-only)
+        """
+        count = ctypes.c_ulonglong()
+        nodes = dbgcore.BNDebuggerGetCallTree(self.handle, count)
+        result = []
+        for i in range(0, count.value):
+            parent = None if nodes[i].parent == 0xffffffff else nodes[i].parent
+            result.append(DebugCallTreeNode(nodes[i].tid, nodes[i].function, parent, nodes[i].count,
+                                            nodes[i].inclusiveCalls))
+
+        dbgcore.BNDebuggerFreeCallTree(nodes)
+        return result
+
+    def export_call_trace(self, path: Union[str, bytes]) -> bool:
+        """
+        Export the call trees to a compact binary file. See ``core/debuggercalltracer.h`` for the format.
+
+        :param path: path of the output file
+        :return: True on success, False on failure
+        """
+        return dbgcore.BNDebuggerExportCallTrace(self.handle, path)
+
+    def start_syscall_trace(self, modules: Optional[List[str]] = None) -> bool:
+        """
+        Start tracing the syscalls made by a local Linux target
+
+        The debugger places a breakpoint on every syscall instruction of the selected modules, and on the instruction
+        after it. The number and the arguments are read when a thread reaches the syscall, and
+        the return value once it gets past it. The hits are handled inside the debug adapter, which resumes the target
+        right away without notifying the UI. The latest 262144 syscalls are kept.
+
+        The syscall instructions are collected from the functions analyzed in the binary view, and from the executable
+        sections of the loaded modules, e.g., libc and ld.so, which are decoded from their files. The modules are only
+        decoded on x86, x86_64 and aarch64. The modules loaded after the trace starts are not searched.
+
+        The target must be paused when this is called. Syscalls are traced while the target is resumed with ``go()``,
+        and during a step over or a step return.
+
+        :param modules: list of module names. When it is empty, all the loaded modules are searched.
+        :return: True on success, False on failure
+        """
+        if modules is None:
+            modules = []
+
+        module_list = (ctypes.c_char_p * len(modules))()
+        for i in range(len(modules)):
+            module = modules[i]
+            module_list[i] = module.encode('utf-8') if isinstance(module, str) else module
+
+        return dbgcore.BNDebuggerStartSyscallTrace(self.handle, module_list, len(modules))
+
+    def stop_syscall_trace(self) -> None:
+        """
+        Stop tracing syscalls, and remove the breakpoints of the syscall trace. The syscalls that have not returned
+        yet are recorded without a result. The records are kept until syscall tracing is started again.
+        """
+        dbgcore.BNDebuggerStopSyscallTrace(self.handle)
+
+    @property
+    def syscall_trace_active(self) -> bool:
+        """Whether syscall tracing is active (read-only)"""
+        return dbgcore.BNDebuggerIsSyscallTraceActive(self.handle)
+
+    @property
+    def syscall_trace(self) -> List[DebugSyscallRecord]:
+        """The traced syscalls, the oldest first (read-only)"""
+        count = ctypes.c_ulonglong()
+        records = dbgcore.BNDebuggerGetSyscallTrace(self.handle, count)
+        result = []
+        for i in range(0, count.value):
+            record = records[i]
+            result.append(DebugSyscallRecord(record.tid, record.address, record.number, record.name,
+                                             [record.args[j] for j in range(6)],
+                                             record.result if record.returned else None))
+
+        dbgcore.BNDebuggerFreeSyscallTrace(records, count.value)
+        return result
+
+    @property
+    def syscall_trace_dropped_count(self) -> int:
+        """The number of syscalls that are dropped because the history is full (read-only)"""
+        return dbgcore.BNDebuggerGetSyscallTraceDroppedCount(self.handle)
+
+    def export_syscall_trace(self, path: Union[str, bytes]) -> bool:
+        """
+        Export the traced syscalls as text, one line per syscall, e.g.,
+        ``[tid 1234] 0x7ffff7e8e887 write(0x1, 0x4052a0, 0xd, 0x0, 0x0, 0x0) = 0xd``
+
+        :param path: path of the output file
+        :return: True on success, False on failure
+        """
+        return dbgcore.BNDebuggerExportSyscallTrace(self.handle, path)
+
+    def profile(self, sample_rate: int = 100, duration: Optional[float] = None, max_samples: int = 0,
+                max_depth: int = 128) -> DebugStopReason:
+        """
+        Run the target under the sampling profiler. The target is interrupted ``sample_rate`` times per second, the
+        stacks of all threads are captured, and the target is resumed right away. The intermediate stops are not
+        reported to the UI.
+
+        The profiling ends after ``duration`` seconds or ``max_samples`` samples, whichever comes first, or when the
+        target stops by itself, e.g., on a breakpoint. This function blocks until the profiling ends. The samples are
+        kept until the next profiling starts, see ``profiler_function_hits`` and ``export_profile``.
+
+        :param sample_rate: the number of samples per second
+        :param duration: the maximum duration in seconds, None means no limit
+        :param max_samples: the maximum number of samples, 0 means no limit
+        :param max_depth: frames deeper than this are not captured
+        :return: the reason the target stops
+        """
+        duration_ms = 0 if duration is None else int(duration * 1000)
+        return DebugStopReason(dbgcore.BNDebuggerProfile(self.handle, sample_rate, max_samples, duration_ms,
+                                                          max_depth))
+
+    @property
+    def profiler_sample_count(self) -> int:
+        """The number of samples taken by the last profiling (read-only)"""
+        return dbgcore.BNDebuggerGetProfilerSampleCount(self.handle)
+
+    @property
+    def profiler_function_hits(self) -> List[DebugProfilerFunctionHits]:
+        """The sampled functions of the last profiling, the ones with the most self samples first (read-only)"""
+        count = ctypes.c_ulonglong()
+        hits = dbgcore.BNDebuggerGetProfilerFunctionHits(self.handle, count)
+        result = []
+        for i in range(0, count.value):
+            result.append(DebugProfilerFunctionHits(hits[i].function, hits[i].name, hits[i].selfSamples,
+                                                    hits[i].totalSamples))
+
+        dbgcore.BNDebuggerFreeProfilerFunctionHits(hits, count.value)
+        return result
+
+    def export_profile(self, path: Union[str, bytes]) -> bool:
+        """
+        Export the samples of the last profiling as folded stacks, i.e., one ``outer;...;inner count`` line per
+        distinct stack. The file can be turned into a flame graph with ``flamegraph.pl``, or loaded into speedscope.
+
+        :param path: path of the output file
+        :return: True on success, False on failure
+        """
+        return dbgcore.BNDebuggerExportProfilerFoldedStacks(self.handle, path)
+
+    def annotate_profile(self) -> None:
+        """
+        Tag every function sampled by the last profiling with its sample counts, replacing the tags of the previous
+        profiling
+        """
+        dbgcore.BNDebuggerAnnotateProfilerSamples(self.handle)
+
     @property
     def ip(self) -> int:
         """
@@ -1428,17 +2204,30 @@ class DebuggerController:
         """
         return dbgcore.BNDebuggerGetExitCode(self.handle)
 
-    def register_event_callback(self, callback: DebuggerEventCallback, name: Union[str, bytes] = '') -> int:
+    def register_event_callback(self, callback: DebuggerEventCallback, name: Union[str, bytes] = '',
+                                delivery: DebuggerEventDelivery = DebuggerEventDelivery.SynchronousEventDelivery,
+                                event_types: Optional[List[DebuggerEventType]] = None) -> int:
         """
         Register a debugger event callback to receive notification when various events happen.
 
         The callback receives DebuggerEvent object that contains the type of the event and associated data.
 
+        By default, the callback is called before the event is posted, on the main thread when the UI is enabled. A
+        ``QueuedEventDelivery`` callback is called on the event dispatcher thread instead, so the debugger does not wait
+        for it. A ``CoalescedEventDelivery`` callback is also called on that thread, but consecutive events that carry
+        no new information are merged, e.g., the stdout messages are concatenated. Use ``flush_event_callbacks()`` to
+        wait for these callbacks to catch up.
+
+        A callback that only handles a few types of events should list them in ``event_types``. The other events are
+        then skipped before they are converted for the callback, which is much cheaper than ignoring them in Python.
+
         :param callback: the callback to register
         :param name: name of the callback
+        :param delivery: how the events are delivered to the callback
+        :param event_types: the types of the events to receive, or None for all events
         :return: an integer handle to the registered event callback
         """
-        return DebuggerEventWrapper.register(self, callback, name)
+        return DebuggerEventWrapper.register(self, callback, name, delivery, event_types)
 
     def remove_event_callback(self, index: int):
         """
@@ -1446,6 +2235,12 @@ class DebuggerController:
         """
         DebuggerEventWrapper.remove(self, index)
 
+    def flush_event_callbacks(self) -> None:
+        """
+        Wait until the queued and coalesced event callbacks have received all the events posted so far
+        """
+        dbgcore.BNDebuggerFlushEventCallbacks(self.handle)
+
     def frames_of_thread(self, tid: int) -> List[DebugFrame]:
         """
         Get the stack frames of the thread specified by ``tid``
@@ -1516,6 +2311,47 @@ class DebuggerController:
     def get_addr_info(self, addr: int):
         return dbgcore.BNDebuggerGetAddressInformation(self.handle, addr)
 
+    def compute_expr_value(self, expr: Union[binaryninja.LowLevelILInstruction, binaryninja.MediumLevelILInstruction,
+                                             binaryninja.HighLevelILInstruction]) -> Optional[int]:
+        """
+        Compute the value of an IL expression using the current registers and memory of the target. This is what the
+        debugger info widget shows for the operands of the instructions.
+
+        :param expr: the LLIL, MLIL or HLIL expression
+        :return: the value, or None if it cannot be computed
+        """
+        value = ctypes.c_ulonglong()
+        if isinstance(expr, binaryninja.LowLevelILInstruction):
+            func = ctypes.cast(expr.function.handle, ctypes.POINTER(dbgcore.BNLowLevelILFunction))
+            ok = dbgcore.BNDebuggerComputeLLILExprValue(self.handle, func, expr.expr_index, value)
+        elif isinstance(expr, binaryninja.MediumLevelILInstruction):
+            func = ctypes.cast(expr.function.handle, ctypes.POINTER(dbgcore.BNMediumLevelILFunction))
+            ok = dbgcore.BNDebuggerComputeMLILExprValue(self.handle, func, expr.expr_index, value)
+        elif isinstance(expr, binaryninja.HighLevelILInstruction):
+            func = ctypes.cast(expr.function.handle, ctypes.POINTER(dbgcore.BNHighLevelILFunction))
+            ok = dbgcore.BNDebuggerComputeHLILExprValue(self.handle, func, expr.expr_index, value)
+        else:
+            return None
+
+        if not ok:
+            return None
+        return value.value
+
+    @property
+    def expr_value_cache_stats(self) -> DebugExprValueCacheStats:
+        """The statistics of the cache of the values computed by ``compute_expr_value`` (read-only)"""
+        stats = dbgcore.BNDebugExprValueCacheStats()
+        dbgcore.BNDebuggerGetExprValueCacheStats(self.handle, stats)
+        return DebugExprValueCacheStats(stats.hits, stats.misses, stats.entries)
+
+    @property
+    def interpreted_instruction_count(self) -> int:
+        """
+        The number of native instructions that were interpreted locally rather than run on the target, see the
+        ``debugger.interpretStraightLineCode`` setting (read-only)
+        """
+        return dbgcore.BNDebuggerGetInterpretedInstructionCount(self.handle)
+
     @property
     def is_first_launch(self):
         return dbgcore.BNDebuggerIsFirstLaunch(self.handle)
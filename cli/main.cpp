@@ -143,11 +143,17 @@ void DisasmDisplay(DbgRef<DebuggerController> debugger, const std::uint32_t coun
 		if (!architecture)
 			return;
 
-		const auto data = debugger->ReadMemory(instruction_offset, 16);
+		size_t size = debugger->GetInstructionLength(instruction_offset);
+		if (size == 0)
+		{
+			printf("failed to disassemble\n");
+			return;
+		}
+
+		const auto data = debugger->ReadMemory(instruction_offset, size);
 		if (data.GetLength() == 0)
 			return;
 
-		size_t size = data.GetLength();
 		std::vector<InstructionTextToken> instruction_tokens {};
 		if (!architecture->GetInstructionText(
 				(const uint8_t*)data.GetData(), instruction_offset, size, instruction_tokens))
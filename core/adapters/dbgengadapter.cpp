@@ -417,8 +417,8 @@ bool DbgEngAdapter::ExecuteWithArgsInternal(const std::string& path, const std::
 		this->Reset();
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.error = fmt::format("Failed to initialize DbgEng");
-		event.data.errorData.shortError = fmt::format("Failed to initialize DbgEng");
+		event.data.setErrorData().error = fmt::format("Failed to initialize DbgEng");
+		event.data.setErrorData().shortError = fmt::format("Failed to initialize DbgEng");
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -428,8 +428,8 @@ bool DbgEngAdapter::ExecuteWithArgsInternal(const std::string& path, const std::
 		this->Reset();
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.error = fmt::format("Failed to engine option DEBUG_ENGOPT_INITIAL_BREAK");
-		event.data.errorData.shortError = fmt::format("Failed to engine option");
+		event.data.setErrorData().error = fmt::format("Failed to engine option DEBUG_ENGOPT_INITIAL_BREAK");
+		event.data.setErrorData().shortError = fmt::format("Failed to engine option");
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -461,8 +461,8 @@ bool DbgEngAdapter::ExecuteWithArgsInternal(const std::string& path, const std::
 		this->Reset();
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.error = fmt::format("CreateProcess2 failed: 0x{:x}", result);
-		event.data.errorData.shortError = fmt::format("CreateProcess2 failed: 0x{:x}", result);
+		event.data.setErrorData().error = fmt::format("CreateProcess2 failed: 0x{:x}", result);
+		event.data.setErrorData().shortError = fmt::format("CreateProcess2 failed: 0x{:x}", result);
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -472,8 +472,8 @@ bool DbgEngAdapter::ExecuteWithArgsInternal(const std::string& path, const std::
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.error = fmt::format("WaitForEvent failed");
-		event.data.errorData.shortError = fmt::format("WaitForEvent failed");
+		event.data.setErrorData().error = fmt::format("WaitForEvent failed");
+		event.data.setErrorData().shortError = fmt::format("WaitForEvent failed");
 		PostDebuggerEvent(event);
 	}
 
@@ -493,8 +493,8 @@ bool DbgEngAdapter::ExecuteWithArgsInternal(const std::string& path, const std::
 			this->Reset();
 			DebuggerEvent event;
 			event.type = LaunchFailureEventType;
-			event.data.errorData.error = fmt::format("Failed to resume the target after the system entry point");
-			event.data.errorData.shortError = fmt::format("Failed to resume target");
+			event.data.setErrorData().error = fmt::format("Failed to resume the target after the system entry point");
+			event.data.setErrorData().shortError = fmt::format("Failed to resume target");
 			PostDebuggerEvent(event);
 			return false;
 		}
@@ -534,7 +534,7 @@ void DbgEngAdapter::EngineLoop()
 					}
 					DebuggerEvent event;
 					event.type = AdapterStoppedEventType;
-					event.data.targetStoppedData.reason = StopReason();
+					event.data.setTargetStoppedData().reason = StopReason();
 					PostDebuggerEvent(event);
 				}
 
@@ -576,7 +576,7 @@ void DbgEngAdapter::EngineLoop()
 				finished = true;
 				DebuggerEvent event;
 				event.type = TargetExitedEventType;
-				event.data.exitData.exitCode = ExitCode();
+				event.data.setExitData().exitCode = ExitCode();
 				PostDebuggerEvent(event);
 				Reset();
 				break;
@@ -608,8 +608,8 @@ bool DbgEngAdapter::AttachInternal(std::uint32_t pid)
 		this->Reset();
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.error = fmt::format("Failed to engine option DEBUG_ENGOPT_INITIAL_BREAK");
-		event.data.errorData.shortError = fmt::format("Failed to engine option");
+		event.data.setErrorData().error = fmt::format("Failed to engine option DEBUG_ENGOPT_INITIAL_BREAK");
+		event.data.setErrorData().shortError = fmt::format("Failed to engine option");
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -619,8 +619,8 @@ bool DbgEngAdapter::AttachInternal(std::uint32_t pid)
 		this->Reset();
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.error = fmt::format("AttachProcess failed: 0x{:x}", result);
-		event.data.errorData.shortError = fmt::format("AttachProcess failed: 0x{:x}", result);
+		event.data.setErrorData().error = fmt::format("AttachProcess failed: 0x{:x}", result);
+		event.data.setErrorData().shortError = fmt::format("AttachProcess failed: 0x{:x}", result);
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -629,8 +629,8 @@ bool DbgEngAdapter::AttachInternal(std::uint32_t pid)
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.error = fmt::format("WaitForEvent failed");
-		event.data.errorData.shortError = fmt::format("WaitForEvent failed");
+		event.data.setErrorData().error = fmt::format("WaitForEvent failed");
+		event.data.setErrorData().shortError = fmt::format("WaitForEvent failed");
 		PostDebuggerEvent(event);
 	}
 
@@ -661,8 +661,8 @@ bool DbgEngAdapter::Connect(const std::string& server, std::uint32_t port)
 {
 	DebuggerEvent event;
 	event.type = LaunchFailureEventType;
-	event.data.errorData.error = fmt::format("Connect() is not implemented in DbgEng");
-	event.data.errorData.shortError = fmt::format("Connect() is not implemented in DbgEng");
+	event.data.setErrorData().error = fmt::format("Connect() is not implemented in DbgEng");
+	event.data.setErrorData().shortError = fmt::format("Connect() is not implemented in DbgEng");
 	PostDebuggerEvent(event);
 	return false;
 }
@@ -1452,7 +1452,7 @@ HRESULT DbgEngOutputCallbacks::Output(unsigned long mask, const char* text)
 {
 	DebuggerEvent event;
 	event.type = BackendMessageEventType;
-	event.data.messageData.message = text;
+	event.data.setMessageData().message = text;
 	m_adapter->PostDebuggerEvent(event);
 	m_output += text;
 	return S_OK;
@@ -23,8 +23,8 @@ bool DbgEngTTDAdapter::ExecuteWithArgsInternal(const std::string& path, const st
         this->Reset();
         DebuggerEvent event;
         event.type = LaunchFailureEventType;
-        event.data.errorData.error = fmt::format("Failed to initialize DbgEng");
-        event.data.errorData.shortError = fmt::format("Failed to initialize DbgEng");
+        event.data.setErrorData().error = fmt::format("Failed to initialize DbgEng");
+        event.data.setErrorData().shortError = fmt::format("Failed to initialize DbgEng");
         PostDebuggerEvent(event);
         return false;
     }
@@ -33,8 +33,8 @@ bool DbgEngTTDAdapter::ExecuteWithArgsInternal(const std::string& path, const st
         this->Reset();
         DebuggerEvent event;
         event.type = LaunchFailureEventType;
-        event.data.errorData.error = fmt::format("Failed to engine option DEBUG_ENGOPT_INITIAL_BREAK");
-        event.data.errorData.shortError = fmt::format("Failed to engine option");
+        event.data.setErrorData().error = fmt::format("Failed to engine option DEBUG_ENGOPT_INITIAL_BREAK");
+        event.data.setErrorData().shortError = fmt::format("Failed to engine option");
         PostDebuggerEvent(event);
         return false;
     }
@@ -44,8 +44,8 @@ bool DbgEngTTDAdapter::ExecuteWithArgsInternal(const std::string& path, const st
         this->Reset();
         DebuggerEvent event;
         event.type = LaunchFailureEventType;
-        event.data.errorData.error = fmt::format("OpenDumpFile failed: 0x{:x}", result);
-        event.data.errorData.shortError = fmt::format("OpenDumpFile failed: 0x{:x}", result);
+        event.data.setErrorData().error = fmt::format("OpenDumpFile failed: 0x{:x}", result);
+        event.data.setErrorData().shortError = fmt::format("OpenDumpFile failed: 0x{:x}", result);
         PostDebuggerEvent(event);
         return false;
     }
@@ -54,8 +54,8 @@ bool DbgEngTTDAdapter::ExecuteWithArgsInternal(const std::string& path, const st
     if (!Wait()) {
         DebuggerEvent event;
         event.type = LaunchFailureEventType;
-        event.data.errorData.error = fmt::format("WaitForEvent failed");
-        event.data.errorData.shortError = fmt::format("WaitForEvent failed");
+        event.data.setErrorData().error = fmt::format("WaitForEvent failed");
+        event.data.setErrorData().shortError = fmt::format("WaitForEvent failed");
         PostDebuggerEvent(event);
     }
 
@@ -74,8 +74,8 @@ bool DbgEngTTDAdapter::ExecuteWithArgsInternal(const std::string& path, const st
             this->Reset();
             DebuggerEvent event;
             event.type = LaunchFailureEventType;
-            event.data.errorData.error = fmt::format("Failed to resume the target after the system entry point");
-            event.data.errorData.shortError = fmt::format("Failed to resume target");
+            event.data.setErrorData().error = fmt::format("Failed to resume the target after the system entry point");
+            event.data.setErrorData().shortError = fmt::format("Failed to resume target");
             PostDebuggerEvent(event);
             return false;
         }
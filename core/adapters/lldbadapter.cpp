@@ -191,8 +191,8 @@ bool LldbAdapter::ExecuteWithArgs(const std::string& path, const std::string& ar
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.shortError = "LLDB failed to create target.";
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = "LLDB failed to create target.";
+		event.data.setErrorData().error =
 			fmt::format("LLDB Failed to create target with \"{}\"", err.GetCString() ? err.GetCString() : "");
 		PostDebuggerEvent(event);
 		return false;
@@ -233,7 +233,7 @@ bool LldbAdapter::ExecuteWithArgs(const std::string& path, const std::string& ar
 	auto result = InvokeBackendCommand(launchCommand);
 	DebuggerEvent evt;
 	evt.type = BackendMessageEventType;
-	evt.data.messageData.message = result;
+	evt.data.setMessageData().message = result;
 	PostDebuggerEvent(evt);
 
 	m_process = m_target.GetProcess();
@@ -243,11 +243,13 @@ bool LldbAdapter::ExecuteWithArgs(const std::string& path, const std::string& ar
 		result.erase(it + 1);
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.shortError = fmt::format("LLDB failed to launch target.");
-		event.data.errorData.error = fmt::format("LLDB Failed to launch target with \"{}\"", result.c_str());
+		event.data.setErrorData().shortError = fmt::format("LLDB failed to launch target.");
+		event.data.setErrorData().error = fmt::format("LLDB Failed to launch target with \"{}\"", result.c_str());
 		PostDebuggerEvent(event);
 		return false;
 	}
+
+	ApplySignalPolicies();
 	return true;
 }
 
@@ -284,8 +286,8 @@ bool LldbAdapter::Attach(std::uint32_t pid)
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.shortError = fmt::format("LLDB failed to attach to target.");
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = fmt::format("LLDB failed to attach to target.");
+		event.data.setErrorData().error =
 			fmt::format("LLDB failed to attach to target with \"{}\"", err.GetCString() ? err.GetCString() : "");
 		PostDebuggerEvent(event);
 		return false;
@@ -300,18 +302,20 @@ bool LldbAdapter::Attach(std::uint32_t pid)
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.shortError = fmt::format("LLDB failed to attach to target.");
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = fmt::format("LLDB failed to attach to target.");
+		event.data.setErrorData().error =
 			fmt::format("LLDB Failed to attach to target with \"{}\"", err.GetCString() ? err.GetCString() : "");
 		PostDebuggerEvent(event);
 		return false;
 	}
 
+	ApplySignalPolicies();
+
 	// LLDB event listener does not get an event when the attach operation completes, so we must send an event here.
 	// This is NOT needed for Connect(), since LLDB event listener sends an event in that case.
 	DebuggerEvent dbgevt;
 	dbgevt.type = AdapterStoppedEventType;
-	dbgevt.data.targetStoppedData.reason = InitialBreakpoint;
+	dbgevt.data.setTargetStoppedData().reason = InitialBreakpoint;
 	PostDebuggerEvent(dbgevt);
 	return true;
 }
@@ -349,8 +353,8 @@ bool LldbAdapter::Connect(const std::string& server, std::uint32_t port)
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.shortError = fmt::format("LLDB failed to connect to target.");
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = fmt::format("LLDB failed to connect to target.");
+		event.data.setErrorData().error =
 			fmt::format("LLDB failed to connect to target with \"{}\"", err.GetCString() ? err.GetCString() : "");
 		PostDebuggerEvent(event);
 		return false;
@@ -372,12 +376,14 @@ bool LldbAdapter::Connect(const std::string& server, std::uint32_t port)
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.shortError = fmt::format("LLDB failed to connect to target.");
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = fmt::format("LLDB failed to connect to target.");
+		event.data.setErrorData().error =
 			fmt::format("LLDB Failed to connect to target with \"{}\"", err.GetCString() ? err.GetCString() : "");
 		PostDebuggerEvent(event);
 		return false;
 	}
+
+	ApplySignalPolicies();
 	return true;
 }
 
@@ -591,6 +597,26 @@ std::vector<DebugFrame> LldbAdapter::GetFramesOfThread(uint32_t tid)
 }
 
 
+std::vector<uint64_t> LldbAdapter::GetFramePCsOfThread(uint32_t tid, size_t maxFrames)
+{
+	std::vector<uint64_t> result;
+	SBThread thread = m_process.GetThreadByID(tid);
+	if (!thread.IsValid())
+		return result;
+
+	// LLDB unwinds lazily, so GetNumFrames() is not called to avoid unwinding the whole stack. The module and
+	// symbol lookups are skipped as well.
+	for (size_t i = 0; i < maxFrames; i++)
+	{
+		SBFrame frame = thread.GetFrameAtIndex(i);
+		if (!frame.IsValid())
+			break;
+		result.push_back(frame.GetPC());
+	}
+	return result;
+}
+
+
 DebugBreakpoint LldbAdapter::AddBreakpoint(const std::uintptr_t address, unsigned long breakpoint_type)
 {
 	SBBreakpoint bp = m_target.BreakpointCreateByAddress(address);
@@ -615,7 +641,7 @@ DebugBreakpoint LldbAdapter::AddBreakpoint(const ModuleNameAndOffset& address, u
 		auto ret = InvokeBackendCommand(entryBreakpointCommand);
 		DebuggerEvent evt;
 		evt.type = BackendMessageEventType;
-		evt.data.messageData.message = ret;
+		evt.data.setMessageData().message = ret;
 		PostDebuggerEvent(evt);
 	}
 
@@ -669,6 +695,860 @@ std::vector<DebugBreakpoint> LldbAdapter::GetBreakpointList() const
 }
 
 
+bool LldbAdapter::AddInternalBreakpoints(const std::vector<std::uint64_t>& addresses)
+{
+	// Hold the lock while creating the breakpoints, so that the event listener cannot see the breakpoint added
+	// events before the IDs are recorded
+	std::unique_lock<std::mutex> lock(m_internalBreakpointsMutex);
+	bool ok = true;
+	for (const auto address: addresses)
+	{
+		if (m_internalBreakpoints.find(address) != m_internalBreakpoints.end())
+			continue;
+
+		SBBreakpoint bp = m_target.BreakpointCreateByAddress(address);
+		if (!bp.IsValid())
+		{
+			ok = false;
+			continue;
+		}
+		m_internalBreakpoints[address] = bp.GetID();
+		m_internalBreakpointIDs.insert(bp.GetID());
+	}
+	return ok;
+}
+
+
+bool LldbAdapter::RemoveInternalBreakpoint(std::uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_internalBreakpointsMutex);
+	auto it = m_internalBreakpoints.find(address);
+	if (it == m_internalBreakpoints.end())
+		return false;
+
+	bool ok = m_target.BreakpointDelete(it->second);
+	m_internalBreakpoints.erase(it);
+	return ok;
+}
+
+
+bool LldbAdapter::IsInternalBreakpointID(lldb::break_id_t id)
+{
+	std::unique_lock<std::mutex> lock(m_internalBreakpointsMutex);
+	return m_internalBreakpointIDs.find(id) != m_internalBreakpointIDs.end();
+}
+
+
+// Offer the breakpoint hits of all threads to the internal breakpoint handler and the breakpoint condition handler.
+// Returns true if the target has been resumed, in which case the stop must not be reported.
+bool LldbAdapter::HandleBreakpointStop()
+{
+	if (!m_resumedByGo && (m_stepFrameCfa == 0))
+		return false;
+
+	bool handled = false;
+	bool shouldStop = false;
+	size_t numThreads = m_process.GetNumThreads();
+	for (size_t i = 0; i < numThreads; i++)
+	{
+		SBThread thread = m_process.GetThreadAtIndex(i);
+		auto reason = thread.GetStopReason();
+		if ((reason == eStopReasonInvalid) || (reason == eStopReasonNone))
+			continue;
+
+		if (reason != eStopReasonBreakpoint)
+			return false;
+
+		// The stop reason data is a list of (breakpoint id, location id) pairs. The internal and user breakpoints can
+		// be at the same address.
+		bool hasInternal = false;
+		bool hasUser = false;
+		size_t dataCount = thread.GetStopReasonDataCount();
+		for (size_t j = 0; j < dataCount; j += 2)
+		{
+			if (IsInternalBreakpointID((lldb::break_id_t)thread.GetStopReasonDataAtIndex(j)))
+				hasInternal = true;
+			else
+				hasUser = true;
+		}
+
+		// Let the handlers read the registers of this thread
+		m_process.SetSelectedThread(thread);
+		uint32_t tid = (uint32_t)thread.GetThreadID();
+		uint64_t pc = thread.GetFrameAtIndex(0).GetPC();
+		if (hasInternal && !HandleInternalBreakpoint(tid, pc) && !hasUser)
+			return false;
+
+		if (hasUser && ShouldStopAtBreakpoint(tid, pc))
+			shouldStop = true;
+
+		handled = true;
+	}
+
+	if (!handled || shouldStop)
+		return false;
+
+	if (!m_resumedByGo)
+		return ResumeInterruptedStep();
+
+	m_silentResume = true;
+	SBError error = m_process.Continue();
+	if (!error.Success())
+	{
+		m_silentResume = false;
+		return false;
+	}
+	return true;
+}
+
+
+void LldbAdapter::SetStepFrame(uint32_t index)
+{
+	m_stepFrameCfa = 0;
+	SBThread thread = m_process.GetSelectedThread();
+	if (!thread.IsValid() || (index >= thread.GetNumFrames()))
+		return;
+
+	m_stepThreadId = thread.GetThreadID();
+	m_stepFrameCfa = thread.GetFrameAtIndex(index).GetCFA();
+}
+
+
+bool LldbAdapter::ResumeInterruptedStep()
+{
+	uint64_t cfa = m_stepFrameCfa;
+	if (cfa == 0)
+		return false;
+
+	SBThread thread = m_process.GetThreadByID(m_stepThreadId);
+	if (!thread.IsValid())
+		return false;
+
+	// The stepping thread may be deep in a callee, or another thread may have been stopped. Step out of the frame
+	// called by the one the step ends in, which also handles recursion, and stops where the original step would.
+	uint32_t count = thread.GetNumFrames();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (thread.GetFrameAtIndex(i).GetCFA() != cfa)
+			continue;
+
+		// The thread is already back in the frame, so the step is complete
+		if (i == 0)
+			return false;
+
+		SBFrame frame = thread.GetFrameAtIndex(i - 1);
+		m_process.SetSelectedThread(thread);
+		m_silentResume = true;
+		SBError error;
+		thread.StepOutOfFrame(frame, error);
+		if (!error.Success())
+		{
+			m_silentResume = false;
+			return false;
+		}
+		return true;
+	}
+
+	LogWarn("Failed to find the frame to resume the step in, the step ends here");
+	return false;
+}
+
+
+bool LldbAdapter::AddWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type)
+{
+	bool read = (type & ReadWatchpoint) != 0;
+	bool write = (type & WriteWatchpoint) != 0;
+
+	std::unique_lock<std::mutex> lock(m_watchpointsMutex);
+	if (m_watchpoints.find(address) != m_watchpoints.end())
+		return false;
+
+	SBError error;
+	SBWatchpoint watchpoint = m_target.WatchAddress(address, size, read, write, error);
+	if (!watchpoint.IsValid() || !error.Success())
+	{
+		const char* message = error.GetCString();
+		LogWarn("Failed to add a watchpoint at 0x%" PRIx64 ": %s", address, message ? message : "unknown error");
+		return false;
+	}
+
+	m_watchpoints[address] = watchpoint.GetID();
+	return true;
+}
+
+
+bool LldbAdapter::RemoveWatchpoint(std::uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_watchpointsMutex);
+	auto it = m_watchpoints.find(address);
+	if (it == m_watchpoints.end())
+		return false;
+
+	bool ok = m_target.DeleteWatchpoint(it->second);
+	m_watchpoints.erase(it);
+	return ok;
+}
+
+
+static bool ThreadHasValidStopReason(SBThread thread)
+{
+	if (!thread.IsValid())
+		return false;
+
+	auto reason = thread.GetStopReason();
+	if ((reason == eStopReasonInvalid) || (reason == eStopReasonNone) || (reason == eStopReasonThreadExiting))
+		return false;
+
+	return true;
+}
+
+
+// Linux definitions, so that this also builds on other platforms
+static constexpr uint64_t LinuxPageSize = 0x1000;
+static constexpr uint64_t LinuxSigsegv = 11;
+static constexpr uint64_t LinuxSyscallMprotect = 10;
+static constexpr uint32_t LinuxProtRead = 1;
+static constexpr uint32_t LinuxProtWrite = 2;
+
+
+bool LldbAdapter::SupportsSoftwareWatchpoints()
+{
+	std::string triple = m_target.GetTriple();
+	return (triple.find("x86_64") != std::string::npos) && (triple.find("linux") != std::string::npos);
+}
+
+
+// Run a syscall in the context of the thread, which must be stopped. The registers and the code at the current pc are
+// restored afterwards. The step is not reported to the controller.
+bool LldbAdapter::InjectSyscall(SBThread& thread, uint64_t number, const std::vector<uint64_t>& args, uint64_t& result)
+{
+	static const char* argumentRegisters[] = {"rdi", "rsi", "rdx", "r10", "r8", "r9"};
+	// The syscall instruction also clobbers rcx and r11. orig_rax tells the kernel which syscall to restart if the
+	// thread was stopped while in one, so it must be restored as well.
+	static const char* savedRegisters[] = {"rax", "rdi", "rsi", "rdx", "r10", "r8", "r9", "rcx", "r11", "rflags"};
+	static const uint8_t syscallInstruction[] = {0x0f, 0x05};
+
+	if (args.size() > sizeof(argumentRegisters) / sizeof(argumentRegisters[0]))
+		return false;
+
+	SBFrame frame = thread.GetFrameAtIndex(0);
+	if (!frame.IsValid())
+		return false;
+
+	uint64_t pc = frame.GetPC();
+	std::vector<std::pair<SBValue, uint64_t>> saved;
+	for (const char* name : savedRegisters)
+	{
+		SBValue reg = frame.FindRegister(name);
+		if (!reg.IsValid())
+			return false;
+		saved.emplace_back(reg, reg.GetValueAsUnsigned());
+	}
+	SBValue origRax = frame.FindRegister("orig_rax");
+	if (origRax.IsValid())
+		saved.emplace_back(origRax, origRax.GetValueAsUnsigned());
+
+	SBError error;
+	uint8_t originalCode[sizeof(syscallInstruction)];
+	if (m_process.ReadMemory(pc, originalCode, sizeof(originalCode), error) != sizeof(originalCode))
+		return false;
+	if (m_process.WriteMemory(pc, syscallInstruction, sizeof(syscallInstruction), error) != sizeof(syscallInstruction))
+		return false;
+
+	auto setRegister = [&](const char* name, uint64_t value) {
+		SBError setError;
+		SBValue reg = frame.FindRegister(name);
+		return reg.IsValid() && reg.SetValueFromCString(fmt::format("{}", value).c_str(), setError);
+	};
+
+	// Like gdb does for inferior calls, clear orig_rax so that the kernel does not restart an interrupted syscall
+	// instead of running the injected one
+	bool ok = setRegister("rax", number);
+	if (origRax.IsValid())
+		ok = ok && setRegister("orig_rax", (uint64_t)-1);
+	for (size_t i = 0; i < args.size(); i++)
+		ok = ok && setRegister(argumentRegisters[i], args[i]);
+
+	if (ok)
+	{
+		ok = StepInstructionAndWait(thread);
+		frame = thread.GetFrameAtIndex(0);
+		result = frame.FindRegister("rax").GetValueAsUnsigned();
+	}
+
+	m_process.WriteMemory(pc, originalCode, sizeof(originalCode), error);
+	frame.SetPC(pc);
+	for (auto& [reg, value] : saved)
+	{
+		SBError setError;
+		reg = frame.FindRegister(reg.GetName());
+		reg.SetValueFromCString(fmt::format("{}", value).c_str(), setError);
+	}
+
+	return ok;
+}
+
+
+bool LldbAdapter::StepInstructionAndWait(SBThread& thread)
+{
+	// The controller only gets here while the target is stopped and the event thread is idle. A synchronous step
+	// hijacks the process events, so the event thread does not see them.
+	SBError error;
+	if (std::this_thread::get_id() != m_eventThreadId.load())
+	{
+		bool async = m_debugger.GetAsync();
+		m_debugger.SetAsync(false);
+		thread.StepInstruction(false, error);
+		m_debugger.SetAsync(async);
+		return error.Success();
+	}
+
+	// The event thread must not switch the debugger to synchronous mode behind the controller. It is the only reader
+	// of the listener, so it consumes the running and stopped events of the step here instead.
+	static constexpr uint32_t StepTimeoutSeconds = 10;
+	thread.StepInstruction(false, error);
+	if (!error.Success())
+		return false;
+
+	SBListener listener = m_debugger.GetListener();
+	SBEvent event;
+	while (listener.WaitForEventForBroadcasterWithType(
+		StepTimeoutSeconds, m_process.GetBroadcaster(), SBProcess::eBroadcastBitStateChanged, event))
+	{
+		StateType state = SBProcess::GetStateFromEvent(event);
+		if ((state == eStateRunning) || (state == eStateStepping) || SBProcess::GetRestartedFromEvent(event))
+			continue;
+		if (state == eStateStopped)
+			return true;
+
+		// The target exited or detached during the step. Put the event back for the event loop to report.
+		m_process.GetBroadcaster().BroadcastEvent(event);
+		return false;
+	}
+
+	LogWarn("Timed out waiting for the target to stop after a step");
+	return false;
+}
+
+
+bool LldbAdapter::ProtectPage(SBThread& thread, uint64_t page, uint32_t protection)
+{
+	uint64_t result = 0;
+	if (!InjectSyscall(thread, LinuxSyscallMprotect, {page, LinuxPageSize, protection}, result))
+		return false;
+
+	// The kernel returns -errno on failure
+	return result == 0;
+}
+
+
+bool LldbAdapter::UpdatePageProtection(uint64_t address, size_t size)
+{
+	// The protection can only be changed by running code in the target, which must be stopped for that
+	if (m_process.GetState() != lldb::eStateStopped)
+		return false;
+
+	SBThread thread = m_process.GetSelectedThread();
+	if (!thread.IsValid())
+		return false;
+
+	bool ok = true;
+	uint64_t firstPage = address & ~(LinuxPageSize - 1);
+	uint64_t lastPage = (address + size - 1) & ~(LinuxPageSize - 1);
+	for (uint64_t page = firstPage; page <= lastPage; page += LinuxPageSize)
+	{
+		// A page with a read or access watchpoint must not be accessible at all. A page with only write watchpoints
+		// is made read-only.
+		bool watched = false;
+		uint32_t removed = 0;
+		for (const auto& watchpoint : m_softwareWatchpoints)
+		{
+			if ((watchpoint.m_address >= page + LinuxPageSize) || (watchpoint.m_address + watchpoint.m_size <= page))
+				continue;
+			watched = true;
+			removed |= (watchpoint.m_type & ReadWatchpoint) ? (LinuxProtRead | LinuxProtWrite) : LinuxProtWrite;
+		}
+
+		auto it = m_protectedPages.find(page);
+		if (!watched)
+		{
+			if (it != m_protectedPages.end())
+			{
+				ok = ProtectPage(thread, page, it->second.m_originalProtection) && ok;
+				m_protectedPages.erase(it);
+			}
+			continue;
+		}
+
+		if (it == m_protectedPages.end())
+		{
+			SBMemoryRegionInfo region;
+			if (!m_process.GetMemoryRegionInfo(page, region).Success() || !region.IsMapped())
+			{
+				ok = false;
+				continue;
+			}
+
+			// Protecting a code page would make the target fault on every instruction
+			if (region.IsExecutable())
+			{
+				LogWarn("Software watchpoints are not supported on executable page 0x%" PRIx64, page);
+				ok = false;
+				continue;
+			}
+
+			uint32_t original = (region.IsReadable() ? LinuxProtRead : 0) | (region.IsWritable() ? LinuxProtWrite : 0);
+			it = m_protectedPages.emplace(page, ProtectedPage {original, original}).first;
+		}
+
+		uint32_t protection = it->second.m_originalProtection & ~removed;
+		if (protection == it->second.m_protection)
+			continue;
+
+		if (!ProtectPage(thread, page, protection))
+		{
+			LogWarn("Failed to change the protection of page 0x%" PRIx64, page);
+			ok = false;
+			continue;
+		}
+		it->second.m_protection = protection;
+	}
+
+	return ok;
+}
+
+
+bool LldbAdapter::AddSoftwareWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type)
+{
+	if (!SupportsSoftwareWatchpoints() || (size == 0))
+		return false;
+
+	std::unique_lock<std::mutex> lock(m_softwareWatchpointsMutex);
+	for (const auto& watchpoint : m_softwareWatchpoints)
+	{
+		if (watchpoint.m_address == address)
+			return false;
+	}
+
+	m_softwareWatchpoints.push_back({address, size, type});
+	if (!UpdatePageProtection(address, size))
+	{
+		m_softwareWatchpoints.pop_back();
+		UpdatePageProtection(address, size);
+		return false;
+	}
+	return true;
+}
+
+
+bool LldbAdapter::RemoveSoftwareWatchpoint(std::uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_softwareWatchpointsMutex);
+	auto it = std::find_if(m_softwareWatchpoints.begin(), m_softwareWatchpoints.end(),
+		[&](const SoftwareWatchpoint& watchpoint) { return watchpoint.m_address == address; });
+	if (it == m_softwareWatchpoints.end())
+		return false;
+
+	size_t size = it->m_size;
+	m_softwareWatchpoints.erase(it);
+	// The faults on the pages are stepped over silently until then
+	if (m_process.GetState() != lldb::eStateStopped)
+	{
+		m_pendingProtectionUpdates.emplace_back(address, size);
+		return true;
+	}
+	return UpdatePageProtection(address, size);
+}
+
+
+void LldbAdapter::ApplyPendingProtectionUpdates()
+{
+	std::unique_lock<std::mutex> lock(m_softwareWatchpointsMutex);
+	// The stop may have been restarted already
+	if (m_pendingProtectionUpdates.empty() || (m_process.GetState() != lldb::eStateStopped))
+		return;
+
+	for (const auto& [address, size] : m_pendingProtectionUpdates)
+	{
+		if (!UpdatePageProtection(address, size))
+			LogWarn("Failed to restore the protection of the pages at 0x%" PRIx64, address);
+	}
+	m_pendingProtectionUpdates.clear();
+}
+
+
+// LLDB describes the signal as "signal SIGSEGV: invalid permissions for mapped object (fault address: 0x...)"
+static bool GetFaultAddress(SBThread& thread, uint64_t& address)
+{
+	char buffer[1024];
+	thread.GetStopDescription(buffer, sizeof(buffer));
+	const std::string description(buffer), marker("fault address: ");
+	auto pos = description.find(marker);
+	if (pos == std::string::npos)
+		return false;
+
+	try
+	{
+		address = std::stoull(description.substr(pos + marker.size()), nullptr, 16);
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+	return true;
+}
+
+
+static bool IsSegmentationFault(SBThread& thread)
+{
+	return (thread.GetStopReason() == eStopReasonSignal) && (thread.GetStopReasonDataCount() > 0)
+		&& (thread.GetStopReasonDataAtIndex(0) == LinuxSigsegv);
+}
+
+
+bool LldbAdapter::HandleSoftwareWatchpointStop(bool& hit)
+{
+	hit = false;
+	std::unique_lock<std::mutex> lock(m_softwareWatchpointsMutex);
+	if (m_protectedPages.empty())
+		return false;
+
+	// The selected thread is not necessarily the one that faulted
+	SBThread thread;
+	uint64_t faultAddress = 0;
+	for (uint32_t i = 0; i < m_process.GetNumThreads(); i++)
+	{
+		SBThread candidate = m_process.GetThreadAtIndex(i);
+		if (IsSegmentationFault(candidate) && GetFaultAddress(candidate, faultAddress))
+		{
+			thread = candidate;
+			break;
+		}
+	}
+	if (!thread.IsValid())
+		return false;
+
+	// Faults on the pages that we do not protect are real crashes, and are reported as usual
+	uint64_t page = faultAddress & ~(LinuxPageSize - 1);
+	if (m_protectedPages.find(page) == m_protectedPages.end())
+		return false;
+
+	// The fault address is the start of the access, which can be up to 16 bytes for the SSE instructions, so the
+	// watchpoints near it are only candidates. Read and access watchpoints are on inaccessible pages, and are hit by
+	// any access. Write watchpoints are only hit when the value changes, whether the page is read-only or not.
+	static constexpr uint64_t MaxAccessSize = 16;
+	std::vector<std::pair<const SoftwareWatchpoint*, std::vector<uint8_t>>> writeWatchpoints;
+	auto checkWatchpoints = [&](uint64_t address) {
+		for (const auto& watchpoint : m_softwareWatchpoints)
+		{
+			if ((watchpoint.m_address >= address + MaxAccessSize)
+				|| (watchpoint.m_address + watchpoint.m_size <= address))
+				continue;
+
+			if (watchpoint.m_type & ReadWatchpoint)
+			{
+				hit = true;
+				continue;
+			}
+
+			std::vector<uint8_t> value(watchpoint.m_size);
+			SBError error;
+			m_process.ReadMemory(watchpoint.m_address, value.data(), value.size(), error);
+			writeWatchpoints.emplace_back(&watchpoint, value);
+		}
+	};
+
+	// Let the faulting instruction run with the page unprotected, and do not deliver the SIGSEGV to the target. An
+	// instruction can access more than one protected page, e.g., a movs or an unaligned access. In that case, the step
+	// faults again on the next page, which is unprotected as well before the step is retried.
+	static constexpr size_t MaxFaultingPages = 4;
+	SBUnixSignals signals = m_process.GetUnixSignals();
+	bool suppress = signals.GetShouldSuppress(LinuxSigsegv);
+	signals.SetShouldSuppress(LinuxSigsegv, true);
+
+	std::vector<uint64_t> unprotected;
+	bool ok = true, stepped = false;
+	while (ok && !stepped)
+	{
+		// A fault on a page that we do not protect is a real crash, which is reported as usual
+		auto it = m_protectedPages.find(page);
+		if (it == m_protectedPages.end())
+			break;
+
+		// Report an access that cannot be stepped over as a hit, rather than faulting forever
+		if ((unprotected.size() == MaxFaultingPages)
+			|| (std::find(unprotected.begin(), unprotected.end(), page) != unprotected.end()))
+		{
+			LogWarn("Failed to step over the access to the watched page 0x%" PRIx64, page);
+			hit = true;
+			break;
+		}
+
+		checkWatchpoints(faultAddress);
+		ok = ProtectPage(thread, page, it->second.m_originalProtection);
+		if (!ok)
+			break;
+		unprotected.push_back(page);
+
+		ok = StepInstructionAndWait(thread);
+		if (ok && IsSegmentationFault(thread) && GetFaultAddress(thread, faultAddress))
+			page = faultAddress & ~(LinuxPageSize - 1);
+		else
+			stepped = true;
+	}
+
+	for (uint64_t unprotectedPage : unprotected)
+		ok = ProtectPage(thread, unprotectedPage, m_protectedPages[unprotectedPage].m_protection) && ok;
+	signals.SetShouldSuppress(LinuxSigsegv, suppress);
+
+	if (!ok)
+	{
+		LogWarn("Failed to step over the access to the watched page 0x%" PRIx64, page);
+		return false;
+	}
+
+	for (const auto& [watchpoint, oldValue] : writeWatchpoints)
+	{
+		std::vector<uint8_t> value(watchpoint->m_size);
+		SBError error;
+		m_process.ReadMemory(watchpoint->m_address, value.data(), value.size(), error);
+		if (value != oldValue)
+			hit = true;
+	}
+
+	if (hit || !stepped)
+		m_process.SetSelectedThread(thread);
+
+	if (hit || !stepped)
+		return false;
+
+	// A step into is complete once the faulting instruction has executed, while a step over or a step return goes on
+	if (!m_resumedByGo)
+		return ResumeInterruptedStep();
+
+	m_silentResume = true;
+	SBError error = m_process.Continue();
+	if (!error.Success())
+	{
+		m_silentResume = false;
+		return false;
+	}
+	return true;
+}
+
+
+bool LldbAdapter::TraceInstructions(const InstructionTraceHandler& handler)
+{
+	if (m_process.GetState() != lldb::eStateStopped)
+		return false;
+
+	SBThread thread = m_process.GetSelectedThread();
+	if (!thread.IsValid())
+		return false;
+
+	m_resumedByGo = false;
+	m_stepFrameCfa = 0;
+	m_instructionTraceHandler = handler;
+	m_tracingInstructions = true;
+
+	SBError error;
+	thread.StepInstruction(false, error);
+	if (!error.Success())
+	{
+		m_tracingInstructions = false;
+		return false;
+	}
+	return true;
+}
+
+
+bool LldbAdapter::HandleInstructionTraceStop()
+{
+	if (!m_tracingInstructions)
+		return false;
+
+	// Anything other than a completed step, e.g., a signal, ends the trace and is reported as usual
+	SBThread thread = m_process.GetSelectedThread();
+	auto reason = thread.GetStopReason();
+	if ((reason != eStopReasonPlanComplete) && (reason != eStopReasonTrace))
+	{
+		m_tracingInstructions = false;
+		return false;
+	}
+
+	if (!m_instructionTraceHandler(thread.GetFrameAtIndex(0).GetPC()))
+	{
+		m_tracingInstructions = false;
+		return false;
+	}
+
+	m_silentResume = true;
+	SBError error;
+	thread.StepInstruction(false, error);
+	if (!error.Success())
+	{
+		m_silentResume = false;
+		m_tracingInstructions = false;
+		return false;
+	}
+	return true;
+}
+
+
+bool LldbAdapter::SetSignalPolicies(const DebugSignalPolicies& policies)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_signalPoliciesMutex);
+		m_signalPolicies = policies;
+	}
+
+	ApplySignalPolicies();
+	return true;
+}
+
+
+bool LldbAdapter::IsMemoryWritable(std::uint64_t address)
+{
+	if (!m_process.IsValid())
+		return false;
+
+	// The pages protected for the software watchpoints are reported as they are now, i.e., not writable
+	SBMemoryRegionInfo region;
+	if (!m_process.GetMemoryRegionInfo(address, region).Success())
+		return false;
+
+	return region.IsMapped() && region.IsWritable();
+}
+
+
+void LldbAdapter::ApplySignalPolicies()
+{
+	if (!m_process.IsValid())
+		return;
+
+	SBUnixSignals signals = m_process.GetUnixSignals();
+	if (!signals.IsValid())
+		return;
+
+	std::unique_lock<std::mutex> lock(m_signalPoliciesMutex);
+	for (const auto& [signal, flags] : m_originalSignalFlags)
+	{
+		signals.SetShouldStop(signal, flags.m_stop);
+		signals.SetShouldNotify(signal, flags.m_notify);
+		signals.SetShouldSuppress(signal, flags.m_suppress);
+	}
+	m_originalSignalFlags.clear();
+
+	for (const auto& [name, policy] : m_signalPolicies)
+	{
+		int32_t signal = signals.GetSignalNumberFromName(name.c_str());
+		if (signal == LLDB_INVALID_SIGNAL_NUMBER)
+		{
+			LogWarn("Unknown signal %s, its policy is ignored", name.c_str());
+			continue;
+		}
+
+		// The debugger pauses the target with SIGSTOP
+		if ((name == "SIGSTOP") || (name == "SIGKILL"))
+		{
+			LogWarn("The policy of %s cannot be changed", name.c_str());
+			continue;
+		}
+
+		m_originalSignalFlags[signal] = {signals.GetShouldStop(signal), signals.GetShouldNotify(signal),
+			signals.GetShouldSuppress(signal)};
+
+		// The software watchpoints need to see the access violations, so LLDB keeps stopping on them, and the ones
+		// that are not watchpoint hits are resumed by HandleSignalStop()
+		bool stop = (policy == SignalPolicyStop) || ((signal == LinuxSigsegv) && SupportsSoftwareWatchpoints());
+		signals.SetShouldStop(signal, stop);
+		signals.SetShouldNotify(signal, stop);
+		signals.SetShouldSuppress(signal, policy == SignalPolicyIgnore);
+	}
+}
+
+
+bool LldbAdapter::HandleSignalStop()
+{
+	if (!m_resumedByGo)
+		return false;
+
+	SBUnixSignals signals = m_process.GetUnixSignals();
+	if (!signals.IsValid())
+		return false;
+
+	{
+		std::unique_lock<std::mutex> lock(m_signalPoliciesMutex);
+		if (m_signalPolicies.empty())
+			return false;
+
+		// Every thread that has a stop reason must have stopped on a signal that does not stop the target
+		bool handled = false;
+		size_t threadCount = m_process.GetNumThreads();
+		for (size_t i = 0; i < threadCount; i++)
+		{
+			SBThread thread = m_process.GetThreadAtIndex(i);
+			if (!ThreadHasValidStopReason(thread))
+				continue;
+
+			if ((thread.GetStopReason() != eStopReasonSignal) || (thread.GetStopReasonDataCount() == 0))
+				return false;
+
+			const char* name = signals.GetSignalAsCString((int32_t)thread.GetStopReasonDataAtIndex(0));
+			if (!name)
+				return false;
+
+			auto it = m_signalPolicies.find(name);
+			if ((it == m_signalPolicies.end()) || (it->second == SignalPolicyStop))
+				return false;
+
+			handled = true;
+		}
+
+		if (!handled)
+			return false;
+	}
+
+	// The suppress flag of the signal decides whether it is delivered when the target resumes
+	m_silentResume = true;
+	SBError error = m_process.Continue();
+	if (!error.Success())
+	{
+		m_silentResume = false;
+		return false;
+	}
+	return true;
+}
+
+
+void LldbAdapter::ClearProcessResources()
+{
+	m_tracingInstructions = false;
+
+	// The target outlives the process, so the LLDB objects behind the IDs must go as well. Otherwise, they would be
+	// set again in the next process, while the maps no longer know about them.
+	{
+		std::unique_lock<std::mutex> lock(m_internalBreakpointsMutex);
+		for (const auto& [address, id] : m_internalBreakpoints)
+			m_target.BreakpointDelete(id);
+		m_internalBreakpoints.clear();
+		m_internalBreakpointIDs.clear();
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_watchpointsMutex);
+		for (const auto& [address, id] : m_watchpoints)
+			m_target.DeleteWatchpoint(id);
+		m_watchpoints.clear();
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_softwareWatchpointsMutex);
+		m_softwareWatchpoints.clear();
+		m_protectedPages.clear();
+		m_pendingProtectionUpdates.clear();
+	}
+}
+
+
 std::unordered_map<std::string, DebugRegister> LldbAdapter::ReadAllRegisters()
 {
 	std::unordered_map<std::string, DebugRegister> result;
@@ -732,21 +1612,14 @@ DebugRegister LldbAdapter::ReadRegister(const std::string& name)
 	if (!frame.IsValid())
 		return result;
 
-	SBValueList regGroups = frame.GetRegisters();
-	size_t numGroups = regGroups.GetSize();
-	for (size_t i = 0; i < numGroups; i++)
-	{
-		SBValue regGroupInfo = regGroups.GetValueAtIndex(i);
-		size_t numRegs = regGroupInfo.GetNumChildren();
-		for (size_t j = 0; j < numRegs; j++)
-		{
-			SBValue reg = regGroupInfo.GetChildAtIndex(j);
-			if (name == reg.GetName())
-				// TODO: register width and internal index
-				return DebugRegister(name, reg.GetValueAsUnsigned(), 0, 0);
-		}
-	}
-	return result;
+	// Only read the requested register, rather than all register groups. This is used by the breakpoint conditions,
+	// which are evaluated on every hit.
+	SBValue reg = frame.FindRegister(name.c_str());
+	if (!reg.IsValid())
+		return result;
+
+	// TODO: internal index
+	return DebugRegister(name, reg.GetValueAsUnsigned(), reg.GetByteSize() * 8, 0);
 }
 
 
@@ -1028,6 +1901,10 @@ DebugStopReason LldbAdapter::StopReason()
 			{
 				reason = DebugStopReason::Breakpoint;
 			}
+			else if (threadReason == lldb::eStopReasonWatchpoint)
+			{
+				reason = DebugStopReason::Watchpoint;
+			}
 			else if (threadReason == lldb::eStopReasonSignal)
 			{
 				size_t dataCount = thread.GetStopReasonDataCount();
@@ -1083,8 +1960,8 @@ bool LldbAdapter::BreakInto()
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "pause failed";
-		event.data.errorData.error = fmt::format("LLDB: pause failed, process state is not running");
+		event.data.setErrorData().shortError = "pause failed";
+		event.data.setErrorData().error = fmt::format("LLDB: pause failed, process state is not running");
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -1101,12 +1978,14 @@ bool LldbAdapter::Go()
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Go failed";
-		event.data.errorData.error = fmt::format("LLDB: go failed, process state is not stopped");
+		event.data.setErrorData().shortError = "Go failed";
+		event.data.setErrorData().error = fmt::format("LLDB: go failed, process state is not stopped");
 		PostDebuggerEvent(event);
 		return false;
 	}
 
+	m_resumedByGo = true;
+	m_stepFrameCfa = 0;
 #ifndef WIN32
 	SBError error = m_process.Continue();
 	if (!error.Success())
@@ -1124,20 +2003,22 @@ bool LldbAdapter::StepInto()
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "step into failed";
-		event.data.errorData.error = fmt::format("LLDB: step into failed, process state is not stopped");
+		event.data.setErrorData().shortError = "step into failed";
+		event.data.setErrorData().error = fmt::format("LLDB: step into failed, process state is not stopped");
 		PostDebuggerEvent(event);
 		return false;
 	}
 
+	m_resumedByGo = false;
+	m_stepFrameCfa = 0;
 #ifndef WIN32
 	SBThread thread = m_process.GetSelectedThread();
 	if (!thread.IsValid())
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Step into failed";
-		event.data.errorData.error = fmt::format("LLDB: step into failed, invalid thread");
+		event.data.setErrorData().shortError = "Step into failed";
+		event.data.setErrorData().error = fmt::format("LLDB: step into failed, invalid thread");
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -1148,8 +2029,8 @@ bool LldbAdapter::StepInto()
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Step into failed";
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = "Step into failed";
+		event.data.setErrorData().error =
 			fmt::format("LLDB: step into failed {}", error.GetCString() ? error.GetCString() : "");
 		PostDebuggerEvent(event);
 		return false;
@@ -1167,20 +2048,22 @@ bool LldbAdapter::StepOver()
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Step over failed";
-		event.data.errorData.error = fmt::format("LLDB: step over failed, process state is not stopped");
+		event.data.setErrorData().shortError = "Step over failed";
+		event.data.setErrorData().error = fmt::format("LLDB: step over failed, process state is not stopped");
 		PostDebuggerEvent(event);
 		return false;
 	}
 
+	m_resumedByGo = false;
+	SetStepFrame(0);
 #ifndef WIN32
 	SBThread thread = m_process.GetSelectedThread();
 	if (!thread.IsValid())
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Step over failed";
-		event.data.errorData.error = fmt::format("LLDB: step over failed, invalid thread");
+		event.data.setErrorData().shortError = "Step over failed";
+		event.data.setErrorData().error = fmt::format("LLDB: step over failed, invalid thread");
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -1191,8 +2074,8 @@ bool LldbAdapter::StepOver()
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Step over failed";
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = "Step over failed";
+		event.data.setErrorData().error =
 			fmt::format("LLDB: step over failed {}", error.GetCString() ? error.GetCString() : "");
 		PostDebuggerEvent(event);
 		return false;
@@ -1210,8 +2093,8 @@ bool LldbAdapter::StepReturn()
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Step return failed";
-		event.data.errorData.error = fmt::format("LLDB: step return failed, process state is not stopped");
+		event.data.setErrorData().shortError = "Step return failed";
+		event.data.setErrorData().error = fmt::format("LLDB: step return failed, process state is not stopped");
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -1235,13 +2118,15 @@ bool LldbAdapter::StepReturn()
 	//			return DebugStopReason::InternalError;
 	//	}
 	//#else
+	m_resumedByGo = false;
+	SetStepFrame(1);
 	auto result = InvokeBackendCommand("finish");
 	if (result.rfind("error: ", 0) == 0)
 	{
 		DebuggerEvent event;
 		event.type = ErrorEventType;
-		event.data.errorData.shortError = "Step return failed";
-		event.data.errorData.error = fmt::format("LLDB: step return failed, {}", result);
+		event.data.setErrorData().shortError = "Step return failed";
+		event.data.setErrorData().error = fmt::format("LLDB: step return failed, {}", result);
 		PostDebuggerEvent(event);
 		return false;
 	}
@@ -1311,20 +2196,21 @@ uint64_t LldbAdapter::GetStackPointer()
 
 bool LldbAdapter::SupportFeature(DebugAdapterCapacity feature)
 {
-	return false;
-}
-
-
-static bool ThreadHasValidStopReason(SBThread thread)
-{
-	if (!thread.IsValid())
-		return false;
-
-	auto reason = thread.GetStopReason();
-	if ((reason == eStopReasonInvalid) || (reason == eStopReasonNone) || (reason == eStopReasonThreadExiting))
+	switch (feature)
+	{
+	case DebugAdapterSupportInternalBreakpoints:
+	case DebugAdapterSupportWatchpoints:
+	case DebugAdapterSupportSignalPolicies:
+		return true;
+	case DebugAdapterSupportSoftwareWatchpoints:
+		return SupportsSoftwareWatchpoints();
+#ifndef WIN32
+	case DebugAdapterSupportInstructionTrace:
+		return true;
+#endif
+	default:
 		return false;
-
-	return true;
+	}
 }
 
 
@@ -1359,6 +2245,7 @@ void LldbAdapter::FixActiveThread()
 
 void LldbAdapter::EventListener()
 {
+	m_eventThreadId = std::this_thread::get_id();
 	auto listener = m_debugger.GetListener();
 
 	bool done = false;
@@ -1383,6 +2270,11 @@ void LldbAdapter::EventListener()
 				{
 				case lldb::eStateRunning:
 				{
+					// The adapter resumed the target on its own after handling an internal breakpoint. The
+					// controller still considers the target running, so there is nothing to report.
+					if (m_silentResume.exchange(false))
+						break;
+
 					DebuggerEvent dbgevt;
 					dbgevt.type = ResumeEventType;
 					PostDebuggerEvent(dbgevt);
@@ -1398,15 +2290,29 @@ void LldbAdapter::EventListener()
 				}
 				case lldb::eStateStopped:
 				{
+					ApplyPendingProtectionUpdates();
+					if (HandleInstructionTraceStop())
+						break;
+
+					if (HandleBreakpointStop())
+						break;
+
 					FixActiveThread();
+					bool softwareWatchpointHit = false;
+					if (HandleSoftwareWatchpointStop(softwareWatchpointHit))
+						break;
+
+					if (!softwareWatchpointHit && HandleSignalStop())
+						break;
+
 					DebuggerEvent dbgevt;
 					dbgevt.type = AdapterStoppedEventType;
 					// LLDB sometimes fails to update the process status when it is already sending eStateStopped event.
 					// When we restart the process, the target will appear to have exited
-					auto reason = StopReason();
+					auto reason = softwareWatchpointHit ? Watchpoint : StopReason();
 					if (reason == ProcessExited)
 						reason = UnknownReason;
-					dbgevt.data.targetStoppedData.reason = reason;
+					dbgevt.data.setTargetStoppedData().reason = reason;
 					PostDebuggerEvent(dbgevt);
 					break;
 				}
@@ -1414,9 +2320,10 @@ void LldbAdapter::EventListener()
 				{
 					done = true;
 					m_targetActive = false;
+					ClearProcessResources();
 					DebuggerEvent dbgevt;
 					dbgevt.type = TargetExitedEventType;
-					dbgevt.data.exitData.exitCode = ExitCode();
+					dbgevt.data.setExitData().exitCode = ExitCode();
 					PostDebuggerEvent(dbgevt);
 					break;
 				}
@@ -1424,6 +2331,7 @@ void LldbAdapter::EventListener()
 				{
 					done = true;
 					m_targetActive = false;
+					ClearProcessResources();
 					DebuggerEvent dbgevt;
 					dbgevt.type = DetachedEventType;
 					PostDebuggerEvent(dbgevt);
@@ -1445,16 +2353,17 @@ void LldbAdapter::EventListener()
 
 				DebuggerEvent event;
 				event.type = StdoutMessageEventType;
-				event.data.messageData.message = output;
-				PostDebuggerEvent(event);
+				event.data.setMessageData().message = std::move(output);
+				PostDebuggerEvent(std::move(event));
 
 				output.clear();
 				while ((count = process.GetSTDERR(buffer, 1024)) > 0)
 					output += std::string(buffer, count);
 
+				event = DebuggerEvent();
 				event.type = StdoutMessageEventType;
-				event.data.messageData.message = output;
-				PostDebuggerEvent(event);
+				event.data.setMessageData().message = std::move(output);
+				PostDebuggerEvent(std::move(event));
 			}
 		}
 		else if (lldb::SBTarget::EventIsTargetEvent(event))
@@ -1471,6 +2380,15 @@ void LldbAdapter::EventListener()
 			{
 				auto bpEventType = lldb::SBBreakpoint::GetBreakpointEventTypeFromEvent(event);
 				auto bp = lldb::SBBreakpoint::GetBreakpointFromEvent(event);
+				if (IsInternalBreakpointID(bp.GetID()))
+				{
+					if (bpEventType == lldb::eBreakpointEventTypeRemoved)
+					{
+						std::unique_lock<std::mutex> lock(m_internalBreakpointsMutex);
+						m_internalBreakpointIDs.erase(bp.GetID());
+					}
+					continue;
+				}
 				for (size_t i = 0; i < bp.GetNumLocations(); i++)
 				{
 					if (bpEventType == lldb::eBreakpointEventTypeAdded)
@@ -1488,15 +2406,15 @@ void LldbAdapter::EventListener()
 							size_t bytes = fileSpec.GetPath(path, sizeof(path));
 							DebuggerEvent evt;
 							evt.type = RelativeBreakpointAddedEvent;
-							evt.data.relativeAddress.module = std::string(path, bytes);
-							evt.data.relativeAddress.offset = bpAddress - moduleBase;
+							evt.data.setRelativeAddress().module = std::string(path, bytes);
+							evt.data.setRelativeAddress().offset = bpAddress - moduleBase;
 							PostDebuggerEvent(evt);
 						}
 						else
 						{
 							DebuggerEvent evt;
 							evt.type = AbsoluteBreakpointAddedEvent;
-							evt.data.absoluteAddress = location.GetAddress().GetLoadAddress(m_target);
+							evt.data.setAbsoluteAddress() = location.GetAddress().GetLoadAddress(m_target);
 							PostDebuggerEvent(evt);
 						}
 					}
@@ -1515,15 +2433,15 @@ void LldbAdapter::EventListener()
 							size_t bytes = fileSpec.GetPath(path, sizeof(path));
 							DebuggerEvent evt;
 							evt.type = RelativeBreakpointRemovedEvent;
-							evt.data.relativeAddress.module = std::string(path, bytes);
-							evt.data.relativeAddress.offset = bpAddress - moduleBase;
+							evt.data.setRelativeAddress().module = std::string(path, bytes);
+							evt.data.setRelativeAddress().offset = bpAddress - moduleBase;
 							PostDebuggerEvent(evt);
 						}
 						else
 						{
 							DebuggerEvent evt;
 							evt.type = AbsoluteBreakpointRemovedEvent;
-							evt.data.absoluteAddress = location.GetAddress().GetLoadAddress(m_target);
+							evt.data.setAbsoluteAddress() = location.GetAddress().GetLoadAddress(m_target);
 							PostDebuggerEvent(evt);
 						}
 					}
@@ -16,6 +16,10 @@ limitations under the License.
 
 #include "../debugadapter.h"
 #include "../debugadaptertype.h"
+#include <atomic>
+#include <map>
+#include <thread>
+#include <unordered_set>
 #ifdef WIN32
 	#pragma warning(push)
 	#pragma warning(disable : 4251)
@@ -45,6 +49,96 @@ namespace BinaryNinjaDebugger {
 		bool m_isElFWithoutDynamicLoader = false;
 		bool IsELFWithoutDynamicLoader(BinaryView* data);
 
+		// Internal breakpoints, keyed by address. The IDs are kept until LLDB reports the removal of the breakpoint,
+		// so that the breakpoint changed events for them are not forwarded to the controller.
+		std::mutex m_internalBreakpointsMutex;
+		std::unordered_map<uint64_t, lldb::break_id_t> m_internalBreakpoints;
+		std::unordered_set<lldb::break_id_t> m_internalBreakpointIDs;
+		bool IsInternalBreakpointID(lldb::break_id_t id);
+
+		// Internal breakpoint hits and breakpoint conditions are handled silently when the target is resumed by Go(),
+		// StepOver() or StepReturn(). A step that runs into such a breakpoint is not turned into a go, but resumed by
+		// stepping out to the frame it ends in.
+		std::atomic<bool> m_resumedByGo = false;
+		// The CFA of the frame that the current step over or step return ends in, or 0 if there is no such step, and
+		// the stepping thread
+		std::atomic<uint64_t> m_stepFrameCfa = 0;
+		std::atomic<uint64_t> m_stepThreadId = 0;
+		// Records the frame of the selected thread that a step ends in, by its index
+		void SetStepFrame(uint32_t index);
+		// Returns true if the interrupted step has been resumed, false if it is complete or cannot be resumed
+		bool ResumeInterruptedStep();
+		// Set when the adapter resumes the target on its own, so the resulting running state is not reported
+		std::atomic<bool> m_silentResume = false;
+		bool HandleBreakpointStop();
+
+		// Watchpoint IDs, keyed by address
+		std::mutex m_watchpointsMutex;
+		std::unordered_map<uint64_t, lldb::watch_id_t> m_watchpoints;
+
+		// Software watchpoints, only supported on x86_64 Linux. The pages that contain the watched ranges are protected
+		// with an injected mprotect() syscall. The access violations on these pages are handled in the event thread:
+		// the page is unprotected, the faulting instruction is single-stepped, and the page is protected again. The
+		// kernel does not raise a signal for the protected pages, so the target's own syscalls on watched buffers fail
+		// with EFAULT. The controller uses a hardware watchpoint instead whenever one can watch the range.
+		struct SoftwareWatchpoint
+		{
+			uint64_t m_address;
+			size_t m_size;
+			DebugWatchpointType m_type;
+		};
+		struct ProtectedPage
+		{
+			uint32_t m_originalProtection;
+			uint32_t m_protection;
+		};
+		std::mutex m_softwareWatchpointsMutex;
+		std::vector<SoftwareWatchpoint> m_softwareWatchpoints;
+		std::map<uint64_t, ProtectedPage> m_protectedPages;
+		// The ranges of the watchpoints removed while the target is running. Their pages are restored when the target
+		// next stops, since the protection can only be changed then.
+		std::vector<std::pair<uint64_t, size_t>> m_pendingProtectionUpdates;
+		bool SupportsSoftwareWatchpoints();
+		bool InjectSyscall(lldb::SBThread& thread, uint64_t number, const std::vector<uint64_t>& args, uint64_t& result);
+		bool ProtectPage(lldb::SBThread& thread, uint64_t page, uint32_t protection);
+		// Recompute the protection of the pages in the range, after a software watchpoint is added or removed
+		bool UpdatePageProtection(uint64_t address, size_t size);
+		// Called from the event thread when the target stops
+		void ApplyPendingProtectionUpdates();
+		// Returns true if the target has been resumed. Sets hit if the stop must be reported as a watchpoint hit.
+		bool HandleSoftwareWatchpointStop(bool& hit);
+
+		std::atomic<std::thread::id> m_eventThreadId;
+		// Single-steps the stopped thread and waits for it to stop again, without reporting the step to the controller
+		bool StepInstructionAndWait(lldb::SBThread& thread);
+
+		// Set while an instruction trace is running. Every single-step stop is passed to the handler in the event
+		// thread, and the next step is started right away without reporting the stop.
+		std::atomic<bool> m_tracingInstructions = false;
+		InstructionTraceHandler m_instructionTraceHandler;
+		// Returns true if the target has been stepped again
+		bool HandleInstructionTraceStop();
+
+		// Signal policies, keyed by the signal name. They are written into the signal table of LLDB whenever a process
+		// is created, so the signals that do not stop the target are passed or discarded by LLDB without even waking
+		// up the event thread. The original flags of the changed signals are kept to restore them later.
+		struct SignalFlags
+		{
+			bool m_stop;
+			bool m_notify;
+			bool m_suppress;
+		};
+		std::mutex m_signalPoliciesMutex;
+		DebugSignalPolicies m_signalPolicies;
+		std::map<int32_t, SignalFlags> m_originalSignalFlags;
+		void ApplySignalPolicies();
+		// Stops that LLDB still reports for such signals, e.g., SIGSEGV, which must be checked against the software
+		// watchpoints first, are resumed from the event thread. Returns true if the target has been resumed.
+		bool HandleSignalStop();
+
+		// Drop the breakpoints and watchpoints that only live as long as the process
+		void ClearProcessResources();
+
 	public:
 		LldbAdapter(BinaryView* data);
 		virtual ~LldbAdapter();
@@ -78,6 +172,7 @@ namespace BinaryNinjaDebugger {
 		bool ResumeThread(std::uint32_t tid) override;
 
 		std::vector<DebugFrame> GetFramesOfThread(uint32_t tid) override;
+		std::vector<uint64_t> GetFramePCsOfThread(uint32_t tid, size_t maxFrames) override;
 
 		DebugBreakpoint AddBreakpoint(const std::uintptr_t address, unsigned long breakpoint_type) override;
 
@@ -90,6 +185,24 @@ namespace BinaryNinjaDebugger {
 
 		std::vector<DebugBreakpoint> GetBreakpointList() const override;
 
+		bool AddInternalBreakpoints(const std::vector<std::uint64_t>& addresses) override;
+
+		bool RemoveInternalBreakpoint(std::uint64_t address) override;
+
+		bool AddWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type) override;
+
+		bool RemoveWatchpoint(std::uint64_t address) override;
+
+		bool AddSoftwareWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type) override;
+
+		bool RemoveSoftwareWatchpoint(std::uint64_t address) override;
+
+		bool TraceInstructions(const InstructionTraceHandler& handler) override;
+
+		bool SetSignalPolicies(const DebugSignalPolicies& policies) override;
+
+		bool IsMemoryWritable(std::uint64_t address) override;
+
 		std::unordered_map<std::string, DebugRegister> ReadAllRegisters() override;
 
 		DebugRegister ReadRegister(const std::string& reg) override;
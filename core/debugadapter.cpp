@@ -52,10 +52,10 @@ DebugAdapter::DebugAdapter(BinaryView* data)
 }
 
 
-void DebugAdapter::PostDebuggerEvent(const DebuggerEvent& event)
+void DebugAdapter::PostDebuggerEvent(DebuggerEvent event)
 {
 	if (m_eventCallback)
-		m_eventCallback(event);
+		m_eventCallback(std::move(event));
 }
 
 
@@ -93,6 +93,78 @@ bool DebugModule::IsSameBaseModule(const std::string& module1, const std::string
 }
 
 
+bool DebugAdapter::AddInternalBreakpoints(const std::vector<std::uint64_t>& addresses)
+{
+	return false;
+}
+
+
+bool DebugAdapter::RemoveInternalBreakpoint(std::uint64_t address)
+{
+	return false;
+}
+
+
+bool DebugAdapter::AddWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type)
+{
+	return false;
+}
+
+
+bool DebugAdapter::RemoveWatchpoint(std::uint64_t address)
+{
+	return false;
+}
+
+
+bool DebugAdapter::AddSoftwareWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type)
+{
+	return false;
+}
+
+
+bool DebugAdapter::RemoveSoftwareWatchpoint(std::uint64_t address)
+{
+	return false;
+}
+
+
+bool DebugAdapter::TraceInstructions(const InstructionTraceHandler& handler)
+{
+	return false;
+}
+
+
+bool DebugAdapter::SetSignalPolicies(const DebugSignalPolicies& policies)
+{
+	return false;
+}
+
+
+bool DebugAdapter::IsMemoryWritable(std::uint64_t address)
+{
+	return false;
+}
+
+
+bool DebugAdapter::HandleInternalBreakpoint(std::uint32_t tid, std::uint64_t address)
+{
+	if (!m_internalBreakpointHandler)
+		return false;
+
+	return m_internalBreakpointHandler(tid, address);
+}
+
+
+bool DebugAdapter::ShouldStopAtBreakpoint(std::uint32_t tid, std::uint64_t address)
+{
+	if (!m_breakpointConditionHandler)
+		return true;
+
+	return m_breakpointConditionHandler(tid, address);
+}
+
+
 bool DebugAdapter::GoReverse()
 {
 	return false;
@@ -140,6 +212,19 @@ std::vector<DebugFrame> DebugAdapter::GetFramesOfThread(std::uint32_t tid)
 }
 
 
+std::vector<uint64_t> DebugAdapter::GetFramePCsOfThread(std::uint32_t tid, size_t maxFrames)
+{
+	std::vector<uint64_t> result;
+	for (const auto& frame : GetFramesOfThread(tid))
+	{
+		if (result.size() >= maxFrames)
+			break;
+		result.push_back(frame.m_pc);
+	}
+	return result;
+}
+
+
 bool DebugAdapter::ConnectToDebugServer(const std::string& server, std::uint32_t port)
 {
 	return false;
@@ -23,6 +23,7 @@ limitations under the License.
 #include <stdexcept>
 #include <functional>
 #include <unordered_map>
+#include <map>
 #include <array>
 #include "binaryninjaapi.h"
 #include <fmt/format.h>
@@ -55,6 +56,11 @@ namespace BinaryNinjaDebugger {
 		DebugAdapterSupportModules,
 		DebugAdapterSupportThreads,
 		DebugAdapterSupportTTD,
+		DebugAdapterSupportInternalBreakpoints,
+		DebugAdapterSupportWatchpoints,
+		DebugAdapterSupportSoftwareWatchpoints,
+		DebugAdapterSupportInstructionTrace,
+		DebugAdapterSupportSignalPolicies,
 	};
 
 
@@ -129,6 +135,23 @@ namespace BinaryNinjaDebugger {
 		bool operator!() const { return !this->m_address && !this->m_id && !this->m_is_active; }
 	};
 
+	typedef BNDebugWatchpointType DebugWatchpointType;
+
+	struct DebugWatchpoint
+	{
+		std::uint64_t m_address {};
+		std::size_t m_size {};
+		DebugWatchpointType m_type {WriteWatchpoint};
+		// Software watchpoints are implemented with page protection, see DebugAdapter::AddSoftwareWatchpoint()
+		bool m_software {};
+
+		DebugWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type, bool software = false) :
+			m_address(address), m_size(size), m_type(type), m_software(software)
+		{}
+
+		DebugWatchpoint() {}
+	};
+
 	struct DebugRegister
 	{
 		std::string m_name {};
@@ -186,6 +209,34 @@ namespace BinaryNinjaDebugger {
 		{}
 	};
 
+	// Called by the adapter, from its event thread, when a thread hits an internal breakpoint. Returning true means
+	// the hit is fully handled, and the adapter can resume the target without reporting a stop.
+	typedef std::function<bool(std::uint32_t tid, std::uint64_t address)> InternalBreakpointHandler;
+
+	// Called by the adapter, from its event thread, when a thread hits a user breakpoint while the target is resumed by
+	// Go(), or in the middle of a step over or a step return. The thread is selected before the call, so the handler
+	// can read its registers. Returning false means the breakpoint condition does not hold, and the adapter resumes the
+	// target, or the step, without reporting a stop.
+	typedef std::function<bool(std::uint32_t tid, std::uint64_t address)> BreakpointConditionHandler;
+
+	// Called by the adapter, from its event thread, with the pc after every step of an instruction trace. Returning
+	// false ends the trace.
+	typedef std::function<bool(std::uint64_t pc)> InstructionTraceHandler;
+
+	// What the adapter does when the target receives a signal
+	enum DebugSignalPolicy
+	{
+		// Stop the target, and deliver the signal to it when it resumes
+		SignalPolicyStop,
+		// Deliver the signal to the target without stopping it
+		SignalPolicyPass,
+		// Discard the signal without stopping the target
+		SignalPolicyIgnore,
+	};
+
+	// Keyed by the signal name, e.g., "SIGUSR1"
+	typedef std::map<std::string, DebugSignalPolicy> DebugSignalPolicies;
+
 	class DebugAdapter
 	{
 		IMPLEMENT_DEBUGGER_API_OBJECT(BNDebugAdapter);
@@ -194,7 +245,10 @@ namespace BinaryNinjaDebugger {
 		// Function to call when the DebugAdapter wants to notify the front-end of certain events
 		// TODO: we should not use a vector here; only the DebuggerController should register one here;
 		// Other components should register their callbacks to the controller, who is responsible for notify them.
-		std::function<void(const DebuggerEvent& event)> m_eventCallback;
+		std::function<void(DebuggerEvent event)> m_eventCallback;
+
+		InternalBreakpointHandler m_internalBreakpointHandler;
+		BreakpointConditionHandler m_breakpointConditionHandler;
 
 	protected:
 		uint64_t m_entryPoint;
@@ -210,7 +264,7 @@ namespace BinaryNinjaDebugger {
 
 		virtual bool Init() { return true; }
 
-		virtual void SetEventCallback(std::function<void(const DebuggerEvent& event)> function)
+		virtual void SetEventCallback(std::function<void(DebuggerEvent event)> function)
 		{
 			m_eventCallback = function;
 		}
@@ -250,6 +304,10 @@ namespace BinaryNinjaDebugger {
 
 		virtual std::vector<DebugFrame> GetFramesOfThread(std::uint32_t tid);
 
+		// The pc of every frame, innermost first, without the symbolization done by GetFramesOfThread(). This is
+		// used when the stacks are captured often, e.g., by the sampling profiler.
+		virtual std::vector<uint64_t> GetFramePCsOfThread(std::uint32_t tid, size_t maxFrames);
+
 		virtual DebugBreakpoint AddBreakpoint(const std::uintptr_t address, unsigned long breakpoint_type = 0) = 0;
 
 		virtual DebugBreakpoint AddBreakpoint(const ModuleNameAndOffset& address, unsigned long breakpoint_type = 0) = 0;
@@ -260,6 +318,57 @@ namespace BinaryNinjaDebugger {
 
 		virtual std::vector<DebugBreakpoint> GetBreakpointList() const = 0;
 
+		// Internal breakpoints are placed by the debugger itself, e.g., for coverage collection. They are not reported
+		// as breakpoint added/removed events, and their hits are first offered to the internal breakpoint handler.
+		// Only adapters that report DebugAdapterSupportInternalBreakpoints implement them.
+		virtual bool AddInternalBreakpoints(const std::vector<std::uint64_t>& addresses);
+
+		virtual bool RemoveInternalBreakpoint(std::uint64_t address);
+
+		void SetInternalBreakpointHandler(InternalBreakpointHandler handler) { m_internalBreakpointHandler = handler; }
+
+		// Sub-classes call this from their event thread
+		bool HandleInternalBreakpoint(std::uint32_t tid, std::uint64_t address);
+
+		void SetBreakpointConditionHandler(BreakpointConditionHandler handler)
+		{
+			m_breakpointConditionHandler = handler;
+		}
+
+		// Sub-classes call this from their event thread. Returns true if the stop should be reported.
+		bool ShouldStopAtBreakpoint(std::uint32_t tid, std::uint64_t address);
+
+		// Watchpoints stop the target when it accesses the memory range. Only adapters that report
+		// DebugAdapterSupportWatchpoints implement them. The number, size and alignment of the watchpoints are
+		// limited by the debug registers of the target.
+		virtual bool AddWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type);
+
+		virtual bool RemoveWatchpoint(std::uint64_t address);
+
+		// Software watchpoints are not limited by the number of debug registers, and can have any size. The pages
+		// that contain the watched memory are protected, and the resulting access violations are checked against the
+		// watched ranges. They are much slower than the hardware ones if the pages are accessed frequently, and the
+		// target's syscalls that access the protected pages fail with EFAULT instead of stopping, which is why the
+		// controller prefers a hardware watchpoint when one can watch the range. Only adapters that report
+		// DebugAdapterSupportSoftwareWatchpoints implement them.
+		virtual bool AddSoftwareWatchpoint(std::uint64_t address, std::size_t size, DebugWatchpointType type);
+
+		virtual bool RemoveSoftwareWatchpoint(std::uint64_t address);
+
+		// Single-step the current thread repeatedly, calling the handler after every step, until it returns false or
+		// the target stops for another reason. The intermediate stops are not reported, only the final one is, like
+		// StepInto(). Only adapters that report DebugAdapterSupportInstructionTrace implement it.
+		virtual bool TraceInstructions(const InstructionTraceHandler& handler);
+
+		// Replace the signal policies. The signals that are not listed keep the default behavior of the adapter. The
+		// signals that do not stop the target are handled by the adapter without involving the controller. Only
+		// adapters that report DebugAdapterSupportSignalPolicies implement it.
+		virtual bool SetSignalPolicies(const DebugSignalPolicies& policies);
+
+		// Whether the target's own code can write to the memory at the address, according to the protection of its
+		// region. Returns false if the adapter cannot tell.
+		virtual bool IsMemoryWritable(std::uint64_t address);
+
 		virtual std::unordered_map<std::string, DebugRegister> ReadAllRegisters() = 0;
 
 		virtual DebugRegister ReadRegister(const std::string& reg) = 0;
@@ -307,7 +416,7 @@ namespace BinaryNinjaDebugger {
 
 		// This is implemented by the (base) DebugAdapter class.
 		// Sub-classes should use it to post debugger events directly (only when needed).
-		void PostDebuggerEvent(const DebuggerEvent& event);
+		void PostDebuggerEvent(DebuggerEvent event);
 
 		virtual void WriteStdin(const std::string& msg);
 
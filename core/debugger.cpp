@@ -125,6 +125,24 @@ static void RegisterSettings()
 			"ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
 			})");
 
+	settings->RegisterSetting("debugger.ilStepUsingBreakpoints",
+		R"({
+			"title" : "Step IL instructions using breakpoints",
+			"type" : "boolean",
+			"default" : true,
+			"description" : "When stepping at the IL level, run to temporary breakpoints on all the possible next IL instructions rather than single-stepping the native instructions one by one. Indirect control flow and function returns are still single-stepped.",
+			"ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
+			})");
+
+	settings->RegisterSetting("debugger.interpretStraightLineCode",
+		R"({
+			"title" : "Interpret straight-line code locally",
+			"type" : "boolean",
+			"default" : true,
+			"description" : "When running to a nearby address, e.g., for run to cursor or stepping over at the IL level, execute the LLIL of the code locally against the cached registers and memory, and write the result to the target in one batch. This only applies to single-threaded targets, and to code without calls or system calls.",
+			"ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
+			})");
+
 	settings->RegisterSetting("debugger.aggressiveAnalysisUpdate",
 		R"({
 			"title" : "Update the analysis aggressively",
@@ -134,6 +152,17 @@ static void RegisterSettings()
 			"ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
 			})");
 
+	settings->RegisterSetting("debugger.stallWarningThreshold",
+		R"({
+			"title" : "Adapter stall warning threshold",
+			"type" : "number",
+			"default" : 10,
+			"minValue" : 0,
+			"maxValue" : 3600,
+			"description" : "Log a warning when the debug adapter takes longer than this many seconds to finish an operation other than resuming the target, e.g., a step or a pause. The warning repeats each time the wait doubles. 0 disables the warnings.",
+			"ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
+			})");
+
 	settings->RegisterSetting("debugger.safeMode",
 		R"({
 			"title" : "Safe Mode",
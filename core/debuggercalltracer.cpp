@@ -0,0 +1,282 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggercalltracer.h"
+#include "debuggercontroller.h"
+#include <cstring>
+#include <fstream>
+
+using namespace BinaryNinjaDebugger;
+
+static const char CallTraceMagic[8] = {'B', 'N', 'D', 'C', 'A', 'L', 'L', 'S'};
+
+
+template <typename T>
+static void AppendValue(std::vector<uint8_t>& data, T value)
+{
+	// The supported targets and hosts are all little-endian
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T));
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+
+DebuggerCallTracer::DebuggerCallTracer(DebuggerController* controller) : m_controller(controller) {}
+
+
+std::vector<uint64_t> DebuggerCallTracer::Start(const std::vector<std::string>& modules)
+{
+	BinaryViewRef data = m_controller->GetData();
+	ArchitectureRef arch = m_controller->GetRemoteArchitecture();
+	if (!data || !arch)
+		return {};
+
+	std::unordered_set<uint64_t> functions;
+	for (const auto& func : data->GetAnalysisFunctionList())
+	{
+		if (modules.empty())
+		{
+			functions.insert(func->GetStart());
+			continue;
+		}
+
+		DebugModule module = m_controller->GetModuleForAddress(func->GetStart());
+		for (const auto& name : modules)
+		{
+			if (module.IsSameBaseModule(name))
+			{
+				functions.insert(func->GetStart());
+				break;
+			}
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_functions = std::move(functions);
+	m_returnAddresses.clear();
+	m_threads.clear();
+	m_nodes.clear();
+	m_nodeIndex.clear();
+
+	m_stackPointerName = arch->GetRegisterName(arch->GetStackPointerRegister());
+	m_linkRegisterName.clear();
+	if (uint32_t linkRegister = arch->GetLinkRegister(); linkRegister != BN_INVALID_REGISTER)
+		m_linkRegisterName = arch->GetRegisterName(linkRegister);
+	m_addressSize = arch->GetAddressSize();
+	m_active = !m_functions.empty();
+
+	return std::vector<uint64_t>(m_functions.begin(), m_functions.end());
+}
+
+
+std::vector<uint64_t> DebuggerCallTracer::Stop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_active)
+		return {};
+
+	// The calls that have not returned yet count towards the inclusive calls up to now
+	std::vector<uint64_t> result;
+	for (auto& [tid, thread] : m_threads)
+	{
+		while (!thread.m_stack.empty())
+			PopFrame(thread, result);
+	}
+
+	result.insert(result.end(), m_functions.begin(), m_functions.end());
+	m_functions.clear();
+	m_returnAddresses.clear();
+	m_active = false;
+	return result;
+}
+
+
+bool DebuggerCallTracer::ReadRegister(const std::string& name, uint64_t& value)
+{
+	DebugAdapter* adapter = m_controller->GetAdapter();
+	if (!adapter)
+		return false;
+
+	DebugRegister reg = adapter->ReadRegister(name);
+	if (reg.m_name.empty())
+		return false;
+
+	value = reg.m_value;
+	return true;
+}
+
+
+bool DebuggerCallTracer::ReadReturnAddress(uint64_t stackPointer, uint64_t& returnAddress)
+{
+	// On arm64 and the like, the call instruction puts the return address in the link register. On x86 and x86_64,
+	// it is on the top of the stack.
+	if (!m_linkRegisterName.empty())
+		return ReadRegister(m_linkRegisterName, returnAddress) || ReadRegister("lr", returnAddress);
+
+	DebugAdapter* adapter = m_controller->GetAdapter();
+	if (!adapter)
+		return false;
+
+	DataBuffer buffer = adapter->ReadMemory(stackPointer, m_addressSize);
+	if ((buffer.GetLength() != m_addressSize) || (m_addressSize > sizeof(returnAddress)))
+		return false;
+
+	returnAddress = 0;
+	memcpy(&returnAddress, buffer.GetData(), m_addressSize);
+	return true;
+}
+
+
+void DebuggerCallTracer::PopFrame(ThreadCalls& thread, std::vector<uint64_t>& released)
+{
+	const ShadowFrame& frame = thread.m_stack.back();
+	m_nodes[frame.m_node].m_inclusiveCalls += thread.m_calls - frame.m_callsOnEntry;
+
+	auto it = m_returnAddresses.find(frame.m_returnAddress);
+	if ((it != m_returnAddresses.end()) && (--it->second == 0))
+	{
+		m_returnAddresses.erase(it);
+		if (m_functions.find(frame.m_returnAddress) == m_functions.end())
+			released.push_back(frame.m_returnAddress);
+	}
+
+	thread.m_stack.pop_back();
+}
+
+
+bool DebuggerCallTracer::Hit(
+	uint32_t tid, uint64_t address, std::vector<uint64_t>& added, std::vector<uint64_t>& released)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_active)
+		return false;
+
+	bool isReturn = m_returnAddresses.find(address) != m_returnAddresses.end();
+	bool isFunction = m_functions.find(address) != m_functions.end();
+	if (!isReturn && !isFunction)
+		return false;
+
+	uint64_t stackPointer = 0;
+	if (!ReadRegister(m_stackPointerName, stackPointer))
+		return true;
+
+	ThreadCalls& thread = m_threads[tid];
+	if (isReturn)
+	{
+		// A return address can also be reached by another thread, or by a loop around the call without returning.
+		// Only the frames entered with a stack pointer not above the current one have returned.
+		auto returned = [&](const ShadowFrame& frame) {
+			return (frame.m_returnAddress == address) && (stackPointer >= frame.m_stackPointer);
+		};
+
+		size_t count = thread.m_stack.size();
+		while ((count > 0) && !returned(thread.m_stack[count - 1]))
+			count--;
+
+		if (count > 0)
+		{
+			// Tail calls leave several frames that return to the same address. The frames above the returned one
+			// were left without returning, e.g., by longjmp or an exception.
+			while ((count > 1) && returned(thread.m_stack[count - 2]))
+				count--;
+			while (thread.m_stack.size() >= count)
+				PopFrame(thread, released);
+		}
+	}
+
+	if (isFunction)
+	{
+		uint64_t returnAddress = 0;
+		if (!ReadReturnAddress(stackPointer, returnAddress))
+			return true;
+
+		uint32_t parent = thread.m_stack.empty() ? InvalidNodeIndex : thread.m_stack.back().m_node;
+		auto key = std::make_tuple(tid, parent, address);
+		uint32_t node;
+		if (auto it = m_nodeIndex.find(key); it != m_nodeIndex.end())
+		{
+			node = it->second;
+		}
+		else
+		{
+			node = (uint32_t)m_nodes.size();
+			m_nodes.push_back({tid, address, parent});
+			m_nodeIndex[key] = node;
+		}
+
+		m_nodes[node].m_count++;
+		thread.m_stack.push_back({returnAddress, stackPointer, node, thread.m_calls});
+		thread.m_calls++;
+
+		if ((m_returnAddresses[returnAddress]++ == 0) && (m_functions.find(returnAddress) == m_functions.end()))
+			added.push_back(returnAddress);
+	}
+
+	return true;
+}
+
+
+bool DebuggerCallTracer::NeedsBreakpoint(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_active)
+		return false;
+
+	return (m_functions.find(address) != m_functions.end())
+		|| (m_returnAddresses.find(address) != m_returnAddresses.end());
+}
+
+
+std::vector<CallTreeNode> DebuggerCallTracer::GetNodes()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::vector<CallTreeNode> result = m_nodes;
+	// Include the calls made so far by the functions that are still on the stack
+	for (const auto& [tid, thread] : m_threads)
+	{
+		for (const auto& frame : thread.m_stack)
+			result[frame.m_node].m_inclusiveCalls += thread.m_calls - frame.m_callsOnEntry;
+	}
+	return result;
+}
+
+
+bool DebuggerCallTracer::Export(const std::string& path)
+{
+	std::vector<CallTreeNode> nodes = GetNodes();
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LogWarn("Failed to open %s for writing the call trace", path.c_str());
+		return false;
+	}
+
+	std::vector<uint8_t> data(CallTraceMagic, CallTraceMagic + sizeof(CallTraceMagic));
+	AppendValue<uint32_t>(data, FileVersion);
+	AppendValue<uint32_t>(data, 0);
+	AppendValue<uint64_t>(data, nodes.size());
+	for (const auto& node : nodes)
+	{
+		AppendValue<uint32_t>(data, node.m_tid);
+		AppendValue<uint32_t>(data, node.m_parent);
+		AppendValue<uint64_t>(data, node.m_function);
+		AppendValue<uint64_t>(data, node.m_count);
+		AppendValue<uint64_t>(data, node.m_inclusiveCalls);
+	}
+
+	file.write((const char*)data.data(), data.size());
+	return file.good();
+}
@@ -0,0 +1,115 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace BinaryNinjaDebugger {
+	class DebuggerController;
+
+	struct CallTreeNode
+	{
+		uint32_t m_tid;
+		// Remote address of the called function
+		uint64_t m_function;
+		// Index of the caller node, or InvalidNodeIndex for the outermost traced calls of the thread
+		uint32_t m_parent;
+		uint64_t m_count = 0;
+		// The number of traced calls made while the function is on the stack, including the calls to itself
+		uint64_t m_inclusiveCalls = 0;
+	};
+
+	// Traces the calls to and the returns from the functions of the selected modules. The entry of every function gets
+	// an internal breakpoint. When it is hit, the return address is pushed onto a per-thread shadow stack, and it
+	// gets an internal breakpoint as well, which pops the frame once the callee returns. Everything is done in the
+	// adapter event thread, and the target is resumed without notifying the UI. The calls are aggregated into one
+	// call tree per thread, where every node counts the calls along the same path.
+	//
+	// The exported file is little-endian, and consists of:
+	//   header: "BNDCALLS", u32 version, u32 reserved, u64 node count
+	//   nodes:  u32 tid, u32 parent index, u64 function, u64 count, u64 inclusive calls
+	class DebuggerCallTracer
+	{
+	private:
+		struct ShadowFrame
+		{
+			uint64_t m_returnAddress;
+			// The stack pointer on entry, which tells apart the recursive calls that return to the same address
+			uint64_t m_stackPointer;
+			uint32_t m_node;
+			uint64_t m_callsOnEntry;
+		};
+
+		struct ThreadCalls
+		{
+			std::vector<ShadowFrame> m_stack;
+			uint64_t m_calls = 0;
+		};
+
+		DebuggerController* m_controller;
+
+		std::mutex m_mutex;
+		// Read by IsActive() without the mutex, from the thread that handles the stops
+		std::atomic<bool> m_active = false;
+		std::unordered_set<uint64_t> m_functions;
+		// Return addresses that have a breakpoint, and the number of shadow frames that return to them
+		std::unordered_map<uint64_t, size_t> m_returnAddresses;
+		std::unordered_map<uint32_t, ThreadCalls> m_threads;
+		std::vector<CallTreeNode> m_nodes;
+		// (tid, parent index, function) -> node index
+		std::map<std::tuple<uint32_t, uint32_t, uint64_t>, uint32_t> m_nodeIndex;
+
+		std::string m_stackPointerName;
+		// Empty if the return address is pushed on the stack by the call instruction
+		std::string m_linkRegisterName;
+		size_t m_addressSize = 8;
+
+		bool ReadRegister(const std::string& name, uint64_t& value);
+		bool ReadReturnAddress(uint64_t stackPointer, uint64_t& returnAddress);
+		void PopFrame(ThreadCalls& thread, std::vector<uint64_t>& released);
+
+	public:
+		static constexpr uint32_t InvalidNodeIndex = 0xffffffff;
+		static constexpr uint32_t FileVersion = 1;
+
+		DebuggerCallTracer(DebuggerController* controller);
+
+		// Clears the previous call trees, and collects the functions of the given modules, or of all the modules when
+		// none is given. Returns the addresses that need a breakpoint.
+		std::vector<uint64_t> Start(const std::vector<std::string>& modules);
+		// Returns the addresses whose breakpoints are no longer needed by the call tracer
+		std::vector<uint64_t> Stop();
+		bool IsActive() const { return m_active; }
+
+		// Called from the adapter event thread. Returns true if the address is a traced function or return address.
+		// The breakpoints to add and to remove are returned in added and released.
+		bool Hit(uint32_t tid, uint64_t address, std::vector<uint64_t>& added, std::vector<uint64_t>& released);
+		// Whether the call tracer still has a breakpoint at the address
+		bool NeedsBreakpoint(uint64_t address);
+
+		std::vector<CallTreeNode> GetNodes();
+		bool Export(const std::string& path);
+	};
+};  // namespace BinaryNinjaDebugger
@@ -0,0 +1,154 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggercommandqueue.h"
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace BinaryNinjaDebugger;
+
+
+DebuggerCommandQueue::DebuggerCommandQueue()
+{
+	m_thread = std::thread([this]() { ExecutorThread(); });
+	m_threadId = m_thread.get_id();
+}
+
+
+DebuggerCommandQueue::~DebuggerCommandQueue()
+{
+	CancelPending();
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_cv.notify_all();
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+
+std::shared_future<DebugStopReason> DebuggerCommandQueue::Submit(
+	DebuggerCommandFunction function, const std::string& coalesceKey)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_quit)
+	{
+		std::promise<DebugStopReason> promise;
+		promise.set_value(UserRequestedBreak);
+		return promise.get_future().share();
+	}
+
+	// Only a command that has not started yet can absorb the new one, so the order of the commands is kept
+	if (!coalesceKey.empty() && !m_commands.empty() && (m_commands.back()->m_coalesceKey == coalesceKey))
+	{
+		m_commands.back()->m_count++;
+		return m_commands.back()->m_result;
+	}
+
+	auto command = std::make_shared<Command>();
+	command->m_function = std::move(function);
+	command->m_coalesceKey = coalesceKey;
+	command->m_token = std::make_shared<DebuggerCancellationToken>();
+	command->m_result = command->m_promise.get_future().share();
+	m_commands.push_back(command);
+	lock.unlock();
+	m_cv.notify_one();
+	return command->m_result;
+}
+
+
+size_t DebuggerCommandQueue::CancelPending()
+{
+	std::deque<std::shared_ptr<Command>> cancelled;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		cancelled.swap(m_commands);
+	}
+
+	for (const auto& command : cancelled)
+		command->m_promise.set_value(UserRequestedBreak);
+	return cancelled.size();
+}
+
+
+size_t DebuggerCommandQueue::GetPendingCount()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_commands.size();
+}
+
+
+bool DebuggerCommandQueue::CancelRunning()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_runningToken)
+		return false;
+
+	m_runningToken->Cancel();
+	return true;
+}
+
+
+DebuggerCancellationTokenRef DebuggerCommandQueue::GetRunningToken()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_runningToken;
+}
+
+
+bool DebuggerCommandQueue::IsBusy()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_runningToken || !m_commands.empty();
+}
+
+
+void DebuggerCommandQueue::ExecutorThread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_cv.wait(lock, [&]() { return m_quit || !m_commands.empty(); });
+		if (m_quit)
+			break;
+
+		auto command = m_commands.front();
+		m_commands.pop_front();
+		m_runningToken = command->m_token;
+		lock.unlock();
+
+		DebugStopReason reason = InternalError;
+		try
+		{
+			reason = command->m_function(command->m_count);
+			command->m_promise.set_value(reason);
+		}
+		catch (const std::exception& e)
+		{
+			LogWarn("Debugger command failed: %s", e.what());
+			command->m_promise.set_value(reason);
+		}
+		catch (...)
+		{
+			// Anything else is handed to the waiters, so they are not left waiting for a result that never comes
+			command->m_promise.set_exception(std::current_exception());
+		}
+
+		lock.lock();
+		m_runningToken = nullptr;
+	}
+}
@@ -0,0 +1,93 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "debuggerevent.h"
+
+namespace BinaryNinjaDebugger {
+	// Runs a target control command. The count is the number of identical commands that were merged into this one,
+	// e.g., 10 step overs queued while the target was busy become one command that steps over 10 times.
+	typedef std::function<DebugStopReason(size_t count)> DebuggerCommandFunction;
+
+	// Every command gets a token. Cancelling it makes the adapter waits of the command give up, so the command ends
+	// early.
+	class DebuggerCancellationToken
+	{
+		std::atomic<bool> m_cancelled = false;
+
+	public:
+		void Cancel() { m_cancelled = true; }
+		bool IsCancelled() const { return m_cancelled; }
+	};
+	typedef std::shared_ptr<DebuggerCancellationToken> DebuggerCancellationTokenRef;
+
+	// Runs the target control commands of a controller one at a time, in the order they are submitted, on a single
+	// thread. The asynchronous APIs (Go(), StepInto(), ...) only submit a command, and the *AndWait() APIs submit one
+	// and wait for its result, so that a command issued while the target is busy runs after the current one rather
+	// than failing.
+	class DebuggerCommandQueue
+	{
+	private:
+		struct Command
+		{
+			DebuggerCommandFunction m_function;
+			// Commands with the same non-empty key are merged when they are queued next to each other
+			std::string m_coalesceKey;
+			size_t m_count = 1;
+			std::promise<DebugStopReason> m_promise;
+			std::shared_future<DebugStopReason> m_result;
+			DebuggerCancellationTokenRef m_token;
+		};
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::deque<std::shared_ptr<Command>> m_commands;
+		DebuggerCancellationTokenRef m_runningToken;
+		bool m_quit = false;
+
+		std::thread m_thread;
+		std::thread::id m_threadId;
+		void ExecutorThread();
+
+	public:
+		DebuggerCommandQueue();
+		// The pending commands are cancelled, and the running one is waited for
+		~DebuggerCommandQueue();
+
+		std::shared_future<DebugStopReason> Submit(
+			DebuggerCommandFunction function, const std::string& coalesceKey = "");
+		// The cancelled commands do not run, and their result is UserRequestedBreak. Returns the number of them.
+		size_t CancelPending();
+		// Returns false if no command is running
+		bool CancelRunning();
+		// The token of the running command, or nullptr if none is running
+		DebuggerCancellationTokenRef GetRunningToken();
+
+		size_t GetPendingCount();
+		bool IsBusy();
+		bool IsExecutorThread() const { return std::this_thread::get_id() == m_threadId; }
+	};
+};  // namespace BinaryNinjaDebugger
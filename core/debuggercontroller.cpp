@@ -15,14 +15,21 @@ limitations under the License.
 */
 
 #include "debuggercontroller.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <thread>
 #include "lowlevelilinstruction.h"
 #include "mediumlevelilinstruction.h"
 #include "highlevelilinstruction.h"
 #include "debuggerfileaccessor.h"
+#include "debuggerllilinterpreter.h"
 
 using namespace BinaryNinjaDebugger;
 
+// Set while the synchronous event callbacks run on the current thread
+static thread_local bool t_deliveringEvents = false;
+
 DebuggerController::DebuggerController(BinaryViewRef data)
 {
 	INIT_DEBUGGER_API_OBJECT();
@@ -32,10 +39,21 @@ DebuggerController::DebuggerController(BinaryViewRef data)
 	m_data->RegisterNotification(this);
 	m_viewStart = m_data->GetStart();
 
+	m_eventCallbacks = std::make_shared<DebuggerEventCallbackList>();
+	m_eventDispatcher = new DebuggerEventDispatcher();
+	m_commandQueue = new DebuggerCommandQueue();
 	m_state = new DebuggerState(data, this);
 	m_adapter = nullptr;
+	m_coverage = new DebuggerCoverage(this);
+	m_tracepoints = new DebuggerTracepoints(this);
+	m_instructionTrace = new DebuggerInstructionTrace();
+	m_callTracer = new DebuggerCallTracer(this);
+	m_profiler = new DebuggerProfiler(this);
+	m_syscallTrace = new DebuggerSyscallTrace(this);
+	m_exprValueCache = new DebuggerExprValueCache();
 	m_shouldAnnotateStackVariable = Settings::Instance()->Get<bool>("debugger.stackVariableAnnotations");
 	RegisterEventCallback([this](const DebuggerEvent& event) { EventHandler(event); }, "Debugger Core");
+	m_stopStagesThread = std::thread([this]() { StopStagesThread(); });
 }
 
 
@@ -44,11 +62,80 @@ DebuggerController::~DebuggerController()
 	m_data->UnregisterNotification(this);
 	m_file = nullptr;
 
+	// The deferred stop stages check the command queue, so they must finish before it goes away
+	{
+		std::unique_lock<std::mutex> lock(m_stopStagesMutex);
+		m_quitStopStagesThread = true;
+	}
+	m_stopStagesCv.notify_all();
+	if (m_stopStagesThread.joinable())
+		m_stopStagesThread.join();
+
+	// The running command uses everything below, so it must finish first
+	if (m_commandQueue)
+	{
+		delete m_commandQueue;
+		m_commandQueue = nullptr;
+	}
+
+	// The tracepoint drain thread posts events, whose callbacks use the state
+	if (m_tracepoints)
+		m_tracepoints->StopDrainThread();
+
+	// Stop delivering events before the objects used by the callbacks go away
+	if (m_eventDispatcher)
+	{
+		delete m_eventDispatcher;
+		m_eventDispatcher = nullptr;
+	}
+
 	if (m_state)
 	{
 		delete m_state;
 		m_state = nullptr;
 	}
+
+	if (m_coverage)
+	{
+		delete m_coverage;
+		m_coverage = nullptr;
+	}
+
+	if (m_tracepoints)
+	{
+		delete m_tracepoints;
+		m_tracepoints = nullptr;
+	}
+
+	if (m_instructionTrace)
+	{
+		delete m_instructionTrace;
+		m_instructionTrace = nullptr;
+	}
+
+	if (m_callTracer)
+	{
+		delete m_callTracer;
+		m_callTracer = nullptr;
+	}
+
+	if (m_profiler)
+	{
+		delete m_profiler;
+		m_profiler = nullptr;
+	}
+
+	if (m_syscallTrace)
+	{
+		delete m_syscallTrace;
+		m_syscallTrace = nullptr;
+	}
+
+	if (m_exprValueCache)
+	{
+		delete m_exprValueCache;
+		m_exprValueCache = nullptr;
+	}
 }
 
 
@@ -57,7 +144,7 @@ void DebuggerController::AddBreakpoint(uint64_t address)
 	m_state->AddBreakpoint(address);
 	DebuggerEvent event;
 	event.type = AbsoluteBreakpointAddedEvent;
-	event.data.absoluteAddress = address;
+	event.data.setAbsoluteAddress() = address;
 	PostDebuggerEvent(event);
 }
 
@@ -67,7 +154,7 @@ void DebuggerController::AddBreakpoint(const ModuleNameAndOffset& address)
 	m_state->AddBreakpoint(address);
 	DebuggerEvent event;
 	event.type = RelativeBreakpointAddedEvent;
-	event.data.relativeAddress = address;
+	event.data.setRelativeAddress() = address;
 	PostDebuggerEvent(event);
 }
 
@@ -75,9 +162,10 @@ void DebuggerController::AddBreakpoint(const ModuleNameAndOffset& address)
 void DebuggerController::DeleteBreakpoint(uint64_t address)
 {
 	m_state->DeleteBreakpoint(address);
+	UpdateBreakpointConditions();
 	DebuggerEvent event;
 	event.type = AbsoluteBreakpointRemovedEvent;
-	event.data.absoluteAddress = address;
+	event.data.setAbsoluteAddress() = address;
 	PostDebuggerEvent(event);
 }
 
@@ -85,28 +173,594 @@ void DebuggerController::DeleteBreakpoint(uint64_t address)
 void DebuggerController::DeleteBreakpoint(const ModuleNameAndOffset& address)
 {
 	m_state->DeleteBreakpoint(address);
+	UpdateBreakpointConditions();
 	DebuggerEvent event;
 	event.type = RelativeBreakpointRemovedEvent;
-	event.data.relativeAddress = address;
+	event.data.setRelativeAddress() = address;
 	PostDebuggerEvent(event);
 }
 
 
-bool DebuggerController::SetIP(uint64_t address)
+bool DebuggerController::SetBreakpointCondition(uint64_t address, const std::string& condition)
+{
+	return SetBreakpointCondition(m_state->GetModules()->AbsoluteAddressToRelative(address), condition);
+}
+
+
+bool DebuggerController::SetBreakpointCondition(const ModuleNameAndOffset& address, const std::string& condition)
+{
+	if (!condition.empty())
+	{
+		DebuggerExpression expression;
+		std::string error;
+		if (!DebuggerExpression::Parse(condition, expression, error))
+		{
+			LogWarn("Invalid breakpoint condition \"%s\": %s", condition.c_str(), error.c_str());
+			return false;
+		}
+	}
+
+	if (!m_state->GetBreakpoints()->SetConditionOffset(address, condition))
+	{
+		LogWarn("There is no breakpoint at %s + 0x%" PRIx64, address.module.c_str(), address.offset);
+		return false;
+	}
+
+	UpdateBreakpointConditions();
+	return true;
+}
+
+
+std::string DebuggerController::GetBreakpointCondition(uint64_t address)
+{
+	return m_state->GetBreakpoints()->GetConditionAbsolute(address);
+}
+
+
+std::string DebuggerController::GetBreakpointCondition(const ModuleNameAndOffset& address)
+{
+	return m_state->GetBreakpoints()->GetConditionOffset(address);
+}
+
+
+uint64_t DebuggerController::GetBreakpointHitCount(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_breakpointConditionMutex);
+	auto it = m_breakpointHitCounts.find(address);
+	if (it == m_breakpointHitCounts.end())
+		return 0;
+	return it->second;
+}
+
+
+void DebuggerController::UpdateBreakpointConditions()
+{
+	// The absolute addresses are only known once the modules are loaded, so this is also called on every stop
+	std::unordered_map<uint64_t, DebuggerExpression> conditions;
+	for (const auto& [address, condition] : m_state->GetBreakpoints()->GetConditions())
+	{
+		DebuggerExpression expression;
+		std::string error;
+		if (!DebuggerExpression::Parse(condition, expression, error))
+			continue;
+
+		if (m_state->IsConnected())
+			conditions[m_state->GetModules()->RelativeAddressToAbsolute(address)] = expression;
+	}
+
+	std::unique_lock<std::mutex> lock(m_breakpointConditionMutex);
+	m_breakpointConditions = std::move(conditions);
+}
+
+
+bool DebuggerController::EvaluateInAdapterThread(const DebuggerExpression& expression, uint64_t& value)
+{
+	// Only the registers and memory used by the expression are read
+	auto readRegister = [this](const std::string& name, uint64_t& value) {
+		DebugRegister reg = m_adapter->ReadRegister(name);
+		if (reg.m_name.empty())
+			return false;
+		value = reg.m_value;
+		return true;
+	};
+	auto readMemory = [this](uint64_t address, size_t size, uint64_t& value) {
+		if (size > sizeof(value))
+			return false;
+		DataBuffer buffer = m_adapter->ReadMemory(address, size);
+		if (buffer.GetLength() != size)
+			return false;
+		// The supported targets are all little-endian
+		value = 0;
+		memcpy(&value, buffer.GetData(), size);
+		return true;
+	};
+
+	size_t addressSize = 8;
+	if (auto arch = m_state->GetRemoteArchitecture())
+		addressSize = arch->GetAddressSize();
+
+	return expression.Evaluate(readRegister, readMemory, addressSize, value);
+}
+
+
+bool DebuggerController::BreakpointConditionHandler(uint32_t tid, uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_breakpointConditionMutex);
+	m_breakpointHitCounts[address]++;
+
+	auto it = m_breakpointConditions.find(address);
+	if (it == m_breakpointConditions.end())
+		return true;
+
+	uint64_t value = 0;
+	if (!EvaluateInAdapterThread(it->second, value))
+	{
+		LogWarn("Failed to evaluate the condition \"%s\" of the breakpoint at 0x%" PRIx64 ", stopping the target",
+			it->second.GetText().c_str(), address);
+		return true;
+	}
+
+	return value != 0;
+}
+
+
+bool DebuggerController::AddWatchpoint(uint64_t address, size_t size, DebugWatchpointType type, bool software)
+{
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+	{
+		LogWarn("Watchpoints can only be added when the target is paused");
+		return false;
+	}
+
+	if (software)
+	{
+		if (!m_adapter->SupportFeature(DebugAdapterSupportSoftwareWatchpoints))
+		{
+			LogWarn("The current debug adapter does not support software watchpoints");
+			return false;
+		}
+
+		if (size == 0)
+		{
+			LogWarn("Invalid watchpoint size 0");
+			return false;
+		}
+	}
+	else if (!m_adapter->SupportFeature(DebugAdapterSupportWatchpoints))
+	{
+		LogWarn("The current debug adapter does not support watchpoints");
+		return false;
+	}
+	else if ((size != 1) && (size != 2) && (size != 4) && (size != 8))
+	{
+		LogWarn("Invalid watchpoint size %zu, it must be 1, 2, 4, or 8", size);
+		return false;
+	}
+
+	if ((type & AccessWatchpoint) == 0)
+	{
+		LogWarn("Invalid watchpoint type %d", type);
+		return false;
+	}
+
+	// The target's syscalls on the pages protected for a software watchpoint fail with EFAULT, so a debug register is
+	// used whenever one is free and can watch the range
+	if (software && m_adapter->SupportFeature(DebugAdapterSupportWatchpoints)
+		&& ((size == 1) || (size == 2) || (size == 4) || (size == 8)) && ((address % size) == 0)
+		&& m_state->GetWatchpoints()->Add(address, size, type, false))
+		return true;
+
+	return m_state->GetWatchpoints()->Add(address, size, type, software);
+}
+
+
+bool DebuggerController::RemoveWatchpoint(uint64_t address)
+{
+	return m_state->GetWatchpoints()->Remove(address);
+}
+
+
+bool DebuggerController::StartCoverage(const std::vector<uint64_t>& functions, const std::vector<std::string>& modules)
+{
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+	{
+		LogWarn("Coverage collection can only be started when the target is paused");
+		return false;
+	}
+
+	if (!m_adapter->SupportFeature(DebugAdapterSupportInternalBreakpoints))
+	{
+		LogWarn("The current debug adapter does not support coverage collection");
+		return false;
+	}
+
+	if (m_coverage->IsActive())
+		StopCoverage();
+
+	std::vector<uint64_t> addresses = m_coverage->Start(functions, modules);
+	// The block that the target currently stops at is already covered. Also, a breakpoint there would never be hit,
+	// since the target steps over it when it resumes.
+	if (m_coverage->RecordHit(m_currentIP))
+		addresses.erase(std::remove(addresses.begin(), addresses.end(), m_currentIP), addresses.end());
+
+	if (m_coverage->GetBlockCount() == 0)
+	{
+		LogWarn("No basic blocks are found in the selected functions or modules");
+		m_coverage->Stop();
+		return false;
+	}
+
+	if (!m_adapter->AddInternalBreakpoints(addresses))
+		LogWarn("Failed to add breakpoints on some of the basic blocks, their coverage will not be collected");
+
+	return true;
+}
+
+
+void DebuggerController::StopCoverage()
+{
+	m_coverage->Stop();
+	if (!m_adapter)
+		return;
+
+	// Blocks that have been covered already had their breakpoints removed
+	auto covered = m_coverage->GetCoveredBlocks();
+	std::set<uint64_t> coveredSet(covered.begin(), covered.end());
+	for (const uint64_t address : m_coverage->GetBlocks())
+	{
+		if (coveredSet.find(address) == coveredSet.end())
+			ReleaseInternalBreakpoint(address);
+	}
+}
+
+
+bool DebuggerController::StartCallTrace(const std::vector<std::string>& modules)
+{
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+	{
+		LogWarn("Call tracing can only be started when the target is paused");
+		return false;
+	}
+
+	if (!m_adapter->SupportFeature(DebugAdapterSupportInternalBreakpoints))
+	{
+		LogWarn("The current debug adapter does not support call tracing");
+		return false;
+	}
+
+	if (m_callTracer->IsActive())
+		StopCallTrace();
+
+	std::vector<uint64_t> addresses = m_callTracer->Start(modules);
+	if (addresses.empty())
+	{
+		LogWarn("No functions are found in the selected modules");
+		return false;
+	}
+
+	if (!m_adapter->AddInternalBreakpoints(addresses))
+		LogWarn("Failed to add breakpoints on some of the functions, their calls will not be traced");
+
+	return true;
+}
+
+
+void DebuggerController::StopCallTrace()
+{
+	std::vector<uint64_t> addresses = m_callTracer->Stop();
+	if (!m_adapter)
+		return;
+
+	for (const uint64_t address : addresses)
+		ReleaseInternalBreakpoint(address);
+}
+
+
+bool DebuggerController::StartSyscallTrace(const std::vector<std::string>& modules)
+{
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+	{
+		LogWarn("Syscall tracing can only be started when the target is paused");
+		return false;
+	}
+
+	if (!m_adapter->SupportFeature(DebugAdapterSupportInternalBreakpoints))
+	{
+		LogWarn("The current debug adapter does not support syscall tracing");
+		return false;
+	}
+
+	// The numbers and the arguments are read with the Linux syscall calling conventions
+	Ref<Platform> platform = GetData()->GetDefaultPlatform();
+	if (!platform || (platform->GetName().rfind("linux", 0) != 0))
+	{
+		LogWarn("Syscall tracing is only supported on Linux targets");
+		return false;
+	}
+
+	if (m_syscallTrace->IsActive())
+		StopSyscallTrace();
+
+	std::vector<uint64_t> addresses = m_syscallTrace->Start(modules);
+	if (addresses.empty())
+	{
+		LogWarn("No syscall instructions are found in the selected modules");
+		return false;
+	}
+
+	if (!m_adapter->AddInternalBreakpoints(addresses))
+		LogWarn("Failed to add breakpoints on some of the syscall instructions, they will not be traced");
+
+	return true;
+}
+
+
+void DebuggerController::StopSyscallTrace()
+{
+	std::vector<uint64_t> addresses = m_syscallTrace->Stop();
+	if (!m_adapter)
+		return;
+
+	for (const uint64_t address : addresses)
+		ReleaseInternalBreakpoint(address);
+}
+
+
+DebugStopReason DebuggerController::TraceInstructionsAndWait(const InstructionTraceOptions& options)
+{
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+	{
+		LogWarn("Instructions can only be traced when the target is paused");
+		return InvalidStatusOrOperation;
+	}
+
+	if (!m_adapter->SupportFeature(DebugAdapterSupportInstructionTrace))
+	{
+		LogWarn("The current debug adapter does not support instruction tracing");
+		return OperationNotSupported;
+	}
+
+	if ((options.m_maxSteps == 0) && !options.m_hasStopAddress)
+	{
+		LogWarn("Instruction tracing needs a step count or a stop address");
+		return InvalidStatusOrOperation;
+	}
+
+	return ExecuteCommandAndWait([&](size_t) {
+		// The stops in between are handled in the adapter event thread, so the caches and the UI are only updated once
+		// the tracing ends
+		m_instructionTrace->Start(
+			m_adapter, m_state->GetInstructionCache(), m_state->GetRemoteArchitecture(), options, m_state->IP());
+		auto reason = StepSilentlyAndWaitInternal([this](uint64_t pc) { return m_instructionTrace->Step(pc); });
+		m_instructionTrace->Stop();
+
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
+}
+
+
+// The stop reasons that the adapters report when the target is interrupted. LLDB reports the SIGSTOP it uses for that
+// as SignalStop on macOS, and as SignalCont on Linux, since GetStopReasonFromLinuxSignal() follows the macOS numbers.
+static bool IsInterruptStopReason(DebugStopReason reason)
+{
+	switch (reason)
+	{
+	case UnknownReason:
+	case UserRequestedBreak:
+	case SignalInt:
+	case SignalStop:
+	case SignalCont:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+DebugStopReason DebuggerController::ProfileAndWait(const ProfilerOptions& options)
+{
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+	{
+		LogWarn("The profiler can only be started when the target is paused");
+		return InvalidStatusOrOperation;
+	}
+
+	if ((options.m_sampleRate == 0) || ((options.m_maxSamples == 0) && (options.m_duration == 0)))
+	{
+		LogWarn("The profiler needs a sample rate, and a sample count or a duration");
+		return InvalidStatusOrOperation;
+	}
+
+	return ExecuteCommandAndWait([&](size_t) {
+		m_profiler->Start();
+		auto interval = std::chrono::microseconds(1000000 / options.m_sampleRate);
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.m_duration);
+		DebugStopReason reason = UnknownReason;
+
+		// One thread interrupts the target for the whole session. Every resume wakes it up, and it breaks into the
+		// target once the interval elapses, unless the target stops by itself before that.
+		std::mutex mutex;
+		std::condition_variable cv;
+		uint64_t resumed = 0;
+		uint64_t stopped = 0;
+		bool interrupted = false;
+		bool quit = false;
+		std::thread interrupter([&]() {
+			std::unique_lock<std::mutex> lock(mutex);
+			uint64_t current = 0;
+			while (true)
+			{
+				cv.wait(lock, [&]() { return quit || (resumed != current); });
+				if (quit)
+					return;
+
+				current = resumed;
+				if (cv.wait_for(lock, interval, [&]() { return quit || (stopped == current); }))
+					continue;
+				interrupted = m_adapter->BreakInto();
+			}
+		});
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				interrupted = false;
+				resumed++;
+			}
+			cv.notify_all();
+
+			reason = GoAndWaitInternal();
+			bool sampled;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				stopped = resumed;
+				sampled = interrupted;
+			}
+			cv.notify_all();
+
+			// A breakpoint, an exception, the exit of the target, or a pause by the user ends the profiling. The target
+			// can also stop by itself just as it is interrupted, so the stop is only a sample if its reason is that of
+			// an interrupt.
+			if (!sampled || m_userRequestedBreak || !IsInterruptStopReason(reason))
+				break;
+
+			// The stacks are read from the adapter directly. The stop is neither reported to the UI, nor does it update
+			// the debugger caches.
+			for (const auto& thread : m_adapter->GetThreadList())
+				m_profiler->AddSample(thread.m_tid, m_adapter->GetFramePCsOfThread(thread.m_tid, options.m_maxDepth));
+			m_profiler->EndSample();
+
+			if ((options.m_maxSamples != 0) && (m_profiler->GetSampleCount() >= options.m_maxSamples))
+				break;
+			if ((options.m_duration != 0) && (std::chrono::steady_clock::now() >= deadline))
+				break;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			quit = true;
+		}
+		cv.notify_all();
+		interrupter.join();
+
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
+}
+
+
+bool DebuggerController::AddTracepoint(uint64_t address, const std::string& format)
+{
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+	{
+		LogWarn("Tracepoints can only be added when the target is paused");
+		return false;
+	}
+
+	if (!m_adapter->SupportFeature(DebugAdapterSupportInternalBreakpoints))
+	{
+		LogWarn("The current debug adapter does not support tracepoints");
+		return false;
+	}
+
+	if (!m_tracepoints->Add(address, format))
+		return false;
+
+	if (!m_adapter->AddInternalBreakpoints({address}))
+	{
+		LogWarn("Failed to add a tracepoint at 0x%" PRIx64, address);
+		m_tracepoints->Remove(address);
+		return false;
+	}
+
+	return true;
+}
+
+
+bool DebuggerController::RemoveTracepoint(uint64_t address)
+{
+	if (!m_tracepoints->Remove(address))
+		return false;
+
+	ReleaseInternalBreakpoint(address);
+	return true;
+}
+
+
+void DebuggerController::ReleaseInternalBreakpoint(uint64_t address)
+{
+	if (!m_adapter)
+		return;
+
+	if (m_tracepoints->Contains(address) || m_coverage->IsPendingBlock(address)
+		|| m_callTracer->NeedsBreakpoint(address) || m_syscallTrace->NeedsBreakpoint(address))
+		return;
+
+	m_adapter->RemoveInternalBreakpoint(address);
+}
+
+
+bool DebuggerController::InternalBreakpointHandler(uint32_t tid, uint64_t address)
+{
+	bool handled = false;
+
+	// Coverage breakpoints are one-shot: once a block is known to be covered, there is no need to stop there again
+	if (m_coverage->RecordHit(address))
+	{
+		ReleaseInternalBreakpoint(address);
+		handled = true;
+	}
+
+	std::vector<uint64_t> added, released;
+	if (m_callTracer->Hit(tid, address, added, released))
+	{
+		if (!added.empty())
+			m_adapter->AddInternalBreakpoints(added);
+		for (const uint64_t returnAddress : released)
+			ReleaseInternalBreakpoint(returnAddress);
+		handled = true;
+	}
+
+	if (m_syscallTrace->Hit(tid, address))
+		handled = true;
+
+	if (m_tracepoints->Contains(address))
+	{
+		auto evaluate = [this](const DebuggerExpression& expression, uint64_t& value) {
+			return EvaluateInAdapterThread(expression, value);
+		};
+		if (m_tracepoints->Hit(tid, address, evaluate))
+			handled = true;
+	}
+
+	return handled;
+}
+
+
+std::string DebuggerController::GetIPRegisterName()
 {
-	std::string ipRegisterName;
 	std::string targetArch = GetRemoteArchitecture()->GetName();
 
 	if ((targetArch == "x86") || (targetArch == "i386"))
-		ipRegisterName = "eip";
+		return "eip";
 	else if (targetArch == "x86_64")
-		ipRegisterName = "rip";
+		return "rip";
 	else if ((targetArch == "aarch64") || (targetArch == "arm64"))
-		ipRegisterName = "pc";
+		return "pc";
 	else
-		ipRegisterName = "pc";
+		return "pc";
+}
 
-	if (!SetRegisterValue(ipRegisterName, address))
+
+bool DebuggerController::SetIP(uint64_t address)
+{
+	if (!SetRegisterValue(GetIPRegisterName(), address))
 		return false;
 
 	// This allows the thread frame widget to update properly
@@ -118,7 +772,7 @@ bool DebuggerController::SetIP(uint64_t address)
 
 bool DebuggerController::Launch()
 {
-	std::thread([&]() { LaunchAndWait(); }).detach();
+	SubmitCommand([this](size_t) { return LaunchAndWait(); });
 	return true;
 }
 
@@ -131,8 +785,8 @@ DebugStopReason DebuggerController::LaunchAndWaitInternal()
 	{
 		DebuggerEvent event;
 		event.type = LaunchFailureEventType;
-		event.data.errorData.shortError = "Safe mode enabled";
-		event.data.errorData.error =
+		event.data.setErrorData().shortError = "Safe mode enabled";
+		event.data.setErrorData().error =
 			fmt::format("Cannot launch the target because the debugger is in safe mode.");
 		PostDebuggerEvent(event);
 		return InternalError;
@@ -160,21 +814,19 @@ DebugStopReason DebuggerController::LaunchAndWaitInternal()
 
 DebugStopReason DebuggerController::LaunchAndWait()
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
-
-	auto reason = LaunchAndWaitInternal();
-	if (!m_userRequestedBreak && (reason != ProcessExited) && (reason != InternalError))
-		NotifyStopped(reason);
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = LaunchAndWaitInternal();
+		if (!m_userRequestedBreak && (reason != ProcessExited) && (reason != InternalError))
+			NotifyStopped(reason);
 
-	m_targetControlMutex.unlock();
-	return reason;
+		return reason;
+	});
 }
 
 
 bool DebuggerController::Attach()
 {
-	std::thread([&]() { AttachAndWait(); }).detach();
+	SubmitCommand([this](size_t) { return AttachAndWait(); });
 	return true;
 }
 
@@ -202,21 +854,19 @@ DebugStopReason DebuggerController::AttachAndWaitInternal()
 
 DebugStopReason DebuggerController::AttachAndWait()
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = AttachAndWaitInternal();
+		if (!m_userRequestedBreak && (reason != ProcessExited) && (reason != InternalError))
+			NotifyStopped(reason);
 
-	auto reason = AttachAndWaitInternal();
-	if (!m_userRequestedBreak && (reason != ProcessExited) && (reason != InternalError))
-		NotifyStopped(reason);
-
-	m_targetControlMutex.unlock();
-	return reason;
+		return reason;
+	});
 }
 
 
 bool DebuggerController::Connect()
 {
-	std::thread([&]() { ConnectAndWait(); }).detach();
+	SubmitCommand([this](size_t) { return ConnectAndWait(); });
 	return true;
 }
 
@@ -244,15 +894,13 @@ DebugStopReason DebuggerController::ConnectAndWaitInternal()
 
 DebugStopReason DebuggerController::ConnectAndWait()
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
-
-	auto reason = ConnectAndWaitInternal();
-	if (!m_userRequestedBreak && (reason != ProcessExited) && (reason != InternalError))
-		NotifyStopped(reason);
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = ConnectAndWaitInternal();
+		if (!m_userRequestedBreak && (reason != ProcessExited) && (reason != InternalError))
+			NotifyStopped(reason);
 
-	m_targetControlMutex.unlock();
-	return reason;
+		return reason;
+	});
 }
 
 
@@ -304,11 +952,20 @@ bool DebuggerController::CreateDebugAdapter()
 
 	m_lastAdapterName = m_state->GetAdapterType();
 	m_state->SetAdapter(m_adapter);
+	m_adapter->SetSignalPolicies(m_state->GetParsedSignalPolicies());
 
 	ApplyBreakpoints();
 
 	// Forward the DebuggerEvent from the adapters to the controller
-	m_adapter->SetEventCallback([this](const DebuggerEvent& event) { PostDebuggerEvent(event); });
+	m_adapter->SetEventCallback([this](DebuggerEvent event) {
+		m_lastAdapterEventTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		PostDebuggerEvent(std::move(event));
+	});
+	m_adapter->SetInternalBreakpointHandler(
+		[this](uint32_t tid, uint64_t address) { return InternalBreakpointHandler(tid, address); });
+	m_adapter->SetBreakpointConditionHandler(
+		[this](uint32_t tid, uint64_t address) { return BreakpointConditionHandler(tid, address); });
 	return true;
 }
 
@@ -317,6 +974,9 @@ bool DebuggerController::CreateDebugAdapter()
 void DebuggerController::ApplyBreakpoints()
 {
 	m_state->ApplyBreakpoints();
+
+	std::unique_lock<std::mutex> lock(m_breakpointConditionMutex);
+	m_breakpointHitCounts.clear();
 }
 
 
@@ -335,53 +995,380 @@ bool DebuggerController::ExpectSingleStep(DebugStopReason reason)
 }
 
 
-bool DebuggerController::Go()
+bool DebuggerController::SubmitResumeCommand(const DebuggerCommandFunction& command, const std::string& coalesceKey)
 {
-	// This is an API function of the debugger. We only do these checks at the API level.
-	if (!CanResumeTarget())
+	// A command submitted while an earlier one runs the target waits for the target to stop
+	if (!CanResumeTarget() && !(m_state->IsConnected() && m_commandQueue->IsBusy()))
 		return false;
 
-	std::thread([&]() { GoAndWait(); }).detach();
+	SubmitCommand(
+		[this, command](size_t count) { return CanResumeTarget() ? command(count) : InvalidStatusOrOperation; },
+		coalesceKey);
+	return true;
+}
+
+
+std::shared_future<DebugStopReason> DebuggerController::SubmitCommand(
+	const DebuggerCommandFunction& command, const std::string& coalesceKey)
+{
+	return m_commandQueue->Submit(
+		[this, command](size_t count) {
+			std::unique_lock<std::recursive_mutex> lock(m_targetControlMutex);
+			return command(count);
+		},
+		coalesceKey);
+}
+
+
+DebugStopReason DebuggerController::ExecuteCommandAndWait(
+	const DebuggerCommandFunction& command, const std::string& coalesceKey)
+{
+	// The commands issued by a running command, e.g., by RestartAndWait(), or by a callback it triggers, run right
+	// away
+	if (m_commandQueue->IsExecutorThread())
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_targetControlMutex);
+		return command(1);
+	}
+
+	// The command that posted the event waits for its synchronous callbacks, so they cannot wait for another command
+	if (t_deliveringEvents)
+	{
+		LogWarn("Cannot wait for a debugger command in a synchronous event callback");
+		return InternalError;
+	}
+
+	try
+	{
+		return SubmitCommand(command, coalesceKey).get();
+	}
+	catch (...)
+	{
+		LogWarn("Debugger command failed with an unknown exception");
+		return InternalError;
+	}
+}
+
+
+DebugStopReason DebuggerController::StepCommand(const std::function<DebugStopReason()>& step, size_t count)
+{
+	// Only the last of the merged steps is reported
+	DebugStopReason reason = UnknownReason;
+	for (size_t i = 0; i < count; i++)
+	{
+		reason = step();
+		if (m_userRequestedBreak || !ExpectSingleStep(reason))
+			break;
+	}
+
+	if (!m_userRequestedBreak && (reason != ProcessExited))
+		NotifyStopped(reason);
+	return reason;
+}
+
+
+size_t DebuggerController::CancelPendingCommands()
+{
+	return m_commandQueue->CancelPending();
+}
+
+
+size_t DebuggerController::GetPendingCommandCount()
+{
+	return m_commandQueue->GetPendingCount();
+}
+
+
+bool DebuggerController::CancelOperation()
+{
+	m_commandQueue->CancelPending();
+	return m_commandQueue->CancelRunning();
+}
+
+
+bool DebuggerController::Go()
+{
+	return SubmitResumeCommand([this](size_t) { return GoAndWait(); });
+}
+
+bool DebuggerController::GoReverse()
+{
+	return SubmitResumeCommand([this](size_t) { return GoReverseAndWait(); });
+}
+
+
+DebugStopReason DebuggerController::GoAndWait()
+{
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = GoAndWaitInternal();
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
+}
+
+DebugStopReason DebuggerController::GoReverseAndWait()
+{
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = GoReverseAndWaitInternal();
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
+}
+
+
+std::shared_ptr<const std::vector<uint64_t>> DebuggerController::GetILInstructionStarts(
+	const FunctionRef& func, BNFunctionGraphType il)
+{
+	if (il == HighLevelLanguageRepresentationFunctionGraph)
+		il = HighLevelILFunctionGraph;
+
+	auto key = std::make_pair(func->GetStart(), il);
+	{
+		std::unique_lock<std::mutex> lock(m_ilInstructionStartsMutex);
+		auto it = m_ilInstructionStarts.find(key);
+		if (it != m_ilInstructionStarts.end())
+			return it->second;
+	}
+
+	auto addresses = std::make_shared<std::vector<uint64_t>>();
+	switch (il)
+	{
+	case LowLevelILFunctionGraph:
+	{
+		LowLevelILFunctionRef llil = func->GetLowLevelILIfAvailable();
+		if (!llil)
+			return nullptr;
+		for (size_t i = 0; i < llil->GetInstructionCount(); i++)
+			addresses->push_back(llil->GetInstruction(i).address);
+		break;
+	}
+	case MediumLevelILFunctionGraph:
+	{
+		MediumLevelILFunctionRef mlil = func->GetMediumLevelILIfAvailable();
+		if (!mlil)
+			return nullptr;
+		for (size_t i = 0; i < mlil->GetInstructionCount(); i++)
+			addresses->push_back(mlil->GetInstruction(i).address);
+		break;
+	}
+	case HighLevelILFunctionGraph:
+	{
+		HighLevelILFunctionRef hlil = func->GetHighLevelILIfAvailable();
+		if (!hlil)
+			return nullptr;
+		for (size_t i = 0; i < hlil->GetInstructionCount(); i++)
+			addresses->push_back(hlil->GetInstruction(i).address);
+		break;
+	}
+	default:
+		return nullptr;
+	}
+
+	std::sort(addresses->begin(), addresses->end());
+	addresses->erase(std::unique(addresses->begin(), addresses->end()), addresses->end());
+
+	std::unique_lock<std::mutex> lock(m_ilInstructionStartsMutex);
+	m_ilInstructionStarts[key] = addresses;
+	return addresses;
+}
+
+
+bool DebuggerController::IsILInstructionStart(BNFunctionGraphType il, uint64_t address)
+{
+	// Stop if the address is not in any function, or the IL is not available, since we cannot do any better
+	std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(address);
+	if (functions.empty())
+		return true;
+
+	for (const FunctionRef& func : functions)
+	{
+		auto addresses = GetILInstructionStarts(func, il);
+		if (!addresses)
+			return true;
+
+		if (std::binary_search(addresses->begin(), addresses->end(), address))
+			return true;
+	}
+	return false;
+}
+
+
+bool DebuggerController::GetNextILInstructionAddresses(
+	BNFunctionGraphType il, bool stepOver, std::vector<uint64_t>& addresses)
+{
+	// Give up on long stretches of native code without any IL instruction start, single-stepping is fine for them
+	static constexpr size_t MaxInstructionsToFollow = 256;
+
+	const uint64_t ip = m_state->IP();
+	std::set<uint64_t> result;
+	std::set<uint64_t> visited;
+	std::vector<uint64_t> pending = {ip};
+	// The native instructions reached from the current one either start an IL instruction, where we stop, or belong
+	// to the current IL instruction, which we keep following
+	auto follow = [&](uint64_t target) {
+		if (IsILInstructionStart(il, target))
+			result.insert(target);
+		else if (visited.find(target) == visited.end())
+			pending.push_back(target);
+	};
+
+	while (!pending.empty())
+	{
+		uint64_t address = pending.back();
+		pending.pop_back();
+		if (!visited.insert(address).second)
+			continue;
+
+		if (visited.size() > MaxInstructionsToFollow)
+			return false;
+
+		auto instruction = m_state->DecodeInstruction(address);
+		if (!instruction)
+			return false;
+
+		const InstructionInfo& info = instruction->m_info;
+
+		// The indirect calls have no branch information, only their IL tells them apart
+		bool isCall = false, isIndirectCall = false;
+		for (size_t i = 0; i < info.branchCount; i++)
+			isCall = isCall || (info.branchType[i] == CallDestination);
+		if (info.branchCount == 0)
+		{
+			auto lifted = m_state->DecodeInstruction(address, true);
+			isIndirectCall = lifted && lifted->m_llil && ((*lifted->m_llil)[0].operation == LLIL_CALL);
+		}
+
+		// The target must not run a call while the temporary breakpoints are set, since a recursive call would hit
+		// them in a deeper frame. When stepping over, the calls are stepped over natively instead: a call at the
+		// current address cannot be followed, and the ones further on are stops of their own. When stepping into, the
+		// callee of an indirect call is unknown.
+		if (stepOver && (isCall || isIndirectCall))
+		{
+			if (address == ip)
+				return false;
+			result.insert(address);
+			continue;
+		}
+		if (isIndirectCall)
+			return false;
+
+		bool fallThrough = true;
+		for (size_t i = 0; i < info.branchCount; i++)
+		{
+			switch (info.branchType[i])
+			{
+			case UnconditionalBranch:
+			case TrueBranch:
+			case FalseBranch:
+				fallThrough = false;
+				follow(info.branchTarget[i]);
+				break;
+			case CallDestination:
+				// When stepping into, the callee is entered before anything else runs. The native step into the callee
+				// stops there only if it is the start of an IL instruction, otherwise we cannot tell where the callee
+				// reaches one.
+				if (!IsILInstructionStart(il, info.branchTarget[i]))
+					return false;
+				fallThrough = false;
+				result.insert(info.branchTarget[i]);
+				break;
+			case SystemCall:
+				break;
+			default:
+				// Function returns, indirect branches, exceptions, etc
+				return false;
+			}
+		}
+
+		if (fallThrough)
+			follow(address + info.length);
+	}
 
-	return true;
+	addresses.assign(result.begin(), result.end());
+	return !addresses.empty();
 }
 
-bool DebuggerController::GoReverse()
+
+DebugStopReason DebuggerController::StepILUsingBreakpoints(BNFunctionGraphType il, bool stepOver)
 {
-	// This is an API function of the debugger. We only do these checks at the API level.
-	if (!CanResumeTarget())
-		return false;
+	// Each iteration runs to the next stop, or single-steps a native instruction that cannot be followed. Give up on
+	// code that never reaches an IL instruction, e.g., a long loop of indirect branches.
+	static constexpr size_t MaxIterations = 4096;
 
-	std::thread([&]() { GoReverseAndWait(); }).detach();
+	// The temporary breakpoints are hit by every thread, but only a hit in the stepping thread ends the step
+	const uint32_t tid = m_state->GetThreads()->GetActiveThread().m_tid;
+	for (size_t i = 0; i < MaxIterations; i++)
+	{
+		std::vector<uint64_t> addresses;
+		if (GetNextILInstructionAddresses(il, stepOver, addresses))
+		{
+			DebugStopReason reason = RunToTemporaryBreakpointsAndWait(addresses);
+			if ((reason != Breakpoint) || m_userRequestedBreak)
+				return reason;
 
-	return true;
-}
+			uint64_t address = m_state->IP();
+			if (std::find(addresses.begin(), addresses.end(), address) == addresses.end())
+				return reason;
 
+			if (m_state->GetThreads()->GetActiveThread().m_tid != tid)
+			{
+				// The breakpoints of the user are reported as usual
+				if (m_state->GetBreakpoints()->ContainsAbsolute(address))
+					return reason;
+
+				// Another thread ran into a temporary breakpoint. Switch back to the stepping thread, and resume the
+				// target without reporting the stop.
+				if (!m_state->GetThreads()->SetActiveThread(DebugThread(tid)))
+					return reason;
+				m_state->GetRegisters()->Update();
+				continue;
+			}
 
-DebugStopReason DebuggerController::GoAndWait()
-{
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
+			// Report the same as single-stepping onto the next IL instruction would
+			if (IsILInstructionStart(il, address))
+				return SingleStep;
 
-	auto reason = GoAndWaitInternal();
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
+			// Otherwise, this is a call that is stepped over natively below
+		}
 
-	m_targetControlMutex.unlock();
-	return reason;
+		DebugStopReason reason = stepOver ? StepOverAndWaitInternal() : StepIntoAndWaitInternal();
+		if (!ExpectSingleStep(reason))
+			return reason;
+
+		if (IsILInstructionStart(il, m_state->IP()))
+			return SingleStep;
+	}
+
+	// The target is stopped in the middle of the IL instruction, which must not look like a completed step
+	LogWarn("Failed to reach the next IL instruction after %zu steps", MaxIterations);
+	return InternalError;
 }
 
-DebugStopReason DebuggerController::GoReverseAndWait()
+
+void DebuggerController::OnAnalysisFunctionUpdated(BinaryView* view, Function* func)
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
+	uint64_t start = func->GetStart();
+	{
+		std::unique_lock<std::mutex> lock(m_updatedStackFunctionsMutex);
+		m_updatedStackFunctions.insert(start);
+	}
+	// The IL of the function may have been regenerated
+	m_exprValueCache->Clear();
 
-	auto reason = GoReverseAndWaitInternal();
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
+	std::unique_lock<std::mutex> lock(m_ilInstructionStartsMutex);
+	auto it = m_ilInstructionStarts.lower_bound(std::make_pair(start, (BNFunctionGraphType)0));
+	while ((it != m_ilInstructionStarts.end()) && (it->first.first == start))
+		it = m_ilInstructionStarts.erase(it);
+}
 
-	m_targetControlMutex.unlock();
-	return reason;
+
+void DebuggerController::OnAnalysisFunctionRemoved(BinaryView* view, Function* func)
+{
+	OnAnalysisFunctionUpdated(view, func);
 }
 
 
@@ -394,68 +1381,13 @@ DebugStopReason DebuggerController::StepIntoIL(BNFunctionGraphType il)
 		return StepIntoAndWaitInternal();
 	}
 	case LowLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepIntoAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				LowLevelILFunctionRef llil = func->GetLowLevelILIfAvailable();
-				if (!llil)
-					return SingleStep;
-
-				size_t start = llil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < llil->GetInstructionCount())
-				{
-					if (llil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case MediumLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepIntoAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				MediumLevelILFunctionRef mlil = func->GetMediumLevelILIfAvailable();
-				if (!mlil)
-					return SingleStep;
-
-				size_t start = mlil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < mlil->GetInstructionCount())
-				{
-					if (mlil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case HighLevelILFunctionGraph:
 	case HighLevelLanguageRepresentationFunctionGraph:
 	{
+		if (Settings::Instance()->Get<bool>("debugger.ilStepUsingBreakpoints"))
+			return StepILUsingBreakpoints(il, false);
+
 		// TODO: This might cause infinite loop
 		while (true)
 		{
@@ -463,23 +1395,8 @@ DebugStopReason DebuggerController::StepIntoIL(BNFunctionGraphType il)
 			if (!ExpectSingleStep(reason))
 				return reason;
 
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
+			if (IsILInstructionStart(il, m_state->IP()))
 				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				HighLevelILFunctionRef hlil = func->GetHighLevelILIfAvailable();
-				if (!hlil)
-					return SingleStep;
-
-				for (size_t i = 0; i < hlil->GetInstructionCount(); i++)
-				{
-					if (hlil->GetInstruction(i).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
 		}
 		break;
 	}
@@ -499,65 +1416,7 @@ DebugStopReason DebuggerController::StepIntoReverseIL(BNFunctionGraphType il)
 		return StepIntoReverseAndWaitInternal();
 	}
 	case LowLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepIntoReverseAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				LowLevelILFunctionRef llil = func->GetLowLevelILIfAvailable();
-				if (!llil)
-					return SingleStep;
-
-				size_t start = llil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < llil->GetInstructionCount())
-				{
-					if (llil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case MediumLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepIntoReverseAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				MediumLevelILFunctionRef mlil = func->GetMediumLevelILIfAvailable();
-				if (!mlil)
-					return SingleStep;
-
-				size_t start = mlil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < mlil->GetInstructionCount())
-				{
-					if (mlil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case HighLevelILFunctionGraph:
 	case HighLevelLanguageRepresentationFunctionGraph:
 	{
@@ -568,23 +1427,8 @@ DebugStopReason DebuggerController::StepIntoReverseIL(BNFunctionGraphType il)
 			if (!ExpectSingleStep(reason))
 				return reason;
 
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
+			if (IsILInstructionStart(il, m_state->IP()))
 				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				HighLevelILFunctionRef hlil = func->GetHighLevelILIfAvailable();
-				if (!hlil)
-					return SingleStep;
-
-				for (size_t i = 0; i < hlil->GetInstructionCount(); i++)
-				{
-					if (hlil->GetInstruction(i).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
 		}
 		break;
 	}
@@ -604,50 +1448,114 @@ DebugStopReason DebuggerController::StepIntoReverseAndWaitInternal()
 
 bool DebuggerController::StepInto(BNFunctionGraphType il)
 {
-	if (!CanResumeTarget())
-		return false;
+	// The step commands queued while the target is busy are merged into one that steps several times
+	return SubmitResumeCommand(
+		[this, il](size_t count) { return StepCommand([&]() { return StepIntoIL(il); }, count); },
+		fmt::format("StepInto {}", il));
+}
 
-	std::thread([&, il]() { StepIntoAndWait(il); }).detach();
+bool DebuggerController::StepIntoReverse(BNFunctionGraphType il)
+{
+	// The step commands queued while the target is busy are merged into one that steps several times
+	return SubmitResumeCommand(
+		[this, il](size_t count) { return StepCommand([&]() { return StepIntoReverseIL(il); }, count); },
+		fmt::format("StepIntoReverse {}", il));
+}
 
-	return true;
+DebugStopReason DebuggerController::StepIntoReverseAndWait(BNFunctionGraphType il)
+{
+	return ExecuteCommandAndWait(
+		[this, il](size_t count) { return StepCommand([&]() { return StepIntoReverseIL(il); }, count); },
+		fmt::format("StepIntoReverse {}", il));
 }
 
-bool DebuggerController::StepIntoReverse(BNFunctionGraphType il)
+DebugStopReason DebuggerController::StepIntoAndWait(BNFunctionGraphType il)
 {
-	if (!CanResumeTarget())
-		return false;
+	return ExecuteCommandAndWait(
+		[this, il](size_t count) { return StepCommand([&]() { return StepIntoIL(il); }, count); },
+		fmt::format("StepInto {}", il));
+}
+
+DebugStopReason DebuggerController::StepSilentlyAndWaitInternal(const InstructionTraceHandler& handler)
+{
+	m_userRequestedBreak = false;
+	if (m_adapter->SupportFeature(DebugAdapterSupportInstructionTrace))
+	{
+		m_silentStepHandler = handler;
+		auto reason = ExecuteAdapterAndWait(DebugAdapterTraceInstructions);
+		m_silentStepHandler = nullptr;
+		return reason;
+	}
 
-	std::thread([&, il]() { StepIntoReverseAndWait(il); }).detach();
+	// The adapter cannot step on its own, so the steps are done here. They still do not notify the stops in between.
+	while (true)
+	{
+		DebugStopReason reason = StepIntoAndWaitInternal();
+		if (!ExpectSingleStep(reason) || m_userRequestedBreak)
+			return reason;
 
-	return true;
+		if (!handler(m_state->IP()))
+			return reason;
+	}
 }
 
-DebugStopReason DebuggerController::StepIntoReverseAndWait(BNFunctionGraphType il)
+
+DebugStopReason DebuggerController::StepIntoNAndWait(uint64_t count)
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
+	if (count == 0)
+	{
+		LogWarn("The number of instructions to step into must be non-zero");
+		return InvalidStatusOrOperation;
+	}
 
-	auto reason = StepIntoReverseIL(il);
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+		return InvalidStatusOrOperation;
 
-	m_targetControlMutex.unlock();
-	return reason;
+	return ExecuteCommandAndWait([&](size_t) {
+		uint64_t steps = 0;
+		auto reason = StepSilentlyAndWaitInternal([&](uint64_t) { return ++steps < count; });
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
 }
 
-DebugStopReason DebuggerController::StepIntoAndWait(BNFunctionGraphType il)
+
+DebugStopReason DebuggerController::StepUntilAndWait(const std::string& condition, uint64_t maxSteps)
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
+	DebuggerExpression expression;
+	std::string error;
+	if (!DebuggerExpression::Parse(condition, expression, error))
+	{
+		LogWarn("Invalid step condition \"%s\": %s", condition.c_str(), error.c_str());
+		return InvalidStatusOrOperation;
+	}
 
-	auto reason = StepIntoIL(il);
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
+	if (!m_adapter || !m_state->IsConnected() || m_state->IsRunning())
+		return InvalidStatusOrOperation;
 
-	m_targetControlMutex.unlock();
-	return reason;
+	return ExecuteCommandAndWait([&](size_t) {
+		uint64_t steps = 0;
+		auto reason = StepSilentlyAndWaitInternal([&](uint64_t) {
+			uint64_t value = 0;
+			if (!EvaluateInAdapterThread(expression, value))
+			{
+				LogWarn("Failed to evaluate the step condition \"%s\", stopping the target", condition.c_str());
+				return false;
+			}
+			if (value != 0)
+				return false;
+			return (maxSteps == 0) || (++steps < maxSteps);
+		});
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
 }
 
+
 DebugStopReason DebuggerController::StepOverIL(BNFunctionGraphType il)
 {
 	switch (il)
@@ -657,67 +1565,13 @@ DebugStopReason DebuggerController::StepOverIL(BNFunctionGraphType il)
 		return StepOverAndWaitInternal();
 	}
 	case LowLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepOverAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				LowLevelILFunctionRef llil = func->GetLowLevelILIfAvailable();
-				if (!llil)
-					return SingleStep;
-
-				size_t start = llil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < llil->GetInstructionCount())
-				{
-					if (llil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case MediumLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepOverAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				MediumLevelILFunctionRef mlil = func->GetMediumLevelILIfAvailable();
-				if (!mlil)
-					return SingleStep;
-
-				size_t start = mlil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < mlil->GetInstructionCount())
-				{
-					if (mlil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case HighLevelILFunctionGraph:
 	case HighLevelLanguageRepresentationFunctionGraph:
 	{
+		if (Settings::Instance()->Get<bool>("debugger.ilStepUsingBreakpoints"))
+			return StepILUsingBreakpoints(il, true);
+
 		// TODO: This might cause infinite loop
 		while (true)
 		{
@@ -725,23 +1579,8 @@ DebugStopReason DebuggerController::StepOverIL(BNFunctionGraphType il)
 			if (!ExpectSingleStep(reason))
 				return reason;
 
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
+			if (IsILInstructionStart(il, m_state->IP()))
 				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				HighLevelILFunctionRef hlil = func->GetHighLevelILIfAvailable();
-				if (!hlil)
-					return SingleStep;
-
-				for (size_t i = 0; i < hlil->GetInstructionCount(); i++)
-				{
-					if (hlil->GetInstruction(i).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
 		}
 		break;
 	}
@@ -760,64 +1599,7 @@ DebugStopReason DebuggerController::StepOverReverseIL(BNFunctionGraphType il)
 		return StepOverReverseAndWaitInternal();
 	}
 	case LowLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepOverReverseAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				LowLevelILFunctionRef llil = func->GetLowLevelILIfAvailable();
-				if (!llil)
-					return SingleStep;
-
-				size_t start = llil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < llil->GetInstructionCount())
-				{
-					if (llil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case MediumLevelILFunctionGraph:
-	{
-		// TODO: This might cause infinite loop
-		while (true)
-		{
-			DebugStopReason reason = StepOverReverseAndWaitInternal();
-			if (!ExpectSingleStep(reason))
-				return reason;
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
-				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				MediumLevelILFunctionRef mlil = func->GetMediumLevelILIfAvailable();
-				if (!mlil)
-					return SingleStep;
-
-				size_t start = mlil->GetInstructionStart(GetData()->GetDefaultArchitecture(), newRemoteRip);
-				if (start < mlil->GetInstructionCount())
-				{
-					if (mlil->GetInstruction(start).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
-		}
-		break;
-	}
 	case HighLevelILFunctionGraph:
 	case HighLevelLanguageRepresentationFunctionGraph:
 	{
@@ -828,23 +1610,8 @@ DebugStopReason DebuggerController::StepOverReverseIL(BNFunctionGraphType il)
 			if (!ExpectSingleStep(reason))
 				return reason;
 
-			uint64_t newRemoteRip = m_state->IP();
-			std::vector<FunctionRef> functions = GetData()->GetAnalysisFunctionsContainingAddress(newRemoteRip);
-			if (functions.empty())
+			if (IsILInstructionStart(il, m_state->IP()))
 				return SingleStep;
-
-			for (FunctionRef& func : functions)
-			{
-				HighLevelILFunctionRef hlil = func->GetHighLevelILIfAvailable();
-				if (!hlil)
-					return SingleStep;
-
-				for (size_t i = 0; i < hlil->GetInstructionCount(); i++)
-				{
-					if (hlil->GetInstruction(i).address == newRemoteRip)
-						return SingleStep;
-				}
-			}
 		}
 		break;
 	}
@@ -856,52 +1623,36 @@ DebugStopReason DebuggerController::StepOverReverseIL(BNFunctionGraphType il)
 
 
 bool DebuggerController::StepOver(BNFunctionGraphType il)
-{
-	if (!CanResumeTarget())
-		return false;
-
-	std::thread([&, il]() { StepOverAndWait(il); }).detach();
-
-	return true;
+{
+	// The step commands queued while the target is busy are merged into one that steps several times
+	return SubmitResumeCommand(
+		[this, il](size_t count) { return StepCommand([&]() { return StepOverIL(il); }, count); },
+		fmt::format("StepOver {}", il));
 }
 
 
 bool DebuggerController::StepOverReverse(BNFunctionGraphType il)
 {
-	if (!CanResumeTarget())
-		return false;
-
-	std::thread([&, il]() { StepOverReverseAndWait(il); }).detach();
-
-	return true;
+	// The step commands queued while the target is busy are merged into one that steps several times
+	return SubmitResumeCommand(
+		[this, il](size_t count) { return StepCommand([&]() { return StepOverReverseIL(il); }, count); },
+		fmt::format("StepOverReverse {}", il));
 }
 
 
 DebugStopReason DebuggerController::StepOverAndWait(BNFunctionGraphType il)
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
-
-	auto reason = StepOverIL(il);
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
-
-	m_targetControlMutex.unlock();
-	return reason;
+	return ExecuteCommandAndWait(
+		[this, il](size_t count) { return StepCommand([&]() { return StepOverIL(il); }, count); },
+		fmt::format("StepOver {}", il));
 }
 
 
 DebugStopReason DebuggerController::StepOverReverseAndWait(BNFunctionGraphType il)
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
-
-	auto reason = StepOverReverseIL(il);
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
-
-	m_targetControlMutex.unlock();
-	return reason;
+	return ExecuteCommandAndWait(
+		[this, il](size_t count) { return StepCommand([&]() { return StepOverReverseIL(il); }, count); },
+		fmt::format("StepOverReverse {}", il));
 }
 
 
@@ -955,58 +1706,93 @@ DebugStopReason DebuggerController::StepReturnReverseAndWaitInternal()
 
 bool DebuggerController::StepReturn()
 {
-	if (!CanResumeTarget())
-		return false;
-
-	std::thread([&]() { StepReturnAndWait(); }).detach();
-
-	return true;
+	return SubmitResumeCommand([this](size_t) { return StepReturnAndWait(); });
 }
 
 
 bool DebuggerController::StepReturnReverse()
 {
-	if (!CanResumeTarget())
-		return false;
+	return SubmitResumeCommand([this](size_t) { return StepReturnReverseAndWait(); });
+}
 
-	std::thread([&]() { StepReturnReverseAndWait(); }).detach();
 
-	return true;
+DebugStopReason DebuggerController::StepReturnAndWait()
+{
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = StepReturnAndWaitInternal();
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
 }
 
 
-DebugStopReason DebuggerController::StepReturnAndWait()
+DebugStopReason DebuggerController::StepReturnReverseAndWait()
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = StepReturnReverseAndWaitInternal();
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
+
+		return reason;
+	});
+}
 
-	auto reason = StepReturnAndWaitInternal();
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
 
-	m_targetControlMutex.unlock();
+DebugStopReason DebuggerController::RunToAndWaitInternal(const std::vector<uint64_t>& remoteAddresses)
+{
+	auto reason = RunToTemporaryBreakpointsAndWait(remoteAddresses);
+	NotifyStopped(reason);
 	return reason;
 }
 
 
-DebugStopReason DebuggerController::StepReturnReverseAndWait()
+bool DebuggerController::InterpretUntil(const std::vector<uint64_t>& remoteAddresses, DebugStopReason& reason)
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
+	// Give up on long-running code, running it on the target is fine then
+	static constexpr size_t MaxInterpretedInstructions = 4096;
 
-	auto reason = StepReturnReverseAndWaitInternal();
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
+	if (!Settings::Instance()->Get<bool>("debugger.interpretStraightLineCode"))
+		return false;
 
-	m_targetControlMutex.unlock();
-	return reason;
+	// Only the current thread is interpreted, while the other threads would also run on the target. The watchpoints,
+	// tracepoints, and coverage breakpoints would not be hit either.
+	if (!m_state->GetWatchpoints()->GetWatchpointList().empty() || !m_tracepoints->GetTracepoints().empty()
+		|| m_coverage->IsActive() || m_callTracer->IsActive() || m_syscallTrace->IsActive()
+		|| (m_state->GetThreads()->GetAllThreads().size() != 1))
+		return false;
+
+	DebuggerLLILInterpreter interpreter(m_state);
+	if (!interpreter.RunUntil(remoteAddresses, MaxInterpretedInstructions) || !interpreter.CanCommit())
+		return false;
+
+	reason = Breakpoint;
+	if (!interpreter.Commit())
+	{
+		// Part of the state may have been written, so the target is no longer at a consistent point
+		LogWarn("Failed to commit the interpreted code, the state of the target is inconsistent");
+		reason = InternalError;
+	}
+	else
+	{
+		m_interpretedInstructionCount += interpreter.GetInstructionCount();
+	}
+
+	m_state->MarkDirty();
+	return true;
 }
 
 
-DebugStopReason DebuggerController::RunToAndWaitInternal(const std::vector<uint64_t>& remoteAddresses)
+DebugStopReason DebuggerController::RunToTemporaryBreakpointsAndWait(const std::vector<uint64_t>& remoteAddresses)
 {
 	m_userRequestedBreak = false;
 
+	// Straight-line code is executed locally, which saves the round trips of resuming and stopping the target
+	DebugStopReason interpretedReason;
+	if (InterpretUntil(remoteAddresses, interpretedReason))
+		return interpretedReason;
+
 	for (uint64_t remoteAddress : remoteAddresses)
 	{
 		if (!m_state->GetBreakpoints()->ContainsAbsolute(remoteAddress))
@@ -1025,34 +1811,25 @@ DebugStopReason DebuggerController::RunToAndWaitInternal(const std::vector<uint6
 		}
 	}
 
-	NotifyStopped(reason);
 	return reason;
 }
 
 
 bool DebuggerController::RunTo(const std::vector<uint64_t>& remoteAddresses)
 {
-	// This is an API function of the debugger. We only do these checks at the API level.
-	if (!CanResumeTarget())
-		return false;
-
-	std::thread([&, remoteAddresses]() { RunToAndWait(remoteAddresses); }).detach();
-
-	return true;
+	return SubmitResumeCommand([this, remoteAddresses](size_t) { return RunToAndWait(remoteAddresses); });
 }
 
 
 DebugStopReason DebuggerController::RunToAndWait(const std::vector<uint64_t>& remoteAddresses)
 {
-	if (!m_targetControlMutex.try_lock())
-		return InternalError;
-
-	auto reason = RunToAndWaitInternal(remoteAddresses);
-	if (!m_userRequestedBreak && (reason != ProcessExited))
-		NotifyStopped(reason);
+	return ExecuteCommandAndWait([&](size_t) {
+		auto reason = RunToAndWaitInternal(remoteAddresses);
+		if (!m_userRequestedBreak && (reason != ProcessExited))
+			NotifyStopped(reason);
 
-	m_targetControlMutex.unlock();
-	return reason;
+		return reason;
+	});
 }
 
 
@@ -1085,7 +1862,7 @@ void DebuggerController::DetectLoadedModule()
 		// a while.
 		DebuggerEvent event;
 		event.type = ModuleLoadedEvent;
-		event.data.absoluteAddress = remoteBase;
+		event.data.setAbsoluteAddress() = remoteBase;
 		PostDebuggerEvent(event);
 	}
 	else
@@ -1164,7 +1941,7 @@ bool DebuggerController::Restart()
 	if (!m_state->IsConnected())
 		return false;
 
-	std::thread([&]() { RestartAndWait(); }).detach();
+	SubmitCommand([this](size_t) { return RestartAndWait(); });
 	return true;
 }
 
@@ -1174,8 +1951,10 @@ DebugStopReason DebuggerController::RestartAndWait()
 	if (!m_state->IsConnected())
 		return InvalidStatusOrOperation;
 
-	QuitAndWait();
-	return LaunchAndWait();
+	return ExecuteCommandAndWait([this](size_t) {
+		QuitAndWait();
+		return LaunchAndWait();
+	});
 }
 
 
@@ -1217,12 +1996,16 @@ void DebuggerController::Detach()
 	if (!m_state->IsConnected())
 		return;
 
+	m_commandQueue->CancelPending();
 	std::thread([&]() { DetachAndWait(); }).detach();
 }
 
 
 void DebuggerController::DetachAndWait()
 {
+	if (!m_commandQueue->IsExecutorThread())
+		m_commandQueue->CancelPending();
+
 	bool locked = false;
 	if (m_targetControlMutex.try_lock())
 		locked = true;
@@ -1246,12 +2029,17 @@ void DebuggerController::Quit()
 	if (!m_state->IsConnected())
 		return;
 
+	m_commandQueue->CancelPending();
 	std::thread([&]() { QuitAndWait(); }).detach();
 }
 
 
 void DebuggerController::QuitAndWait()
 {
+	// Restart runs this as a part of its command, and must not cancel the commands after it
+	if (!m_commandQueue->IsExecutorThread())
+		m_commandQueue->CancelPending();
+
 	bool locked = false;
 	if (m_targetControlMutex.try_lock())
 		locked = true;
@@ -1281,6 +2069,7 @@ bool DebuggerController::Pause()
 	if (!(m_state->IsConnected() && m_state->IsRunning()))
 		return false;
 
+	m_commandQueue->CancelPending();
 	std::thread([&]() { PauseAndWait(); }).detach();
 
 	return true;
@@ -1296,6 +2085,9 @@ DebugStopReason DebuggerController::PauseAndWaitInternal()
 
 DebugStopReason DebuggerController::PauseAndWait()
 {
+	if (!m_commandQueue->IsExecutorThread())
+		m_commandQueue->CancelPending();
+
 	auto reason = PauseAndWaitInternal();
 	NotifyStopped(reason);
 	return reason;
@@ -1332,34 +2124,19 @@ DebugStopReason DebuggerController::EmulateStepOverAndWait()
 	if (!remoteArch)
 		return InternalError;
 
-	size_t size = remoteArch->GetMaxInstructionLength();
-	DataBuffer buffer = m_adapter->ReadMemory(remoteIP, size);
-	size_t bytesRead = buffer.GetLength();
-
-	Ref<LowLevelILFunction> ilFunc = new LowLevelILFunction(remoteArch, nullptr);
-	ilFunc->SetCurrentAddress(remoteArch, remoteIP);
-	remoteArch->GetInstructionLowLevelIL((const uint8_t*)buffer.GetData(), remoteIP, bytesRead, *ilFunc);
+	// Whenever there is a failure, we fail back to step into
+	auto instruction = m_state->DecodeInstruction(remoteIP, true);
+	if (!instruction || !instruction->m_llil)
+		return StepIntoAndWaitInternal();
 
-	const auto& instr = (*ilFunc)[0];
+	const auto& instr = (*instruction->m_llil)[0];
 	if (instr.operation != LLIL_CALL)
 	{
 		return StepIntoAndWaitInternal();
 	}
 	else
 	{
-		InstructionInfo info;
-		if (!remoteArch->GetInstructionInfo((const uint8_t*)buffer.GetData(), remoteIP, bytesRead, info))
-		{
-			// Whenever there is a failure, we fail back to step into
-			return StepIntoAndWaitInternal();
-		}
-
-		if (info.length == 0)
-		{
-			return StepIntoAndWaitInternal();
-		}
-
-		uint64_t remoteIPNext = remoteIP + info.length;
+		uint64_t remoteIPNext = remoteIP + instruction->GetLength();
 		return RunToAndWaitInternal({remoteIPNext});
 	}
 }
@@ -1537,18 +2314,20 @@ void DebuggerController::EventHandler(const DebuggerEvent& event)
 	case ResumeEventType:
 	case StepIntoEventType:
 	{
+		m_stopEpoch++;
 		// Todo: this is just a temporary workaround. Otherwise, the connection status would not be set properly
 		m_state->SetConnectionStatus(DebugAdapterConnectedStatus);
 		m_state->SetExecutionStatus(DebugAdapterRunningStatus);
 		break;
 	}
 	case TargetExitedEventType:
-		m_exitCode = event.data.exitData.exitCode;
+		m_exitCode = event.data.exitData().exitCode;
 		m_state->MarkDirty();
 	case QuitDebuggingEventType:
 	case DetachedEventType:
 	case LaunchFailureEventType:
 	{
+		m_stopEpoch++;
 		m_inputFileLoaded = false;
 		m_initialBreakpointSeen = false;
 		RemoveDebuggerMemoryRegion();
@@ -1559,27 +2338,47 @@ void DebuggerController::EventHandler(const DebuggerEvent& event)
 		}
 		m_lastIP = m_currentIP;
 		m_currentIP = 0;
+		m_coverage->Stop();
+		m_callTracer->Stop();
+		m_syscallTrace->Stop();
+		// The adapter drops the internal breakpoints when the target exits, and the addresses may change on relaunch
+		m_tracepoints->Flush();
+		m_tracepoints->Clear();
+		m_state->GetWatchpoints()->Clear();
 		m_state->SetConnectionStatus(DebugAdapterNotConnectedStatus);
 		m_state->SetExecutionStatus(DebugAdapterInvalidStatus);
 		break;
 	}
 	case TargetStoppedEventType:
 	{
+		m_stopEpoch++;
+		// Make sure the tracepoint logs show up before the stop
+		m_tracepoints->Flush();
 		m_state->MarkDirty();
-		m_state->UpdateCaches();
+		// Only the registers of the active thread are read here. The threads, frames and modules are read lazily, or
+		// by the deferred stages once the stop is delivered.
+		m_state->GetRegisters()->Update();
 		m_state->SetConnectionStatus(DebugAdapterConnectedStatus);
 		m_state->SetExecutionStatus(DebugAdapterPausedStatus);
 		m_lastIP = m_currentIP;
 		m_currentIP = m_state->IP();
 
+		// A coverage breakpoint that shares its address with a user breakpoint is reported as a normal stop
+		if (m_coverage->RecordHit(m_currentIP))
+			ReleaseInternalBreakpoint(m_currentIP);
+
+		UpdateBreakpointConditions();
+		// This only reads the modules until the input file is found, and the UI must rebase the view before it shows
+		// the first stop
 		DetectLoadedModule();
-		UpdateStackVariables();
+		// Only the registers that changed are sent, so scripts can use them in expressions once the wait returns
 		AddRegisterValuesToExpressionParser();
 		break;
 	}
 	case ActiveThreadChangedEvent:
 	{
-		m_state->UpdateCaches();
+		// SetActiveThread() has already read the registers of the new thread
+		m_exprValueCache->Clear();
 		m_lastIP = m_currentIP;
 		m_currentIP = m_state->IP();
 		AddRegisterValuesToExpressionParser();
@@ -1587,6 +2386,7 @@ void DebuggerController::EventHandler(const DebuggerEvent& event)
 	}
 	case RegisterChangedEvent:
 	{
+		m_exprValueCache->Clear();
 		m_lastIP = m_currentIP;
 		m_currentIP = m_state->IP();
 		AddRegisterValuesToExpressionParser();
@@ -1594,7 +2394,7 @@ void DebuggerController::EventHandler(const DebuggerEvent& event)
 	}
 	case ErrorEventType:
 	{
-		LogError("%s", event.data.errorData.error.c_str());
+		LogError("%s", event.data.errorData().error.c_str());
 		break;
 	}
 	default:
@@ -1603,99 +2403,209 @@ void DebuggerController::EventHandler(const DebuggerEvent& event)
 }
 
 
-size_t DebuggerController::RegisterEventCallback(
-	std::function<void(const DebuggerEvent&)> callback, const std::string& name)
+size_t DebuggerController::RegisterEventCallback(std::function<void(const DebuggerEvent&)> callback,
+	const std::string& name, DebuggerEventDelivery delivery, uint64_t eventMask)
 {
-	std::unique_lock<std::recursive_mutex> lock(m_callbackMutex);
 	DebuggerEventCallback object;
 	object.function = callback;
 	object.index = m_callbackIndex++;
 	object.name = name;
-	m_eventCallbacks.push_back(object);
+	object.delivery = delivery;
+	object.eventMask = eventMask;
+	object.enabled = std::make_shared<std::atomic<bool>>(true);
+
+	std::unique_lock<std::mutex> lock(m_callbackMutex);
+	auto callbacks = std::make_shared<DebuggerEventCallbackList>(*m_eventCallbacks);
+	callbacks->Add(object);
+	m_eventCallbacks = callbacks;
 	return object.index;
 }
 
 
 bool DebuggerController::RemoveEventCallback(size_t index)
 {
-	std::unique_lock<std::recursive_mutex> lock(m_callbackMutex);
-	m_disabledCallbacks.insert(index);
-	return RemoveEventCallbackInternal(index);
-}
-
-
-bool DebuggerController::RemoveEventCallbackInternal(size_t index)
-{
-	for (auto it = m_eventCallbacks.begin(); it != m_eventCallbacks.end(); it++)
+	std::unique_lock<std::mutex> lock(m_callbackMutex);
+	auto callbacks = std::make_shared<DebuggerEventCallbackList>();
+	bool found = false;
+	bool asynchronous = false;
+	for (const auto& cb : m_eventCallbacks->m_callbacks)
 	{
-		if (it->index == index)
+		if (cb.index == index)
 		{
-			m_eventCallbacks.erase(it);
-			return true;
+			// The events that are already posted may still hold the old list
+			cb.enabled->store(false);
+			found = true;
+			asynchronous = (cb.delivery != SynchronousEventDelivery);
+			continue;
 		}
+
+		callbacks->Add(cb);
 	}
-	return false;
+	m_eventCallbacks = callbacks;
+	lock.unlock();
+
+	// Make sure the callback is not running on the dispatcher thread once this returns, so its owner can go away
+	if (asynchronous && m_eventDispatcher)
+		m_eventDispatcher->WaitForDelivery();
+
+	return found;
+}
+
+
+void DebuggerController::FlushEventCallbacks()
+{
+	if (m_eventDispatcher)
+		m_eventDispatcher->Flush();
 }
 
 
-void DebuggerController::PostDebuggerEvent(const DebuggerEvent& event)
+void DebuggerController::PostDebuggerEvent(DebuggerEvent event)
 {
-	std::unique_lock<std::recursive_mutex> callbackLock(m_callbackMutex);
-	std::list<DebuggerEventCallback> eventCallbacks = m_eventCallbacks;
-	callbackLock.unlock();
+	DebuggerEventCallbackListRef eventCallbacks;
+	{
+		std::unique_lock<std::mutex> callbackLock(m_callbackMutex);
+		eventCallbacks = m_eventCallbacks;
+	}
 
 	if (event.type == AdapterStoppedEventType)
 		m_lastAdapterStopEventConsumed = false;
 
-	ExecuteOnMainThreadAndWait([&]() {
-		DebuggerEvent eventToSend = event;
-		if ((eventToSend.type == TargetStoppedEventType) && !m_initialBreakpointSeen)
+	DebuggerEvent stopEvent;
+	bool sendStopEvent = false;
+	auto deliver = [&]() {
+		bool delivering = t_deliveringEvents;
+		t_deliveringEvents = true;
+		if ((event.type == TargetStoppedEventType) && !m_initialBreakpointSeen)
 		{
 			m_initialBreakpointSeen = true;
-			eventToSend.data.targetStoppedData.reason = InitialBreakpoint;
+			event.data.setTargetStoppedData().reason = InitialBreakpoint;
 		}
 
-		for (const DebuggerEventCallback& cb : eventCallbacks)
+		for (const DebuggerEventCallback& cb : eventCallbacks->m_callbacks)
 		{
-			if (m_disabledCallbacks.find(cb.index) != m_disabledCallbacks.end())
+			if ((cb.delivery != SynchronousEventDelivery) || !DebuggerEventMaskContains(cb.eventMask, event.type)
+				|| !cb.enabled->load())
 				continue;
 
-			cb.function(eventToSend);
+			cb.function(event);
 		}
 
 		// If the current event is an AdapterStoppedEvent, and it is not consumed by any callback, then the adapter
 		// stop is not caused by the debugger core. Notify a target stop reason in this case.
 		if (event.type == AdapterStoppedEventType && !m_lastAdapterStopEventConsumed)
 		{
-			DebuggerEvent stopEvent = event;
+			stopEvent = event;
 			stopEvent.type = TargetStoppedEventType;
 			if (!m_initialBreakpointSeen)
 			{
 				m_initialBreakpointSeen = true;
-				stopEvent.data.targetStoppedData.reason = InitialBreakpoint;
+				stopEvent.data.setTargetStoppedData().reason = InitialBreakpoint;
 			}
-			for (const DebuggerEventCallback& cb : eventCallbacks)
+			sendStopEvent = true;
+			for (const DebuggerEventCallback& cb : eventCallbacks->m_callbacks)
 			{
-				if (m_disabledCallbacks.find(cb.index) != m_disabledCallbacks.end())
+				if ((cb.delivery != SynchronousEventDelivery)
+					|| !DebuggerEventMaskContains(cb.eventMask, TargetStoppedEventType) || !cb.enabled->load())
 					continue;
 
 				cb.function(stopEvent);
 			}
 		}
-	});
+		t_deliveringEvents = delivering;
+	};
+
+	// Only the UI needs the callbacks to run on the main thread. Headless sessions call them right away.
+	if (BinaryNinja::IsUIEnabled())
+		ExecuteOnMainThreadAndWait(deliver);
+	else
+		deliver();
+
+	// The events posted while the controller is being destroyed only reach the synchronous callbacks
+	if (!m_eventDispatcher)
+		return;
+
+	bool stopped = (event.type == TargetStoppedEventType) || sendStopEvent;
+	uint64_t epoch = m_stopEpoch;
+	m_eventDispatcher->Post(std::move(event), eventCallbacks);
+	if (sendStopEvent)
+		m_eventDispatcher->Post(std::move(stopEvent), eventCallbacks);
+
+	if (stopped)
+		QueueDeferredStopStages(epoch);
+}
+
+
+void DebuggerController::QueueDeferredStopStages(uint64_t epoch)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_stopStagesMutex);
+		if (m_quitStopStagesThread)
+			return;
+
+		// A newer stop replaces the one that is still waiting
+		m_stopStagesPending = true;
+		m_stopStagesEpoch = epoch;
+	}
+	m_stopStagesCv.notify_one();
+}
+
+
+void DebuggerController::StopStagesThread()
+{
+	std::unique_lock<std::mutex> lock(m_stopStagesMutex);
+	while (true)
+	{
+		m_stopStagesCv.wait(lock, [&]() { return m_quitStopStagesThread || m_stopStagesPending; });
+		if (m_quitStopStagesThread)
+			break;
+
+		uint64_t epoch = m_stopStagesEpoch;
+		m_stopStagesPending = false;
+		lock.unlock();
+		RunDeferredStopStages(epoch);
+		lock.lock();
+	}
+}
+
 
-	CleanUpDisabledEvent();
+bool DebuggerController::IsStopOutdated(uint64_t epoch)
+{
+	// The results would be thrown away once the target is resumed or stops again, or a command that resumes it waits
+	return (m_stopEpoch != epoch) || (m_commandQueue->GetPendingCount() > 0) || !m_state->IsConnected();
 }
 
 
-void DebuggerController::CleanUpDisabledEvent()
+void DebuggerController::RunDeferredStopStages(uint64_t epoch)
 {
-	std::unique_lock<std::recursive_mutex> lock(m_callbackMutex);
-	for (const auto index : m_disabledCallbacks)
+	// The stages run in the order of how soon their results are likely to be needed. Each of them is skipped once the
+	// stop is outdated, and the thread and module updates also give up between the adapter calls they make. The
+	// threads and modules skipped here are read when they are needed, and the stack variables are annotated again on
+	// the next stop. Each stage holds m_targetControlMutex, so it does not use the adapter while a command does.
+	auto isOutdated = [this, epoch]() { return IsStopOutdated(epoch); };
+	const std::function<void()> stages[] = {
+		[&]() {
+			if (m_state->GetThreads()->IsDirty())
+				m_state->GetThreads()->Update(isOutdated);
+		},
+		[&]() {
+			if (m_state->GetModules()->IsDirty())
+				m_state->GetModules()->Update(isOutdated);
+		},
+		[this]() { UpdateStackVariables(); },
+	};
+
+	for (const auto& stage : stages)
 	{
-		RemoveEventCallbackInternal(index);
+		if (isOutdated())
+			return;
+
+		std::unique_lock<std::recursive_mutex> lock(m_targetControlMutex);
+		// A command may have resumed the target while this waited for the mutex
+		if (isOutdated())
+			return;
+
+		stage();
 	}
-	m_disabledCallbacks.clear();
 }
 
 
@@ -1703,8 +2613,8 @@ void DebuggerController::NotifyStopped(DebugStopReason reason, void* data)
 {
 	DebuggerEvent event;
 	event.type = TargetStoppedEventType;
-	event.data.targetStoppedData.reason = reason;
-	event.data.targetStoppedData.data = data;
+	event.data.setTargetStoppedData().reason = reason;
+	event.data.setTargetStoppedData().data = data;
 	PostDebuggerEvent(event);
 }
 
@@ -1713,9 +2623,9 @@ void DebuggerController::NotifyError(const std::string& error, const std::string
 {
 	DebuggerEvent event;
 	event.type = ErrorEventType;
-	event.data.errorData.error = error;
-	event.data.errorData.shortError = shortError;
-	event.data.errorData.data = data;
+	event.data.setErrorData().error = error;
+	event.data.setErrorData().shortError = shortError;
+	event.data.setErrorData().data = data;
 	PostDebuggerEvent(event);
 }
 
@@ -1760,7 +2670,9 @@ bool DebuggerController::WriteMemory(std::uintptr_t address, const DataBuffer& b
 	if (!memory)
 		return false;
 
-	return memory->WriteMemory(address, buffer);
+	bool ok = memory->WriteMemory(address, buffer);
+	m_exprValueCache->Clear();
+	return ok;
 }
 
 
@@ -1865,40 +2777,31 @@ std::string DebuggerController::InvokeBackendCommand(const std::string& cmd)
 }
 
 
-void DebuggerController::ProcessOneVariable(uint64_t varAddress, Confidence<Ref<Type>> type, const std::string& name)
-{
-	StackVariableNameAndType varNameAndType(type, name);
-	auto iter = m_debuggerVariables.find(varAddress);
-	if ((iter == m_debuggerVariables.end()) || (iter->second != varNameAndType))
-	{
-		// The variable is not yet defined, or has changed. Define it.
-		// Should we use DataVariable, or UserDataVariable?
-		GetData()->DefineDataVariable(varAddress, type);
-		if (!name.empty())
-		{
-			SymbolRef sym = new Symbol(DataSymbol, name, name, name, varAddress);
-			GetData()->DefineUserSymbol(sym);
-		}
-		m_debuggerVariables[varAddress] = varNameAndType;
-	}
+// Pointers are followed this many levels deep at most, and a stack frame visits at most this many variables and members
+static constexpr size_t StackVariableMaxDepth = 8;
+static constexpr size_t StackVariableFrameBudget = 4096;
 
-	m_addressesWithVariable.insert(varAddress);
 
-	// If there is still a data variable at varAddress, we remove it from the oldAddresses set.
-	// After we process all data variables, values in the set oldAddresses means where there was a data var,
-	// but there no longer should be one. Later we iterate over it and remove all data vars and symbols at
-	// these addresses.
-	auto iter2 = m_oldAddresses.find(varAddress);
-	if (iter2 != m_oldAddresses.end())
-		m_oldAddresses.erase(iter2);
+void DebuggerController::ProcessOneVariable(
+	StackVariableWalk& walk, uint64_t varAddress, Confidence<Ref<Type>> type, const std::string& name)
+{
+	walk.variables.emplace_back(varAddress, StackVariableNameAndType(type, name));
 }
 
 
-void DebuggerController::DefineVariablesRecursive(uint64_t address, Confidence<Ref<Type>> type)
+void DebuggerController::DefineVariablesRecursive(
+	StackVariableWalk& walk, uint64_t address, Confidence<Ref<Type>> type, size_t depth)
 {
+	if (walk.budget == 0)
+		return;
+	walk.budget--;
+
 	size_t addressSize = GetData()->GetAddressSize();
 	if (type->IsPointer())
 	{
+		if (depth >= StackVariableMaxDepth)
+			return;
+
 		auto reader = BinaryReader(GetData());
 		reader.Seek(address);
 		uint64_t targetAddress = 0;
@@ -1914,32 +2817,31 @@ void DebuggerController::DefineVariablesRecursive(uint64_t address, Confidence<R
 			if (readOk)
 				targetAddress = addr;
 		}
-		if (readOk)
+		if (readOk && walk.visited.insert(targetAddress).second)
 		{
 			// Define a data variable for the child
-			ProcessOneVariable(targetAddress, type->GetChildType(), "");
+			ProcessOneVariable(walk, targetAddress, type->GetChildType(), "");
 			// Recurse into the child
-			DefineVariablesRecursive(targetAddress, type->GetChildType());
+			DefineVariablesRecursive(walk, targetAddress, type->GetChildType(), depth + 1);
 		}
 	}
 	else if (type->IsStructure())
 	{
 		auto structure = type->GetStructure();
 		auto members = structure->GetMembers();
-		auto memberType = type->GetChildType();
-		for (size_t i = 0; i < members.size(); i++)
+		for (size_t i = 0; (i < members.size()) && (walk.budget > 0); i++)
 		{
 			uint64_t memberOffset = address + members[i].offset;
-			DefineVariablesRecursive(memberOffset, members[i].type);
+			DefineVariablesRecursive(walk, memberOffset, members[i].type, depth);
 		}
 	}
 	else if (type->IsArray())
 	{
 		auto memberType = type->GetChildType();
-		for (size_t i = 0; i < type->GetElementCount(); i++)
+		for (size_t i = 0; (i < type->GetElementCount()) && (walk.budget > 0); i++)
 		{
 			uint64_t memberOffset = address + i * memberType->GetWidth();
-			DefineVariablesRecursive(memberOffset, memberType);
+			DefineVariablesRecursive(walk, memberOffset, memberType, depth);
 		}
 	}
 }
@@ -1953,20 +2855,27 @@ void DebuggerController::UpdateStackVariables()
 	if (!GetData())
 		return;
 
-	auto id = GetData()->BeginUndoActions();
-	std::vector<DebugThread> threads = GetAllThreads();
-	uint64_t frameAdjustment = 0;
 	if (!GetData()->GetDefaultArchitecture())
 		return;
 
+	auto start = std::chrono::steady_clock::now();
+	uint64_t frameAdjustment = 0;
 	std::string archName = GetData()->GetDefaultArchitecture()->GetName();
 	if ((archName == "x86") || (archName == "x86_64"))
 		frameAdjustment = 8;
 
-	m_oldAddresses = m_addressesWithVariable;
-	m_addressesWithVariable.clear();
-	auto oldAddressWithComment = m_addressesWithComment;
-	m_addressesWithComment.clear();
+	std::set<uint64_t> updatedFunctions;
+	{
+		std::unique_lock<std::mutex> lock(m_updatedStackFunctionsMutex);
+		updatedFunctions.swap(m_updatedStackFunctions);
+	}
+
+	// Only the variables of the frames that are new since the last stop are looked up. The others keep the variables
+	// found back then.
+	std::map<std::pair<uint64_t, uint64_t>, std::vector<std::pair<uint64_t, StackVariableNameAndType>>> frameVariables;
+	std::map<uint64_t, StackVariableNameAndType> variables;
+	std::map<uint64_t, std::string> comments;
+	size_t lookedUpFrames = 0;
 
 	const DebugThread thread = GetActiveThread();
 	std::vector<DebugFrame> frames = GetFramesOfThread(thread.m_tid);
@@ -1976,82 +2885,142 @@ void DebuggerController::UpdateStackVariables()
 		{
 			const DebugFrame& frame = frames[i];
 			const DebugFrame& prevFrame = frames[i + 1];
-			// If there is no function at a stacktrace function start, add one
-			auto functions = GetData()->GetAnalysisFunctionsForAddress(frame.m_functionStart);
-			if (functions.empty())
+			auto key = std::make_pair(frame.m_functionStart, prevFrame.m_sp);
+			if (frameVariables.find(key) != frameVariables.end())
 				continue;
 
-			FunctionRef func = functions[0];
-
-			auto vars = func->GetVariables();
-			// BN's variable storage offset is calculated against the entry status of the function, i.e.,
-			// before the current stack frame is created. Here we take the stack pointer of the previous stack frame,
-			// and subtract the size of return address from it
-			uint64_t framePointer = prevFrame.m_sp - frameAdjustment;
-			for (const auto& [var, varNameAndType] : vars)
+			auto& frameVars = frameVariables[key];
+			auto cached = m_stackFrameVariables.find(key);
+			if ((cached != m_stackFrameVariables.end()) && (updatedFunctions.count(frame.m_functionStart) == 0))
 			{
-				if (var.type != StackVariableSourceType)
-					continue;
+				frameVars = std::move(cached->second);
+			}
+			else
+			{
+				lookedUpFrames++;
+				// If there is no function at a stacktrace function start, add one
+				auto functions = GetData()->GetAnalysisFunctionsForAddress(frame.m_functionStart);
+				if (!functions.empty())
+				{
+					FunctionRef func = functions[0];
+					auto vars = func->GetVariables();
+					// BN's variable storage offset is calculated against the entry status of the function, i.e.,
+					// before the current stack frame is created. Here we take the stack pointer of the previous stack
+					// frame, and subtract the size of return address from it
+					uint64_t framePointer = prevFrame.m_sp - frameAdjustment;
+					for (const auto& [var, varNameAndType] : vars)
+					{
+						if (var.type != StackVariableSourceType)
+							continue;
+
+						uint64_t varAddress = framePointer + var.storage;
+						frameVars.emplace_back(
+							varAddress, StackVariableNameAndType(varNameAndType.type, varNameAndType.name));
+					}
+				}
+			}
 
-				uint64_t varAddress = framePointer + var.storage;
-				ProcessOneVariable(varAddress, varNameAndType.type, varNameAndType.name);
-				DefineVariablesRecursive(varAddress, varNameAndType.type);
+			// The pointers in the frame are read from the current memory
+			StackVariableWalk walk;
+			walk.budget = StackVariableFrameBudget;
+			for (const auto& [varAddress, var] : frameVars)
+			{
+				ProcessOneVariable(walk, varAddress, var.type, var.name);
+				DefineVariablesRecursive(walk, varAddress, var.type, 0);
 			}
+			for (const auto& [address, var] : walk.variables)
+				variables[address] = var;
 		}
 
 		for (const DebugFrame& frame : frames)
 		{
 			// Annotate the stack pointer and the frame pointer, using the current stack frame
-			GetData()->SetCommentForAddress(frame.m_sp, fmt::format("Stack #{}\n====================", frame.m_index));
-			GetData()->SetCommentForAddress(frame.m_fp, fmt::format("Frame #{}", frame.m_index));
-			m_addressesWithComment.insert(frame.m_sp);
-			m_addressesWithComment.insert(frame.m_fp);
-
-			auto iter2 = oldAddressWithComment.find(frame.m_sp);
-			if (iter2 != oldAddressWithComment.end())
-				oldAddressWithComment.erase(iter2);
-
-			iter2 = oldAddressWithComment.find(frame.m_fp);
-			if (iter2 != oldAddressWithComment.end())
-				oldAddressWithComment.erase(iter2);
+			comments[frame.m_sp] = fmt::format("Stack #{}\n====================", frame.m_index);
+			comments[frame.m_fp] = fmt::format("Frame #{}", frame.m_index);
 		}
 	}
 
-	for (uint64_t address : m_oldAddresses)
+	m_stackFrameVariables = std::move(frameVariables);
+
+	// Apply the differences to the view in one batch, so the symbol notifications are sent once
+	size_t defined = 0;
+	size_t undefined = 0;
+	auto id = GetData()->BeginUndoActions();
+	GetData()->BeginBulkModifySymbols();
+	for (const auto& [address, var] : m_debuggerVariables)
 	{
-		auto iter = m_addressesWithVariable.find(address);
-		if (iter != m_addressesWithVariable.end())
-			m_addressesWithVariable.erase(iter);
+		auto iter = variables.find(address);
+		if ((iter != variables.end()) && (iter->second == var))
+			continue;
 
+		undefined++;
 		GetData()->UndefineDataVariable(address);
 		auto symbol = GetData()->GetSymbolByAddress(address);
 		if (symbol)
 			GetData()->UndefineUserSymbol(symbol);
 	}
 
-	for (uint64_t address : oldAddressWithComment)
+	for (const auto& [address, var] : variables)
+	{
+		auto iter = m_debuggerVariables.find(address);
+		if ((iter != m_debuggerVariables.end()) && (iter->second == var))
+			continue;
+
+		defined++;
+		// Should we use DataVariable, or UserDataVariable?
+		GetData()->DefineDataVariable(address, var.type);
+		if (!var.name.empty())
+		{
+			SymbolRef sym = new Symbol(DataSymbol, var.name, var.name, var.name, address);
+			GetData()->DefineUserSymbol(sym);
+		}
+	}
+	GetData()->EndBulkModifySymbols();
+
+	for (const auto& [address, comment] : m_stackComments)
+	{
+		if (comments.find(address) == comments.end())
+			GetData()->SetCommentForAddress(address, "");
+	}
+
+	for (const auto& [address, comment] : comments)
 	{
-		GetData()->SetCommentForAddress(address, "");
+		auto iter = m_stackComments.find(address);
+		if ((iter == m_stackComments.end()) || (iter->second != comment))
+			GetData()->SetCommentForAddress(address, comment);
 	}
 	GetData()->ForgetUndoActions(id);
+
+	m_debuggerVariables = std::move(variables);
+	m_stackComments = std::move(comments);
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	LogDebug("Stack variable annotation took %.3f ms: %zu of %zu frames looked up, %zu variables defined, "
+		"%zu undefined", elapsed.count() / 1000.0, lookedUpFrames, m_stackFrameVariables.size(), defined, undefined);
 }
 
 
 void DebuggerController::AddRegisterValuesToExpressionParser()
 {
-	auto regs = GetAllRegisters();
+	// Only the registers whose values changed since the last call are sent. A single step usually changes a few.
 	std::vector<std::string> names;
-	names.reserve(regs.size());
 	std::vector<uint64_t> values;
-	values.reserve(regs.size());
+	std::unique_lock<std::mutex> lock(m_expressionParserMutex);
+	m_state->GetRegisters()->VisitRegisters([&](const DebugRegister& reg) {
+		auto [iter, inserted] = m_expressionParserValues.try_emplace(reg.m_name, reg.m_value);
+		if (!inserted)
+		{
+			if (iter->second == reg.m_value)
+				return;
+			iter->second = reg.m_value;
+		}
 
-	for (const auto& reg: regs)
-	{
-		names.push_back(std::string(reg.m_name));
-		values.emplace_back(reg.m_value);
-	}
+		names.push_back(reg.m_name);
+		values.push_back(reg.m_value);
+	});
 
-	GetData()->AddExpressionParserMagicValues(names, values);
+	if (!names.empty())
+		GetData()->AddExpressionParserMagicValues(names, values);
 }
 
 
@@ -2161,6 +3130,10 @@ std::string DebuggerController::GetStopReasonString(DebugStopReason reason)
 		return "UserRequestedBreak";
 	case OperationNotSupported:
 		return "OperationNotSupported";
+	case Watchpoint:
+		return "Watchpoint";
+	case OperationTimedOut:
+		return "OperationTimedOut";
 	default:
 		return "";
 	}
@@ -2182,25 +3155,39 @@ DebugStopReason DebuggerController::ExecuteAdapterAndWait(const DebugAdapterOper
 	// If this is a pause operation, do not try to lock the mutex -- it is mostly likely held by another thread
 	if ((operation != DebugAdapterPause) && (operation != DebugAdapterQuit) && (operation != DebugAdapterDetach)
 		&& !m_adapterMutex.try_lock())
-		throw std::runtime_error("Cannot obtain mutex for debug adapter");
+	{
+		LogWarn("Cannot obtain mutex for debug adapter");
+		return InternalError;
+	}
 
-	Semaphore sem;
-	DebugStopReason reason = UnknownReason;
+	// A cancelled command, e.g., one that steps repeatedly, must not start another operation
+	if ((operation != DebugAdapterPause) && (operation != DebugAdapterQuit) && (operation != DebugAdapterDetach)
+		&& m_commandQueue->IsExecutorThread())
+	{
+		auto token = m_commandQueue->GetRunningToken();
+		if (token && token->IsCancelled())
+		{
+			m_adapterMutex.unlock();
+			return UserRequestedBreak;
+		}
+	}
+
+	auto wait = std::make_shared<AdapterStopWait>();
 	size_t callback = RegisterEventCallback(
-		[&](const DebuggerEvent& event) {
+		[this, wait](const DebuggerEvent& event) {
 			switch (event.type)
 			{
 			case AdapterStoppedEventType:
-				reason = event.data.targetStoppedData.reason;
-				sem.Release();
+				wait->m_reason = event.data.targetStoppedData().reason;
+				wait->m_sem.Release();
 				break;
 			// It is a little awkward to add two cases for these events, but we must take them into account,
 			// since after we resume the target, the target can either or exit.
 			case TargetExitedEventType:
 			case DetachedEventType:
 				// There is no DebugStopReason for "detach", so we use ProcessExited for now
-				reason = ProcessExited;
-				sem.Release();
+				wait->m_reason = ProcessExited;
+				wait->m_sem.Release();
 				break;
 			default:
 				break;
@@ -2237,6 +3224,9 @@ DebugStopReason DebuggerController::ExecuteAdapterAndWait(const DebugAdapterOper
 	case DebugAdapterStepReturnReverse:
 		resumeOK = m_adapter->StepReturnReverse();
 		break;
+	case DebugAdapterTraceInstructions:
+		resumeOK = m_adapter->TraceInstructions(m_silentStepHandler);
+		break;
 	case DebugAdapterPause:
 		operationRequested = m_adapter->BreakInto();
 		break;
@@ -2262,7 +3252,8 @@ DebugStopReason DebuggerController::ExecuteAdapterAndWait(const DebugAdapterOper
 	bool ok = false;
 	if ((operation == DebugAdapterGo) || (operation == DebugAdapterStepInto) || (operation == DebugAdapterStepOver)
 		|| (operation == DebugAdapterStepReturn) || (operation == DebugAdapterLaunch)
-		|| (operation == DebugAdapterConnect) || (operation == DebugAdapterAttach))
+		|| (operation == DebugAdapterConnect) || (operation == DebugAdapterAttach)
+		|| (operation == DebugAdapterTraceInstructions))
 	{
 		ok = resumeOK;
 	}
@@ -2275,10 +3266,9 @@ DebugStopReason DebuggerController::ExecuteAdapterAndWait(const DebugAdapterOper
 		ok = true;
 	}
 
+	DebugStopReason reason = InternalError;
 	if (ok)
-		sem.Wait();
-	else
-		reason = InternalError;
+		reason = WaitForAdapterStop(*wait, operation);
 
 	RemoveEventCallback(callback);
 	if ((operation != DebugAdapterPause) && (operation != DebugAdapterQuit) && (operation != DebugAdapterDetach))
@@ -2287,6 +3277,97 @@ DebugStopReason DebuggerController::ExecuteAdapterAndWait(const DebugAdapterOper
 }
 
 
+static const char* GetAdapterOperationName(DebugAdapterOperation operation)
+{
+	switch (operation)
+	{
+	case DebugAdapterLaunch:
+		return "launch";
+	case DebugAdapterAttach:
+		return "attach";
+	case DebugAdapterConnect:
+		return "connect";
+	case DebugAdapterGo:
+		return "go";
+	case DebugAdapterGoReverse:
+		return "go reverse";
+	case DebugAdapterStepInto:
+		return "step into";
+	case DebugAdapterStepIntoReverse:
+		return "step into reverse";
+	case DebugAdapterStepOver:
+		return "step over";
+	case DebugAdapterStepOverReverse:
+		return "step over reverse";
+	case DebugAdapterStepReturn:
+		return "step return";
+	case DebugAdapterStepReturnReverse:
+		return "step return reverse";
+	case DebugAdapterTraceInstructions:
+		return "trace instructions";
+	case DebugAdapterPause:
+		return "pause";
+	case DebugAdapterQuit:
+		return "quit";
+	case DebugAdapterDetach:
+		return "detach";
+	default:
+		return "unknown";
+	}
+}
+
+
+DebugStopReason DebuggerController::WaitForAdapterStop(AdapterStopWait& wait, DebugAdapterOperation operation)
+{
+	// The wait wakes up periodically to check the cancellation, the timeout and the watchdog
+	static constexpr std::chrono::milliseconds WaitInterval(100);
+	// How long to wait for the target to stop after breaking into it
+	static constexpr std::chrono::milliseconds BreakIntoTimeout(5000);
+
+	auto token = m_commandQueue->IsExecutorThread() ? m_commandQueue->GetRunningToken() : nullptr;
+	uint64_t timeout = m_operationTimeout;
+	// Resuming the target can legitimately take forever, so the watchdog only looks at the other operations
+	bool watch = (operation != DebugAdapterGo) && (operation != DebugAdapterGoReverse);
+	double stallThreshold = Settings::Instance()->Get<double>("debugger.stallWarningThreshold");
+	double nextStallWarning = stallThreshold;
+
+	auto start = std::chrono::steady_clock::now();
+	while (!wait.m_sem.WaitFor(WaitInterval))
+	{
+		auto now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(now - start).count();
+		bool cancelled = token && token->IsCancelled();
+		bool timedOut = (timeout != 0) && (elapsed * 1000 >= timeout);
+		if (cancelled || timedOut)
+		{
+			if (timedOut)
+				LogWarn("The %s operation did not finish within the %" PRIu64 " ms timeout",
+					GetAdapterOperationName(operation), timeout);
+
+			// Leave the target stopped, so the next operation starts from a known state
+			if ((operation != DebugAdapterPause) && (operation != DebugAdapterQuit)
+				&& (operation != DebugAdapterDetach))
+			{
+				if (!m_adapter->BreakInto() || !wait.m_sem.WaitFor(BreakIntoTimeout))
+					LogWarn("The target did not stop after the %s operation was %s",
+						GetAdapterOperationName(operation), cancelled ? "cancelled" : "timed out");
+			}
+			return cancelled ? UserRequestedBreak : OperationTimedOut;
+		}
+
+		if (watch && (stallThreshold > 0) && (elapsed >= nextStallWarning))
+		{
+			int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+			int64_t lastEvent = m_lastAdapterEventTime;
+			LogWarn("The debug adapter has not finished the %s operation after %.1f s. Its last event was %.1f s ago.",
+				GetAdapterOperationName(operation), elapsed, (nowMs - lastEvent) / 1000.0);
+			nextStallWarning *= 2;
+		}
+	}
+	return wait.m_reason;
+}
+
+
 Ref<Metadata> DebuggerController::GetAdapterProperty(const std::string& name)
 {
 	if (!m_adapter)
@@ -2619,7 +3700,28 @@ bool DebuggerController::ComputeExprValueAPI(const BinaryNinja::LowLevelILInstru
 }
 
 
-bool DebuggerController::ComputeExprValue(const LowLevelILInstruction &instr, uint64_t& value)
+bool DebuggerController::ComputeExprValue(const LowLevelILInstruction& instr, uint64_t& value)
+{
+	// IL that does not belong to a function, e.g., an instruction lifted on its own, has nothing stable to key the
+	// cache by
+	Ref<Function> owner = instr.function->GetFunction();
+	if (!owner)
+		return ComputeExprValueUncached(instr, value);
+
+	uint64_t functionStart = owner->GetStart();
+	size_t expr = instr.exprIndex;
+	bool ok = false;
+	uint64_t generation = 0;
+	if (m_exprValueCache->Lookup(m_stopEpoch, functionStart, LowLevelILFunctionGraph, expr, ok, value, generation))
+		return ok;
+
+	ok = ComputeExprValueUncached(instr, value);
+	m_exprValueCache->Store(generation, functionStart, LowLevelILFunctionGraph, expr, ok, value);
+	return ok;
+}
+
+
+bool DebuggerController::ComputeExprValueUncached(const LowLevelILInstruction &instr, uint64_t& value)
 {
 	if (instr.size > 8)
 		return false;
@@ -3087,7 +4189,27 @@ bool DebuggerController::ComputeExprValueAPI(const BinaryNinja::MediumLevelILIns
 }
 
 
-bool DebuggerController::ComputeExprValue(const MediumLevelILInstruction &instr, uint64_t& value)
+bool DebuggerController::ComputeExprValue(const MediumLevelILInstruction& instr, uint64_t& value)
+{
+	// IL that does not belong to a function has nothing stable to key the cache by
+	Ref<Function> owner = instr.function->GetFunction();
+	if (!owner)
+		return ComputeExprValueUncached(instr, value);
+
+	uint64_t functionStart = owner->GetStart();
+	size_t expr = instr.exprIndex;
+	bool ok = false;
+	uint64_t generation = 0;
+	if (m_exprValueCache->Lookup(m_stopEpoch, functionStart, MediumLevelILFunctionGraph, expr, ok, value, generation))
+		return ok;
+
+	ok = ComputeExprValueUncached(instr, value);
+	m_exprValueCache->Store(generation, functionStart, MediumLevelILFunctionGraph, expr, ok, value);
+	return ok;
+}
+
+
+bool DebuggerController::ComputeExprValueUncached(const MediumLevelILInstruction &instr, uint64_t& value)
 {
 	if (instr.size > 8)
 		return false;
@@ -3472,7 +4594,27 @@ bool DebuggerController::ComputeExprValueAPI(const BinaryNinja::HighLevelILInstr
 }
 
 
-bool DebuggerController::ComputeExprValue(const HighLevelILInstruction &instr, uint64_t& value)
+bool DebuggerController::ComputeExprValue(const HighLevelILInstruction& instr, uint64_t& value)
+{
+	// IL that does not belong to a function has nothing stable to key the cache by
+	Ref<Function> owner = instr.function->GetFunction();
+	if (!owner)
+		return ComputeExprValueUncached(instr, value);
+
+	uint64_t functionStart = owner->GetStart();
+	size_t expr = instr.exprIndex;
+	bool ok = false;
+	uint64_t generation = 0;
+	if (m_exprValueCache->Lookup(m_stopEpoch, functionStart, HighLevelILFunctionGraph, expr, ok, value, generation))
+		return ok;
+
+	ok = ComputeExprValueUncached(instr, value);
+	m_exprValueCache->Store(generation, functionStart, HighLevelILFunctionGraph, expr, ok, value);
+	return ok;
+}
+
+
+bool DebuggerController::ComputeExprValueUncached(const HighLevelILInstruction &instr, uint64_t& value)
 {
 	if (instr.size > 8)
 		return false;
@@ -20,20 +20,25 @@ limitations under the License.
 #include "debuggerevent.h"
 #include <queue>
 #include <list>
+#include <condition_variable>
+#include <thread>
 #include "ffi_global.h"
 #include "refcountobject.h"
 #include "debuggerfileaccessor.h"
+#include "debuggercoverage.h"
+#include "debuggerexpression.h"
+#include "debuggertracepoints.h"
+#include "debuggerinstructiontrace.h"
+#include "debuggercalltracer.h"
+#include "debuggerprofiler.h"
+#include "debuggersyscalltrace.h"
+#include "debuggereventdispatcher.h"
+#include "debuggercommandqueue.h"
+#include "debuggerexprvaluecache.h"
 
 DECLARE_DEBUGGER_API_OBJECT(BNDebuggerController, DebuggerController);
 
 namespace BinaryNinjaDebugger {
-	struct DebuggerEventCallback
-	{
-		std::function<void(const DebuggerEvent& event)> function;
-		size_t index;
-		std::string name;
-	};
-
 	// This is used by the debugger to track stack variables it defined. It is simpler than
 	// BinaryNinja::VariableNameAndType that it does not track the Variable and autoDefined.
 	struct StackVariableNameAndType
@@ -48,9 +53,22 @@ namespace BinaryNinjaDebugger {
 			name = n;
 		}
 
-		bool operator==(const StackVariableNameAndType& other) { return (type == other.type) && (name == other.name); }
+		bool operator==(const StackVariableNameAndType& other) const
+		{
+			return (type == other.type) && (name == other.name);
+		}
+
+		bool operator!=(const StackVariableNameAndType& other) const { return !(*this == other); }
+	};
 
-		bool operator!=(const StackVariableNameAndType& other) { return !(*this == other); }
+	// The variables found in one stack frame, including the ones reached by following pointers
+	struct StackVariableWalk
+	{
+		std::vector<std::pair<uint64_t, StackVariableNameAndType>> variables;
+		// The pointer targets that are already visited, which stops the walk on cycles
+		std::set<uint64_t> visited;
+		// The number of variables and members that can still be visited
+		size_t budget = 0;
 	};
 
 	// This is the controller class of the debugger. It receives the input from the UI/API, and then route them to
@@ -65,6 +83,13 @@ namespace BinaryNinjaDebugger {
 		FileMetadataRef m_file;
 		BinaryViewRef m_data;
 		DebuggerFileAccessor* m_accessor;
+		DebuggerCoverage* m_coverage;
+		DebuggerTracepoints* m_tracepoints;
+		DebuggerInstructionTrace* m_instructionTrace;
+		DebuggerCallTracer* m_callTracer;
+		DebuggerProfiler* m_profiler;
+		DebuggerSyscallTrace* m_syscallTrace;
+		DebuggerExprValueCache* m_exprValueCache;
 		// This is the start address of the first file segments in the m_data. Unlike the return value of GetStart(),
 		// this does not change even if we add the debugger memory region. In the future, this should be provided by
 		// the binary view -- we will no longer need to track it ourselves
@@ -75,9 +100,11 @@ namespace BinaryNinjaDebugger {
 		static size_t g_controllerCount;
 
 		std::atomic<size_t> m_callbackIndex = 0;
-		std::list<DebuggerEventCallback> m_eventCallbacks;
-		std::recursive_mutex m_callbackMutex;
-		std::set<size_t> m_disabledCallbacks;
+		// Replaced rather than modified when a callback is added or removed, see DebuggerEventCallbackList
+		DebuggerEventCallbackListRef m_eventCallbacks;
+		std::mutex m_callbackMutex;
+		DebuggerEventDispatcher* m_eventDispatcher;
+		DebuggerCommandQueue* m_commandQueue;
 
 		// m_adapterMutex is a low-level mutex that protects the adapter access. It cannot be locked recursively.
 		// m_targetControlMutex is a high-level mutex that prevents two threads from controlling the debugger at the
@@ -96,6 +123,19 @@ namespace BinaryNinjaDebugger {
 
 		bool m_lastAdapterStopEventConsumed = true;
 
+		// In milliseconds, 0 means no timeout
+		std::atomic<uint64_t> m_operationTimeout = 0;
+		// When the adapter last posted an event, in milliseconds of the steady clock. Used to report stalls.
+		std::atomic<int64_t> m_lastAdapterEventTime = 0;
+		// The state shared with the event callback of ExecuteAdapterAndWait(). The callback can still be running after
+		// the wait ends, e.g., on a timeout, so it must not refer to the stack of the waiting thread.
+		struct AdapterStopWait
+		{
+			Semaphore m_sem;
+			std::atomic<DebugStopReason> m_reason = UnknownReason;
+		};
+		DebugStopReason WaitForAdapterStop(AdapterStopWait& wait, DebugAdapterOperation operation);
+
 		bool m_inputFileLoaded = false;
 		bool m_initialBreakpointSeen = false;
 
@@ -103,11 +143,49 @@ namespace BinaryNinjaDebugger {
 		bool m_shouldAnnotateStackVariable = false;
 
 		void EventHandler(const DebuggerEvent& event);
+		// The stop handling in EventHandler() only does the work whose cost does not depend on the number of threads or
+		// modules, i.e., the IP, the stop reason and the registers of the active thread, so the UI can show the stop
+		// right away. The rest runs in stages on m_stopStagesThread after the stop is delivered, see
+		// RunDeferredStopStages(). m_stopEpoch changes on every stop and resume, which tells the stages that their stop
+		// is gone.
+		std::atomic<uint64_t> m_stopEpoch = 0;
+		std::thread m_stopStagesThread;
+		std::mutex m_stopStagesMutex;
+		std::condition_variable m_stopStagesCv;
+		bool m_stopStagesPending = false;
+		uint64_t m_stopStagesEpoch = 0;
+		bool m_quitStopStagesThread = false;
+		void StopStagesThread();
+		void QueueDeferredStopStages(uint64_t epoch);
+		void RunDeferredStopStages(uint64_t epoch);
+		bool IsStopOutdated(uint64_t epoch);
 		void UpdateStackVariables();
+		// The register values last sent to the expression parser of m_data
+		std::mutex m_expressionParserMutex;
+		std::unordered_map<std::string, uint64_t> m_expressionParserValues;
 		void AddRegisterValuesToExpressionParser();
 		bool CreateDebugAdapter();
 		bool CreateDebuggerBinaryView();
 
+		// Sorted and unique addresses of the IL instructions of a function, which are where IL stepping stops. Walking the
+		// IL after every native step is slow for large functions, so they are cached per function and IL level, and
+		// dropped when the function is updated by the analysis.
+		std::mutex m_ilInstructionStartsMutex;
+		std::map<std::pair<uint64_t, BNFunctionGraphType>, std::shared_ptr<const std::vector<uint64_t>>>
+			m_ilInstructionStarts;
+		// Returns nullptr if the IL of the function is not available yet
+		std::shared_ptr<const std::vector<uint64_t>> GetILInstructionStarts(
+			const FunctionRef& func, BNFunctionGraphType il);
+		bool IsILInstructionStart(BNFunctionGraphType il, uint64_t address);
+		// Finds the addresses where the execution can first reach the start of an IL instruction, by following the
+		// native control flow from the current instruction. When stepping over, the calls on the way are included as
+		// well, so they can be stepped over natively. Returns false if that cannot be determined statically, e.g., on
+		// indirect branches or function returns.
+		bool GetNextILInstructionAddresses(BNFunctionGraphType il, bool stepOver, std::vector<uint64_t>& addresses);
+		// Steps one IL instruction of the active thread by running to temporary breakpoints, falling back to
+		// single-stepping if the next addresses are unknown. Returns InternalError if no IL instruction is reached.
+		DebugStopReason StepILUsingBreakpoints(BNFunctionGraphType il, bool stepOver);
+
 		DebugStopReason StepIntoIL(BNFunctionGraphType il);
 		DebugStopReason StepIntoReverseIL(BNFunctionGraphType il);
 		DebugStopReason StepOverIL(BNFunctionGraphType il);
@@ -131,18 +209,51 @@ namespace BinaryNinjaDebugger {
 		DebugStopReason StepReturnAndWaitInternal();
 		DebugStopReason StepReturnReverseAndWaitInternal();
 		DebugStopReason RunToAndWaitInternal(const std::vector<uint64_t> &remoteAddresses);
+		// Same as RunToAndWaitInternal(), but does not notify the stop
+		DebugStopReason RunToTemporaryBreakpointsAndWait(const std::vector<uint64_t>& remoteAddresses);
+		// Single-steps the target until the handler returns false. The steps are handled in the adapter event thread
+		// when the adapter supports it.
+		DebugStopReason StepSilentlyAndWaitInternal(const InstructionTraceHandler& handler);
+
+		// Target control commands run on m_commandQueue, while holding m_targetControlMutex
+		std::shared_future<DebugStopReason> SubmitCommand(
+			const DebuggerCommandFunction& command, const std::string& coalesceKey = "");
+		DebugStopReason ExecuteCommandAndWait(
+			const DebuggerCommandFunction& command, const std::string& coalesceKey = "");
+		// Submits a command that resumes the target. Returns false if the target cannot be resumed now or after the
+		// commands ahead of it.
+		bool SubmitResumeCommand(const DebuggerCommandFunction& command, const std::string& coalesceKey = "");
+		// Repeats the step count times, or until it does not end with a single step stop
+		DebugStopReason StepCommand(const std::function<DebugStopReason()>& step, size_t count);
+		// The handler of the steps done for DebugAdapterTraceInstructions
+		InstructionTraceHandler m_silentStepHandler;
+		// Fast-forwards the target to one of the addresses by interpreting its code locally. Returns false, without
+		// changing the target, when the code cannot be interpreted. Otherwise, reason is Breakpoint, or InternalError
+		// when the target was only partially written.
+		bool InterpretUntil(const std::vector<uint64_t>& remoteAddresses, DebugStopReason& reason);
+		// The number of native instructions executed by InterpretUntil() so far
+		std::atomic<uint64_t> m_interpretedInstructionCount = 0;
 
 		// Whether we can resume the execution of the target, including stepping.
 		bool CanResumeTarget();
 
 		bool ExpectSingleStep(DebugStopReason reason);
 
+		// The stack variables and comments that are currently defined in the view
 		std::map<uint64_t, StackVariableNameAndType> m_debuggerVariables;
-		std::set<uint64_t> m_addressesWithVariable;
-		std::set<uint64_t> m_oldAddresses;
-		std::set<uint64_t> m_addressesWithComment;
-		void ProcessOneVariable(uint64_t address, Confidence<Ref<Type>> type, const std::string& name);
-		void DefineVariablesRecursive(uint64_t address, Confidence<Ref<Type>> type);
+		std::map<uint64_t, std::string> m_stackComments;
+		// The stack-resident variables of the frames seen on the last stop, keyed by the function start and the stack
+		// pointer of the caller frame. The variables of a frame with the same key are not looked up again. The pointers
+		// can change between stops, so they are followed again on every stop.
+		std::map<std::pair<uint64_t, uint64_t>, std::vector<std::pair<uint64_t, StackVariableNameAndType>>>
+			m_stackFrameVariables;
+		// The functions updated by the analysis since the last stop, whose frames must be walked again
+		std::mutex m_updatedStackFunctionsMutex;
+		std::set<uint64_t> m_updatedStackFunctions;
+		void ProcessOneVariable(
+			StackVariableWalk& walk, uint64_t address, Confidence<Ref<Type>> type, const std::string& name);
+		void DefineVariablesRecursive(
+			StackVariableWalk& walk, uint64_t address, Confidence<Ref<Type>> type, size_t depth);
 
 		void ApplyBreakpoints();
 
@@ -153,6 +264,24 @@ namespace BinaryNinjaDebugger {
 
 		void DetectLoadedModule();
 
+		// Called from the adapter event thread, see DebugAdapter::SetInternalBreakpointHandler()
+		bool InternalBreakpointHandler(uint32_t tid, uint64_t address);
+		// Coverage, tracepoints and the call tracer share the internal breakpoints. Remove the one at the address
+		// unless another of them still needs it.
+		void ReleaseInternalBreakpoint(uint64_t address);
+
+		// The parsed breakpoint conditions, keyed by the absolute address. This is a snapshot of the conditions in
+		// DebuggerBreakpoints, which is read by the adapter event thread without touching the debugger state.
+		std::mutex m_breakpointConditionMutex;
+		std::unordered_map<uint64_t, DebuggerExpression> m_breakpointConditions;
+		std::unordered_map<uint64_t, uint64_t> m_breakpointHitCounts;
+		void UpdateBreakpointConditions();
+		// Called from the adapter event thread, see DebugAdapter::SetBreakpointConditionHandler()
+		bool BreakpointConditionHandler(uint32_t tid, uint64_t address);
+		// Evaluate an expression against the selected thread from the adapter event thread, while the target is
+		// stopped but the stop is not reported yet. It bypasses the debugger caches, which are not valid at this time.
+		bool EvaluateInAdapterThread(const DebuggerExpression& expression, uint64_t& value);
+
 	public:
 		DebuggerController(BinaryViewRef data);
 		static DbgRef<DebuggerController> GetController(BinaryViewRef data);
@@ -175,6 +304,52 @@ namespace BinaryNinjaDebugger {
 		void DeleteBreakpoint(uint64_t address);
 		void DeleteBreakpoint(const ModuleNameAndOffset& address);
 		DebugBreakpoint GetAllBreakpoints();
+		// An empty condition removes the condition of the breakpoint. Returns false if there is no breakpoint at the
+		// address, or the condition cannot be parsed.
+		bool SetBreakpointCondition(uint64_t address, const std::string& condition);
+		bool SetBreakpointCondition(const ModuleNameAndOffset& address, const std::string& condition);
+		std::string GetBreakpointCondition(uint64_t address);
+		std::string GetBreakpointCondition(const ModuleNameAndOffset& address);
+		// The number of times the breakpoint is hit since the target is launched, including the hits whose condition
+		// does not hold. Only hits while the target is resumed by go are counted.
+		uint64_t GetBreakpointHitCount(uint64_t address);
+
+		// watchpoints
+		bool AddWatchpoint(uint64_t address, size_t size, DebugWatchpointType type, bool software = false);
+		bool RemoveWatchpoint(uint64_t address);
+		bool ContainsWatchpoint(uint64_t address) { return m_state->GetWatchpoints()->Contains(address); }
+		std::vector<DebugWatchpoint> GetWatchpoints() { return m_state->GetWatchpoints()->GetWatchpointList(); }
+
+		// coverage
+		bool StartCoverage(const std::vector<uint64_t>& functions, const std::vector<std::string>& modules = {});
+		void StopCoverage();
+		DebuggerCoverage* GetCoverage() const { return m_coverage; }
+
+		// tracepoints
+		bool AddTracepoint(uint64_t address, const std::string& format = "");
+		bool RemoveTracepoint(uint64_t address);
+		std::vector<Tracepoint> GetTracepoints() { return m_tracepoints->GetTracepoints(); }
+		uint64_t GetTracepointHitCount(uint64_t address) { return m_tracepoints->GetHitCount(address); }
+		bool SetTracepointOutputFile(const std::string& path) { return m_tracepoints->SetOutputFile(path); }
+		std::string GetTracepointOutputFile() { return m_tracepoints->GetOutputFile(); }
+
+		// instruction trace
+		DebugStopReason TraceInstructionsAndWait(const InstructionTraceOptions& options);
+		DebuggerInstructionTrace* GetInstructionTrace() const { return m_instructionTrace; }
+
+		// call trace
+		bool StartCallTrace(const std::vector<std::string>& modules = {});
+		void StopCallTrace();
+		DebuggerCallTracer* GetCallTracer() const { return m_callTracer; }
+
+		// syscall trace
+		bool StartSyscallTrace(const std::vector<std::string>& modules = {});
+		void StopSyscallTrace();
+		DebuggerSyscallTrace* GetSyscallTrace() const { return m_syscallTrace; }
+
+		// sampling profiler
+		DebugStopReason ProfileAndWait(const ProfilerOptions& options);
+		DebuggerProfiler* GetProfiler() const { return m_profiler; }
 
 		// registers
 		uint64_t GetRegisterValue(const std::string& name);
@@ -213,20 +388,24 @@ namespace BinaryNinjaDebugger {
 		bool WriteMemory(std::uintptr_t address, const DataBuffer& buffer);
 
 		// debugger events
-		size_t RegisterEventCallback(
-			std::function<void(const DebuggerEvent& event)> callback, const std::string& name = "");
+		// The callback only receives the events selected by eventMask, see DebuggerEventMask()
+		size_t RegisterEventCallback(std::function<void(const DebuggerEvent& event)> callback,
+			const std::string& name = "", DebuggerEventDelivery delivery = SynchronousEventDelivery,
+			uint64_t eventMask = AllDebuggerEventsMask);
 		bool RemoveEventCallback(size_t index);
-		bool RemoveEventCallbackInternal(size_t index);
+		void FlushEventCallbacks();
 		void NotifyStopped(DebugStopReason reason, void* data = nullptr);
 		void NotifyError(const std::string& error, const std::string& shortError, void* data = nullptr);
 		void NotifyEvent(DebuggerEventType event);
-		void PostDebuggerEvent(const DebuggerEvent& event);
-		void CleanUpDisabledEvent();
+		// The event is moved through to the asynchronous callbacks, so pass a temporary or std::move() it when it is
+		// no longer needed
+		void PostDebuggerEvent(DebuggerEvent event);
 
 		// shortcut for instruction pointer
 		uint64_t GetLastIP() const { return m_lastIP; }
 		uint64_t GetCurrentIP() const { return m_currentIP; }
 		bool SetIP(uint64_t address);
+		std::string GetIPRegisterName();
 
 		// target control
 		bool Execute();
@@ -256,6 +435,14 @@ namespace BinaryNinjaDebugger {
 
 		DebugStopReason ExecuteAdapterAndWait(const DebugAdapterOperation operation);
 
+		// Bounds the wait for the adapter in every operation. The target is broken into when it elapses, and the
+		// operation returns OperationTimedOut. 0 means no timeout.
+		void SetOperationTimeout(uint64_t milliseconds) { m_operationTimeout = milliseconds; }
+		uint64_t GetOperationTimeout() const { return m_operationTimeout; }
+		// Cancels the running command and the pending ones. The running one returns UserRequestedBreak. Returns
+		// false if no command was running.
+		bool CancelOperation();
+
 		// Synchronous APIs
 		DebugStopReason LaunchAndWait();
 		DebugStopReason GoAndWait();
@@ -265,6 +452,11 @@ namespace BinaryNinjaDebugger {
 		DebugStopReason ConnectAndWait();
 		DebugStopReason StepIntoAndWait(BNFunctionGraphType il = NormalFunctionGraph);
 		DebugStopReason StepIntoReverseAndWait(BNFunctionGraphType il = NormalFunctionGraph);
+		// Step into count instructions, and only notify the final stop
+		DebugStopReason StepIntoNAndWait(uint64_t count);
+		// Step into until the condition, e.g., "$rip == 0x401000" or "$rax > 5", evaluates to non-zero, or after
+		// maxSteps instructions (0 means no limit). Only the final stop is notified.
+		DebugStopReason StepUntilAndWait(const std::string& condition, uint64_t maxSteps = 0);
 		DebugStopReason StepOverAndWait(BNFunctionGraphType il = NormalFunctionGraph);
 		DebugStopReason StepOverReverseAndWait(BNFunctionGraphType il);
 		DebugStopReason StepReturnAndWait();
@@ -274,6 +466,10 @@ namespace BinaryNinjaDebugger {
 		void DetachAndWait();
 		void QuitAndWait();
 
+		// Drops the target control commands that have not started yet. Pause, quit and detach do this as well.
+		size_t CancelPendingCommands();
+		size_t GetPendingCommandCount();
+
 		// getters
 		DebugAdapter* GetAdapter() { return m_adapter; }
 		DebuggerState* GetState() { return m_state; }
@@ -304,6 +500,14 @@ namespace BinaryNinjaDebugger {
 
 		void OnRebased(BinaryView* oldView, BinaryView* newView) override {
 			m_data = newView;
+			{
+				std::unique_lock<std::mutex> lock(m_ilInstructionStartsMutex);
+				m_ilInstructionStarts.clear();
+			}
+			{
+				std::unique_lock<std::mutex> lock(m_expressionParserMutex);
+				m_expressionParserValues.clear();
+			}
 			m_viewStart = newView->GetStart();
 			// UnregisterNotification() is not designed to be called from one of the callbacks, so we cannot call it
 			// here. Also, there is no need to do so -- the oldView is about to be deleted
@@ -311,21 +515,30 @@ namespace BinaryNinjaDebugger {
 			newView->RegisterNotification(this);
 		}
 
+		void OnAnalysisFunctionUpdated(BinaryView* view, Function* func) override;
+		void OnAnalysisFunctionRemoved(BinaryView* view, Function* func) override;
+
 		bool RemoveDebuggerMemoryRegion();
 		bool ReAddDebuggerMemoryRegion();
 
 		uint64_t GetViewFileSegmentsStart() { return m_viewStart; }
 
+		// The values are cached until the target state changes, see DebuggerExprValueCache
+		ExprValueCacheStats GetExprValueCacheStats() { return m_exprValueCache->GetStats(); }
+		uint64_t GetInterpretedInstructionCount() const { return m_interpretedInstructionCount; }
 		bool ComputeExprValueAPI(const LowLevelILInstruction& instr, uint64_t& value);
 		bool ComputeExprValue(const LowLevelILInstruction& instr, uint64_t& value);
+		bool ComputeExprValueUncached(const LowLevelILInstruction& instr, uint64_t& value);
 		uint64_t GetValueFromComparison(const BNLowLevelILOperation op, uint64_t left, uint64_t right, size_t size);
 
 		bool ComputeExprValueAPI(const MediumLevelILInstruction& instr, uint64_t& value);
 		bool ComputeExprValue(const MediumLevelILInstruction& instr, uint64_t& value);
+		bool ComputeExprValueUncached(const MediumLevelILInstruction& instr, uint64_t& value);
 		uint64_t GetValueFromComparison(const BNMediumLevelILOperation op, uint64_t left, uint64_t right, size_t size);
 
 		bool ComputeExprValueAPI(const HighLevelILInstruction& instr, uint64_t& value);
 		bool ComputeExprValue(const HighLevelILInstruction& instr, uint64_t& value);
+		bool ComputeExprValueUncached(const HighLevelILInstruction& instr, uint64_t& value);
 		uint64_t GetValueFromComparison(const BNHighLevelILOperation op, uint64_t left, uint64_t right, size_t size);
 
 		bool GetVariableValueAPI(const Variable& var, uint64_t address, size_t size, uint64_t& value);
@@ -0,0 +1,251 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggercoverage.h"
+#include "debuggercontroller.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace BinaryNinjaDebugger;
+
+
+DebuggerCoverage::DebuggerCoverage(DebuggerController* controller) : m_controller(controller) {}
+
+
+uint16_t DebuggerCoverage::GetModuleIndex(uint64_t address)
+{
+	// m_modules is sorted by base address
+	auto it = std::upper_bound(m_modules.begin(), m_modules.end(), address,
+		[](uint64_t addr, const CoverageModule& module) { return addr < module.m_base; });
+	if (it == m_modules.begin())
+		return InvalidModuleIndex;
+
+	--it;
+	if (address >= it->m_end)
+		return InvalidModuleIndex;
+
+	return (uint16_t)(it - m_modules.begin());
+}
+
+
+std::vector<uint64_t> DebuggerCoverage::Start(
+	const std::vector<uint64_t>& functions, const std::vector<std::string>& modules)
+{
+	BinaryViewRef data = m_controller->GetData();
+	if (!data)
+		return {};
+
+	std::vector<FunctionRef> selected;
+	for (const uint64_t address : functions)
+	{
+		for (const auto& func : data->GetAnalysisFunctionsForAddress(address))
+			selected.push_back(func);
+	}
+
+	if (!modules.empty())
+	{
+		for (const auto& func : data->GetAnalysisFunctionList())
+		{
+			DebugModule module = m_controller->GetModuleForAddress(func->GetStart());
+			for (const auto& name : modules)
+			{
+				if (module.IsSameBaseModule(name))
+				{
+					selected.push_back(func);
+					break;
+				}
+			}
+		}
+	}
+
+	// Functions can share basic blocks, and the same function can be selected more than once
+	std::map<uint64_t, uint32_t> blocks;
+	for (const auto& func : selected)
+	{
+		for (const auto& block : func->GetBasicBlocks())
+			blocks[block->GetStart()] = (uint32_t)block->GetLength();
+	}
+
+	std::vector<DebugModule> debugModules = m_controller->GetAllModules();
+	std::sort(debugModules.begin(), debugModules.end(),
+		[](const DebugModule& a, const DebugModule& b) { return a.m_address < b.m_address; });
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_modules.clear();
+	m_blocks.clear();
+	m_blockIndex.clear();
+	m_coveredCount = 0;
+
+	for (size_t i = 0; i < debugModules.size(); i++)
+	{
+		// LLDB does not always know the size of a module, in which case it extends to the start of the next one
+		uint64_t end = debugModules[i].m_address + debugModules[i].m_size;
+		if (debugModules[i].m_size == 0)
+			end = (i + 1 < debugModules.size()) ? debugModules[i + 1].m_address : UINT64_MAX;
+		m_modules.push_back({debugModules[i].m_name, debugModules[i].m_address, end});
+	}
+
+	std::vector<uint64_t> result;
+	result.reserve(blocks.size());
+	m_blocks.reserve(blocks.size());
+	for (const auto& [start, size] : blocks)
+	{
+		m_blockIndex[start] = m_blocks.size();
+		m_blocks.push_back({start, size, GetModuleIndex(start)});
+		result.push_back(start);
+	}
+	m_bitmap.assign((m_blocks.size() + 7) / 8, 0);
+	m_active = true;
+
+	return result;
+}
+
+
+void DebuggerCoverage::Stop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_active = false;
+}
+
+
+bool DebuggerCoverage::RecordHit(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_active)
+		return false;
+
+	auto it = m_blockIndex.find(address);
+	if (it == m_blockIndex.end())
+		return false;
+
+	size_t index = it->second;
+	uint8_t mask = (uint8_t)(1 << (index % 8));
+	if ((m_bitmap[index / 8] & mask) == 0)
+	{
+		m_bitmap[index / 8] |= mask;
+		m_coveredCount++;
+	}
+	return true;
+}
+
+
+bool DebuggerCoverage::IsPendingBlock(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_active)
+		return false;
+
+	auto it = m_blockIndex.find(address);
+	if (it == m_blockIndex.end())
+		return false;
+
+	size_t index = it->second;
+	return (m_bitmap[index / 8] & (1 << (index % 8))) == 0;
+}
+
+
+size_t DebuggerCoverage::GetBlockCount()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_blocks.size();
+}
+
+
+size_t DebuggerCoverage::GetCoveredBlockCount()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_coveredCount;
+}
+
+
+std::vector<uint64_t> DebuggerCoverage::GetBlocks()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::vector<uint64_t> result;
+	result.reserve(m_blocks.size());
+	for (const auto& block : m_blocks)
+		result.push_back(block.m_start);
+	return result;
+}
+
+
+std::vector<uint64_t> DebuggerCoverage::GetCoveredBlocks()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::vector<uint64_t> result;
+	result.reserve(m_coveredCount);
+	for (size_t i = 0; i < m_blocks.size(); i++)
+	{
+		if (m_bitmap[i / 8] & (1 << (i % 8)))
+			result.push_back(m_blocks[i].m_start);
+	}
+	return result;
+}
+
+
+std::vector<uint8_t> DebuggerCoverage::GetBitmap()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_bitmap;
+}
+
+
+bool DebuggerCoverage::ExportDrcov(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LogWarn("Failed to open %s for writing coverage", path.c_str());
+		return false;
+	}
+
+	std::vector<size_t> covered;
+	for (size_t i = 0; i < m_blocks.size(); i++)
+	{
+		if ((m_bitmap[i / 8] & (1 << (i % 8))) && (m_blocks[i].m_moduleIndex != InvalidModuleIndex))
+			covered.push_back(i);
+	}
+
+	file << "DRCOV VERSION: 2\n";
+	file << "DRCOV FLAVOR: drcov\n";
+	file << fmt::format("Module Table: version 2, count {}\n", m_modules.size());
+	file << "Columns: id, base, end, entry, checksum, timestamp, path\n";
+	for (size_t i = 0; i < m_modules.size(); i++)
+	{
+		file << fmt::format("{:3}, 0x{:016x}, 0x{:016x}, 0x0000000000000000, 0x00000000, 0x00000000, {}\n", i,
+			m_modules[i].m_base, m_modules[i].m_end, m_modules[i].m_path);
+	}
+
+	// Each entry is a struct _bb_entry_t { uint32_t start; uint16_t size; uint16_t mod_id; }, where start is relative
+	// to the module base
+	file << fmt::format("BB Table: {} bbs\n", covered.size());
+	for (const size_t i : covered)
+	{
+		const CoverageBlock& block = m_blocks[i];
+		uint8_t entry[8];
+		uint32_t start = (uint32_t)(block.m_start - m_modules[block.m_moduleIndex].m_base);
+		uint16_t size = (uint16_t)std::min<uint32_t>(block.m_size, UINT16_MAX);
+		uint16_t moduleIndex = block.m_moduleIndex;
+		memcpy(entry, &start, sizeof(start));
+		memcpy(entry + 4, &size, sizeof(size));
+		memcpy(entry + 6, &moduleIndex, sizeof(moduleIndex));
+		file.write((const char*)entry, sizeof(entry));
+	}
+
+	return file.good();
+}
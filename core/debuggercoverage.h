@@ -0,0 +1,89 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace BinaryNinjaDebugger {
+	class DebuggerController;
+
+	struct CoverageModule
+	{
+		std::string m_path;
+		uint64_t m_base;
+		uint64_t m_end;
+	};
+
+	struct CoverageBlock
+	{
+		uint64_t m_start;
+		uint32_t m_size;
+		// Index into the module table, or InvalidModuleIndex if the block does not belong to any known module
+		uint16_t m_moduleIndex;
+	};
+
+	// Basic block coverage collection. Every basic block start of the selected functions gets a one-shot internal
+	// breakpoint. The adapter reports the hits from its event thread, and the breakpoint is removed on its first hit,
+	// so every block costs at most one stop, and the target is resumed without notifying the UI.
+	class DebuggerCoverage
+	{
+	private:
+		DebuggerController* m_controller;
+
+		std::mutex m_mutex;
+		std::vector<CoverageModule> m_modules;
+		// Sorted by start address. The bitmap has one bit for each block, in the same order.
+		std::vector<CoverageBlock> m_blocks;
+		std::vector<uint8_t> m_bitmap;
+		std::unordered_map<uint64_t, size_t> m_blockIndex;
+		size_t m_coveredCount = 0;
+		// Written while holding m_mutex, but read without it from both the adapter event thread and the API threads
+		std::atomic<bool> m_active = false;
+
+		uint16_t GetModuleIndex(uint64_t address);
+
+	public:
+		static constexpr uint16_t InvalidModuleIndex = 0xffff;
+
+		DebuggerCoverage(DebuggerController* controller);
+
+		// Collect the basic blocks of the given functions (remote addresses of function starts) and of all functions
+		// in the given modules. Returns the addresses that need a breakpoint.
+		std::vector<uint64_t> Start(const std::vector<uint64_t>& functions, const std::vector<std::string>& modules);
+		void Stop();
+		bool IsActive() const { return m_active; }
+
+		// Called from the adapter event thread. Returns true if the address is the start of a tracked basic block.
+		bool RecordHit(uint64_t address);
+		// Whether the address is the start of a tracked basic block that is not covered yet
+		bool IsPendingBlock(uint64_t address);
+
+		size_t GetBlockCount();
+		size_t GetCoveredBlockCount();
+		std::vector<uint64_t> GetBlocks();
+		std::vector<uint64_t> GetCoveredBlocks();
+		std::vector<uint8_t> GetBitmap();
+
+		// Write the covered blocks in the drcov (version 2) format, which is understood by Lighthouse, bncov, etc.
+		bool ExportDrcov(const std::string& path);
+	};
+};  // namespace BinaryNinjaDebugger
@@ -17,6 +17,7 @@ limitations under the License.
 #pragma once
 #include "cstddef"
 #include <string>
+#include <variant>
 #include "debuggercommon.h"
 #include "../api/ffi.h"
 
@@ -27,10 +28,10 @@ namespace BinaryNinjaDebugger {
 
 	struct TargetStoppedEventData
 	{
-		DebugStopReason reason;
-		std::uint32_t lastActiveThread;
-		size_t exitCode;
-		void* data;
+		DebugStopReason reason = UnknownReason;
+		std::uint32_t lastActiveThread = 0;
+		size_t exitCode = 0;
+		void* data = nullptr;
 	};
 
 
@@ -38,13 +39,13 @@ namespace BinaryNinjaDebugger {
 	{
 		std::string shortError {};
 		std::string error {};
-		void* data;
+		void* data = nullptr;
 	};
 
 
 	struct TargetExitedEventData
 	{
-		uint64_t exitCode;
+		uint64_t exitCode = 0;
 	};
 
 
@@ -54,15 +55,65 @@ namespace BinaryNinjaDebugger {
 	};
 
 
-	// This should really be a union, but gcc complains...
-	struct DebuggerEventData
+	// An event carries at most one of these payloads, so copying or moving it only touches the strings of that one.
+	// The set*() accessors switch the event to the requested payload, resetting it if another one was held, and are
+	// used to fill in an event. The non-const accessors require the payload to be held already, and the const ones
+	// return an empty payload if another one is held. The FFI still passes all of them in the BNDebuggerEventData
+	// struct.
+	class DebuggerEventData
 	{
-		TargetStoppedEventData targetStoppedData;
-		ErrorEventData errorData;
-		uint64_t absoluteAddress;
-		ModuleNameAndOffset relativeAddress;
-		TargetExitedEventData exitData;
-		StdoutMessageEventData messageData;
+		std::variant<std::monostate, TargetStoppedEventData, ErrorEventData, uint64_t, ModuleNameAndOffset,
+			TargetExitedEventData, StdoutMessageEventData>
+			m_payload;
+
+		template <typename T>
+		T& Emplace()
+		{
+			if (!std::holds_alternative<T>(m_payload))
+				m_payload.template emplace<T>();
+			return std::get<T>(m_payload);
+		}
+
+		template <typename T>
+		T& Get()
+		{
+			// Throws std::bad_variant_access if another payload is held
+			return std::get<T>(m_payload);
+		}
+
+		template <typename T>
+		const T& Get() const
+		{
+			static const T empty {};
+			if (auto payload = std::get_if<T>(&m_payload))
+				return *payload;
+			return empty;
+		}
+
+	public:
+		TargetStoppedEventData& setTargetStoppedData() { return Emplace<TargetStoppedEventData>(); }
+		TargetStoppedEventData& targetStoppedData() { return Get<TargetStoppedEventData>(); }
+		const TargetStoppedEventData& targetStoppedData() const { return Get<TargetStoppedEventData>(); }
+
+		ErrorEventData& setErrorData() { return Emplace<ErrorEventData>(); }
+		ErrorEventData& errorData() { return Get<ErrorEventData>(); }
+		const ErrorEventData& errorData() const { return Get<ErrorEventData>(); }
+
+		uint64_t& setAbsoluteAddress() { return Emplace<uint64_t>(); }
+		uint64_t& absoluteAddress() { return Get<uint64_t>(); }
+		uint64_t absoluteAddress() const { return Get<uint64_t>(); }
+
+		ModuleNameAndOffset& setRelativeAddress() { return Emplace<ModuleNameAndOffset>(); }
+		ModuleNameAndOffset& relativeAddress() { return Get<ModuleNameAndOffset>(); }
+		const ModuleNameAndOffset& relativeAddress() const { return Get<ModuleNameAndOffset>(); }
+
+		TargetExitedEventData& setExitData() { return Emplace<TargetExitedEventData>(); }
+		TargetExitedEventData& exitData() { return Get<TargetExitedEventData>(); }
+		const TargetExitedEventData& exitData() const { return Get<TargetExitedEventData>(); }
+
+		StdoutMessageEventData& setMessageData() { return Emplace<StdoutMessageEventData>(); }
+		StdoutMessageEventData& messageData() { return Get<StdoutMessageEventData>(); }
+		const StdoutMessageEventData& messageData() const { return Get<StdoutMessageEventData>(); }
 	};
 
 
@@ -0,0 +1,179 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggereventdispatcher.h"
+
+using namespace BinaryNinjaDebugger;
+
+
+DebuggerEventDispatcher::DebuggerEventDispatcher(size_t capacity) : m_capacity(capacity)
+{
+	m_thread = std::thread([this]() { DispatchThread(); });
+	m_threadId = m_thread.get_id();
+}
+
+
+DebuggerEventDispatcher::~DebuggerEventDispatcher()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_eventCv.notify_all();
+	m_spaceCv.notify_all();
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+
+bool DebuggerEventDispatcher::CanCoalesce(const DebuggerEvent& last, const DebuggerEvent& event)
+{
+	if (last.type != event.type)
+		return false;
+
+	switch (event.type)
+	{
+	case StdoutMessageEventType:
+	case BackendMessageEventType:
+	case RegisterChangedEvent:
+	case ThreadStateChangedEvent:
+	case ActiveThreadChangedEvent:
+	case DebuggerSettingsChangedEvent:
+	case ForceMemoryCacheUpdateEvent:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+void DebuggerEventDispatcher::Post(DebuggerEvent event, const DebuggerEventCallbackListRef& callbacks)
+{
+	// Nothing is queued for the events that no asynchronous callback subscribes to
+	bool queued = callbacks && DebuggerEventMaskContains(callbacks->m_queuedMask, event.type);
+	bool coalesced = callbacks && DebuggerEventMaskContains(callbacks->m_coalescedMask, event.type);
+	if (!queued && !coalesced)
+		return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_quit)
+		return;
+
+	if (coalesced)
+	{
+		PendingEvent* last = m_coalesced.empty() ? nullptr : &m_coalesced.back();
+		if (last && (last->m_callbacks == callbacks) && CanCoalesce(last->m_event, event))
+		{
+			if ((event.type == StdoutMessageEventType) || (event.type == BackendMessageEventType))
+				last->m_event.data.setMessageData().message += event.data.messageData().message;
+		}
+		else
+		{
+			// The callbacks posting events must not wait for themselves
+			if (!IsDispatcherThread())
+				m_spaceCv.wait(lock, [&]() { return m_quit || (m_coalesced.size() < m_capacity); });
+			if (m_quit)
+				return;
+			// The event is only copied when both kinds of callbacks want it
+			if (queued)
+				m_coalesced.push_back({event, callbacks});
+			else
+				m_coalesced.push_back({std::move(event), callbacks});
+		}
+	}
+
+	if (queued)
+	{
+		if (!IsDispatcherThread())
+			m_spaceCv.wait(lock, [&]() { return m_quit || (m_queued.size() < m_capacity); });
+		if (m_quit)
+			return;
+		m_queued.push_back({std::move(event), callbacks});
+	}
+
+	lock.unlock();
+	m_eventCv.notify_one();
+}
+
+
+void DebuggerEventDispatcher::Deliver(const PendingEvent& pending, DebuggerEventDelivery delivery)
+{
+	for (const DebuggerEventCallback& cb : pending.m_callbacks->m_callbacks)
+	{
+		if ((cb.delivery != delivery) || !DebuggerEventMaskContains(cb.eventMask, pending.m_event.type))
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_deliveryMutex);
+		if (!cb.enabled->load())
+			continue;
+
+		cb.function(pending.m_event);
+	}
+}
+
+
+void DebuggerEventDispatcher::DispatchThread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_eventCv.wait(lock, [&]() { return m_quit || !m_queued.empty() || !m_coalesced.empty(); });
+		if (m_quit)
+			break;
+
+		// Take everything that is queued now, so the producers only wait for the lock briefly
+		std::deque<PendingEvent> queued, coalesced;
+		queued.swap(m_queued);
+		coalesced.swap(m_coalesced);
+		m_delivering = true;
+		lock.unlock();
+		m_spaceCv.notify_all();
+
+		for (const auto& pending : queued)
+			Deliver(pending, QueuedEventDelivery);
+		for (const auto& pending : coalesced)
+			Deliver(pending, CoalescedEventDelivery);
+
+		lock.lock();
+		m_delivering = false;
+		if (m_queued.empty() && m_coalesced.empty())
+			m_idleCv.notify_all();
+	}
+
+	m_queued.clear();
+	m_coalesced.clear();
+	m_delivering = false;
+	m_idleCv.notify_all();
+}
+
+
+void DebuggerEventDispatcher::Flush()
+{
+	if (IsDispatcherThread())
+		return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idleCv.wait(lock, [&]() { return m_quit || (m_queued.empty() && m_coalesced.empty() && !m_delivering); });
+}
+
+
+void DebuggerEventDispatcher::WaitForDelivery()
+{
+	if (IsDispatcherThread())
+		return;
+
+	std::unique_lock<std::mutex> lock(m_deliveryMutex);
+}
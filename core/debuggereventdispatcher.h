@@ -0,0 +1,128 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "debuggerevent.h"
+
+namespace BinaryNinjaDebugger {
+	typedef BNDebuggerEventDelivery DebuggerEventDelivery;
+
+	// Bit n of an event mask selects the DebuggerEventType n
+	static constexpr uint64_t AllDebuggerEventsMask = ~0ULL;
+	inline uint64_t DebuggerEventMask(std::initializer_list<DebuggerEventType> types)
+	{
+		uint64_t mask = 0;
+		for (const auto type : types)
+			mask |= 1ULL << type;
+		return mask;
+	}
+	inline bool DebuggerEventMaskContains(uint64_t mask, DebuggerEventType type)
+	{
+		return (mask >> type) & 1;
+	}
+
+	struct DebuggerEventCallback
+	{
+		std::function<void(const DebuggerEvent& event)> function;
+		size_t index;
+		std::string name;
+		DebuggerEventDelivery delivery = SynchronousEventDelivery;
+		uint64_t eventMask = AllDebuggerEventsMask;
+		// Cleared when the callback is removed, so that the events which are already on the way are not delivered
+		std::shared_ptr<std::atomic<bool>> enabled;
+	};
+
+	// The callbacks registered when an event is posted. The list is never modified once it is published, so posting
+	// an event only takes a reference to it.
+	struct DebuggerEventCallbackList
+	{
+		std::vector<DebuggerEventCallback> m_callbacks;
+		// The events that any of the queued and the coalesced callbacks subscribe to
+		uint64_t m_queuedMask = 0;
+		uint64_t m_coalescedMask = 0;
+
+		void Add(const DebuggerEventCallback& callback)
+		{
+			m_callbacks.push_back(callback);
+			if (callback.delivery == QueuedEventDelivery)
+				m_queuedMask |= callback.eventMask;
+			else if (callback.delivery == CoalescedEventDelivery)
+				m_coalescedMask |= callback.eventMask;
+		}
+	};
+	typedef std::shared_ptr<const DebuggerEventCallbackList> DebuggerEventCallbackListRef;
+
+	// Delivers the events to the QueuedEventDelivery and CoalescedEventDelivery callbacks from a dedicated thread, so
+	// that the thread posting the event, e.g., the adapter event thread, never waits for them. The events are kept in
+	// bounded queues. A producer waits when the queue is full, except for the dispatcher thread itself, which posts
+	// the events raised by the callbacks.
+	//
+	// The coalesced callbacks get the same events in the same order, except that consecutive events which carry no
+	// new information are merged before they are delivered: the stdout and backend messages are concatenated, and the
+	// repeated notifications, e.g., RegisterChangedEvent, are sent once.
+	class DebuggerEventDispatcher
+	{
+	private:
+		struct PendingEvent
+		{
+			DebuggerEvent m_event;
+			DebuggerEventCallbackListRef m_callbacks;
+		};
+
+		std::mutex m_mutex;
+		std::condition_variable m_eventCv;
+		std::condition_variable m_spaceCv;
+		std::condition_variable m_idleCv;
+		std::deque<PendingEvent> m_queued;
+		std::deque<PendingEvent> m_coalesced;
+		size_t m_capacity;
+		bool m_delivering = false;
+		bool m_quit = false;
+
+		// Held while a callback runs, so that a callback is not called after RemoveEventCallback() returns
+		std::mutex m_deliveryMutex;
+
+		std::thread m_thread;
+		std::thread::id m_threadId;
+		void DispatchThread();
+		void Deliver(const PendingEvent& pending, DebuggerEventDelivery delivery);
+
+		static bool CanCoalesce(const DebuggerEvent& last, const DebuggerEvent& event);
+
+	public:
+		DebuggerEventDispatcher(size_t capacity = 4096);
+		// The events that are not delivered yet are dropped
+		~DebuggerEventDispatcher();
+
+		void Post(DebuggerEvent event, const DebuggerEventCallbackListRef& callbacks);
+		// Waits until all events posted so far are delivered. Returns right away on the dispatcher thread.
+		void Flush();
+		// Waits for the callback that is running on the dispatcher thread, if any, to return
+		void WaitForDelivery();
+		bool IsDispatcherThread() const { return std::this_thread::get_id() == m_threadId; }
+	};
+};  // namespace BinaryNinjaDebugger
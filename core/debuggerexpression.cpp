@@ -0,0 +1,439 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggerexpression.h"
+#include <algorithm>
+#include <cctype>
+#include <vector>
+#include <fmt/format.h>
+
+using namespace BinaryNinjaDebugger;
+
+
+enum ExpressionNodeType
+{
+	ConstantExpressionNode,
+	RegisterExpressionNode,
+	LoadExpressionNode,
+	UnaryExpressionNode,
+	BinaryExpressionNode,
+};
+
+
+struct DebuggerExpression::Node
+{
+	ExpressionNodeType type;
+	// The operator of unary and binary nodes, e.g., "+", "<=", "!"
+	std::string op;
+	uint64_t value = 0;
+	// Register name of register nodes
+	std::string name;
+	// Load size of load nodes, 0 means the address size
+	size_t size = 0;
+	// The number of nodes on the longest path from this node to a leaf, including itself
+	size_t depth = 1;
+	std::shared_ptr<const Node> left;
+	std::shared_ptr<const Node> right;
+};
+
+
+namespace {
+	typedef std::shared_ptr<const DebuggerExpression::Node> NodeRef;
+
+	// Both the parser and the evaluator recurse, the latter on the adapter event thread, so deeply nested expressions
+	// are rejected rather than risking a stack overflow
+	constexpr size_t MaxExpressionDepth = 256;
+
+	// From the lowest to the highest precedence
+	const std::vector<std::vector<std::string>> g_binaryOperators = {
+		{"||"},
+		{"&&"},
+		{"|"},
+		{"^"},
+		{"&"},
+		{"==", "!="},
+		{"<=", ">=", "<", ">"},
+		{"<<", ">>"},
+		{"+", "-"},
+		{"*", "/", "%"},
+	};
+
+
+	class ExpressionParser
+	{
+		const std::string& m_text;
+		size_t m_pos = 0;
+		// The number of ParseUnary() calls on the stack, which is where every nesting goes through
+		size_t m_nesting = 0;
+
+		bool CheckDepth(size_t depth)
+		{
+			if (depth <= MaxExpressionDepth)
+				return true;
+			error = fmt::format("the expression is nested too deeply (more than {} levels)", MaxExpressionDepth);
+			return false;
+		}
+
+		void SkipSpaces()
+		{
+			while (m_pos < m_text.size() && isspace((unsigned char)m_text[m_pos]))
+				m_pos++;
+		}
+
+		bool Peek(const std::string& token)
+		{
+			SkipSpaces();
+			return m_text.compare(m_pos, token.size(), token) == 0;
+		}
+
+		bool Consume(const std::string& token)
+		{
+			if (!Peek(token))
+				return false;
+			m_pos += token.size();
+			return true;
+		}
+
+		// The longest binary operator at the current position, at the given precedence level. Operators that are a
+		// prefix of a longer operator at another level, e.g., "&" and "&&", or "<" and "<<", are rejected here.
+		bool ConsumeBinaryOperator(size_t level, std::string& op)
+		{
+			SkipSpaces();
+			std::string longest;
+			for (const auto& ops : g_binaryOperators)
+			{
+				for (const auto& candidate : ops)
+				{
+					if ((candidate.size() > longest.size()) && (m_text.compare(m_pos, candidate.size(), candidate) == 0))
+						longest = candidate;
+				}
+			}
+
+			for (const auto& candidate : g_binaryOperators[level])
+			{
+				if (candidate == longest)
+				{
+					op = candidate;
+					m_pos += candidate.size();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		NodeRef ParseBinary(size_t level)
+		{
+			if (level >= g_binaryOperators.size())
+				return ParseUnary();
+
+			NodeRef left = ParseBinary(level + 1);
+			if (!left)
+				return nullptr;
+
+			std::string op;
+			while (ConsumeBinaryOperator(level, op))
+			{
+				NodeRef right = ParseBinary(level + 1);
+				if (!right)
+					return nullptr;
+
+				auto node = std::make_shared<DebuggerExpression::Node>();
+				node->type = BinaryExpressionNode;
+				node->op = op;
+				node->left = left;
+				node->right = right;
+				node->depth = std::max(left->depth, right->depth) + 1;
+				if (!CheckDepth(node->depth))
+					return nullptr;
+				left = node;
+			}
+			return left;
+		}
+
+		NodeRef ParseUnary()
+		{
+			if (!CheckDepth(m_nesting + 1))
+				return nullptr;
+
+			m_nesting++;
+			NodeRef result = ParseUnaryOperand();
+			m_nesting--;
+			return result;
+		}
+
+		NodeRef ParseUnaryOperand()
+		{
+			for (const std::string op : {"-", "~", "!"})
+			{
+				// "!=" is never at the start of an operand, so there is no ambiguity here
+				if (Consume(op))
+				{
+					NodeRef operand = ParseUnary();
+					if (!operand)
+						return nullptr;
+
+					auto node = std::make_shared<DebuggerExpression::Node>();
+					node->type = UnaryExpressionNode;
+					node->op = op;
+					node->left = operand;
+					node->depth = operand->depth + 1;
+					return node;
+				}
+			}
+			return ParsePrimary();
+		}
+
+		NodeRef ParsePrimary()
+		{
+			SkipSpaces();
+			if (m_pos >= m_text.size())
+			{
+				error = "unexpected end of expression";
+				return nullptr;
+			}
+
+			if (Consume("("))
+			{
+				NodeRef inner = ParseBinary(0);
+				if (!inner)
+					return nullptr;
+				if (!Consume(")"))
+				{
+					error = fmt::format("expecting ')' at offset {}", m_pos);
+					return nullptr;
+				}
+				return inner;
+			}
+
+			if (Consume("["))
+			{
+				NodeRef address = ParseBinary(0);
+				if (!address)
+					return nullptr;
+				if (!Consume("]"))
+				{
+					error = fmt::format("expecting ']' at offset {}", m_pos);
+					return nullptr;
+				}
+
+				auto node = std::make_shared<DebuggerExpression::Node>();
+				node->type = LoadExpressionNode;
+				node->left = address;
+				node->depth = address->depth + 1;
+				if (Consume(".q"))
+					node->size = 8;
+				else if (Consume(".d"))
+					node->size = 4;
+				else if (Consume(".w"))
+					node->size = 2;
+				else if (Consume(".b"))
+					node->size = 1;
+				return node;
+			}
+
+			char c = m_text[m_pos];
+			if (isdigit((unsigned char)c))
+			{
+				size_t end = 0;
+				uint64_t value = 0;
+				try
+				{
+					value = std::stoull(m_text.substr(m_pos), &end, 0);
+				}
+				catch (const std::exception&)
+				{
+					error = fmt::format("invalid number at offset {}", m_pos);
+					return nullptr;
+				}
+				m_pos += end;
+
+				auto node = std::make_shared<DebuggerExpression::Node>();
+				node->type = ConstantExpressionNode;
+				node->value = value;
+				return node;
+			}
+
+			if ((c == '$') || isalpha((unsigned char)c) || (c == '_'))
+			{
+				if (c == '$')
+					m_pos++;
+
+				size_t start = m_pos;
+				while (m_pos < m_text.size() && (isalnum((unsigned char)m_text[m_pos]) || (m_text[m_pos] == '_')))
+					m_pos++;
+
+				if (m_pos == start)
+				{
+					error = fmt::format("expecting a register name at offset {}", start);
+					return nullptr;
+				}
+
+				auto node = std::make_shared<DebuggerExpression::Node>();
+				node->type = RegisterExpressionNode;
+				node->name = m_text.substr(start, m_pos - start);
+				return node;
+			}
+
+			error = fmt::format("unexpected character '{}' at offset {}", c, m_pos);
+			return nullptr;
+		}
+
+	public:
+		std::string error;
+
+		ExpressionParser(const std::string& text) : m_text(text) {}
+
+		NodeRef Parse()
+		{
+			NodeRef root = ParseBinary(0);
+			if (!root)
+				return nullptr;
+
+			SkipSpaces();
+			if (m_pos != m_text.size())
+			{
+				error = fmt::format("unexpected character '{}' at offset {}", m_text[m_pos], m_pos);
+				return nullptr;
+			}
+			return root;
+		}
+	};
+
+
+	bool EvaluateNode(const DebuggerExpression::Node* node, const ExpressionRegisterReader& readRegister,
+		const ExpressionMemoryReader& readMemory, size_t addressSize, uint64_t& value)
+	{
+		switch (node->type)
+		{
+		case ConstantExpressionNode:
+			value = node->value;
+			return true;
+		case RegisterExpressionNode:
+			return readRegister(node->name, value);
+		case LoadExpressionNode:
+		{
+			uint64_t address;
+			if (!EvaluateNode(node->left.get(), readRegister, readMemory, addressSize, address))
+				return false;
+			return readMemory(address, node->size ? node->size : addressSize, value);
+		}
+		case UnaryExpressionNode:
+		{
+			uint64_t operand;
+			if (!EvaluateNode(node->left.get(), readRegister, readMemory, addressSize, operand))
+				return false;
+
+			if (node->op == "-")
+				value = -operand;
+			else if (node->op == "~")
+				value = ~operand;
+			else
+				value = !operand;
+			return true;
+		}
+		case BinaryExpressionNode:
+		{
+			uint64_t left, right;
+			if (!EvaluateNode(node->left.get(), readRegister, readMemory, addressSize, left))
+				return false;
+
+			// Short-circuit the logical operators, so that `rdi != 0 && [rdi] == 1` does not read from address 0
+			if ((node->op == "&&") && !left)
+			{
+				value = 0;
+				return true;
+			}
+			if ((node->op == "||") && left)
+			{
+				value = 1;
+				return true;
+			}
+
+			if (!EvaluateNode(node->right.get(), readRegister, readMemory, addressSize, right))
+				return false;
+
+			const std::string& op = node->op;
+			if (op == "+")
+				value = left + right;
+			else if (op == "-")
+				value = left - right;
+			else if (op == "*")
+				value = left * right;
+			else if ((op == "/") || (op == "%"))
+			{
+				if (right == 0)
+					return false;
+				value = (op == "/") ? left / right : left % right;
+			}
+			else if (op == "<<")
+				value = (right >= 64) ? 0 : left << right;
+			else if (op == ">>")
+				value = (right >= 64) ? 0 : left >> right;
+			else if (op == "&")
+				value = left & right;
+			else if (op == "|")
+				value = left | right;
+			else if (op == "^")
+				value = left ^ right;
+			else if (op == "==")
+				value = left == right;
+			else if (op == "!=")
+				value = left != right;
+			else if (op == "<")
+				value = left < right;
+			else if (op == "<=")
+				value = left <= right;
+			else if (op == ">")
+				value = left > right;
+			else if (op == ">=")
+				value = left >= right;
+			else if ((op == "&&") || (op == "||"))
+				value = right != 0;
+			else
+				return false;
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+}  // namespace
+
+
+bool DebuggerExpression::Parse(const std::string& text, DebuggerExpression& result, std::string& error)
+{
+	ExpressionParser parser(text);
+	NodeRef root = parser.Parse();
+	if (!root)
+	{
+		error = parser.error;
+		return false;
+	}
+
+	result.m_root = root;
+	result.m_text = text;
+	return true;
+}
+
+
+bool DebuggerExpression::Evaluate(const ExpressionRegisterReader& readRegister,
+	const ExpressionMemoryReader& readMemory, size_t addressSize, uint64_t& value) const
+{
+	if (!m_root)
+		return false;
+
+	return EvaluateNode(m_root.get(), readRegister, readMemory, addressSize, value);
+}
@@ -0,0 +1,61 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace BinaryNinjaDebugger {
+	// Callbacks used by the evaluator to access the target. They return false on failure.
+	typedef std::function<bool(const std::string& name, uint64_t& value)> ExpressionRegisterReader;
+	typedef std::function<bool(uint64_t address, size_t size, uint64_t& value)> ExpressionMemoryReader;
+
+	// A small expression language that looks like the LLIL text representation, e.g., `rax == 0x10 && [rsp + 8].d != 0`.
+	// It is used for breakpoint conditions, which are evaluated in the adapter event thread, so it must not depend on
+	// the debugger caches or the analysis. An expression is parsed once and can then be evaluated cheaply many times.
+	//
+	// Supported syntax:
+	//   - integers, in decimal or hex (0x prefix)
+	//   - register names, optionally prefixed with `$`
+	//   - memory loads: `[expr]` reads a pointer-sized value, `[expr].b/.w/.d/.q` reads 1/2/4/8 bytes
+	//   - unary operators: - ~ !
+	//   - binary operators, with C precedence: * / % + - << >> < <= > >= == != & ^ | && ||
+	// All arithmetic is done on unsigned 64-bit values. Expressions nested more than 256 levels deep are rejected.
+	class DebuggerExpression
+	{
+	public:
+		struct Node;
+
+	private:
+		std::shared_ptr<const Node> m_root;
+		std::string m_text;
+
+	public:
+		DebuggerExpression() = default;
+
+		// Returns false and sets error if the text cannot be parsed
+		static bool Parse(const std::string& text, DebuggerExpression& result, std::string& error);
+
+		bool IsValid() const { return m_root != nullptr; }
+		const std::string& GetText() const { return m_text; }
+
+		bool Evaluate(const ExpressionRegisterReader& readRegister, const ExpressionMemoryReader& readMemory,
+			size_t addressSize, uint64_t& value) const;
+	};
+};  // namespace BinaryNinjaDebugger
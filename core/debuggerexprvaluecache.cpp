@@ -0,0 +1,83 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggerexprvaluecache.h"
+
+using namespace BinaryNinja;
+using namespace BinaryNinjaDebugger;
+
+// The cache is simply emptied when it grows beyond this many expressions
+static constexpr size_t MaxCachedExprValues = 64 * 1024;
+
+
+bool DebuggerExprValueCache::Lookup(uint64_t epoch, uint64_t functionStart, BNFunctionGraphType il, size_t expr,
+	bool& ok, uint64_t& value, uint64_t& generation)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (epoch != m_epoch)
+	{
+		m_values.clear();
+		m_epoch = epoch;
+		m_generation++;
+	}
+
+	auto it = m_values.find(std::make_tuple(functionStart, il, expr));
+	if (it == m_values.end())
+	{
+		m_misses++;
+		generation = m_generation;
+		return false;
+	}
+
+	m_hits++;
+	ok = it->second.m_ok;
+	value = it->second.m_value;
+	return true;
+}
+
+
+void DebuggerExprValueCache::Store(uint64_t generation, uint64_t functionStart, BNFunctionGraphType il, size_t expr,
+	bool ok, uint64_t value)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	// The target state has changed while the value was computed
+	if (generation != m_generation)
+		return;
+
+	if (m_values.size() >= MaxCachedExprValues)
+		m_values.clear();
+
+	m_values[std::make_tuple(functionStart, il, expr)] = {ok, value};
+}
+
+
+void DebuggerExprValueCache::Clear()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_values.clear();
+	m_generation++;
+}
+
+
+ExprValueCacheStats DebuggerExprValueCache::GetStats()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	ExprValueCacheStats stats;
+	stats.m_hits = m_hits;
+	stats.m_misses = m_misses;
+	stats.m_entries = m_values.size();
+	return stats;
+}
@@ -0,0 +1,66 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include "binaryninjaapi.h"
+
+namespace BinaryNinjaDebugger {
+	struct ExprValueCacheStats
+	{
+		uint64_t m_hits = 0;
+		uint64_t m_misses = 0;
+		size_t m_entries = 0;
+	};
+
+	// Caches the values of the IL expressions computed by DebuggerController::ComputeExprValue(). The debugger info
+	// widget computes every operand of every visible instruction, and the same subexpressions, e.g., an offset from the
+	// stack pointer, show up on many lines. The entries belong to one stop epoch, i.e., they are dropped once the
+	// target resumes or stops again. They are also dropped when the registers, the memory or the IL may have changed.
+	class DebuggerExprValueCache
+	{
+	private:
+		struct CachedValue
+		{
+			bool m_ok;
+			uint64_t m_value;
+		};
+
+		std::mutex m_mutex;
+		uint64_t m_epoch = 0;
+		// Changes whenever the entries are dropped, so a value computed before that is not stored
+		uint64_t m_generation = 0;
+		// Keyed by the start of the function owning the IL, the IL level and the expression index. The IL function
+		// object itself is not used since its address can be reused once it is freed.
+		std::map<std::tuple<uint64_t, BNFunctionGraphType, size_t>, CachedValue> m_values;
+		uint64_t m_hits = 0;
+		uint64_t m_misses = 0;
+
+	public:
+		// Returns true if the result of the expression is cached for the epoch. ok tells whether the value could be
+		// computed. Otherwise, the value should be computed and passed to Store() along with the generation.
+		bool Lookup(uint64_t epoch, uint64_t functionStart, BNFunctionGraphType il, size_t expr, bool& ok,
+			uint64_t& value, uint64_t& generation);
+		void Store(uint64_t generation, uint64_t functionStart, BNFunctionGraphType il, size_t expr, bool ok,
+			uint64_t value);
+		void Clear();
+		ExprValueCacheStats GetStats();
+	};
+};  // namespace BinaryNinjaDebugger
@@ -34,7 +34,8 @@ DebuggerFileAccessor::DebuggerFileAccessor(BinaryView* parent)
 	m_controller = DebuggerController::GetController(parent);
 	m_eventCallback = m_controller->RegisterEventCallback([this](const DebuggerEvent& event){
 		eventHandler(event);
-	}, "Process View");
+	}, "Process View", SynchronousEventDelivery,
+		DebuggerEventMask({TargetStoppedEventType, ForceMemoryCacheUpdateEvent}));
 }
 
 
@@ -0,0 +1,108 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggerinstructioncache.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace BinaryNinja;
+using namespace BinaryNinjaDebugger;
+
+// The cache is simply emptied when it grows beyond this many instructions
+static constexpr size_t MaxCachedInstructions = 64 * 1024;
+
+
+std::shared_ptr<const DecodedInstruction> DebuggerInstructionCache::Decode(Ref<Architecture> arch, uint64_t address,
+	const uint8_t* data, size_t len, bool lift)
+{
+	if (!arch || !data || (len == 0))
+		return nullptr;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::shared_ptr<const DecodedInstruction> cached;
+	auto it = m_instructions.find(address);
+	if (it != m_instructions.end())
+	{
+		const auto& instruction = it->second;
+		if ((instruction->m_arch == arch) && (instruction->m_bytes.size() <= len)
+			&& (memcmp(instruction->m_bytes.data(), data, instruction->m_bytes.size()) == 0))
+		{
+			if (!lift || instruction->m_lifted)
+				return instruction;
+			cached = instruction;
+		}
+	}
+
+	std::shared_ptr<DecodedInstruction> result;
+	if (cached)
+	{
+		// Only the LLIL is missing. The cached entries are shared, so a new one is created.
+		result = std::make_shared<DecodedInstruction>(*cached);
+	}
+	else
+	{
+		result = std::make_shared<DecodedInstruction>();
+		result->m_address = address;
+		result->m_arch = arch;
+		if (!arch->GetInstructionInfo(data, address, len, result->m_info) || (result->m_info.length == 0)
+			|| (result->m_info.length > len))
+		{
+			m_instructions.erase(address);
+			return nullptr;
+		}
+		result->m_bytes.assign(data, data + result->m_info.length);
+	}
+
+	if (lift)
+	{
+		Ref<LowLevelILFunction> ilFunc = new LowLevelILFunction(arch, nullptr);
+		ilFunc->SetCurrentAddress(arch, address);
+		if (arch->GetInstructionLowLevelIL(data, address, len, *ilFunc) && (ilFunc->GetInstructionCount() > 0))
+			result->m_llil = ilFunc;
+		result->m_lifted = true;
+	}
+
+	if (m_instructions.size() >= MaxCachedInstructions)
+		m_instructions.clear();
+
+	m_maxInstructionLength = std::max(m_maxInstructionLength, arch->GetMaxInstructionLength());
+	m_instructions[address] = result;
+	return result;
+}
+
+
+void DebuggerInstructionCache::Invalidate(uint64_t address, size_t size)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	// An instruction that starts before the range can still extend into it
+	uint64_t start = address > m_maxInstructionLength ? address - m_maxInstructionLength : 0;
+	uint64_t end = address + size;
+	auto it = m_instructions.lower_bound(start);
+	while ((it != m_instructions.end()) && (it->first < end))
+	{
+		if (it->first + it->second->GetLength() > address)
+			it = m_instructions.erase(it);
+		else
+			++it;
+	}
+}
+
+
+void DebuggerInstructionCache::Clear()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_instructions.clear();
+}
@@ -0,0 +1,65 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "binaryninjaapi.h"
+
+namespace BinaryNinjaDebugger {
+	struct DecodedInstruction
+	{
+		uint64_t m_address;
+		BinaryNinja::Ref<BinaryNinja::Architecture> m_arch;
+		// The bytes of the instruction, which are compared against the memory on every lookup
+		std::vector<uint8_t> m_bytes;
+		// The length and the branches of the instruction
+		BinaryNinja::InstructionInfo m_info;
+		// The lifted LLIL of the instruction. It is only lifted when requested, since that costs much more than
+		// decoding the instruction.
+		BinaryNinja::Ref<BinaryNinja::LowLevelILFunction> m_llil;
+		bool m_lifted = false;
+
+		size_t GetLength() const { return m_info.length; }
+	};
+
+	// Caches the decoded instructions of the target by address, so that stepping, emulation, tracing, and the UI do not
+	// decode and lift the same bytes again and again. The entries are invalidated when DebuggerMemory writes to the
+	// memory or finds that a cached block has changed. Since code can also be modified by the target itself, a lookup
+	// still compares the bytes of the entry against the memory it is given.
+	class DebuggerInstructionCache
+	{
+	private:
+		std::mutex m_mutex;
+		std::map<uint64_t, std::shared_ptr<const DecodedInstruction>> m_instructions;
+		// The longest instruction of the architectures seen so far, which bounds the entries overlapping a range
+		size_t m_maxInstructionLength = 1;
+
+	public:
+		// Returns the instruction at the start of data, or nullptr if the bytes are not a valid instruction. When lift is
+		// true, the returned instruction has its LLIL lifted, if the architecture can lift it.
+		std::shared_ptr<const DecodedInstruction> Decode(BinaryNinja::Ref<BinaryNinja::Architecture> arch,
+			uint64_t address, const uint8_t* data, size_t len, bool lift = false);
+
+		// Drops the instructions that overlap the range
+		void Invalidate(uint64_t address, size_t size);
+		void Clear();
+	};
+};  // namespace BinaryNinjaDebugger
@@ -0,0 +1,529 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggerinstructiontrace.h"
+#include "debugadapter.h"
+#include "lowlevelilinstruction.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace BinaryNinja;
+using namespace BinaryNinjaDebugger;
+
+// The exported file has the offset of every this many records
+static constexpr uint64_t InstructionTraceIndexInterval = 1024;
+static const char InstructionTraceMagic[8] = {'B', 'N', 'D', 'T', 'R', 'A', 'C', 'E'};
+// The instruction pointer and the flags are read after every step, since they are not always written in the IL
+static const char* const InstructionPointerAndFlagsRegisters[] = {"rip", "eip", "pc", "rflags", "eflags", "cpsr"};
+
+
+template <typename T>
+static void AppendValue(std::vector<uint8_t>& data, T value)
+{
+	// The supported targets and hosts are all little-endian
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T));
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+
+template <typename T>
+static T ExtractValue(const std::vector<uint8_t>& data, size_t& offset)
+{
+	T value {};
+	if (offset + sizeof(T) <= data.size())
+		memcpy(&value, data.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return value;
+}
+
+
+static std::vector<uint8_t> SerializeRecord(const InstructionTraceRecord& record)
+{
+	std::vector<uint8_t> data;
+	data.reserve(10);
+	AppendValue<uint64_t>(data, record.m_pc);
+	AppendValue<uint8_t>(data, (uint8_t)std::min<size_t>(record.m_registers.size(), UINT8_MAX));
+	AppendValue<uint8_t>(data, (uint8_t)std::min<size_t>(record.m_memory.size(), UINT8_MAX));
+	for (size_t i = 0; i < record.m_registers.size() && i < UINT8_MAX; i++)
+	{
+		AppendValue<uint16_t>(data, record.m_registers[i].first);
+		AppendValue<uint64_t>(data, record.m_registers[i].second);
+	}
+	for (size_t i = 0; i < record.m_memory.size() && i < UINT8_MAX; i++)
+	{
+		const auto& access = record.m_memory[i];
+		AppendValue<uint64_t>(data, access.m_address);
+		AppendValue<uint8_t>(data, (uint8_t)access.m_bytes.size());
+		data.insert(data.end(), access.m_bytes.begin(), access.m_bytes.end());
+	}
+	return data;
+}
+
+
+static InstructionTraceRecord DeserializeRecord(const std::vector<uint8_t>& data)
+{
+	InstructionTraceRecord record;
+	size_t offset = 0;
+	record.m_pc = ExtractValue<uint64_t>(data, offset);
+	uint8_t registerCount = ExtractValue<uint8_t>(data, offset);
+	uint8_t memoryCount = ExtractValue<uint8_t>(data, offset);
+	for (size_t i = 0; i < registerCount; i++)
+	{
+		uint16_t index = ExtractValue<uint16_t>(data, offset);
+		uint64_t value = ExtractValue<uint64_t>(data, offset);
+		record.m_registers.emplace_back(index, value);
+	}
+	for (size_t i = 0; i < memoryCount; i++)
+	{
+		InstructionTraceMemoryAccess access;
+		access.m_address = ExtractValue<uint64_t>(data, offset);
+		uint8_t size = ExtractValue<uint8_t>(data, offset);
+		if (offset + size > data.size())
+			break;
+		access.m_bytes.assign(data.begin() + offset, data.begin() + offset + size);
+		offset += size;
+		record.m_memory.push_back(access);
+	}
+	return record;
+}
+
+
+void DebuggerInstructionTrace::Start(DebugAdapter* adapter, DebuggerInstructionCache* instructionCache,
+	Ref<Architecture> arch, const InstructionTraceOptions& options, uint64_t pc)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_adapter = adapter;
+	m_instructionCache = instructionCache;
+	m_arch = arch;
+	m_options = options;
+	m_steps = 0;
+	// The records are found through m_recordOffsets, so the stale bytes of the previous trace need not be cleared
+	size_t bufferSize = std::max<size_t>(options.m_bufferSize, 4096);
+	if (m_buffer.size() != bufferSize)
+	{
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+		m_buffer.resize(bufferSize);
+	}
+	m_recordOffsets.clear();
+	m_end = 0;
+	m_droppedCount = 0;
+	m_registerNames.clear();
+	m_registerIndices.clear();
+	m_lastRegisters.clear();
+	m_pendingAccesses.clear();
+	m_instructions.clear();
+	m_currentInstruction = nullptr;
+
+	// The registers are recorded as they are before the instruction executes, and the memory after it. All registers
+	// are read for the first record, which the written registers are then looked up in.
+	m_current = {pc, {}, {}};
+	if (m_options.m_recordRegisters)
+		RecordRegisters(m_current);
+	if (m_options.m_recordRegisters || m_options.m_recordMemory)
+		m_currentInstruction = &GetInstruction(pc);
+	if (m_options.m_recordMemory)
+		m_pendingAccesses = GetMemoryAccesses(pc);
+}
+
+
+void DebuggerInstructionTrace::Stop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	// The instruction at the current pc has not executed, so it is not recorded
+	m_adapter = nullptr;
+	m_instructionCache = nullptr;
+	m_pendingAccesses.clear();
+	m_instructions.clear();
+	m_currentInstruction = nullptr;
+}
+
+
+bool DebuggerInstructionTrace::Step(uint64_t pc)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_adapter)
+		return false;
+
+	if (m_options.m_recordMemory)
+		RecordMemory(m_current);
+	Append(SerializeRecord(m_current));
+	m_steps++;
+
+	if ((m_options.m_maxSteps && (m_steps >= m_options.m_maxSteps)) || (m_options.m_hasStopAddress && (pc == m_options.m_stopAddress)))
+		return false;
+
+	m_current = {pc, {}, {}};
+	if (m_options.m_recordRegisters)
+		RecordRegisters(m_current);
+	if (m_options.m_recordRegisters || m_options.m_recordMemory)
+		m_currentInstruction = &GetInstruction(pc);
+	if (m_options.m_recordMemory)
+		m_pendingAccesses = GetMemoryAccesses(pc);
+	return true;
+}
+
+
+void DebuggerInstructionTrace::Append(const std::vector<uint8_t>& record)
+{
+	if (record.size() > m_buffer.size())
+	{
+		m_droppedCount++;
+		return;
+	}
+
+	while (!m_recordOffsets.empty() && (m_end + record.size() - m_recordOffsets.front() > m_buffer.size()))
+	{
+		m_recordOffsets.pop_front();
+		m_droppedCount++;
+	}
+
+	m_recordOffsets.push_back(m_end);
+	for (uint8_t byte : record)
+		m_buffer[(m_end++) % m_buffer.size()] = byte;
+}
+
+
+std::vector<uint8_t> DebuggerInstructionTrace::ReadRecord(size_t index) const
+{
+	uint64_t start = m_recordOffsets[index];
+	uint64_t end = (index + 1 < m_recordOffsets.size()) ? m_recordOffsets[index + 1] : m_end;
+	std::vector<uint8_t> result;
+	result.reserve(end - start);
+	for (uint64_t offset = start; offset < end; offset++)
+		result.push_back(m_buffer[offset % m_buffer.size()]);
+	return result;
+}
+
+
+void DebuggerInstructionTrace::RecordRegisters(InstructionTraceRecord& record)
+{
+	// The registers written by the instruction that just executed
+	if (!m_currentInstruction || !m_currentInstruction->m_writtenRegistersKnown)
+	{
+		for (const auto& [name, reg] : m_adapter->ReadAllRegisters())
+			RecordRegister(record, name, reg.m_value);
+		return;
+	}
+
+	for (const auto& name : m_currentInstruction->m_writtenRegisters)
+	{
+		DebugRegister reg = m_adapter->ReadRegister(name);
+		if (!reg.m_name.empty())
+			RecordRegister(record, name, reg.m_value);
+	}
+}
+
+
+void DebuggerInstructionTrace::RecordRegister(InstructionTraceRecord& record, const std::string& name, uint64_t value)
+{
+	auto last = m_lastRegisters.find(name);
+	if ((last != m_lastRegisters.end()) && (last->second == value))
+		return;
+	m_lastRegisters[name] = value;
+
+	auto it = m_registerIndices.find(name);
+	if (it == m_registerIndices.end())
+	{
+		it = m_registerIndices.emplace(name, (uint16_t)m_registerNames.size()).first;
+		m_registerNames.push_back(name);
+	}
+	record.m_registers.emplace_back(it->second, value);
+}
+
+
+const DebuggerInstructionTrace::TracedInstruction& DebuggerInstructionTrace::GetInstruction(uint64_t pc)
+{
+	auto it = m_instructions.find(pc);
+	if (it != m_instructions.end())
+		return it->second;
+
+	TracedInstruction& result = m_instructions[pc];
+	if (!m_arch)
+		return result;
+
+	// The target is running as far as DebuggerMemory is concerned, so the bytes are read from the adapter. The cache
+	// still saves lifting the instructions again, when the same code is traced again.
+	DataBuffer buffer = m_adapter->ReadMemory(pc, m_arch->GetMaxInstructionLength());
+	result.m_instruction =
+		m_instructionCache->Decode(m_arch, pc, (const uint8_t*)buffer.GetData(), buffer.GetLength(), true);
+	if (result.m_instruction && m_options.m_recordRegisters)
+		result.m_writtenRegistersKnown = GetWrittenRegisters(*result.m_instruction, result.m_writtenRegisters);
+	return result;
+}
+
+
+bool DebuggerInstructionTrace::GetWrittenRegisters(
+	const DecodedInstruction& instruction, std::vector<std::string>& names)
+{
+	names.clear();
+	if (!instruction.m_llil)
+		return false;
+
+	// The names must match the ones the adapter returned when all registers were read
+	auto addRegister = [&](uint32_t reg) {
+		if (LLIL_REG_IS_TEMP(reg))
+			return true;
+		std::string name = m_arch->GetRegisterName(m_arch->GetRegisterInfo(reg).fullWidthRegister);
+		if (m_registerIndices.find(name) == m_registerIndices.end())
+			return false;
+		if (std::find(names.begin(), names.end(), name) == names.end())
+			names.push_back(name);
+		return true;
+	};
+
+	Ref<LowLevelILFunction> ilFunc = instruction.m_llil;
+	for (size_t i = 0; i < ilFunc->GetInstructionCount(); i++)
+	{
+		LowLevelILInstruction instr = ilFunc->GetInstruction(i);
+		switch (instr.operation)
+		{
+		case LLIL_SET_REG:
+			if (!addRegister(instr.GetDestRegister<LLIL_SET_REG>()))
+				return false;
+			break;
+		case LLIL_SET_REG_SPLIT:
+			if (!addRegister(instr.GetHighRegister<LLIL_SET_REG_SPLIT>())
+				|| !addRegister(instr.GetLowRegister<LLIL_SET_REG_SPLIT>()))
+				return false;
+			break;
+		case LLIL_NOP:
+		case LLIL_SET_FLAG:
+		case LLIL_STORE:
+		case LLIL_PUSH:
+		case LLIL_GOTO:
+		case LLIL_IF:
+		case LLIL_JUMP:
+		case LLIL_JUMP_TO:
+		case LLIL_RET:
+			break;
+		default:
+			// Calls, system calls, intrinsics, and unlifted instructions can write registers that are not in the IL
+			return false;
+		}
+	}
+
+	// The stack pointer changes with the pushes and pops nested in the expressions
+	if (!addRegister(m_arch->GetStackPointerRegister()))
+		return false;
+	for (const char* name : InstructionPointerAndFlagsRegisters)
+	{
+		if ((m_registerIndices.find(name) != m_registerIndices.end())
+			&& (std::find(names.begin(), names.end(), name) == names.end()))
+			names.push_back(name);
+	}
+	return true;
+}
+
+
+void DebuggerInstructionTrace::RecordMemory(InstructionTraceRecord& record)
+{
+	for (const auto& [address, size] : m_pendingAccesses)
+	{
+		DataBuffer buffer = m_adapter->ReadMemory(address, size);
+		if (buffer.GetLength() != size)
+			continue;
+
+		InstructionTraceMemoryAccess access;
+		access.m_address = address;
+		access.m_bytes.assign((const uint8_t*)buffer.GetData(), (const uint8_t*)buffer.GetData() + size);
+		record.m_memory.push_back(access);
+	}
+	m_pendingAccesses.clear();
+}
+
+
+std::vector<std::pair<uint64_t, size_t>> DebuggerInstructionTrace::GetMemoryAccesses(uint64_t pc)
+{
+	std::vector<std::pair<uint64_t, size_t>> result;
+	auto instruction = GetInstruction(pc).m_instruction;
+	if (!instruction || !instruction->m_llil)
+		return result;
+
+	Ref<LowLevelILFunction> ilFunc = instruction->m_llil;
+
+	// Only the address expressions made of registers, constants, and simple arithmetic are evaluated. The registers
+	// hold the values before the instruction executes.
+	std::function<bool(const LowLevelILInstruction&, uint64_t&)> evaluate;
+	evaluate = [&](const LowLevelILInstruction& expr, uint64_t& value) {
+		uint64_t left, right;
+		switch (expr.operation)
+		{
+		case LLIL_CONST:
+		case LLIL_CONST_PTR:
+			value = expr.GetConstant();
+			return true;
+		case LLIL_REG:
+		{
+			uint32_t reg = expr.GetSourceRegister<LLIL_REG>();
+			if (LLIL_REG_IS_TEMP(reg))
+				return false;
+			DebugRegister regValue = m_adapter->ReadRegister(m_arch->GetRegisterName(reg));
+			if (regValue.m_name.empty())
+				return false;
+			value = regValue.m_value;
+			return true;
+		}
+		case LLIL_ADD:
+		case LLIL_SUB:
+		case LLIL_MUL:
+		case LLIL_LSL:
+			if (!evaluate(expr.GetLeftExpr(), left) || !evaluate(expr.GetRightExpr(), right))
+				return false;
+			if (expr.operation == LLIL_ADD)
+				value = left + right;
+			else if (expr.operation == LLIL_SUB)
+				value = left - right;
+			else if (expr.operation == LLIL_MUL)
+				value = left * right;
+			else
+				value = (right >= 64) ? 0 : left << right;
+			return true;
+		case LLIL_ZX:
+		case LLIL_SX:
+		case LLIL_LOW_PART:
+			return evaluate(expr.GetSourceExpr(), value);
+		default:
+			return false;
+		}
+	};
+
+	std::string stackPointer = m_arch->GetRegisterName(m_arch->GetStackPointerRegister());
+	for (size_t i = 0; i < ilFunc->GetInstructionCount(); i++)
+	{
+		ilFunc->GetInstruction(i).VisitExprs([&](const LowLevelILInstruction& expr) {
+			uint64_t address;
+			switch (expr.operation)
+			{
+			case LLIL_LOAD:
+				if (evaluate(expr.GetSourceExpr<LLIL_LOAD>(), address))
+					result.emplace_back(address, expr.size);
+				break;
+			case LLIL_STORE:
+				if (evaluate(expr.GetDestExpr<LLIL_STORE>(), address))
+					result.emplace_back(address, expr.size);
+				break;
+			case LLIL_PUSH:
+			case LLIL_POP:
+			{
+				DebugRegister sp = m_adapter->ReadRegister(stackPointer);
+				if (!sp.m_name.empty())
+					result.emplace_back(expr.operation == LLIL_PUSH ? sp.m_value - expr.size : sp.m_value, expr.size);
+				break;
+			}
+			default:
+				break;
+			}
+			return true;
+		});
+	}
+	return result;
+}
+
+
+uint64_t DebuggerInstructionTrace::GetStepCount()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_steps;
+}
+
+
+uint64_t DebuggerInstructionTrace::GetDroppedRecordCount()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_droppedCount;
+}
+
+
+std::vector<std::string> DebuggerInstructionTrace::GetRegisterNames()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_registerNames;
+}
+
+
+std::vector<uint64_t> DebuggerInstructionTrace::GetAddresses()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::vector<uint64_t> result;
+	result.reserve(m_recordOffsets.size());
+	for (uint64_t offset : m_recordOffsets)
+	{
+		// The pc is at the start of every record
+		uint64_t pc = 0;
+		for (size_t i = 0; i < sizeof(pc); i++)
+			pc |= (uint64_t)m_buffer[(offset + i) % m_buffer.size()] << (i * 8);
+		result.push_back(pc);
+	}
+	return result;
+}
+
+
+std::vector<InstructionTraceRecord> DebuggerInstructionTrace::GetRecords()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::vector<InstructionTraceRecord> result;
+	result.reserve(m_recordOffsets.size());
+	for (size_t i = 0; i < m_recordOffsets.size(); i++)
+		result.push_back(DeserializeRecord(ReadRecord(i)));
+	return result;
+}
+
+
+bool DebuggerInstructionTrace::Export(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LogWarn("Failed to open %s for writing the instruction trace", path.c_str());
+		return false;
+	}
+
+	std::vector<uint8_t> data(InstructionTraceMagic, InstructionTraceMagic + sizeof(InstructionTraceMagic));
+	AppendValue<uint32_t>(data, FileVersion);
+	AppendValue<uint32_t>(data, (uint32_t)m_registerNames.size());
+	AppendValue<uint64_t>(data, m_recordOffsets.size());
+	AppendValue<uint64_t>(data, m_droppedCount);
+	size_t indexOffsetPosition = data.size();
+	AppendValue<uint64_t>(data, 0);
+
+	for (const auto& name : m_registerNames)
+	{
+		AppendValue<uint16_t>(data, (uint16_t)name.size());
+		data.insert(data.end(), name.begin(), name.end());
+	}
+
+	std::vector<uint64_t> index;
+	for (size_t i = 0; i < m_recordOffsets.size(); i++)
+	{
+		if (i % InstructionTraceIndexInterval == 0)
+			index.push_back(data.size());
+		std::vector<uint8_t> record = ReadRecord(i);
+		data.insert(data.end(), record.begin(), record.end());
+	}
+
+	uint64_t indexOffset = data.size();
+	memcpy(data.data() + indexOffsetPosition, &indexOffset, sizeof(indexOffset));
+	AppendValue<uint64_t>(data, index.size());
+	for (uint64_t offset : index)
+		AppendValue<uint64_t>(data, offset);
+
+	file.write((const char*)data.data(), data.size());
+	return file.good();
+}
@@ -0,0 +1,142 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "binaryninjaapi.h"
+#include "debuggerinstructioncache.h"
+
+namespace BinaryNinjaDebugger {
+	class DebugAdapter;
+
+	struct InstructionTraceOptions
+	{
+		// The tracing ends after this many steps (0 means no limit), or when the target reaches m_stopAddress,
+		// whichever comes first
+		uint64_t m_maxSteps = 0;
+		uint64_t m_stopAddress = 0;
+		bool m_hasStopAddress = false;
+		// Record the registers that changed in every step. All registers are read when the tracing starts, and after
+		// that only the ones the executed instruction can write.
+		bool m_recordRegisters = false;
+		// Record the memory loaded or stored by every instruction, with its value after the instruction executes
+		bool m_recordMemory = false;
+		// The size of the ring buffer in bytes. The oldest records are dropped when it is full.
+		size_t m_bufferSize = 64 * 1024 * 1024;
+	};
+
+	struct InstructionTraceMemoryAccess
+	{
+		uint64_t m_address;
+		std::vector<uint8_t> m_bytes;
+	};
+
+	struct InstructionTraceRecord
+	{
+		uint64_t m_pc;
+		// Register index, as in GetRegisterNames(), and value
+		std::vector<std::pair<uint16_t, uint64_t>> m_registers;
+		std::vector<InstructionTraceMemoryAccess> m_memory;
+	};
+
+	// Records the instructions executed by the target while the adapter single-steps it from its event thread. Every
+	// step appends a compact binary record to a ring buffer: the pc, followed by the changed registers and the
+	// accessed memory when they are requested. Nothing is sent to the UI until the tracing ends. Every step is still a
+	// single-step round trip through the adapter, which bounds the rate, see test_instruction_trace_throughput.
+	//
+	// The exported file is little-endian, and consists of:
+	//   header:    "BNDTRACE", u32 version, u32 register count, u64 record count, u64 dropped record count,
+	//              u64 offset of the index
+	//   registers: for each register, u16 name length and the name
+	//   records:   u64 pc, u8 register count, u8 memory access count, then for each register u16 index and u64 value,
+	//              and for each memory access u64 address, u8 size and the bytes
+	//   index:     u64 count, followed by the file offsets of every InstructionTraceIndexInterval-th record
+	class DebuggerInstructionTrace
+	{
+	private:
+		std::mutex m_mutex;
+		DebugAdapter* m_adapter = nullptr;
+		DebuggerInstructionCache* m_instructionCache = nullptr;
+		BinaryNinja::Ref<BinaryNinja::Architecture> m_arch;
+		InstructionTraceOptions m_options;
+		uint64_t m_steps = 0;
+
+		// The bytes of the records wrap around in m_buffer. The offsets increase monotonically, and are wrapped when
+		// indexing m_buffer.
+		std::vector<uint8_t> m_buffer;
+		std::deque<uint64_t> m_recordOffsets;
+		uint64_t m_end = 0;
+		uint64_t m_droppedCount = 0;
+
+		std::vector<std::string> m_registerNames;
+		std::unordered_map<std::string, uint16_t> m_registerIndices;
+		std::unordered_map<std::string, uint64_t> m_lastRegisters;
+		// The record of the instruction at the current pc, which is appended once it executes
+		InstructionTraceRecord m_current;
+		// The memory accessed by the instruction at the current pc, which is read after it executes
+		std::vector<std::pair<uint64_t, size_t>> m_pendingAccesses;
+
+		struct TracedInstruction
+		{
+			std::shared_ptr<const DecodedInstruction> m_instruction;
+			// The registers the instruction can write, which are read after it executes. All registers are read
+			// instead when they are not known, e.g., for calls and system calls.
+			std::vector<std::string> m_writtenRegisters;
+			bool m_writtenRegistersKnown = false;
+		};
+		// The instructions are read and analyzed once per trace, since the code is assumed not to change while it is
+		// traced. This saves reading the instruction from the target on every step.
+		std::unordered_map<uint64_t, TracedInstruction> m_instructions;
+		// The instruction at the current pc, or nullptr before the first one
+		const TracedInstruction* m_currentInstruction = nullptr;
+
+		void Append(const std::vector<uint8_t>& record);
+		std::vector<uint8_t> ReadRecord(size_t index) const;
+		void RecordRegisters(InstructionTraceRecord& record);
+		void RecordRegister(InstructionTraceRecord& record, const std::string& name, uint64_t value);
+		const TracedInstruction& GetInstruction(uint64_t pc);
+		bool GetWrittenRegisters(const DecodedInstruction& instruction, std::vector<std::string>& names);
+		void RecordMemory(InstructionTraceRecord& record);
+		std::vector<std::pair<uint64_t, size_t>> GetMemoryAccesses(uint64_t pc);
+
+	public:
+		static constexpr uint32_t FileVersion = 1;
+
+		// Clears the previous trace. The adapter and the cache must stay valid until Stop() is called.
+		void Start(DebugAdapter* adapter, DebuggerInstructionCache* instructionCache,
+			BinaryNinja::Ref<BinaryNinja::Architecture> arch,
+			const InstructionTraceOptions& options, uint64_t pc);
+		void Stop();
+
+		// Called from the adapter event thread after every step. Returns false when the tracing should end.
+		bool Step(uint64_t pc);
+
+		uint64_t GetStepCount();
+		uint64_t GetDroppedRecordCount();
+		std::vector<std::string> GetRegisterNames();
+		std::vector<uint64_t> GetAddresses();
+		std::vector<InstructionTraceRecord> GetRecords();
+
+		bool Export(const std::string& path);
+	};
+};  // namespace BinaryNinjaDebugger
@@ -0,0 +1,876 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggerllilinterpreter.h"
+#include "debuggerstate.h"
+#include "debuggercontroller.h"
+#include <cinttypes>
+#include <cstring>
+
+using namespace BinaryNinja;
+using namespace BinaryNinjaDebugger;
+
+// Bounds the LLIL instructions executed for one native instruction, e.g., with a rep prefix
+static constexpr size_t MaxILInstructionsPerStep = 4096;
+
+// The names some adapters use for the registers, when they differ from the names in the architecture
+static const std::map<std::string, std::string> RegisterAliases = {{"x29", "fp"}, {"x30", "lr"}};
+
+// The register that holds the flags of each architecture, under the names the adapters use for it, and the bit of each
+// flag in it
+struct FlagsRegister
+{
+	std::vector<std::string> m_names;
+	std::map<std::string, uint64_t> m_bits;
+};
+
+static const std::map<std::string, uint64_t> X86FlagBits = {
+	{"c", 0}, {"p", 2}, {"a", 4}, {"z", 6}, {"s", 7}, {"d", 10}, {"o", 11}};
+static const std::map<std::string, uint64_t> ArmFlagBits = {{"n", 31}, {"z", 30}, {"c", 29}, {"v", 28}};
+static const std::map<std::string, FlagsRegister> FlagsRegisters = {
+	{"x86", {{"eflags"}, X86FlagBits}},
+	{"x86_64", {{"rflags", "eflags"}, X86FlagBits}},
+	{"aarch64", {{"cpsr", "nzcv"}, ArmFlagBits}},
+	{"armv7", {{"cpsr"}, ArmFlagBits}},
+	{"thumb2", {{"cpsr"}, ArmFlagBits}},
+};
+
+
+static uint64_t SizeMask(size_t size)
+{
+	if (size >= 8)
+		return ~0ULL;
+	if (size == 0)
+		return 1;
+	return (1ULL << (size * 8)) - 1;
+}
+
+
+static int64_t SignExtend(uint64_t value, size_t size)
+{
+	if ((size == 0) || (size >= 8))
+		return value;
+	uint64_t sign = 1ULL << (size * 8 - 1);
+	value &= SizeMask(size);
+	return (int64_t)((value ^ sign) - sign);
+}
+
+
+DebuggerLLILInterpreter::DebuggerLLILInterpreter(DebuggerState* state) : m_state(state) {}
+
+
+bool DebuggerLLILInterpreter::ReadFullRegister(uint32_t reg, uint64_t& value)
+{
+	if (auto it = m_registers.find(reg); it != m_registers.end())
+	{
+		value = it->second;
+		return true;
+	}
+
+	if (m_arch->GetRegisterInfo(reg).size > 8)
+		return false;
+
+	std::string name = m_arch->GetRegisterName(reg);
+	DebuggerRegisters* registers = m_state->GetRegisters();
+	if (!registers->GetRegisterValue(name, value))
+	{
+		auto alias = RegisterAliases.find(name);
+		if ((alias == RegisterAliases.end()) || !registers->GetRegisterValue(alias->second, value))
+			return false;
+		name = alias->second;
+	}
+
+	m_registers[reg] = value;
+	m_registerNames[reg] = name;
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::ReadRegister(uint32_t reg, uint64_t& value)
+{
+	if (LLIL_REG_IS_TEMP(reg))
+	{
+		auto it = m_tempRegisters.find(reg);
+		if (it == m_tempRegisters.end())
+			return false;
+		value = it->second;
+		return true;
+	}
+
+	BNRegisterInfo info = m_arch->GetRegisterInfo(reg);
+	if (info.size > 8)
+		return false;
+
+	uint64_t full;
+	if (!ReadFullRegister(info.fullWidthRegister, full))
+		return false;
+
+	value = (info.offset >= 8) ? 0 : (full >> (info.offset * 8)) & SizeMask(info.size);
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::WriteRegister(uint32_t reg, uint64_t value)
+{
+	if (LLIL_REG_IS_TEMP(reg))
+	{
+		m_tempRegisters[reg] = value;
+		return true;
+	}
+
+	BNRegisterInfo info = m_arch->GetRegisterInfo(reg);
+	BNRegisterInfo fullInfo = m_arch->GetRegisterInfo(info.fullWidthRegister);
+	if ((info.size > 8) || (fullInfo.size > 8) || (info.offset >= 8))
+		return false;
+
+	// The old value is needed for the partial writes, and to know the name of the register in the adapter
+	uint64_t full;
+	if (!ReadFullRegister(info.fullWidthRegister, full))
+		return false;
+
+	uint64_t mask = SizeMask(info.size);
+	value &= mask;
+	switch (info.extend)
+	{
+	case ZeroExtendToFullWidth:
+		full = value;
+		break;
+	case SignExtendToFullWidth:
+		full = SignExtend(value, info.size);
+		break;
+	default:
+		full = (full & ~(mask << (info.offset * 8))) | (value << (info.offset * 8));
+		break;
+	}
+
+	m_registers[info.fullWidthRegister] = full & SizeMask(fullInfo.size);
+	m_modifiedRegisters.insert(info.fullWidthRegister);
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::ReadMemory(uint64_t address, size_t size, uint64_t& value)
+{
+	if ((size == 0) || (size > 8))
+		return false;
+
+	DataBuffer buffer = m_state->GetMemory()->ReadMemory(address, size);
+	if (buffer.GetLength() != size)
+		return false;
+
+	uint8_t bytes[8];
+	memcpy(bytes, buffer.GetData(), size);
+	for (size_t i = 0; i < size; i++)
+	{
+		auto it = m_overlay.find((address + i) & ~0xffULL);
+		if (it != m_overlay.end())
+			bytes[i] = it->second.m_bytes[(address + i) & 0xff];
+	}
+
+	// The supported targets are all little-endian
+	value = 0;
+	memcpy(&value, bytes, size);
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::WriteMemory(uint64_t address, size_t size, uint64_t value)
+{
+	if ((size == 0) || (size > 8))
+		return false;
+
+	uint8_t bytes[8];
+	memcpy(bytes, &value, sizeof(bytes));
+	for (size_t i = 0; i < size; i++)
+	{
+		uint64_t block = (address + i) & ~0xffULL;
+		auto it = m_overlay.find(block);
+		if (it == m_overlay.end())
+		{
+			// The target would fault on memory that cannot be written. A block never spans two pages, so its first
+			// write checks the protection for all of it.
+			if (!m_state->GetAdapter()->IsMemoryWritable(block))
+				return false;
+
+			DataBuffer buffer = m_state->GetMemory()->ReadMemory(block, 0x100);
+			if (buffer.GetLength() != 0x100)
+				return false;
+
+			OverlayBlock overlay;
+			overlay.m_bytes.assign((const uint8_t*)buffer.GetData(), (const uint8_t*)buffer.GetData() + 0x100);
+			it = m_overlay.emplace(block, std::move(overlay)).first;
+		}
+
+		it->second.m_bytes[(address + i) & 0xff] = bytes[i];
+		it->second.m_written.set((address + i) & 0xff);
+	}
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::GetFlagBit(uint32_t flag, uint64_t& bit)
+{
+	auto layout = FlagsRegisters.find(m_arch->GetName());
+	if (layout == FlagsRegisters.end())
+		return false;
+
+	auto it = layout->second.m_bits.find(m_arch->GetFlagName(flag));
+	if (it == layout->second.m_bits.end())
+		return false;
+	bit = it->second;
+
+	if (m_flagsLoaded)
+		return true;
+
+	for (const std::string& name : layout->second.m_names)
+	{
+		if (m_state->GetRegisters()->GetRegisterValue(name, m_flags))
+		{
+			m_flagsRegisterName = name;
+			m_flagsLoaded = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool DebuggerLLILInterpreter::ReadFlag(uint32_t flag, bool& value)
+{
+	if (LLIL_REG_IS_TEMP(flag))
+	{
+		auto it = m_tempFlags.find(flag);
+		if (it == m_tempFlags.end())
+			return false;
+		value = it->second;
+		return true;
+	}
+
+	uint64_t bit;
+	if (!GetFlagBit(flag, bit))
+		return false;
+
+	value = (m_flags >> bit) & 1;
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::WriteFlag(uint32_t flag, bool value)
+{
+	if (LLIL_REG_IS_TEMP(flag))
+	{
+		m_tempFlags[flag] = value;
+		return true;
+	}
+
+	uint64_t bit;
+	if (!GetFlagBit(flag, bit))
+		return false;
+
+	m_flags = (m_flags & ~(1ULL << bit)) | ((uint64_t)value << bit);
+	m_flagsModified = true;
+	return true;
+}
+
+
+static bool ComputeFlag(BNLowLevelILOperation operation, BNFlagRole role, size_t size, uint64_t left, uint64_t right,
+	uint64_t result, bool& value)
+{
+	if ((size == 0) || (size > 8))
+		return false;
+
+	// A negation sets the flags like a subtraction from zero
+	if (operation == LLIL_NEG)
+	{
+		operation = LLIL_SUB;
+		right = left;
+		left = 0;
+	}
+
+	uint64_t mask = SizeMask(size);
+	uint64_t sign = 1ULL << (size * 8 - 1);
+	left &= mask;
+	right &= mask;
+	result &= mask;
+	bool add = operation == LLIL_ADD;
+	bool sub = operation == LLIL_SUB;
+	bool logical = (operation == LLIL_AND) || (operation == LLIL_OR) || (operation == LLIL_XOR);
+
+	switch (role)
+	{
+	case ZeroFlagRole:
+		value = result == 0;
+		return true;
+	case NegativeSignFlagRole:
+		value = (result & sign) != 0;
+		return true;
+	case PositiveSignFlagRole:
+		value = (result & sign) == 0;
+		return true;
+	case EvenParityFlagRole:
+	case OddParityFlagRole:
+	{
+		// The parity is computed on the lowest byte
+		uint64_t byte = result & 0xff;
+		byte ^= byte >> 4;
+		byte ^= byte >> 2;
+		byte ^= byte >> 1;
+		value = ((byte & 1) == 0) == (role == EvenParityFlagRole);
+		return true;
+	}
+	case CarryFlagRole:
+	case CarryFlagWithInvertedSubtractRole:
+		// The logical operations clear the carry and the overflow
+		if (add)
+			value = result < left;
+		else if (sub)
+			value = (role == CarryFlagRole) ? (left < right) : (left >= right);
+		else if (logical)
+			value = false;
+		else
+			return false;
+		return true;
+	case OverflowFlagRole:
+		if (add)
+			value = ((left ^ result) & (right ^ result) & sign) != 0;
+		else if (sub)
+			value = ((left ^ right) & (left ^ result) & sign) != 0;
+		else if (logical)
+			value = false;
+		else
+			return false;
+		return true;
+	case HalfCarryFlagRole:
+		// The half carry is undefined after the logical operations, e.g., the AF of x86 after test, and is cleared
+		if (logical)
+		{
+			value = false;
+			return true;
+		}
+		if (!add && !sub)
+			return false;
+		value = ((left ^ right ^ result) & 0x10) != 0;
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+bool DebuggerLLILInterpreter::SetFlags(
+	const LowLevelILInstruction& expr, uint64_t left, uint64_t right, uint64_t result)
+{
+	uint32_t semClass = m_arch->GetSemanticClassForFlagWriteType(expr.flags);
+	for (uint32_t flag : m_arch->GetFlagsWrittenByFlagWriteType(expr.flags))
+	{
+		bool value;
+		if (!ComputeFlag(expr.operation, m_arch->GetFlagRole(flag, semClass), expr.size, left, right, result, value)
+			|| !WriteFlag(flag, value))
+			return false;
+	}
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::EvaluateFlagCondition(BNLowLevelILFlagCondition condition, uint32_t semClass, bool& value)
+{
+	// The conditions are computed from the flags with the standard roles
+	auto readRole = [&](BNFlagRole role, bool& flag) {
+		for (uint32_t candidate : m_arch->GetAllFlags())
+		{
+			if (m_arch->GetFlagRole(candidate, semClass) == role)
+				return ReadFlag(candidate, flag);
+		}
+		return false;
+	};
+
+	bool zero, sign, borrow, overflow;
+	auto readZero = [&]() { return readRole(ZeroFlagRole, zero); };
+	auto readSign = [&]() {
+		if (readRole(NegativeSignFlagRole, sign))
+			return true;
+		if (!readRole(PositiveSignFlagRole, sign))
+			return false;
+		sign = !sign;
+		return true;
+	};
+	auto readBorrow = [&]() {
+		if (readRole(CarryFlagRole, borrow))
+			return true;
+		if (!readRole(CarryFlagWithInvertedSubtractRole, borrow))
+			return false;
+		borrow = !borrow;
+		return true;
+	};
+	auto readOverflow = [&]() { return readRole(OverflowFlagRole, overflow); };
+
+	switch (condition)
+	{
+	case LLFC_E:
+	case LLFC_NE:
+		if (!readZero())
+			return false;
+		value = (condition == LLFC_E) ? zero : !zero;
+		return true;
+	case LLFC_NEG:
+	case LLFC_POS:
+		if (!readSign())
+			return false;
+		value = (condition == LLFC_NEG) ? sign : !sign;
+		return true;
+	case LLFC_O:
+	case LLFC_NO:
+		if (!readOverflow())
+			return false;
+		value = (condition == LLFC_O) ? overflow : !overflow;
+		return true;
+	case LLFC_ULT:
+	case LLFC_UGE:
+		if (!readBorrow())
+			return false;
+		value = (condition == LLFC_ULT) ? borrow : !borrow;
+		return true;
+	case LLFC_ULE:
+	case LLFC_UGT:
+		if (!readBorrow() || !readZero())
+			return false;
+		value = (condition == LLFC_ULE) ? (borrow || zero) : !(borrow || zero);
+		return true;
+	case LLFC_SLT:
+	case LLFC_SGE:
+		if (!readSign() || !readOverflow())
+			return false;
+		value = (condition == LLFC_SLT) ? (sign != overflow) : (sign == overflow);
+		return true;
+	case LLFC_SLE:
+	case LLFC_SGT:
+		if (!readSign() || !readOverflow() || !readZero())
+			return false;
+		value = (condition == LLFC_SLE) ? (zero || (sign != overflow)) : !(zero || (sign != overflow));
+		return true;
+	default:
+		// The floating point conditions
+		return false;
+	}
+}
+
+
+bool DebuggerLLILInterpreter::Evaluate(const LowLevelILInstruction& expr, uint64_t& value)
+{
+	if (expr.size > 8)
+		return false;
+
+	uint64_t left = 0, right = 0;
+	switch (expr.operation)
+	{
+	case LLIL_CONST:
+	case LLIL_CONST_PTR:
+		value = expr.GetConstant();
+		break;
+	case LLIL_REG:
+		if (!ReadRegister(expr.GetSourceRegister<LLIL_REG>(), value))
+			return false;
+		break;
+	case LLIL_FLAG:
+	{
+		bool flag;
+		if (!ReadFlag(expr.GetSourceFlag<LLIL_FLAG>(), flag))
+			return false;
+		value = flag;
+		break;
+	}
+	case LLIL_FLAG_COND:
+	{
+		bool flag;
+		if (!EvaluateFlagCondition(
+				expr.GetFlagCondition<LLIL_FLAG_COND>(), expr.GetSemanticFlagClass<LLIL_FLAG_COND>(), flag))
+			return false;
+		value = flag;
+		break;
+	}
+	case LLIL_LOAD:
+		if (!Evaluate(expr.GetSourceExpr<LLIL_LOAD>(), left) || !ReadMemory(left, expr.size, value))
+			return false;
+		break;
+	case LLIL_POP:
+	{
+		uint32_t stackPointer = m_arch->GetStackPointerRegister();
+		if (!ReadRegister(stackPointer, left) || !ReadMemory(left, expr.size, value)
+			|| !WriteRegister(stackPointer, left + expr.size))
+			return false;
+		break;
+	}
+	case LLIL_NEG:
+	case LLIL_NOT:
+	case LLIL_SX:
+	case LLIL_ZX:
+	case LLIL_LOW_PART:
+	case LLIL_BOOL_TO_INT:
+	{
+		auto source = expr.GetSourceExpr();
+		if (!Evaluate(source, left))
+			return false;
+
+		if (expr.operation == LLIL_NEG)
+			value = -left;
+		else if (expr.operation == LLIL_NOT)
+			value = ~left;
+		else if (expr.operation == LLIL_SX)
+			value = SignExtend(left, source.size);
+		else
+			value = left;
+		break;
+	}
+	case LLIL_ADD:
+	case LLIL_SUB:
+	case LLIL_AND:
+	case LLIL_OR:
+	case LLIL_XOR:
+	case LLIL_LSL:
+	case LLIL_LSR:
+	case LLIL_ASR:
+	case LLIL_ROL:
+	case LLIL_ROR:
+	case LLIL_MUL:
+	case LLIL_DIVU:
+	case LLIL_DIVS:
+	case LLIL_MODU:
+	case LLIL_MODS:
+	case LLIL_CMP_E:
+	case LLIL_CMP_NE:
+	case LLIL_CMP_SLT:
+	case LLIL_CMP_ULT:
+	case LLIL_CMP_SLE:
+	case LLIL_CMP_ULE:
+	case LLIL_CMP_SGE:
+	case LLIL_CMP_UGE:
+	case LLIL_CMP_SGT:
+	case LLIL_CMP_UGT:
+	{
+		auto leftExpr = expr.GetLeftExpr();
+		if (!Evaluate(leftExpr, left) || !Evaluate(expr.GetRightExpr(), right))
+			return false;
+
+		size_t bits = expr.size * 8;
+		// Same as DebuggerController::ComputeExprValue()
+		uint64_t shift = right & ((expr.size <= 4) ? 0b11111 : 0b111111);
+		// The comparisons are done at the size of their operands
+		int64_t signedLeft = SignExtend(left, leftExpr.size);
+		int64_t signedRight = SignExtend(right, leftExpr.size);
+		switch (expr.operation)
+		{
+		case LLIL_ADD:
+			value = left + right;
+			break;
+		case LLIL_SUB:
+			value = left - right;
+			break;
+		case LLIL_AND:
+			value = left & right;
+			break;
+		case LLIL_OR:
+			value = left | right;
+			break;
+		case LLIL_XOR:
+			value = left ^ right;
+			break;
+		case LLIL_LSL:
+			value = left << shift;
+			break;
+		case LLIL_LSR:
+			value = left >> shift;
+			break;
+		case LLIL_ASR:
+			value = SignExtend(left, expr.size) >> shift;
+			break;
+		case LLIL_ROL:
+		case LLIL_ROR:
+		{
+			if (bits == 0)
+				return false;
+			uint64_t count = right % bits;
+			if (expr.operation == LLIL_ROR)
+				count = (bits - count) % bits;
+			value = (count == 0) ? left : ((left << count) | (left >> (bits - count)));
+			break;
+		}
+		case LLIL_MUL:
+			value = left * right;
+			break;
+		case LLIL_DIVU:
+		case LLIL_MODU:
+			// The target would fault
+			if (right == 0)
+				return false;
+			value = (expr.operation == LLIL_DIVU) ? left / right : left % right;
+			break;
+		case LLIL_DIVS:
+		case LLIL_MODS:
+		{
+			int64_t dividend = SignExtend(left, expr.size);
+			int64_t divisor = SignExtend(right, expr.size);
+			if ((divisor == 0) || ((divisor == -1) && (dividend == INT64_MIN)))
+				return false;
+			value = (expr.operation == LLIL_DIVS) ? dividend / divisor : dividend % divisor;
+			break;
+		}
+		case LLIL_CMP_E:
+			value = left == right;
+			break;
+		case LLIL_CMP_NE:
+			value = left != right;
+			break;
+		case LLIL_CMP_SLT:
+			value = signedLeft < signedRight;
+			break;
+		case LLIL_CMP_ULT:
+			value = left < right;
+			break;
+		case LLIL_CMP_SLE:
+			value = signedLeft <= signedRight;
+			break;
+		case LLIL_CMP_ULE:
+			value = left <= right;
+			break;
+		case LLIL_CMP_SGE:
+			value = signedLeft >= signedRight;
+			break;
+		case LLIL_CMP_UGE:
+			value = left >= right;
+			break;
+		case LLIL_CMP_SGT:
+			value = signedLeft > signedRight;
+			break;
+		case LLIL_CMP_UGT:
+			value = left > right;
+			break;
+		default:
+			return false;
+		}
+		break;
+	}
+	default:
+		// Floating point, intrinsics, double precision arithmetic, the operations that use the carry, etc.
+		return false;
+	}
+
+	value &= SizeMask(expr.size);
+	if (expr.flags != 0)
+		return SetFlags(expr, left, right, value);
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::Step()
+{
+	// The code written by the interpreted code itself is not decoded from the overlay
+	size_t maxLength = m_arch->GetMaxInstructionLength();
+	if ((m_overlay.find(m_pc & ~0xffULL) != m_overlay.end())
+		|| (m_overlay.find((m_pc + maxLength - 1) & ~0xffULL) != m_overlay.end()))
+		return false;
+
+	auto instruction = m_state->DecodeInstruction(m_pc, true);
+	if (!instruction || !instruction->m_llil)
+		return false;
+
+	Ref<LowLevelILFunction> il = instruction->m_llil;
+	size_t count = il->GetInstructionCount();
+	uint64_t next = m_pc + instruction->GetLength();
+	size_t index = 0;
+	size_t executed = 0;
+	m_tempRegisters.clear();
+	m_tempFlags.clear();
+	while (index < count)
+	{
+		if (++executed > MaxILInstructionsPerStep)
+			return false;
+
+		LowLevelILInstruction instr = il->GetInstruction(index++);
+		uint64_t address, value;
+		switch (instr.operation)
+		{
+		case LLIL_NOP:
+			break;
+		case LLIL_SET_REG:
+			if (!Evaluate(instr.GetSourceExpr<LLIL_SET_REG>(), value)
+				|| !WriteRegister(instr.GetDestRegister<LLIL_SET_REG>(), value))
+				return false;
+			break;
+		case LLIL_SET_FLAG:
+			if (!Evaluate(instr.GetSourceExpr<LLIL_SET_FLAG>(), value)
+				|| !WriteFlag(instr.GetDestFlag<LLIL_SET_FLAG>(), value != 0))
+				return false;
+			break;
+		case LLIL_SET_REG_SPLIT:
+			// The size of the instruction is the size of each half
+			if ((instr.size == 0) || (instr.size > 4) || !Evaluate(instr.GetSourceExpr<LLIL_SET_REG_SPLIT>(), value)
+				|| !WriteRegister(instr.GetLowRegister<LLIL_SET_REG_SPLIT>(), value & SizeMask(instr.size))
+				|| !WriteRegister(instr.GetHighRegister<LLIL_SET_REG_SPLIT>(), value >> (instr.size * 8)))
+				return false;
+			break;
+		case LLIL_STORE:
+			if (!Evaluate(instr.GetDestExpr<LLIL_STORE>(), address)
+				|| !Evaluate(instr.GetSourceExpr<LLIL_STORE>(), value) || !WriteMemory(address, instr.size, value))
+				return false;
+			break;
+		case LLIL_PUSH:
+		{
+			uint32_t stackPointer = m_arch->GetStackPointerRegister();
+			if (!Evaluate(instr.GetSourceExpr<LLIL_PUSH>(), value) || !ReadRegister(stackPointer, address))
+				return false;
+			address -= instr.size;
+			if (!WriteMemory(address, instr.size, value) || !WriteRegister(stackPointer, address))
+				return false;
+			break;
+		}
+		case LLIL_GOTO:
+			index = instr.GetTarget<LLIL_GOTO>();
+			break;
+		case LLIL_IF:
+			if (!Evaluate(instr.GetConditionExpr<LLIL_IF>(), value))
+				return false;
+			index = value ? instr.GetTrueTarget<LLIL_IF>() : instr.GetFalseTarget<LLIL_IF>();
+			break;
+		case LLIL_JUMP:
+			if (!Evaluate(instr.GetDestExpr<LLIL_JUMP>(), next))
+				return false;
+			index = count;
+			break;
+		case LLIL_JUMP_TO:
+			if (!Evaluate(instr.GetDestExpr<LLIL_JUMP_TO>(), next))
+				return false;
+			index = count;
+			break;
+		default:
+			// Calls, returns, system calls, intrinsics, traps, etc.
+			return false;
+		}
+
+		// A branch past the end of the lifted instruction, which falls through to the next native instruction
+		if (index > count)
+			return false;
+	}
+
+	m_pc = next;
+	m_instructionCount++;
+	return true;
+}
+
+
+bool DebuggerLLILInterpreter::RunUntil(const std::vector<uint64_t>& targets, size_t maxInstructions)
+{
+	m_arch = m_state->GetRemoteArchitecture();
+	if (!m_arch)
+		return false;
+
+	m_pc = m_state->IP();
+	std::set<uint64_t> stops(targets.begin(), targets.end());
+	while (m_instructionCount < maxInstructions)
+	{
+		if (!Step())
+			return false;
+
+		if (stops.find(m_pc) != stops.end())
+			return true;
+
+		// The target would stop at the breakpoint first
+		if (m_state->GetBreakpoints()->ContainsAbsolute(m_pc))
+			return false;
+	}
+	return false;
+}
+
+
+bool DebuggerLLILInterpreter::CanCommit()
+{
+	// The protection may have changed since the block was first written
+	DebugAdapter* adapter = m_state->GetAdapter();
+	for (const auto& [block, overlay] : m_overlay)
+	{
+		if (!adapter->IsMemoryWritable(block))
+			return false;
+	}
+
+	// The registers were read from the cache under these names, so the adapter knows them
+	DebuggerRegisters* registers = m_state->GetRegisters();
+	uint64_t value;
+	for (uint32_t reg : m_modifiedRegisters)
+	{
+		auto it = m_registerNames.find(reg);
+		if ((it == m_registerNames.end()) || !registers->GetRegisterValue(it->second, value))
+			return false;
+	}
+
+	if (m_flagsModified && (m_flagsRegisterName.empty() || !registers->GetRegisterValue(m_flagsRegisterName, value)))
+		return false;
+
+	std::string ipName = m_state->GetController()->GetIPRegisterName();
+	return !ipName.empty() && registers->GetRegisterValue(ipName, value);
+}
+
+
+bool DebuggerLLILInterpreter::Commit()
+{
+	DebuggerMemory* memory = m_state->GetMemory();
+	for (const auto& [block, overlay] : m_overlay)
+	{
+		size_t i = 0;
+		while (i < 0x100)
+		{
+			if (!overlay.m_written[i])
+			{
+				i++;
+				continue;
+			}
+
+			size_t start = i;
+			while ((i < 0x100) && overlay.m_written[i])
+				i++;
+
+			if (!memory->WriteMemory(block + start, DataBuffer(overlay.m_bytes.data() + start, i - start)))
+			{
+				LogWarn("Failed to write the interpreted memory at 0x%" PRIx64, block + start);
+				return false;
+			}
+		}
+	}
+
+	DebugAdapter* adapter = m_state->GetAdapter();
+	for (uint32_t reg : m_modifiedRegisters)
+	{
+		if (!adapter->WriteRegister(m_registerNames[reg], m_registers[reg]))
+		{
+			LogWarn("Failed to write the interpreted register %s", m_registerNames[reg].c_str());
+			return false;
+		}
+	}
+
+	if (m_flagsModified && !adapter->WriteRegister(m_flagsRegisterName, m_flags))
+	{
+		LogWarn("Failed to write the interpreted flags to %s", m_flagsRegisterName.c_str());
+		return false;
+	}
+
+	if (!adapter->WriteRegister(m_state->GetController()->GetIPRegisterName(), m_pc))
+	{
+		LogWarn("Failed to set the instruction pointer to 0x%" PRIx64, m_pc);
+		return false;
+	}
+
+	m_state->GetRegisters()->MarkDirty();
+	m_state->GetThreads()->MarkDirty();
+	return true;
+}
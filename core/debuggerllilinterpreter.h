@@ -0,0 +1,102 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "binaryninjaapi.h"
+#include "lowlevelilinstruction.h"
+
+namespace BinaryNinjaDebugger {
+	class DebuggerState;
+
+	// Executes the LLIL of the target's code locally, against the cached registers and memory of DebuggerState, so that
+	// straight-line code and simple loops can be fast-forwarded without single-stepping the target. The registers and
+	// memory written by the code are buffered, the latter in a copy-on-write overlay of DebuggerMemory, and only reach
+	// the target in one batch when Commit() is called. A write to memory that the adapter does not report as writable
+	// ends the run, since the target would fault there.
+	//
+	// The flags are modeled by their role, for the common integer operations, and written back as the bits of the
+	// flags register, e.g., rflags or cpsr. Only the current thread is executed. Anything that cannot be modeled
+	// exactly ends the run, e.g., calls, returns, system calls, intrinsics, registers wider than 64 bits, the flags of
+	// other operations, and unsupported operations.
+	class DebuggerLLILInterpreter
+	{
+	private:
+		struct OverlayBlock
+		{
+			std::vector<uint8_t> m_bytes;
+			std::bitset<256> m_written;
+		};
+
+		DebuggerState* m_state;
+		BinaryNinja::Ref<BinaryNinja::Architecture> m_arch;
+		uint64_t m_pc = 0;
+		size_t m_instructionCount = 0;
+
+		// The values of the full-width registers, and the name the adapter uses for them
+		std::unordered_map<uint32_t, uint64_t> m_registers;
+		std::unordered_map<uint32_t, std::string> m_registerNames;
+		std::set<uint32_t> m_modifiedRegisters;
+		std::unordered_map<uint32_t, uint64_t> m_tempRegisters;
+		// The flags register, which is read when a flag is first used
+		bool m_flagsLoaded = false;
+		bool m_flagsModified = false;
+		std::string m_flagsRegisterName;
+		uint64_t m_flags = 0;
+		std::unordered_map<uint32_t, bool> m_tempFlags;
+		// Blocks of 256 bytes, copied from DebuggerMemory when they are first written to
+		std::map<uint64_t, OverlayBlock> m_overlay;
+
+		bool ReadFullRegister(uint32_t reg, uint64_t& value);
+		bool ReadRegister(uint32_t reg, uint64_t& value);
+		bool WriteRegister(uint32_t reg, uint64_t value);
+		bool ReadMemory(uint64_t address, size_t size, uint64_t& value);
+		bool WriteMemory(uint64_t address, size_t size, uint64_t value);
+		bool GetFlagBit(uint32_t flag, uint64_t& bit);
+		bool ReadFlag(uint32_t flag, bool& value);
+		bool WriteFlag(uint32_t flag, bool value);
+		// Sets the flags written by the expression, from its operands and its result
+		bool SetFlags(const BinaryNinja::LowLevelILInstruction& expr, uint64_t left, uint64_t right, uint64_t result);
+		bool EvaluateFlagCondition(BNLowLevelILFlagCondition condition, uint32_t semClass, bool& value);
+		bool Evaluate(const BinaryNinja::LowLevelILInstruction& expr, uint64_t& value);
+		// Executes the native instruction at m_pc
+		bool Step();
+
+	public:
+		DebuggerLLILInterpreter(DebuggerState* state);
+
+		// Interprets the code from the current IP until it reaches one of the targets, after executing at least one
+		// instruction. Returns false if it reaches a breakpoint, an instruction it cannot execute, or the instruction
+		// limit first. Nothing is written to the target either way.
+		bool RunUntil(const std::vector<uint64_t>& targets, size_t maxInstructions);
+
+		uint64_t GetPC() const { return m_pc; }
+		size_t GetInstructionCount() const { return m_instructionCount; }
+
+		// Checks that every pending write can be applied to the target, without writing anything
+		bool CanCommit();
+		// Writes the modified memory, registers and flags, and the new IP, to the target. A failure leaves the target
+		// partially written, so CanCommit() should be checked first.
+		bool Commit();
+	};
+};  // namespace BinaryNinjaDebugger
@@ -0,0 +1,249 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggerprofiler.h"
+#include "debuggercontroller.h"
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace BinaryNinjaDebugger;
+
+static const char* ProfilerTagTypeName = "Profiler Samples";
+
+
+DebuggerProfiler::DebuggerProfiler(DebuggerController* controller) : m_controller(controller) {}
+
+
+void DebuggerProfiler::Start()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_stacks.clear();
+	m_sampleCount = 0;
+	m_stackCount = 0;
+}
+
+
+void DebuggerProfiler::AddSample(uint32_t tid, const std::vector<uint64_t>& pcs)
+{
+	if (pcs.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_stacks[std::make_pair(tid, pcs)]++;
+	m_stackCount++;
+}
+
+
+void DebuggerProfiler::EndSample()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_sampleCount++;
+}
+
+
+uint64_t DebuggerProfiler::GetSampleCount()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_sampleCount;
+}
+
+
+uint64_t DebuggerProfiler::GetStackCount()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_stackCount;
+}
+
+
+uint64_t DebuggerProfiler::GetFunction(uint64_t pc, bool isReturnAddress)
+{
+	BinaryViewRef data = m_controller->GetData();
+	if (!data)
+		return 0;
+
+	uint64_t address = isReturnAddress ? pc - 1 : pc;
+	auto functions = data->GetAnalysisFunctionsForAddress(address);
+	if (functions.empty())
+		return 0;
+
+	return functions[0]->GetStart();
+}
+
+
+std::string DebuggerProfiler::GetFunctionName(uint64_t function, uint64_t pc)
+{
+	BinaryViewRef data = m_controller->GetData();
+	if (data && (function != 0))
+	{
+		if (auto symbol = data->GetSymbolByAddress(function))
+			return symbol->GetShortName();
+		return fmt::format("sub_{:x}", function);
+	}
+
+	DebugModule module = m_controller->GetModuleForAddress(pc);
+	if (!module.m_short_name.empty())
+		return fmt::format("{}+0x{:x}", module.m_short_name, pc - module.m_address);
+
+	return fmt::format("0x{:x}", pc);
+}
+
+
+std::vector<ProfilerFunctionHits> DebuggerProfiler::GetFunctionHits()
+{
+	std::map<std::pair<uint32_t, std::vector<uint64_t>>, uint64_t> stacks;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		stacks = m_stacks;
+	}
+
+	// The same pcs show up in many stacks, so every pc is only resolved once
+	std::unordered_map<uint64_t, uint64_t> innermostFunctions, outerFunctions;
+	auto resolve = [&](uint64_t pc, bool isReturnAddress) {
+		auto& cache = isReturnAddress ? outerFunctions : innermostFunctions;
+		auto it = cache.find(pc);
+		if (it != cache.end())
+			return it->second;
+		uint64_t function = GetFunction(pc, isReturnAddress);
+		cache[pc] = function;
+		return function;
+	};
+
+	std::map<uint64_t, ProfilerFunctionHits> hits;
+	for (const auto& [key, count] : stacks)
+	{
+		const auto& pcs = key.second;
+		// A recursive function is only counted once per sample
+		std::unordered_set<uint64_t> seen;
+		for (size_t i = 0; i < pcs.size(); i++)
+		{
+			uint64_t function = resolve(pcs[i], i != 0);
+			if (function == 0)
+				continue;
+
+			auto& entry = hits[function];
+			entry.m_function = function;
+			if (i == 0)
+				entry.m_selfSamples += count;
+			if (seen.insert(function).second)
+				entry.m_totalSamples += count;
+		}
+	}
+
+	std::vector<ProfilerFunctionHits> result;
+	result.reserve(hits.size());
+	for (auto& [function, entry] : hits)
+	{
+		entry.m_name = GetFunctionName(function, function);
+		result.push_back(entry);
+	}
+
+	std::sort(result.begin(), result.end(), [](const ProfilerFunctionHits& a, const ProfilerFunctionHits& b) {
+		if (a.m_selfSamples != b.m_selfSamples)
+			return a.m_selfSamples > b.m_selfSamples;
+		return a.m_totalSamples > b.m_totalSamples;
+	});
+	return result;
+}
+
+
+bool DebuggerProfiler::ExportFoldedStacks(const std::string& path)
+{
+	std::map<std::pair<uint32_t, std::vector<uint64_t>>, uint64_t> stacks;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		stacks = m_stacks;
+	}
+
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LogWarn("Failed to open %s for writing the profile", path.c_str());
+		return false;
+	}
+
+	std::unordered_map<uint64_t, std::string> innermostNames, outerNames;
+	auto resolve = [&](uint64_t pc, bool isReturnAddress) {
+		auto& cache = isReturnAddress ? outerNames : innermostNames;
+		auto it = cache.find(pc);
+		if (it != cache.end())
+			return it->second;
+		std::string name = GetFunctionName(GetFunction(pc, isReturnAddress), pc);
+		// ';' separates the frames, and ' ' separates the stack from the count
+		std::replace(name.begin(), name.end(), ';', ':');
+		std::replace(name.begin(), name.end(), ' ', '_');
+		cache[pc] = name;
+		return name;
+	};
+
+	// Different pcs in the same functions fold into the same line. The threads are merged.
+	std::map<std::string, uint64_t> folded;
+	for (const auto& [key, count] : stacks)
+	{
+		const auto& pcs = key.second;
+		std::string line;
+		for (size_t i = pcs.size(); i > 0; i--)
+		{
+			if (!line.empty())
+				line += ';';
+			line += resolve(pcs[i - 1], i != 1);
+		}
+		folded[line] += count;
+	}
+
+	for (const auto& [line, count] : folded)
+		file << line << ' ' << count << '\n';
+
+	return file.good();
+}
+
+
+void DebuggerProfiler::AnnotateFunctions()
+{
+	BinaryViewRef data = m_controller->GetData();
+	if (!data)
+		return;
+
+	Ref<TagType> type = data->GetTagType(ProfilerTagTypeName);
+	if (!type)
+	{
+		type = new TagType(data, ProfilerTagTypeName, "🔥");
+		data->AddTagType(type);
+	}
+
+	// Remove the tags of the previous profile
+	for (const auto& func : data->GetAnalysisFunctionList())
+		func->RemoveAutoFunctionTagsOfType(type);
+
+	uint64_t stackCount = GetStackCount();
+	if (stackCount == 0)
+		return;
+
+	for (const auto& hits : GetFunctionHits())
+	{
+		for (const auto& func : data->GetAnalysisFunctionsForAddress(hits.m_function))
+		{
+			if (func->GetStart() != hits.m_function)
+				continue;
+
+			func->CreateAutoFunctionTag(type,
+				fmt::format("{} samples ({:.1f}%), {} self", hits.m_totalSamples,
+					100.0 * hits.m_totalSamples / stackCount, hits.m_selfSamples),
+				true);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BinaryNinjaDebugger {
+	class DebuggerController;
+
+	struct ProfilerOptions
+	{
+		// Samples per second
+		uint32_t m_sampleRate = 100;
+		// The profiling ends after this many samples or milliseconds (0 means no limit), whichever comes first, or when
+		// the target stops by itself
+		uint64_t m_maxSamples = 0;
+		uint64_t m_duration = 0;
+		// Frames deeper than this are not captured
+		size_t m_maxDepth = 128;
+	};
+
+	struct ProfilerFunctionHits
+	{
+		uint64_t m_function;
+		std::string m_name;
+		// The captured stacks whose innermost frame is in the function. Every sample captures one stack per thread.
+		uint64_t m_selfSamples = 0;
+		// The captured stacks that have the function anywhere
+		uint64_t m_totalSamples = 0;
+	};
+
+	// Collects the stacks of all threads every time the sampling profiler interrupts the target. The raw pcs are
+	// aggregated as they come in, and are only resolved to functions when the results are read, so a sample costs
+	// no more than a stop and an unwind of every thread.
+	class DebuggerProfiler
+	{
+	private:
+		DebuggerController* m_controller;
+
+		std::mutex m_mutex;
+		// (tid, pcs with the innermost frame first) -> number of samples
+		std::map<std::pair<uint32_t, std::vector<uint64_t>>, uint64_t> m_stacks;
+		uint64_t m_sampleCount = 0;
+		// The number of captured stacks, i.e., one per thread in every sample
+		uint64_t m_stackCount = 0;
+
+		// The function containing the pc of a frame, or 0 if there is none. The pcs of the outer frames are return
+		// addresses, which can be the start of the next function after a call that does not return.
+		uint64_t GetFunction(uint64_t pc, bool isReturnAddress);
+		std::string GetFunctionName(uint64_t function, uint64_t pc);
+
+	public:
+		DebuggerProfiler(DebuggerController* controller);
+
+		// Clears the previous samples
+		void Start();
+		void AddSample(uint32_t tid, const std::vector<uint64_t>& pcs);
+		// Counts the interrupts of the target, which capture the stacks of all threads
+		void EndSample();
+
+		uint64_t GetSampleCount();
+		uint64_t GetStackCount();
+		// Sorted by the self samples, in descending order
+		std::vector<ProfilerFunctionHits> GetFunctionHits();
+
+		// Write the samples as folded stacks, i.e., one "outer;...;inner count" line per distinct stack, which can be
+		// fed to flamegraph.pl, speedscope, etc.
+		bool ExportFoldedStacks(const std::string& path);
+		// Tag every sampled function with its hit counts
+		void AnnotateFunctions();
+	};
+};  // namespace BinaryNinjaDebugger
@@ -14,7 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 #include <utility>
 #include <filesystem>
@@ -38,6 +40,7 @@ DebuggerRegisters::DebuggerRegisters(DebuggerState* state) : m_state(state)
 
 void DebuggerRegisters::MarkDirty()
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	m_dirty = true;
 	m_registerCache.clear();
 }
@@ -45,6 +48,7 @@ void DebuggerRegisters::MarkDirty()
 
 void DebuggerRegisters::Update()
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	DebugAdapter* adapter = m_state->GetAdapter();
 	if (!adapter)
 		return;
@@ -61,6 +65,7 @@ uint64_t DebuggerRegisters::GetRegisterValue(const std::string& name)
 {
 	// Unlike the Python implementation, we require the DebuggerState to explicitly check for dirty caches
 	// and update the values when necessary. This is mainly because the update can be expensive.
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -72,12 +77,28 @@ uint64_t DebuggerRegisters::GetRegisterValue(const std::string& name)
 }
 
 
+bool DebuggerRegisters::GetRegisterValue(const std::string& name, uint64_t& value)
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+	if (IsDirty())
+		Update();
+
+	auto iter = m_registerCache.find(name);
+	if (iter == m_registerCache.end())
+		return false;
+
+	value = iter->second.m_value;
+	return true;
+}
+
+
 bool DebuggerRegisters::SetRegisterValue(const std::string& name, uint64_t value)
 {
 	DebugAdapter* adapter = m_state->GetAdapter();
 	if (!adapter)
 		return false;
 
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	auto iter = m_registerCache.find(name);
 	if (iter == m_registerCache.end())
 		return false;
@@ -89,20 +110,34 @@ bool DebuggerRegisters::SetRegisterValue(const std::string& name, uint64_t value
 	// Because some registers are correlated, changing the value of one register could invalidate the value of other
 	// registers as well.
 	MarkDirty();
+	lock.unlock();
 
 	m_state->GetController()->NotifyEvent(RegisterChangedEvent);
 	return true;
 }
 
 
+void DebuggerRegisters::VisitRegisters(const std::function<void(const DebugRegister&)>& visitor)
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+	if (IsDirty())
+		Update();
+
+	for (const auto& [name, reg] : m_registerCache)
+		visitor(reg);
+}
+
+
 std::vector<DebugRegister> DebuggerRegisters::GetAllRegisters()
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
 	std::vector<DebugRegister> result {};
 	for (auto& [reg_name, reg] : m_registerCache)
 		result.push_back(reg);
+	lock.unlock();
 
 	std::sort(result.begin(), result.end(), [](const DebugRegister& lhs, const DebugRegister& rhs) {
 		return lhs.m_registerIndex < rhs.m_registerIndex;
@@ -141,6 +176,7 @@ DebuggerThreads::DebuggerThreads(DebuggerState* state) : m_state(state)
 
 void DebuggerThreads::MarkDirty()
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	m_dirty = true;
 	// clearing these here corrupts thread state updating in ::Update() below
 	// m_threads.clear();
@@ -205,8 +241,9 @@ void DebuggerThreads::SymbolizeFrames(std::vector<DebugFrame>& frames)
 }
 
 
-void DebuggerThreads::Update()
+void DebuggerThreads::Update(const std::function<bool()>& isCancelled)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (!m_state)
 		return;
 
@@ -217,14 +254,17 @@ void DebuggerThreads::Update()
 	if (!adapter)
 		return;
 
-	m_frames.clear();
-
+	// The cached threads and frames are only replaced once all of them are read
+	std::map<uint32_t, std::vector<DebugFrame>> newFrames;
 	std::vector<DebugThread> newThreads = adapter->GetThreadList();
 	for (auto thread = newThreads.begin(); thread != newThreads.end(); thread++)
 	{
+		if (isCancelled && isCancelled())
+			return;
+
 		auto frames = adapter->GetFramesOfThread(thread->m_tid);
 		SymbolizeFrames(frames);
-		m_frames[thread->m_tid] = frames;
+		newFrames[thread->m_tid] = frames;
 
 		// update thread states in new thread list
 		auto oldThread = std::find_if(m_threads.begin(), m_threads.end(), [&](DebugThread const& t) {
@@ -235,9 +275,11 @@ void DebuggerThreads::Update()
 			thread->m_isFrozen = oldThread->m_isFrozen;
 	}
 
-	m_threads.clear();
-	m_threads = newThreads;
+	if (isCancelled && isCancelled())
+		return;
 
+	m_frames = std::move(newFrames);
+	m_threads = std::move(newThreads);
 	m_dirty = false;
 }
 
@@ -270,6 +312,7 @@ bool DebuggerThreads::SetActiveThread(const DebugThread& thread)
 
 std::vector<DebugThread> DebuggerThreads::GetAllThreads()
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 	return m_threads;
@@ -278,6 +321,7 @@ std::vector<DebugThread> DebuggerThreads::GetAllThreads()
 
 std::vector<DebugFrame> DebuggerThreads::GetFramesOfThread(uint32_t tid)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -291,6 +335,7 @@ std::vector<DebugFrame> DebuggerThreads::GetFramesOfThread(uint32_t tid)
 
 bool DebuggerThreads::SuspendThread(std::uint32_t tid)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (!m_state)
 		return false;
 
@@ -320,6 +365,7 @@ bool DebuggerThreads::SuspendThread(std::uint32_t tid)
 
 bool DebuggerThreads::ResumeThread(std::uint32_t tid)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (!m_state)
 		return false;
 
@@ -354,13 +400,15 @@ DebuggerModules::DebuggerModules(DebuggerState* state) : m_state(state)
 
 void DebuggerModules::MarkDirty()
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	m_dirty = true;
 	m_modules.clear();
 }
 
 
-void DebuggerModules::Update()
+void DebuggerModules::Update(const std::function<bool()>& isCancelled)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	DebugAdapter* adapter = m_state->GetAdapter();
 	if (!adapter)
 		return;
@@ -368,13 +416,21 @@ void DebuggerModules::Update()
 	if (!m_state->IsConnected())
 		return;
 
-	m_modules = adapter->GetModuleList();
+	if (isCancelled && isCancelled())
+		return;
+
+	std::vector<DebugModule> modules = adapter->GetModuleList();
+	if (isCancelled && isCancelled())
+		return;
+
+	m_modules = std::move(modules);
 	m_dirty = false;
 }
 
 
 bool DebuggerModules::GetModuleBase(const std::string& name, uint64_t& address)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -395,6 +451,7 @@ bool DebuggerModules::GetModuleBase(const std::string& name, uint64_t& address)
 
 DebugModule DebuggerModules::GetModuleByName(const std::string& name)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -409,6 +466,7 @@ DebugModule DebuggerModules::GetModuleByName(const std::string& name)
 
 DebugModule DebuggerModules::GetModuleForAddress(uint64_t remoteAddress)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -436,6 +494,7 @@ DebugModule DebuggerModules::GetModuleForAddress(uint64_t remoteAddress)
 
 ModuleNameAndOffset DebuggerModules::AbsoluteAddressToRelative(uint64_t absoluteAddress)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -457,6 +516,7 @@ ModuleNameAndOffset DebuggerModules::AbsoluteAddressToRelative(uint64_t absolute
 
 uint64_t DebuggerModules::RelativeAddressToAbsolute(const ModuleNameAndOffset& relativeAddress)
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -482,6 +542,7 @@ uint64_t DebuggerModules::RelativeAddressToAbsolute(const ModuleNameAndOffset& r
 
 std::vector<DebugModule> DebuggerModules::GetAllModules()
 {
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
 	if (IsDirty())
 		Update();
 
@@ -551,6 +612,8 @@ bool DebuggerBreakpoints::RemoveAbsolute(uint64_t remoteAddress)
 		{
 			m_breakpoints.erase(iter);
 		}
+		if (auto condition = FindCondition(info); condition != m_conditions.end())
+			m_conditions.erase(condition);
 		SerializeMetadata();
 		m_state->GetAdapter()->RemoveBreakpoint(remoteAddress);
 		return true;
@@ -565,6 +628,8 @@ bool DebuggerBreakpoints::RemoveOffset(const ModuleNameAndOffset& address)
 	{
 		if (auto iter = std::find(m_breakpoints.begin(), m_breakpoints.end(), address); iter != m_breakpoints.end())
 			m_breakpoints.erase(iter);
+		if (auto condition = FindCondition(address); condition != m_conditions.end())
+			m_conditions.erase(condition);
 
 		SerializeMetadata();
 
@@ -612,6 +677,56 @@ bool DebuggerBreakpoints::ContainsAbsolute(uint64_t address)
 }
 
 
+std::map<ModuleNameAndOffset, std::string>::iterator DebuggerBreakpoints::FindCondition(
+	const ModuleNameAndOffset& address)
+{
+	// ModuleNameAndOffset::operator== compares the base name of the modules, while operator< compares the full path,
+	// so we cannot use m_conditions.find() here
+	return std::find_if(m_conditions.begin(), m_conditions.end(),
+		[&](const auto& condition) { return condition.first == address; });
+}
+
+
+bool DebuggerBreakpoints::SetConditionOffset(const ModuleNameAndOffset& address, const std::string& condition)
+{
+	auto iter = std::find(m_breakpoints.begin(), m_breakpoints.end(), address);
+	if (iter == m_breakpoints.end())
+		return false;
+
+	if (auto existing = FindCondition(address); existing != m_conditions.end())
+		m_conditions.erase(existing);
+
+	// Always key the condition with the module name that the breakpoint is saved with
+	if (!condition.empty())
+		m_conditions[*iter] = condition;
+
+	SerializeMetadata();
+	return true;
+}
+
+
+bool DebuggerBreakpoints::SetConditionAbsolute(uint64_t remoteAddress, const std::string& condition)
+{
+	ModuleNameAndOffset info = m_state->GetModules()->AbsoluteAddressToRelative(remoteAddress);
+	return SetConditionOffset(info, condition);
+}
+
+
+std::string DebuggerBreakpoints::GetConditionOffset(const ModuleNameAndOffset& address)
+{
+	if (auto condition = FindCondition(address); condition != m_conditions.end())
+		return condition->second;
+	return "";
+}
+
+
+std::string DebuggerBreakpoints::GetConditionAbsolute(uint64_t remoteAddress)
+{
+	ModuleNameAndOffset info = m_state->GetModules()->AbsoluteAddressToRelative(remoteAddress);
+	return GetConditionOffset(info);
+}
+
+
 void DebuggerBreakpoints::SerializeMetadata()
 {
 	// TODO: who should free these Metadata objects?
@@ -621,6 +736,8 @@ void DebuggerBreakpoints::SerializeMetadata()
 		std::map<std::string, Ref<Metadata>> info;
 		info["module"] = new Metadata(bp.module);
 		info["offset"] = new Metadata(bp.offset);
+		if (auto condition = FindCondition(bp); condition != m_conditions.end())
+			info["condition"] = new Metadata(condition->second);
 		breakpoints.push_back(new Metadata(info));
 	}
 	m_state->GetController()->GetData()->StoreMetadata("debugger.breakpoints", new Metadata(breakpoints));
@@ -635,6 +752,7 @@ void DebuggerBreakpoints::UnserializedMetadata()
 
 	vector<Ref<Metadata>> array = metadata->GetArray();
 	std::vector<ModuleNameAndOffset> newBreakpoints;
+	std::map<ModuleNameAndOffset, std::string> newConditions;
 
 	for (auto& element : array)
 	{
@@ -654,9 +772,14 @@ void DebuggerBreakpoints::UnserializedMetadata()
 
 		address.offset = info["offset"]->GetUnsignedInteger();
 		newBreakpoints.push_back(address);
+
+		// Breakpoints saved by older versions do not have a condition
+		if (info["condition"] && info["condition"]->IsString() && !info["condition"]->GetString().empty())
+			newConditions[address] = info["condition"]->GetString();
 	}
 
 	m_breakpoints = newBreakpoints;
+	m_conditions = newConditions;
 }
 
 
@@ -670,6 +793,62 @@ void DebuggerBreakpoints::Apply()
 }
 
 
+DebuggerWatchpoints::DebuggerWatchpoints(DebuggerState* state) : m_state(state) {}
+
+
+bool DebuggerWatchpoints::Add(uint64_t address, size_t size, DebugWatchpointType type, bool software)
+{
+	if (!m_state->GetAdapter() || !m_state->IsConnected())
+		return false;
+
+	if (Contains(address))
+		return false;
+
+	auto adapter = m_state->GetAdapter();
+	bool ok = software ? adapter->AddSoftwareWatchpoint(address, size, type) : adapter->AddWatchpoint(address, size, type);
+	if (!ok)
+		return false;
+
+	m_watchpoints.emplace_back(address, size, type, software);
+	return true;
+}
+
+
+bool DebuggerWatchpoints::Remove(uint64_t address)
+{
+	auto iter = std::find_if(m_watchpoints.begin(), m_watchpoints.end(),
+		[&](const DebugWatchpoint& watchpoint) { return watchpoint.m_address == address; });
+	if (iter == m_watchpoints.end())
+		return false;
+
+	bool software = iter->m_software;
+	m_watchpoints.erase(iter);
+	if (m_state->GetAdapter() && m_state->IsConnected())
+	{
+		if (software)
+			m_state->GetAdapter()->RemoveSoftwareWatchpoint(address);
+		else
+			m_state->GetAdapter()->RemoveWatchpoint(address);
+	}
+
+	return true;
+}
+
+
+bool DebuggerWatchpoints::Contains(uint64_t address) const
+{
+	return std::find_if(m_watchpoints.begin(), m_watchpoints.end(),
+		[&](const DebugWatchpoint& watchpoint) { return watchpoint.m_address == address; })
+		!= m_watchpoints.end();
+}
+
+
+void DebuggerWatchpoints::Clear()
+{
+	m_watchpoints.clear();
+}
+
+
 DebuggerMemory::DebuggerMemory(DebuggerState* state) : m_state(state) {}
 
 
@@ -688,9 +867,11 @@ void DebuggerMemory::MarkDirty()
 
 DataBuffer DebuggerMemory::ReadBlock(uint64_t block)
 {
+	DataBuffer oldValue;
 	auto iter = m_valueCache.find(block);
 	if (iter != m_valueCache.end())
 	{
+		oldValue = iter->second.value;
 		switch (iter->second.status)
 		{
 		case FailedToReadStatus:
@@ -723,13 +904,19 @@ DataBuffer DebuggerMemory::ReadBlock(uint64_t block)
 		DataBuffer buffer = m_state->GetAdapter()->ReadMemory(block, 0x100);
 		if (buffer.GetLength() > 0)
 		{
-			// Successfully updated
+			// Successfully updated. The instructions decoded from the block are stale if its content has changed.
+			if ((oldValue.GetLength() > 0)
+				&& ((oldValue.GetLength() != buffer.GetLength())
+					|| (memcmp(oldValue.GetData(), buffer.GetData(), buffer.GetLength()) != 0)))
+				m_state->GetInstructionCache()->Invalidate(block, 0x100);
 			m_valueCache[block] = {buffer, UpToDateStatus};
 			return buffer;
 		}
 	}
 
 	// Update failed
+	if (oldValue.GetLength() > 0)
+		m_state->GetInstructionCache()->Invalidate(block, 0x100);
 	m_valueCache[block] = {{}, FailedToReadStatus};
 	return {};
 }
@@ -783,6 +970,8 @@ bool DebuggerMemory::WriteMemory(std::uintptr_t address, const DataBuffer& buffe
 	if (!adapter->WriteMemory(address, buffer))
 		return false;
 
+	m_state->GetInstructionCache()->Invalidate(address, buffer.GetLength());
+
 	//	TODO: Assume any memory change invalidates memory cache (suboptimal, may not be necessary)
 	MarkDirty();
 	return true;
@@ -799,7 +988,9 @@ DebuggerState::DebuggerState(BinaryViewRef data, DebuggerController* controller)
 	m_threads = new DebuggerThreads(this);
 	m_breakpoints = new DebuggerBreakpoints(this);
 	m_breakpoints->UnserializedMetadata();
+	m_watchpoints = new DebuggerWatchpoints(this);
 	m_memory = new DebuggerMemory(this);
+	m_instructionCache = new DebuggerInstructionCache();
 
 	// TODO: A better way to deal with this is to have the adapters return a fitness score, and then we pick the highest
 	// one from the list. Similar to what we do for the views.
@@ -823,6 +1014,10 @@ DebuggerState::DebuggerState(BinaryViewRef data, DebuggerController* controller)
 	if (metadata && metadata->IsString())
 		m_commandLineArgs = metadata->GetString();
 
+	metadata = m_controller->GetData()->QueryMetadata("debugger.signal_policies");
+	if (metadata && metadata->IsString() && ParseSignalPolicies(metadata->GetString(), m_parsedSignalPolicies))
+		m_signalPolicies = metadata->GetString();
+
 	metadata = m_controller->GetData()->QueryMetadata("debugger.input_file");
 	if (metadata && metadata->IsString())
 		m_inputFile = metadata->GetString();
@@ -892,7 +1087,9 @@ DebuggerState::~DebuggerState()
 	delete m_registers;
 	delete m_threads;
 	delete m_breakpoints;
+	delete m_watchpoints;
 	delete m_memory;
+	delete m_instructionCache;
 }
 
 
@@ -994,6 +1191,17 @@ Ref<Architecture> DebuggerState::GetRemoteArchitecture() const
 }
 
 
+std::shared_ptr<const DecodedInstruction> DebuggerState::DecodeInstruction(uint64_t address, bool lift)
+{
+	Ref<Architecture> arch = GetRemoteArchitecture();
+	if (!arch)
+		return nullptr;
+
+	DataBuffer buffer = m_memory->ReadMemory(address, arch->GetMaxInstructionLength());
+	return m_instructionCache->Decode(arch, address, (const uint8_t*)buffer.GetData(), buffer.GetLength(), lift);
+}
+
+
 void DebuggerState::SetAdapterType(const std::string& adapter)
 {
 	m_adapterType = adapter;
@@ -1035,6 +1243,73 @@ void DebuggerState::SetCommandLineArguments(const std::string& arguments)
 }
 
 
+bool DebuggerState::ParseSignalPolicies(const std::string& text, DebugSignalPolicies& policies)
+{
+	DebugSignalPolicies result;
+	size_t i = 0;
+	while (i < text.size())
+	{
+		if (isspace((unsigned char)text[i]) || (text[i] == ','))
+		{
+			i++;
+			continue;
+		}
+
+		size_t end = i;
+		while ((end < text.size()) && !isspace((unsigned char)text[end]) && (text[end] != ','))
+			end++;
+		std::string token = text.substr(i, end - i);
+		i = end;
+
+		size_t equal = token.find('=');
+		if ((equal == std::string::npos) || (equal == 0))
+		{
+			LogWarn("Invalid signal policy \"%s\", expecting NAME=stop|pass|ignore", token.c_str());
+			return false;
+		}
+
+		std::string name = token.substr(0, equal);
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return toupper(c); });
+		if (name.rfind("SIG", 0) != 0)
+			name = "SIG" + name;
+
+		std::string action = token.substr(equal + 1);
+		std::transform(action.begin(), action.end(), action.begin(), [](unsigned char c) { return tolower(c); });
+		if (action == "stop")
+			result[name] = SignalPolicyStop;
+		else if (action == "pass")
+			result[name] = SignalPolicyPass;
+		else if (action == "ignore")
+			result[name] = SignalPolicyIgnore;
+		else
+		{
+			LogWarn("Invalid action \"%s\" of the signal policy \"%s\", expecting stop, pass or ignore",
+				action.c_str(), token.c_str());
+			return false;
+		}
+	}
+
+	policies = result;
+	return true;
+}
+
+
+bool DebuggerState::SetSignalPolicies(const std::string& policies)
+{
+	DebugSignalPolicies parsed;
+	if (!ParseSignalPolicies(policies, parsed))
+		return false;
+
+	m_signalPolicies = policies;
+	m_parsedSignalPolicies = parsed;
+	if (m_adapter)
+		m_adapter->SetSignalPolicies(m_parsedSignalPolicies);
+
+	m_controller->NotifyEvent(DebuggerSettingsChangedEvent);
+	return true;
+}
+
+
 void DebuggerState::SetRemoteHost(const std::string& host)
 {
 	m_remoteHost = host;
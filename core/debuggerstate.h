@@ -16,6 +16,9 @@ limitations under the License.
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include "binaryninjaapi.h"
 #include "ui/uitypes.h"
 #include "debugadaptertype.h"
@@ -23,6 +26,7 @@ limitations under the License.
 #include "semaphore.h"
 #include "ffi_global.h"
 #include "refcountobject.h"
+#include "debuggerinstructioncache.h"
 
 DECLARE_DEBUGGER_API_OBJECT(BNDebuggerState, DebuggerState);
 
@@ -36,18 +40,25 @@ namespace BinaryNinjaDebugger {
 	{
 	private:
 		DebuggerState* m_state;
+		// The caches are updated on the thread that reports a stop, and read from the UI at the same time
+		std::recursive_mutex m_mutex;
 		std::unordered_map<std::string, DebugRegister> m_registerCache;
-		bool m_dirty;
+		std::atomic<bool> m_dirty;
 
 	public:
 		DebuggerRegisters(DebuggerState* state);
 		// DebugRegister operator[](std::string name);
 		uint64_t GetRegisterValue(const std::string& name);
+		// Returns false if the adapter does not have the register
+		bool GetRegisterValue(const std::string& name, uint64_t& value);
 		bool SetRegisterValue(const std::string& name, uint64_t value);
 		void MarkDirty();
 		bool IsDirty() const { return m_dirty; }
 		void Update();
 		std::vector<DebugRegister> GetAllRegisters();
+		// Calls the visitor with every register while the cache is locked. Unlike GetAllRegisters(), this copies
+		// nothing and does not compute the hints.
+		void VisitRegisters(const std::function<void(const DebugRegister&)>& visitor);
 	};
 
 
@@ -55,13 +66,15 @@ namespace BinaryNinjaDebugger {
 	{
 	private:
 		DebuggerState* m_state;
+		std::recursive_mutex m_mutex;
 		std::vector<DebugModule> m_modules;
-		bool m_dirty;
+		std::atomic<bool> m_dirty;
 
 	public:
 		DebuggerModules(DebuggerState* state);
 		void MarkDirty();
-		void Update();
+		// The modules are left dirty if isCancelled returns true, which is checked around the adapter call
+		void Update(const std::function<bool()>& isCancelled = nullptr);
 		bool IsDirty() const { return m_dirty; }
 
 		std::vector<DebugModule> GetAllModules();
@@ -79,6 +92,9 @@ namespace BinaryNinjaDebugger {
 	private:
 		DebuggerState* m_state;
 		std::vector<ModuleNameAndOffset> m_breakpoints;
+		// Conditions of the breakpoints, in the debugger expression syntax (see DebuggerExpression)
+		std::map<ModuleNameAndOffset, std::string> m_conditions;
+		std::map<ModuleNameAndOffset, std::string>::iterator FindCondition(const ModuleNameAndOffset& address);
 
 	public:
 		DebuggerBreakpoints(DebuggerState* state, std::vector<ModuleNameAndOffset> initial = {});
@@ -92,6 +108,31 @@ namespace BinaryNinjaDebugger {
 		void SerializeMetadata();
 		void UnserializedMetadata();
 		std::vector<ModuleNameAndOffset> GetBreakpointList() const { return m_breakpoints; }
+
+		// An empty condition makes the breakpoint unconditional
+		bool SetConditionAbsolute(uint64_t remoteAddress, const std::string& condition);
+		bool SetConditionOffset(const ModuleNameAndOffset& address, const std::string& condition);
+		std::string GetConditionAbsolute(uint64_t remoteAddress);
+		std::string GetConditionOffset(const ModuleNameAndOffset& address);
+		std::map<ModuleNameAndOffset, std::string> GetConditions() const { return m_conditions; }
+	};
+
+
+	// Watchpoints are set on absolute addresses, which are usually heap or stack objects of the current process. So
+	// unlike the breakpoints, they are neither saved in the metadata nor re-applied when the target is relaunched.
+	class DebuggerWatchpoints
+	{
+	private:
+		DebuggerState* m_state;
+		std::vector<DebugWatchpoint> m_watchpoints;
+
+	public:
+		DebuggerWatchpoints(DebuggerState* state);
+		bool Add(uint64_t address, size_t size, DebugWatchpointType type, bool software = false);
+		bool Remove(uint64_t address);
+		bool Contains(uint64_t address) const;
+		void Clear();
+		std::vector<DebugWatchpoint> GetWatchpointList() const { return m_watchpoints; }
 	};
 
 
@@ -100,13 +141,15 @@ namespace BinaryNinjaDebugger {
 	private:
 		DebuggerState* m_state;
 		std::vector<DebugThread> m_threads;
+		std::recursive_mutex m_mutex;
 		std::map<uint32_t, std::vector<DebugFrame>> m_frames;
-		bool m_dirty;
+		std::atomic<bool> m_dirty;
 
 	public:
 		DebuggerThreads(DebuggerState* state);
 		void MarkDirty();
-		void Update();
+		// The threads are left dirty if isCancelled returns true, which is checked between the adapter calls
+		void Update(const std::function<bool()>& isCancelled = nullptr);
 		DebugThread GetActiveThread() const;
 		bool SetActiveThread(const DebugThread& thread);
 		bool IsDirty() const { return m_dirty; }
@@ -168,12 +211,16 @@ namespace BinaryNinjaDebugger {
 		DebuggerRegisters* m_registers;
 		DebuggerThreads* m_threads;
 		DebuggerBreakpoints* m_breakpoints;
+		DebuggerWatchpoints* m_watchpoints;
 		DebuggerMemory* m_memory;
+		DebuggerInstructionCache* m_instructionCache;
 
 		std::string m_executablePath;
 		std::string m_inputFile;
 		std::string m_workingDirectory;
 		std::string m_commandLineArgs;
+		std::string m_signalPolicies;
+		DebugSignalPolicies m_parsedSignalPolicies;
 		std::string m_remoteHost;
 		uint32_t m_remotePort = 0;
 		int32_t m_pidAttach = 0;
@@ -194,9 +241,11 @@ namespace BinaryNinjaDebugger {
 
 		DebuggerModules* GetModules() const { return m_modules; }
 		DebuggerBreakpoints* GetBreakpoints() const { return m_breakpoints; }
+		DebuggerWatchpoints* GetWatchpoints() const { return m_watchpoints; }
 		DebuggerRegisters* GetRegisters() const { return m_registers; }
 		DebuggerThreads* GetThreads() const { return m_threads; }
 		DebuggerMemory* GetMemory() const { return m_memory; }
+		DebuggerInstructionCache* GetInstructionCache() const { return m_instructionCache; }
 		// This is no longer a remote architecture, because we do not really read the remote arch
 		Ref<Architecture> GetRemoteArchitecture() const;
 
@@ -205,6 +254,8 @@ namespace BinaryNinjaDebugger {
 		std::string GetInputFile() const { return m_inputFile; }
 		std::string GetWorkingDirectory() const { return m_workingDirectory; }
 		std::string GetCommandLineArguments() const { return m_commandLineArgs; }
+		std::string GetSignalPolicies() const { return m_signalPolicies; }
+		const DebugSignalPolicies& GetParsedSignalPolicies() const { return m_parsedSignalPolicies; }
 		std::string GetRemoteHost() const { return m_remoteHost; }
 		uint32_t GetRemotePort() const { return m_remotePort; }
 		bool GetRequestTerminalEmulator() const { return m_requestTerminalEmulator; }
@@ -216,6 +267,10 @@ namespace BinaryNinjaDebugger {
 		std::string GetInputFile();
 		void SetWorkingDirectory(const std::string& directory);
 		void SetCommandLineArguments(const std::string& arguments);
+		// The policies are separated by spaces or commas, e.g., "SIGUSR1=pass SIGPROF=ignore SIGSEGV=stop". Returns
+		// false and logs a warning if they cannot be parsed, in which case the current policies are kept.
+		bool SetSignalPolicies(const std::string& policies);
+		static bool ParseSignalPolicies(const std::string& text, DebugSignalPolicies& policies);
 		void SetRemoteHost(const std::string& host);
 		void SetRemotePort(uint32_t port);
 		void SetRequestTerminalEmulator(bool requested);
@@ -232,6 +287,9 @@ namespace BinaryNinjaDebugger {
 		uint64_t IP();
 		uint64_t StackPointer();
 
+		// Decodes the instruction at the address from the cached memory. Returns nullptr on failure.
+		std::shared_ptr<const DecodedInstruction> DecodeInstruction(uint64_t address, bool lift = false);
+
 		bool IsConnected() const { return m_connectionStatus == DebugAdapterConnectedStatus; }
 		bool IsConnecting() const { return m_connectionStatus == DebugAdapterConnectingStatus; }
 		bool IsRunning() const { return m_targetStatus == DebugAdapterRunningStatus; }
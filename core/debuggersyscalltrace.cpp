@@ -0,0 +1,551 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggersyscalltrace.h"
+#include "debuggercontroller.h"
+#include "lowlevelilinstruction.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace BinaryNinjaDebugger;
+
+// The number of completed syscalls that can wait for the drain thread before new ones are dropped
+static constexpr size_t SyscallRecordCapacity = 64 * 1024;
+// The number of syscalls that are kept. The oldest ones are dropped when there are more.
+static constexpr size_t SyscallHistoryCapacity = 256 * 1024;
+static constexpr std::chrono::milliseconds SyscallDrainInterval(100);
+// The encodings of the syscall instructions, which are only lifted to confirm them when the bytes match
+static const std::unordered_map<std::string, std::vector<std::vector<uint8_t>>> SyscallEncodings = {
+	{"x86_64", {{0x0f, 0x05}}},
+	{"x86", {{0xcd, 0x80}, {0x0f, 0x34}}},
+	{"aarch64", {{0x01, 0x00, 0x00, 0xd4}}},
+};
+
+
+struct ElfExecutableSection
+{
+	// The address in the file, before the module is relocated
+	uint64_t m_address;
+	uint64_t m_offset;
+	uint64_t m_size;
+};
+
+
+template <typename T>
+static T ReadElfValue(const std::vector<uint8_t>& data, uint64_t offset)
+{
+	// Only little-endian files are parsed
+	T value {};
+	if ((offset <= data.size()) && (sizeof(T) <= data.size() - offset))
+		memcpy(&value, data.data() + offset, sizeof(T));
+	return value;
+}
+
+
+// Parses the executable sections of a little-endian ELF file, and the address its header is loaded at before the
+// module is relocated
+static bool ParseElfExecutableSections(
+	const std::vector<uint8_t>& data, std::vector<ElfExecutableSection>& sections, uint64_t& headerAddress)
+{
+	static constexpr uint32_t PT_LOAD_TYPE = 1;
+	static constexpr uint32_t SHT_NOBITS_TYPE = 8;
+	static constexpr uint64_t SHF_EXECINSTR_FLAG = 4;
+
+	if ((data.size() < 0x34) || (memcmp(data.data(), "\x7f" "ELF", 4) != 0) || (data[5] != 1))
+		return false;
+
+	bool is64 = data[4] == 2;
+	if (is64 && (data.size() < 0x40))
+		return false;
+
+	uint64_t phoff = is64 ? ReadElfValue<uint64_t>(data, 0x20) : ReadElfValue<uint32_t>(data, 0x1c);
+	uint64_t shoff = is64 ? ReadElfValue<uint64_t>(data, 0x28) : ReadElfValue<uint32_t>(data, 0x20);
+	uint16_t phentsize = ReadElfValue<uint16_t>(data, is64 ? 0x36 : 0x2a);
+	uint16_t phnum = ReadElfValue<uint16_t>(data, is64 ? 0x38 : 0x2c);
+	uint16_t shentsize = ReadElfValue<uint16_t>(data, is64 ? 0x3a : 0x2e);
+	uint16_t shnum = ReadElfValue<uint16_t>(data, is64 ? 0x3c : 0x30);
+
+	// The header is loaded with the segment that maps the start of the file
+	bool found = false;
+	for (uint16_t i = 0; i < phnum; i++)
+	{
+		uint64_t entry = phoff + (uint64_t)i * phentsize;
+		if (ReadElfValue<uint32_t>(data, entry) != PT_LOAD_TYPE)
+			continue;
+
+		uint64_t offset = is64 ? ReadElfValue<uint64_t>(data, entry + 8) : ReadElfValue<uint32_t>(data, entry + 4);
+		uint64_t address = is64 ? ReadElfValue<uint64_t>(data, entry + 0x10) : ReadElfValue<uint32_t>(data, entry + 8);
+		if (!found || (address - offset < headerAddress))
+			headerAddress = address - offset;
+		found = true;
+	}
+	if (!found)
+		return false;
+
+	for (uint16_t i = 0; i < shnum; i++)
+	{
+		uint64_t entry = shoff + (uint64_t)i * shentsize;
+		uint32_t type = ReadElfValue<uint32_t>(data, entry + 4);
+		uint64_t flags = is64 ? ReadElfValue<uint64_t>(data, entry + 8) : ReadElfValue<uint32_t>(data, entry + 8);
+		if ((type == SHT_NOBITS_TYPE) || !(flags & SHF_EXECINSTR_FLAG))
+			continue;
+
+		ElfExecutableSection section;
+		if (is64)
+		{
+			section.m_address = ReadElfValue<uint64_t>(data, entry + 0x10);
+			section.m_offset = ReadElfValue<uint64_t>(data, entry + 0x18);
+			section.m_size = ReadElfValue<uint64_t>(data, entry + 0x20);
+		}
+		else
+		{
+			section.m_address = ReadElfValue<uint32_t>(data, entry + 0xc);
+			section.m_offset = ReadElfValue<uint32_t>(data, entry + 0x10);
+			section.m_size = ReadElfValue<uint32_t>(data, entry + 0x14);
+		}
+		if ((section.m_offset > data.size()) || (section.m_size > data.size() - section.m_offset))
+			continue;
+		sections.push_back(section);
+	}
+	return true;
+}
+
+
+DebuggerSyscallTrace::DebuggerSyscallTrace(DebuggerController* controller) :
+	m_controller(controller), m_records(SyscallRecordCapacity)
+{}
+
+
+DebuggerSyscallTrace::~DebuggerSyscallTrace()
+{
+	StopDrainThread();
+}
+
+
+bool DebuggerSyscallTrace::GetSyscallRegisters(
+	const std::string& arch, std::string& number, std::string& result, std::vector<std::string>& args)
+{
+	// The Linux syscall calling conventions
+	if (arch == "x86_64")
+	{
+		number = "rax";
+		result = "rax";
+		args = {"rdi", "rsi", "rdx", "r10", "r8", "r9"};
+	}
+	else if ((arch == "x86") || (arch == "i386"))
+	{
+		number = "eax";
+		result = "eax";
+		args = {"ebx", "ecx", "edx", "esi", "edi", "ebp"};
+	}
+	else if ((arch == "aarch64") || (arch == "arm64"))
+	{
+		number = "x8";
+		result = "x0";
+		args = {"x0", "x1", "x2", "x3", "x4", "x5"};
+	}
+	else if ((arch == "armv7") || (arch == "thumb2"))
+	{
+		number = "r7";
+		result = "r0";
+		args = {"r0", "r1", "r2", "r3", "r4", "r5"};
+	}
+	else
+	{
+		LogWarn("Syscall tracing is not supported on %s", arch.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+std::vector<uint64_t> DebuggerSyscallTrace::Start(const std::vector<std::string>& modules)
+{
+	BinaryViewRef data = m_controller->GetData();
+	ArchitectureRef arch = m_controller->GetRemoteArchitecture();
+	if (!data || !arch)
+		return {};
+
+	std::string numberRegister, resultRegister;
+	std::vector<std::string> argumentRegisters;
+	if (!GetSyscallRegisters(arch->GetName(), numberRegister, resultRegister, argumentRegisters))
+		return {};
+
+	auto isSelected = [&](const DebugModule& module) {
+		if (modules.empty())
+			return true;
+		for (const auto& name : modules)
+		{
+			if (module.IsSameBaseModule(name))
+				return true;
+		}
+		return false;
+	};
+
+	std::unordered_map<uint64_t, uint64_t> sites;
+	for (const auto& func : data->GetAnalysisFunctionList())
+	{
+		if (!isSelected(m_controller->GetModuleForAddress(func->GetStart())))
+			continue;
+
+		LowLevelILFunctionRef llil = func->GetLowLevelILIfAvailable();
+		if (!llil)
+			continue;
+
+		for (size_t i = 0; i < llil->GetInstructionCount(); i++)
+		{
+			LowLevelILInstruction instr = llil->GetInstruction(i);
+			if (instr.operation != LLIL_SYSCALL)
+				continue;
+
+			size_t length = data->GetInstructionLength(func->GetArchitecture(), instr.address);
+			if (length != 0)
+				sites[instr.address] = instr.address + length;
+		}
+	}
+
+	// Most syscalls are made by the shared libraries, whose code is not analyzed
+	if (SyscallEncodings.find(arch->GetName()) != SyscallEncodings.end())
+	{
+		for (const auto& module : m_controller->GetAllModules())
+		{
+			if (isSelected(module))
+				FindModuleSyscalls(arch, module, sites);
+		}
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(m_historyMutex);
+		Collect();
+		m_history.clear();
+		m_droppedCount = 0;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_sites = std::move(sites);
+	m_returnAddresses.clear();
+	for (const auto& [site, returnAddress] : m_sites)
+		m_returnAddresses[returnAddress]++;
+	m_pending.clear();
+	m_numberRegister = numberRegister;
+	m_resultRegister = resultRegister;
+	m_argumentRegisters = argumentRegisters;
+	m_active = !m_sites.empty();
+	if (!m_active)
+		return {};
+	lock.unlock();
+
+	StopDrainThread();
+	m_quitDrainThread = false;
+	m_drainThread = std::thread([this]() { DrainThread(); });
+
+	std::vector<uint64_t> result;
+	for (const auto& [site, returnAddress] : m_sites)
+		result.push_back(site);
+	for (const auto& [returnAddress, count] : m_returnAddresses)
+		result.push_back(returnAddress);
+	return result;
+}
+
+
+std::vector<uint64_t> DebuggerSyscallTrace::Stop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_active)
+		return {};
+
+	std::vector<uint64_t> result;
+	for (const auto& [site, returnAddress] : m_sites)
+		result.push_back(site);
+	for (const auto& [returnAddress, count] : m_returnAddresses)
+		result.push_back(returnAddress);
+
+	std::vector<SyscallRecord> pending;
+	for (auto& [tid, record] : m_pending)
+		pending.push_back(record);
+
+	m_sites.clear();
+	m_returnAddresses.clear();
+	m_pending.clear();
+	m_active = false;
+	lock.unlock();
+
+	StopDrainThread();
+
+	std::unique_lock<std::mutex> historyLock(m_historyMutex);
+	Collect();
+	for (auto& record : pending)
+		AddToHistory(std::move(record));
+
+	return result;
+}
+
+
+bool DebuggerSyscallTrace::ReadRegister(const std::string& name, uint64_t& value)
+{
+	DebugAdapter* adapter = m_controller->GetAdapter();
+	if (!adapter)
+		return false;
+
+	DebugRegister reg = adapter->ReadRegister(name);
+	if (reg.m_name.empty())
+		return false;
+
+	value = reg.m_value;
+	return true;
+}
+
+
+void DebuggerSyscallTrace::FindModuleSyscalls(
+	Ref<Architecture> arch, const DebugModule& module, std::unordered_map<uint64_t, uint64_t>& sites)
+{
+	DebugAdapter* adapter = m_controller->GetAdapter();
+	if (!adapter)
+		return;
+
+	// The pseudo modules, e.g., [vdso], have no file
+	std::ifstream file(module.m_name, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+		return;
+	std::vector<uint8_t> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	std::vector<ElfExecutableSection> sections;
+	uint64_t headerAddress = 0;
+	if (!ParseElfExecutableSections(contents, sections, headerAddress))
+		return;
+
+	const auto& encodings = SyscallEncodings.at(arch->GetName());
+	uint64_t bias = module.m_address - headerAddress;
+	size_t alignment = std::max<size_t>(arch->GetInstructionAlignment(), 1);
+	size_t count = 0;
+	for (const auto& section : sections)
+	{
+		const uint8_t* code = contents.data() + section.m_offset;
+		uint64_t offset = 0;
+		while (offset < section.m_size)
+		{
+			uint64_t address = section.m_address + bias + offset;
+			size_t remaining = section.m_size - offset;
+			InstructionInfo info;
+			if (!arch->GetInstructionInfo(code + offset, address, remaining, info) || (info.length == 0)
+				|| (info.length > remaining))
+			{
+				offset += alignment;
+				continue;
+			}
+
+			for (const auto& encoding : encodings)
+			{
+				if ((info.length != encoding.size()) || (memcmp(code + offset, encoding.data(), info.length) != 0))
+					continue;
+
+				// The breakpoints must only be placed on the instructions that the target actually has there
+				DataBuffer bytes = adapter->ReadMemory(address, info.length);
+				if ((bytes.GetLength() != info.length) || (memcmp(bytes.GetData(), encoding.data(), info.length) != 0))
+					break;
+
+				Ref<LowLevelILFunction> ilFunc = new LowLevelILFunction(arch, nullptr);
+				ilFunc->SetCurrentAddress(arch, address);
+				if (!arch->GetInstructionLowLevelIL(code + offset, address, info.length, *ilFunc)
+					|| (ilFunc->GetInstructionCount() == 0))
+					break;
+
+				for (size_t i = 0; i < ilFunc->GetInstructionCount(); i++)
+				{
+					if (ilFunc->GetInstruction(i).operation == LLIL_SYSCALL)
+					{
+						sites[address] = address + info.length;
+						count++;
+						break;
+					}
+				}
+				break;
+			}
+			offset += info.length;
+		}
+	}
+
+	LogDebug("Found %zu syscall instructions in %s", count, module.m_name.c_str());
+}
+
+
+bool DebuggerSyscallTrace::Hit(uint32_t tid, uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_active)
+		return false;
+
+	bool handled = false;
+	// A syscall can be followed by another one right away, so the return is handled first
+	if (m_returnAddresses.find(address) != m_returnAddresses.end())
+	{
+		handled = true;
+		auto it = m_pending.find(tid);
+		if ((it != m_pending.end()) && (m_sites[it->second.m_address] == address))
+		{
+			SyscallRecord record = it->second;
+			m_pending.erase(it);
+			record.m_returned = ReadRegister(m_resultRegister, record.m_result);
+			m_records.Push(std::move(record));
+		}
+	}
+
+	if (m_sites.find(address) != m_sites.end())
+	{
+		handled = true;
+		SyscallRecord record;
+		record.m_tid = tid;
+		record.m_address = address;
+		ReadRegister(m_numberRegister, record.m_number);
+		for (size_t i = 0; i < m_argumentRegisters.size(); i++)
+			ReadRegister(m_argumentRegisters[i], record.m_args[i]);
+
+		// The previous syscall of the thread never got back to the next instruction, e.g., rt_sigreturn
+		auto it = m_pending.find(tid);
+		if (it != m_pending.end())
+		{
+			m_records.Push(std::move(it->second));
+			it->second = record;
+		}
+		else
+		{
+			m_pending[tid] = record;
+		}
+	}
+
+	return handled;
+}
+
+
+bool DebuggerSyscallTrace::NeedsBreakpoint(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return (m_sites.find(address) != m_sites.end()) || (m_returnAddresses.find(address) != m_returnAddresses.end());
+}
+
+
+void DebuggerSyscallTrace::AddToHistory(SyscallRecord&& record)
+{
+	if (m_history.size() >= SyscallHistoryCapacity)
+	{
+		m_history.pop_front();
+		m_droppedCount++;
+	}
+	m_history.push_back(std::move(record));
+}
+
+
+void DebuggerSyscallTrace::Collect()
+{
+	std::vector<SyscallRecord> records;
+	m_records.Drain(records);
+	for (auto& record : records)
+		AddToHistory(std::move(record));
+}
+
+
+std::vector<SyscallRecord> DebuggerSyscallTrace::GetRecords()
+{
+	std::unique_lock<std::mutex> lock(m_historyMutex);
+	Collect();
+	return std::vector<SyscallRecord>(m_history.begin(), m_history.end());
+}
+
+
+uint64_t DebuggerSyscallTrace::GetDroppedRecordCount()
+{
+	std::unique_lock<std::mutex> lock(m_historyMutex);
+	return m_droppedCount + m_records.GetDroppedCount();
+}
+
+
+std::string DebuggerSyscallTrace::GetSyscallName(uint64_t number)
+{
+	BinaryViewRef data = m_controller->GetData();
+	if (!data || !data->GetDefaultPlatform())
+		return "";
+
+	return data->GetDefaultPlatform()->GetSystemCallName((uint32_t)number);
+}
+
+
+bool DebuggerSyscallTrace::Export(const std::string& path)
+{
+	std::vector<SyscallRecord> records = GetRecords();
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LogWarn("Failed to open %s for writing the syscall trace", path.c_str());
+		return false;
+	}
+
+	std::unordered_map<uint64_t, std::string> names;
+	for (const auto& record : records)
+	{
+		auto it = names.find(record.m_number);
+		if (it == names.end())
+		{
+			std::string name = GetSyscallName(record.m_number);
+			if (name.empty())
+				name = fmt::format("syscall_{}", record.m_number);
+			it = names.emplace(record.m_number, name).first;
+		}
+
+		file << fmt::format("[tid {}] 0x{:x} {}(0x{:x}, 0x{:x}, 0x{:x}, 0x{:x}, 0x{:x}, 0x{:x})", record.m_tid,
+			record.m_address, it->second, record.m_args[0], record.m_args[1], record.m_args[2], record.m_args[3],
+			record.m_args[4], record.m_args[5]);
+		if (record.m_returned)
+			file << fmt::format(" = 0x{:x}\n", record.m_result);
+		else
+			file << " = ?\n";
+	}
+
+	return file.good();
+}
+
+
+void DebuggerSyscallTrace::DrainThread()
+{
+	std::unique_lock<std::mutex> lock(m_drainThreadMutex);
+	while (!m_quitDrainThread)
+	{
+		m_drainThreadCv.wait_for(lock, SyscallDrainInterval);
+		if (m_records.IsEmpty())
+			continue;
+
+		lock.unlock();
+		{
+			std::unique_lock<std::mutex> historyLock(m_historyMutex);
+			Collect();
+		}
+		lock.lock();
+	}
+}
+
+
+void DebuggerSyscallTrace::StopDrainThread()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_drainThreadMutex);
+		m_quitDrainThread = true;
+	}
+	m_drainThreadCv.notify_all();
+	if (m_drainThread.joinable())
+		m_drainThread.join();
+}
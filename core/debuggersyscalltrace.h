@@ -0,0 +1,125 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "binaryninjaapi.h"
+#include "ringbuffer.h"
+
+namespace BinaryNinjaDebugger {
+	class DebuggerController;
+	struct DebugModule;
+
+	struct SyscallRecord
+	{
+		uint32_t m_tid = 0;
+		// Address of the syscall instruction
+		uint64_t m_address = 0;
+		uint64_t m_number = 0;
+		uint64_t m_args[6] = {};
+		uint64_t m_result = 0;
+		// False if the syscall did not return while it was traced, e.g., exit, or a blocking call that is pending
+		bool m_returned = false;
+	};
+
+	// Traces the syscalls made by a local Linux target. The syscall instructions found in the selected modules, and the
+	// instructions that follow them, get internal breakpoints. The number and the arguments
+	// are read when a thread reaches a syscall instruction, and the result once the thread gets past it. Everything is
+	// done in the adapter event thread, and the target is resumed without notifying the UI. The completed records are
+	// pushed into a lock-free ring buffer, which a background thread moves into a bounded history in batches.
+	//
+	// The syscall instructions are collected from the functions analyzed in the binary view, and from the executable
+	// sections of the loaded modules, e.g., libc and ld.so, which are read from their files and decoded linearly. The
+	// modules are only decoded on x86, x86_64 and aarch64, where the code of the shared libraries has no inline data
+	// or mixed instruction sets. The modules loaded after the trace starts are not searched.
+	class DebuggerSyscallTrace
+	{
+	private:
+		DebuggerController* m_controller;
+
+		std::mutex m_mutex;
+		bool m_active = false;
+		// Syscall instruction -> the address of the next instruction
+		std::unordered_map<uint64_t, uint64_t> m_sites;
+		// Addresses of the instructions after the syscalls, and the number of syscall sites that return to them
+		std::unordered_map<uint64_t, size_t> m_returnAddresses;
+		// The syscall that every thread is in
+		std::unordered_map<uint32_t, SyscallRecord> m_pending;
+
+		std::string m_numberRegister;
+		std::string m_resultRegister;
+		std::vector<std::string> m_argumentRegisters;
+
+		RingBuffer<SyscallRecord> m_records;
+
+		// Serializes the consumers of m_records, i.e., the drain thread and Collect()
+		std::mutex m_historyMutex;
+		std::deque<SyscallRecord> m_history;
+		uint64_t m_droppedCount = 0;
+
+		std::thread m_drainThread;
+		std::mutex m_drainThreadMutex;
+		std::condition_variable m_drainThreadCv;
+		bool m_quitDrainThread = false;
+		void DrainThread();
+		void StopDrainThread();
+
+		bool ReadRegister(const std::string& name, uint64_t& value);
+		// Adds the syscall instructions in the executable sections of the module's file
+		void FindModuleSyscalls(BinaryNinja::Ref<BinaryNinja::Architecture> arch, const DebugModule& module,
+			std::unordered_map<uint64_t, uint64_t>& sites);
+		// Moves the pending records from the ring buffer into the history. The caller must hold m_historyMutex.
+		void Collect();
+		void AddToHistory(SyscallRecord&& record);
+
+	public:
+		DebuggerSyscallTrace(DebuggerController* controller);
+		~DebuggerSyscallTrace();
+
+		// Returns false and logs a warning if the target is not supported
+		static bool GetSyscallRegisters(const std::string& arch, std::string& number, std::string& result,
+			std::vector<std::string>& args);
+
+		// Clears the previous records, and collects the syscall instructions of the given modules, or of all the
+		// modules when none is given. Returns the addresses that need a breakpoint.
+		std::vector<uint64_t> Start(const std::vector<std::string>& modules);
+		// Returns the addresses whose breakpoints are no longer needed by the syscall trace. The syscalls that have
+		// not returned yet are recorded as such.
+		std::vector<uint64_t> Stop();
+		bool IsActive() const { return m_active; }
+
+		// Called from the adapter event thread. Returns true if the address is a syscall instruction or follows one.
+		bool Hit(uint32_t tid, uint64_t address);
+		// Whether the syscall trace still has a breakpoint at the address
+		bool NeedsBreakpoint(uint64_t address);
+
+		std::vector<SyscallRecord> GetRecords();
+		uint64_t GetDroppedRecordCount();
+		// The name of the syscall in the platform of the target, or an empty string if it is unknown
+		std::string GetSyscallName(uint64_t number);
+		// Writes one line per syscall, e.g.,
+		// "[tid 1234] 0x7ffff7e8e887 write(0x1, 0x4052a0, 0xd, 0x0, 0x0, 0x0) = 0xd"
+		bool Export(const std::string& path);
+	};
+};  // namespace BinaryNinjaDebugger
@@ -0,0 +1,316 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "debuggertracepoints.h"
+#include "debuggercontroller.h"
+#include <chrono>
+
+using namespace BinaryNinjaDebugger;
+
+// The number of records that can be pending before new ones are dropped
+static constexpr size_t TracepointRecordCapacity = 64 * 1024;
+// The maximum number of records that are sent to the console in one message
+static constexpr size_t TracepointDrainBatchSize = 4096;
+static constexpr std::chrono::milliseconds TracepointDrainInterval(200);
+
+
+DebuggerTracepoints::DebuggerTracepoints(DebuggerController* controller) :
+	m_controller(controller), m_records(TracepointRecordCapacity)
+{}
+
+
+DebuggerTracepoints::~DebuggerTracepoints()
+{
+	StopDrainThread();
+}
+
+
+void DebuggerTracepoints::StopDrainThread()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_drainThreadMutex);
+		m_quitDrainThread = true;
+	}
+	m_drainThreadCv.notify_all();
+	if (m_drainThread.joinable())
+		m_drainThread.join();
+}
+
+
+bool DebuggerTracepoints::ParseFormat(const std::string& format, std::vector<TracepointFormatPart>& parts)
+{
+	// Literal text, with "{expr}" or "{expr:d}" for the values. "{{" and "}}" are literal braces.
+	parts.clear();
+	std::string text;
+	size_t i = 0;
+	while (i < format.size())
+	{
+		char c = format[i];
+		if ((c == '{' || c == '}') && (i + 1 < format.size()) && (format[i + 1] == c))
+		{
+			text += c;
+			i += 2;
+			continue;
+		}
+
+		if (c == '}')
+		{
+			LogWarn("Unmatched '}' at offset %zu of the tracepoint format \"%s\"", i, format.c_str());
+			return false;
+		}
+
+		if (c != '{')
+		{
+			text += c;
+			i++;
+			continue;
+		}
+
+		size_t end = format.find('}', i);
+		if (end == std::string::npos)
+		{
+			LogWarn("Unmatched '{' at offset %zu of the tracepoint format \"%s\"", i, format.c_str());
+			return false;
+		}
+
+		TracepointFormatPart part;
+		part.m_text = text;
+		text.clear();
+
+		std::string expression = format.substr(i + 1, end - i - 1);
+		if (auto colon = expression.rfind(':'); colon != std::string::npos)
+		{
+			std::string spec = expression.substr(colon + 1);
+			if (spec == "d")
+				part.m_decimal = true;
+			else if (spec != "x")
+			{
+				LogWarn("Unknown format specifier \"%s\" in the tracepoint format \"%s\"", spec.c_str(),
+					format.c_str());
+				return false;
+			}
+			expression = expression.substr(0, colon);
+		}
+
+		std::string error;
+		if (!DebuggerExpression::Parse(expression, part.m_expression, error))
+		{
+			LogWarn("Invalid expression \"%s\" in the tracepoint format \"%s\": %s", expression.c_str(),
+				format.c_str(), error.c_str());
+			return false;
+		}
+
+		parts.push_back(part);
+		i = end + 1;
+	}
+
+	if (!text.empty())
+	{
+		TracepointFormatPart part;
+		part.m_text = text;
+		parts.push_back(part);
+	}
+
+	return true;
+}
+
+
+bool DebuggerTracepoints::Add(uint64_t address, const std::string& format)
+{
+	Tracepoint tracepoint;
+	tracepoint.m_address = address;
+	tracepoint.m_format = format;
+	if (!ParseFormat(format, tracepoint.m_parts))
+		return false;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_tracepoints[address] = tracepoint;
+	UpdateDrainThread();
+	return true;
+}
+
+
+bool DebuggerTracepoints::Remove(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	bool removed = m_tracepoints.erase(address) != 0;
+	UpdateDrainThread();
+	return removed;
+}
+
+
+bool DebuggerTracepoints::Contains(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_tracepoints.find(address) != m_tracepoints.end();
+}
+
+
+void DebuggerTracepoints::Clear()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_tracepoints.clear();
+	UpdateDrainThread();
+}
+
+
+std::vector<Tracepoint> DebuggerTracepoints::GetTracepoints()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	std::vector<Tracepoint> result;
+	for (const auto& [address, tracepoint] : m_tracepoints)
+		result.push_back(tracepoint);
+	return result;
+}
+
+
+uint64_t DebuggerTracepoints::GetHitCount(uint64_t address)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto it = m_tracepoints.find(address);
+	if (it == m_tracepoints.end())
+		return 0;
+	return it->second.m_hitCount;
+}
+
+
+bool DebuggerTracepoints::Hit(uint32_t tid, uint64_t address, const TracepointEvaluator& evaluate)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto it = m_tracepoints.find(address);
+	if (it == m_tracepoints.end())
+		return false;
+
+	Tracepoint& tracepoint = it->second;
+	tracepoint.m_hitCount++;
+	if (tracepoint.m_parts.empty())
+		return true;
+
+	std::string message;
+	for (const auto& part : tracepoint.m_parts)
+	{
+		message += part.m_text;
+		if (!part.m_expression.IsValid())
+			continue;
+
+		uint64_t value = 0;
+		if (!evaluate(part.m_expression, value))
+			message += "<error>";
+		else if (part.m_decimal)
+			message += fmt::format("{}", value);
+		else
+			message += fmt::format("0x{:x}", value);
+	}
+	lock.unlock();
+
+	m_records.Push({address, tid, std::move(message)});
+	return true;
+}
+
+
+bool DebuggerTracepoints::SetOutputFile(const std::string& path)
+{
+	// Write out the pending records to the old destination first
+	Flush();
+
+	std::unique_lock<std::mutex> lock(m_drainMutex);
+	if (m_outputFile.is_open())
+		m_outputFile.close();
+	m_outputPath.clear();
+
+	if (path.empty())
+		return true;
+
+	m_outputFile.open(path, std::ios::out | std::ios::app);
+	if (!m_outputFile.is_open())
+	{
+		LogWarn("Failed to open %s for writing tracepoint logs", path.c_str());
+		return false;
+	}
+	m_outputPath = path;
+	return true;
+}
+
+
+std::string DebuggerTracepoints::GetOutputFile()
+{
+	std::unique_lock<std::mutex> lock(m_drainMutex);
+	return m_outputPath;
+}
+
+
+void DebuggerTracepoints::Flush()
+{
+	std::unique_lock<std::mutex> lock(m_drainMutex);
+	std::vector<TracepointRecord> records;
+	while (m_records.Drain(records, TracepointDrainBatchSize) > 0)
+	{
+		std::string text;
+		for (const auto& record : records)
+			text += fmt::format("[tracepoint 0x{:x}, tid {}] {}\n", record.m_address, record.m_tid, record.m_message);
+		records.clear();
+
+		if (m_outputFile.is_open())
+		{
+			m_outputFile << text;
+			m_outputFile.flush();
+		}
+		else
+		{
+			DebuggerEvent event;
+			event.type = BackendMessageEventType;
+			event.data.setMessageData().message = std::move(text);
+			m_controller->PostDebuggerEvent(std::move(event));
+		}
+	}
+}
+
+
+void DebuggerTracepoints::UpdateDrainThread()
+{
+	bool active = !m_tracepoints.empty();
+	std::unique_lock<std::mutex> lock(m_drainThreadMutex);
+	if (active == m_drainThreadActive)
+		return;
+
+	m_drainThreadActive = active;
+	// The thread is not stopped when the tracepoints are cleared, since that happens from the event callbacks, which
+	// the thread may be waiting for. It sleeps until the next Add() instead.
+	if (active && !m_drainThread.joinable() && !m_quitDrainThread)
+		m_drainThread = std::thread([this]() { DrainThread(); });
+	else
+		m_drainThreadCv.notify_all();
+}
+
+
+void DebuggerTracepoints::DrainThread()
+{
+	std::unique_lock<std::mutex> lock(m_drainThreadMutex);
+	while (!m_quitDrainThread)
+	{
+		if (m_drainThreadActive)
+			m_drainThreadCv.wait_for(lock, TracepointDrainInterval);
+		else
+			m_drainThreadCv.wait(lock, [this]() { return m_drainThreadActive || m_quitDrainThread; });
+
+		if (m_quitDrainThread || m_records.IsEmpty())
+			continue;
+
+		lock.unlock();
+		Flush();
+		lock.lock();
+	}
+}
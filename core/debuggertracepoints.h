@@ -0,0 +1,114 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "debuggerexpression.h"
+#include "ringbuffer.h"
+
+namespace BinaryNinjaDebugger {
+	class DebuggerController;
+
+	// A piece of a tracepoint log format. Either literal text, or an expression whose value is printed.
+	struct TracepointFormatPart
+	{
+		std::string m_text;
+		DebuggerExpression m_expression;
+		bool m_decimal = false;
+	};
+
+	struct Tracepoint
+	{
+		uint64_t m_address;
+		// The log format, e.g., "strlen({rdi}) called with [rdi] = {[rdi].b:d}". An empty format only counts the hits.
+		std::string m_format;
+		std::vector<TracepointFormatPart> m_parts;
+		uint64_t m_hitCount = 0;
+	};
+
+	struct TracepointRecord
+	{
+		uint64_t m_address;
+		uint32_t m_tid;
+		std::string m_message;
+	};
+
+	// Evaluates an expression against the thread that hits the tracepoint. Returns false on failure.
+	typedef std::function<bool(const DebuggerExpression& expression, uint64_t& value)> TracepointEvaluator;
+
+	// Tracepoints are internal breakpoints that count their hits and optionally log a formatted line, and then let the
+	// target continue without reporting a stop. The hits are handled in the adapter event thread. The log records
+	// are pushed into a lock-free ring buffer, which a background thread drains in batches to the debugger console
+	// or to a file, so that the target is never slowed down by the UI.
+	class DebuggerTracepoints
+	{
+	private:
+		DebuggerController* m_controller;
+
+		std::mutex m_mutex;
+		std::map<uint64_t, Tracepoint> m_tracepoints;
+
+		RingBuffer<TracepointRecord> m_records;
+
+		// Serializes the consumers of m_records, i.e., the drain thread and Flush()
+		std::mutex m_drainMutex;
+		std::ofstream m_outputFile;
+		std::string m_outputPath;
+
+		// The drain thread is started by the first Add(), and only wakes up periodically while there are tracepoints
+		std::thread m_drainThread;
+		std::mutex m_drainThreadMutex;
+		std::condition_variable m_drainThreadCv;
+		bool m_drainThreadActive = false;
+		bool m_quitDrainThread = false;
+		void DrainThread();
+		// Called while holding m_mutex
+		void UpdateDrainThread();
+
+	public:
+		DebuggerTracepoints(DebuggerController* controller);
+		~DebuggerTracepoints();
+
+		// Returns false and logs a warning if the format cannot be parsed
+		static bool ParseFormat(const std::string& format, std::vector<TracepointFormatPart>& parts);
+
+		bool Add(uint64_t address, const std::string& format);
+		bool Remove(uint64_t address);
+		bool Contains(uint64_t address);
+		void Clear();
+		std::vector<Tracepoint> GetTracepoints();
+		uint64_t GetHitCount(uint64_t address);
+		uint64_t GetDroppedRecordCount() const { return m_records.GetDroppedCount(); }
+
+		// Called from the adapter event thread. Returns true if there is a tracepoint at the address.
+		bool Hit(uint32_t tid, uint64_t address, const TracepointEvaluator& evaluate);
+
+		// An empty path sends the records to the debugger console
+		bool SetOutputFile(const std::string& path);
+		std::string GetOutputFile();
+		// Write out all pending records, e.g., before reporting a stop
+		void Flush();
+		// Stops the drain thread for good. The later records are only written out by Flush().
+		void StopDrainThread();
+	};
+};  // namespace BinaryNinjaDebugger
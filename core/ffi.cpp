@@ -180,6 +180,15 @@ bool BNDebuggerWriteMemory(BNDebuggerController* controller, uint64_t address, B
 }
 
 
+size_t BNDebuggerGetInstructionLength(BNDebuggerController* controller, uint64_t address)
+{
+	auto instruction = controller->object->GetState()->DecodeInstruction(address);
+	if (!instruction)
+		return 0;
+	return instruction->GetLength();
+}
+
+
 BNDebugProcess* BNDebuggerGetProcessList(BNDebuggerController* controller, size_t* size)
 {
 	std::vector<DebugProcess> processes = controller->object->GetProcessList();
@@ -446,6 +455,36 @@ void BNDebuggerPause(BNDebuggerController* controller)
 }
 
 
+size_t BNDebuggerCancelPendingCommands(BNDebuggerController* controller)
+{
+	return controller->object->CancelPendingCommands();
+}
+
+
+size_t BNDebuggerGetPendingCommandCount(BNDebuggerController* controller)
+{
+	return controller->object->GetPendingCommandCount();
+}
+
+
+void BNDebuggerSetOperationTimeout(BNDebuggerController* controller, uint64_t milliseconds)
+{
+	controller->object->SetOperationTimeout(milliseconds);
+}
+
+
+uint64_t BNDebuggerGetOperationTimeout(BNDebuggerController* controller)
+{
+	return controller->object->GetOperationTimeout();
+}
+
+
+bool BNDebuggerCancelOperation(BNDebuggerController* controller)
+{
+	return controller->object->CancelOperation();
+}
+
+
 // Convenience function, either launch the target process or connect to a remote, depending on the selected adapter
 void BNDebuggerLaunchOrConnect(BNDebuggerController* controller)
 {
@@ -548,6 +587,19 @@ BNDebugStopReason BNDebuggerStepIntoReverseAndWait(BNDebuggerController* control
 }
 
 
+BNDebugStopReason BNDebuggerStepIntoNAndWait(BNDebuggerController* controller, uint64_t count)
+{
+	return controller->object->StepIntoNAndWait(count);
+}
+
+
+BNDebugStopReason BNDebuggerStepUntilAndWait(
+	BNDebuggerController* controller, const char* condition, uint64_t maxSteps)
+{
+	return controller->object->StepUntilAndWait(condition, maxSteps);
+}
+
+
 BNDebugStopReason BNDebuggerStepOverAndWait(BNDebuggerController* controller, BNFunctionGraphType il)
 {
 	return controller->object->StepOverAndWait(il);
@@ -760,6 +812,18 @@ void BNDebuggerSetCommandLineArguments(BNDebuggerController* controller, const c
 }
 
 
+char* BNDebuggerGetSignalPolicies(BNDebuggerController* controller)
+{
+	return BNDebuggerAllocString(controller->object->GetState()->GetSignalPolicies().c_str());
+}
+
+
+bool BNDebuggerSetSignalPolicies(BNDebuggerController* controller, const char* policies)
+{
+	return controller->object->GetState()->SetSignalPolicies(policies);
+}
+
+
 // TODO: the structures to hold information about the breakpoints are different in the API and the core, so we need to
 // convert it here. Better unify them later.
 BNDebugBreakpoint* BNDebuggerGetBreakpoints(BNDebuggerController* controller, size_t* count)
@@ -866,6 +930,80 @@ bool BNDebuggerContainsRelativeBreakpoint(BNDebuggerController* controller, cons
 }
 
 
+bool BNDebuggerAddWatchpoint(
+	BNDebuggerController* controller, uint64_t address, size_t size, BNDebugWatchpointType type, bool software)
+{
+	return controller->object->AddWatchpoint(address, size, type, software);
+}
+
+
+bool BNDebuggerRemoveWatchpoint(BNDebuggerController* controller, uint64_t address)
+{
+	return controller->object->RemoveWatchpoint(address);
+}
+
+
+bool BNDebuggerContainsWatchpoint(BNDebuggerController* controller, uint64_t address)
+{
+	return controller->object->ContainsWatchpoint(address);
+}
+
+
+BNDebugWatchpoint* BNDebuggerGetWatchpoints(BNDebuggerController* controller, size_t* count)
+{
+	std::vector<DebugWatchpoint> watchpoints = controller->object->GetWatchpoints();
+	*count = watchpoints.size();
+
+	BNDebugWatchpoint* result = new BNDebugWatchpoint[watchpoints.size()];
+	for (size_t i = 0; i < watchpoints.size(); i++)
+	{
+		result[i].address = watchpoints[i].m_address;
+		result[i].size = watchpoints[i].m_size;
+		result[i].type = watchpoints[i].m_type;
+		result[i].software = watchpoints[i].m_software;
+	}
+	return result;
+}
+
+
+void BNDebuggerFreeWatchpoints(BNDebugWatchpoint* watchpoints)
+{
+	delete[] watchpoints;
+}
+
+
+bool BNDebuggerSetAbsoluteBreakpointCondition(BNDebuggerController* controller, uint64_t address, const char* condition)
+{
+	return controller->object->SetBreakpointCondition(address, condition);
+}
+
+
+bool BNDebuggerSetRelativeBreakpointCondition(
+	BNDebuggerController* controller, const char* module, uint64_t offset, const char* condition)
+{
+	return controller->object->SetBreakpointCondition(ModuleNameAndOffset(module, offset), condition);
+}
+
+
+char* BNDebuggerGetAbsoluteBreakpointCondition(BNDebuggerController* controller, uint64_t address)
+{
+	return BNDebuggerAllocString(controller->object->GetBreakpointCondition(address).c_str());
+}
+
+
+char* BNDebuggerGetRelativeBreakpointCondition(BNDebuggerController* controller, const char* module, uint64_t offset)
+{
+	return BNDebuggerAllocString(
+		controller->object->GetBreakpointCondition(ModuleNameAndOffset(module, offset)).c_str());
+}
+
+
+uint64_t BNDebuggerGetBreakpointHitCount(BNDebuggerController* controller, uint64_t address)
+{
+	return controller->object->GetBreakpointHitCount(address);
+}
+
+
 uint64_t BNDebuggerRelativeAddressToAbsolute(BNDebuggerController* controller, const char* module, uint64_t offset)
 {
 	DebuggerState* state = controller->object->GetState();
@@ -907,41 +1045,37 @@ bool BNDebuggerIsSameBaseModule(const char* module1, const char* module2)
 }
 
 
-size_t BNDebuggerRegisterEventCallback(
-	BNDebuggerController* controller, void (*callback)(void* ctx, BNDebuggerEvent* event), const char* name, void* ctx)
+size_t BNDebuggerRegisterEventCallback(BNDebuggerController* controller,
+	void (*callback)(void* ctx, BNDebuggerEvent* event), const char* name, void* ctx, BNDebuggerEventDelivery delivery,
+	uint64_t eventMask)
 {
 	return controller->object->RegisterEventCallback(
 		[=](const DebuggerEvent& event) {
-			BNDebuggerEvent* evt = new BNDebuggerEvent;
-
-			evt->type = event.type;
-			evt->data.targetStoppedData.reason = event.data.targetStoppedData.reason;
-			evt->data.targetStoppedData.exitCode = event.data.targetStoppedData.exitCode;
-			evt->data.targetStoppedData.lastActiveThread = event.data.targetStoppedData.lastActiveThread;
-			evt->data.targetStoppedData.data = event.data.targetStoppedData.data;
-
-			evt->data.errorData.error = BNDebuggerAllocString(event.data.errorData.error.c_str());
-			evt->data.errorData.shortError = BNDebuggerAllocString(event.data.errorData.shortError.c_str());
-			evt->data.errorData.data = event.data.errorData.data;
+			// The strings are borrowed from the core event, which outlives the callback, so converting an event does
+			// not allocate
+			BNDebuggerEvent evt;
+			evt.type = event.type;
+			evt.data.targetStoppedData.reason = event.data.targetStoppedData().reason;
+			evt.data.targetStoppedData.exitCode = event.data.targetStoppedData().exitCode;
+			evt.data.targetStoppedData.lastActiveThread = event.data.targetStoppedData().lastActiveThread;
+			evt.data.targetStoppedData.data = event.data.targetStoppedData().data;
 
-			evt->data.exitData.exitCode = event.data.exitData.exitCode;
+			evt.data.errorData.error = const_cast<char*>(event.data.errorData().error.c_str());
+			evt.data.errorData.shortError = const_cast<char*>(event.data.errorData().shortError.c_str());
+			evt.data.errorData.data = event.data.errorData().data;
 
-			evt->data.relativeAddress.module = BNDebuggerAllocString(event.data.relativeAddress.module.c_str());
-			evt->data.relativeAddress.offset = event.data.relativeAddress.offset;
+			evt.data.exitData.exitCode = event.data.exitData().exitCode;
 
-			evt->data.absoluteAddress = event.data.absoluteAddress;
+			evt.data.relativeAddress.module = const_cast<char*>(event.data.relativeAddress().module.c_str());
+			evt.data.relativeAddress.offset = event.data.relativeAddress().offset;
 
-			evt->data.messageData.message = BNDebuggerAllocString(event.data.messageData.message.c_str());
+			evt.data.absoluteAddress = event.data.absoluteAddress();
 
-			callback(ctx, evt);
+			evt.data.messageData.message = const_cast<char*>(event.data.messageData().message.c_str());
 
-			BNDebuggerFreeString(evt->data.errorData.error);
-			BNDebuggerFreeString(evt->data.errorData.shortError);
-			BNDebuggerFreeString(evt->data.relativeAddress.module);
-			BNDebuggerFreeString(evt->data.messageData.message);
-			delete evt;
+			callback(ctx, &evt);
 		},
-		name);
+		name, delivery, eventMask);
 }
 
 
@@ -951,6 +1085,12 @@ void BNDebuggerRemoveEventCallback(BNDebuggerController* controller, size_t inde
 }
 
 
+void BNDebuggerFlushEventCallbacks(BNDebuggerController* controller)
+{
+	controller->object->FlushEventCallbacks();
+}
+
+
 uint32_t BNDebuggerGetExitCode(BNDebuggerController* controller)
 {
 	return controller->object->GetExitCode();
@@ -1026,27 +1166,49 @@ bool BNDebuggerIsTTD(BNDebuggerController* controller)
 
 void BNDebuggerPostDebuggerEvent(BNDebuggerController* controller, BNDebuggerEvent* event)
 {
+	// The C event carries every payload, while the core event holds only the one that matches its type
 	DebuggerEvent evt;
 	evt.type = event->type;
-	evt.data.targetStoppedData.reason = event->data.targetStoppedData.reason;
-	evt.data.targetStoppedData.exitCode = event->data.targetStoppedData.exitCode;
-	evt.data.targetStoppedData.lastActiveThread = event->data.targetStoppedData.lastActiveThread;
-	evt.data.targetStoppedData.data = event->data.targetStoppedData.data;
-
-	evt.data.errorData.error = event->data.errorData.error;
-	evt.data.errorData.shortError = event->data.errorData.shortError;
-	evt.data.errorData.data = event->data.errorData.data;
-
-	evt.data.exitData.exitCode = event->data.exitData.exitCode;
-
-	evt.data.relativeAddress.module = event->data.relativeAddress.module;
-	evt.data.relativeAddress.offset = event->data.relativeAddress.offset;
-
-	evt.data.absoluteAddress = event->data.absoluteAddress;
-
-	evt.data.messageData.message = event->data.messageData.message;
+	switch (event->type)
+	{
+	case TargetStoppedEventType:
+	case AdapterStoppedEventType:
+		evt.data.setTargetStoppedData().reason = event->data.targetStoppedData.reason;
+		evt.data.setTargetStoppedData().exitCode = event->data.targetStoppedData.exitCode;
+		evt.data.setTargetStoppedData().lastActiveThread = event->data.targetStoppedData.lastActiveThread;
+		evt.data.setTargetStoppedData().data = event->data.targetStoppedData.data;
+		break;
+	case ErrorEventType:
+	case LaunchFailureEventType:
+	case InvalidOperationEventType:
+	case InternalErrorEventType:
+		evt.data.setErrorData().error = event->data.errorData.error;
+		evt.data.setErrorData().shortError = event->data.errorData.shortError;
+		evt.data.setErrorData().data = event->data.errorData.data;
+		break;
+	case TargetExitedEventType:
+	case AdapterTargetExitedEventType:
+		evt.data.setExitData().exitCode = event->data.exitData.exitCode;
+		break;
+	case RelativeBreakpointAddedEvent:
+	case RelativeBreakpointRemovedEvent:
+		evt.data.setRelativeAddress().module = event->data.relativeAddress.module;
+		evt.data.setRelativeAddress().offset = event->data.relativeAddress.offset;
+		break;
+	case AbsoluteBreakpointAddedEvent:
+	case AbsoluteBreakpointRemovedEvent:
+	case ModuleLoadedEvent:
+		evt.data.setAbsoluteAddress() = event->data.absoluteAddress;
+		break;
+	case StdoutMessageEventType:
+	case BackendMessageEventType:
+		evt.data.setMessageData().message = event->data.messageData.message;
+		break;
+	default:
+		break;
+	}
 
-	controller->object->PostDebuggerEvent(evt);
+	controller->object->PostDebuggerEvent(std::move(evt));
 }
 
 
@@ -1068,6 +1230,345 @@ uint64_t BNDebuggerGetViewFileSegmentsStart(BNDebuggerController* controller)
 }
 
 
+bool BNDebuggerStartCoverage(BNDebuggerController* controller, const uint64_t* functions, size_t functionCount,
+	const char** modules, size_t moduleCount)
+{
+	std::vector<uint64_t> functionList;
+	functionList.reserve(functionCount);
+	for (size_t i = 0; i < functionCount; i++)
+		functionList.push_back(functions[i]);
+
+	std::vector<std::string> moduleList;
+	moduleList.reserve(moduleCount);
+	for (size_t i = 0; i < moduleCount; i++)
+		moduleList.emplace_back(modules[i]);
+
+	return controller->object->StartCoverage(functionList, moduleList);
+}
+
+
+void BNDebuggerStopCoverage(BNDebuggerController* controller)
+{
+	controller->object->StopCoverage();
+}
+
+
+bool BNDebuggerIsCoverageActive(BNDebuggerController* controller)
+{
+	return controller->object->GetCoverage()->IsActive();
+}
+
+
+uint64_t* BNDebuggerGetCoverageBlocks(BNDebuggerController* controller, bool coveredOnly, size_t* count)
+{
+	DebuggerCoverage* coverage = controller->object->GetCoverage();
+	std::vector<uint64_t> blocks = coveredOnly ? coverage->GetCoveredBlocks() : coverage->GetBlocks();
+	*count = blocks.size();
+	uint64_t* result = new uint64_t[blocks.size()];
+	std::copy(blocks.begin(), blocks.end(), result);
+	return result;
+}
+
+
+void BNDebuggerFreeCoverageBlocks(uint64_t* blocks)
+{
+	delete[] blocks;
+}
+
+
+BNDataBuffer* BNDebuggerGetCoverageBitmap(BNDebuggerController* controller)
+{
+	std::vector<uint8_t> bitmap = controller->object->GetCoverage()->GetBitmap();
+	DataBuffer* data = new DataBuffer(bitmap.data(), bitmap.size());
+	return data->GetBufferObject();
+}
+
+
+bool BNDebuggerExportCoverageDrcov(BNDebuggerController* controller, const char* path)
+{
+	return controller->object->GetCoverage()->ExportDrcov(path);
+}
+
+
+bool BNDebuggerAddTracepoint(BNDebuggerController* controller, uint64_t address, const char* format)
+{
+	return controller->object->AddTracepoint(address, format);
+}
+
+
+bool BNDebuggerRemoveTracepoint(BNDebuggerController* controller, uint64_t address)
+{
+	return controller->object->RemoveTracepoint(address);
+}
+
+
+BNDebugTracepoint* BNDebuggerGetTracepoints(BNDebuggerController* controller, size_t* count)
+{
+	std::vector<Tracepoint> tracepoints = controller->object->GetTracepoints();
+	*count = tracepoints.size();
+
+	BNDebugTracepoint* result = new BNDebugTracepoint[tracepoints.size()];
+	for (size_t i = 0; i < tracepoints.size(); i++)
+	{
+		result[i].address = tracepoints[i].m_address;
+		result[i].format = BNDebuggerAllocString(tracepoints[i].m_format.c_str());
+		result[i].hitCount = tracepoints[i].m_hitCount;
+	}
+	return result;
+}
+
+
+void BNDebuggerFreeTracepoints(BNDebugTracepoint* tracepoints, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		BNDebuggerFreeString(tracepoints[i].format);
+	}
+	delete[] tracepoints;
+}
+
+
+uint64_t BNDebuggerGetTracepointHitCount(BNDebuggerController* controller, uint64_t address)
+{
+	return controller->object->GetTracepointHitCount(address);
+}
+
+
+bool BNDebuggerSetTracepointOutputFile(BNDebuggerController* controller, const char* path)
+{
+	return controller->object->SetTracepointOutputFile(path);
+}
+
+
+char* BNDebuggerGetTracepointOutputFile(BNDebuggerController* controller)
+{
+	return BNDebuggerAllocString(controller->object->GetTracepointOutputFile().c_str());
+}
+
+
+BNDebugStopReason BNDebuggerTraceInstructions(BNDebuggerController* controller, uint64_t maxSteps,
+	uint64_t stopAddress, bool recordRegisters, bool recordMemory)
+{
+	InstructionTraceOptions options;
+	options.m_maxSteps = maxSteps;
+	options.m_stopAddress = stopAddress;
+	options.m_hasStopAddress = stopAddress != 0;
+	options.m_recordRegisters = recordRegisters;
+	options.m_recordMemory = recordMemory;
+	return controller->object->TraceInstructionsAndWait(options);
+}
+
+
+uint64_t* BNDebuggerGetInstructionTrace(BNDebuggerController* controller, size_t* count)
+{
+	std::vector<uint64_t> addresses = controller->object->GetInstructionTrace()->GetAddresses();
+	*count = addresses.size();
+	uint64_t* result = new uint64_t[addresses.size()];
+	std::copy(addresses.begin(), addresses.end(), result);
+	return result;
+}
+
+
+void BNDebuggerFreeInstructionTrace(uint64_t* addresses)
+{
+	delete[] addresses;
+}
+
+
+uint64_t BNDebuggerGetInstructionTraceDroppedCount(BNDebuggerController* controller)
+{
+	return controller->object->GetInstructionTrace()->GetDroppedRecordCount();
+}
+
+
+bool BNDebuggerExportInstructionTrace(BNDebuggerController* controller, const char* path)
+{
+	return controller->object->GetInstructionTrace()->Export(path);
+}
+
+
+bool BNDebuggerStartCallTrace(BNDebuggerController* controller, const char** modules, size_t moduleCount)
+{
+	std::vector<std::string> moduleList;
+	moduleList.reserve(moduleCount);
+	for (size_t i = 0; i < moduleCount; i++)
+		moduleList.emplace_back(modules[i]);
+
+	return controller->object->StartCallTrace(moduleList);
+}
+
+
+void BNDebuggerStopCallTrace(BNDebuggerController* controller)
+{
+	controller->object->StopCallTrace();
+}
+
+
+bool BNDebuggerIsCallTraceActive(BNDebuggerController* controller)
+{
+	return controller->object->GetCallTracer()->IsActive();
+}
+
+
+BNDebugCallTreeNode* BNDebuggerGetCallTree(BNDebuggerController* controller, size_t* count)
+{
+	std::vector<CallTreeNode> nodes = controller->object->GetCallTracer()->GetNodes();
+	*count = nodes.size();
+	BNDebugCallTreeNode* result = new BNDebugCallTreeNode[nodes.size()];
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		result[i].tid = nodes[i].m_tid;
+		result[i].function = nodes[i].m_function;
+		result[i].parent = nodes[i].m_parent;
+		result[i].count = nodes[i].m_count;
+		result[i].inclusiveCalls = nodes[i].m_inclusiveCalls;
+	}
+	return result;
+}
+
+
+void BNDebuggerFreeCallTree(BNDebugCallTreeNode* nodes)
+{
+	delete[] nodes;
+}
+
+
+bool BNDebuggerExportCallTrace(BNDebuggerController* controller, const char* path)
+{
+	return controller->object->GetCallTracer()->Export(path);
+}
+
+
+bool BNDebuggerStartSyscallTrace(BNDebuggerController* controller, const char** modules, size_t moduleCount)
+{
+	std::vector<std::string> moduleList;
+	moduleList.reserve(moduleCount);
+	for (size_t i = 0; i < moduleCount; i++)
+		moduleList.emplace_back(modules[i]);
+
+	return controller->object->StartSyscallTrace(moduleList);
+}
+
+
+void BNDebuggerStopSyscallTrace(BNDebuggerController* controller)
+{
+	controller->object->StopSyscallTrace();
+}
+
+
+bool BNDebuggerIsSyscallTraceActive(BNDebuggerController* controller)
+{
+	return controller->object->GetSyscallTrace()->IsActive();
+}
+
+
+BNDebugSyscallRecord* BNDebuggerGetSyscallTrace(BNDebuggerController* controller, size_t* count)
+{
+	DebuggerSyscallTrace* trace = controller->object->GetSyscallTrace();
+	std::vector<SyscallRecord> records = trace->GetRecords();
+	*count = records.size();
+
+	std::unordered_map<uint64_t, std::string> names;
+	BNDebugSyscallRecord* result = new BNDebugSyscallRecord[records.size()];
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		const auto& record = records[i];
+		auto it = names.find(record.m_number);
+		if (it == names.end())
+			it = names.emplace(record.m_number, trace->GetSyscallName(record.m_number)).first;
+
+		result[i].tid = record.m_tid;
+		result[i].address = record.m_address;
+		result[i].number = record.m_number;
+		result[i].name = BNDebuggerAllocString(it->second.c_str());
+		for (size_t j = 0; j < 6; j++)
+			result[i].args[j] = record.m_args[j];
+		result[i].result = record.m_result;
+		result[i].returned = record.m_returned;
+	}
+	return result;
+}
+
+
+void BNDebuggerFreeSyscallTrace(BNDebugSyscallRecord* records, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		BNDebuggerFreeString(records[i].name);
+	}
+	delete[] records;
+}
+
+
+uint64_t BNDebuggerGetSyscallTraceDroppedCount(BNDebuggerController* controller)
+{
+	return controller->object->GetSyscallTrace()->GetDroppedRecordCount();
+}
+
+
+bool BNDebuggerExportSyscallTrace(BNDebuggerController* controller, const char* path)
+{
+	return controller->object->GetSyscallTrace()->Export(path);
+}
+
+
+BNDebugStopReason BNDebuggerProfile(BNDebuggerController* controller, uint32_t sampleRate, uint64_t maxSamples,
+	uint64_t duration, size_t maxDepth)
+{
+	ProfilerOptions options;
+	options.m_sampleRate = sampleRate;
+	options.m_maxSamples = maxSamples;
+	options.m_duration = duration;
+	options.m_maxDepth = maxDepth;
+	return controller->object->ProfileAndWait(options);
+}
+
+
+uint64_t BNDebuggerGetProfilerSampleCount(BNDebuggerController* controller)
+{
+	return controller->object->GetProfiler()->GetSampleCount();
+}
+
+
+BNDebugProfilerFunctionHits* BNDebuggerGetProfilerFunctionHits(BNDebuggerController* controller, size_t* count)
+{
+	std::vector<ProfilerFunctionHits> hits = controller->object->GetProfiler()->GetFunctionHits();
+	*count = hits.size();
+
+	BNDebugProfilerFunctionHits* result = new BNDebugProfilerFunctionHits[hits.size()];
+	for (size_t i = 0; i < hits.size(); i++)
+	{
+		result[i].function = hits[i].m_function;
+		result[i].name = BNDebuggerAllocString(hits[i].m_name.c_str());
+		result[i].selfSamples = hits[i].m_selfSamples;
+		result[i].totalSamples = hits[i].m_totalSamples;
+	}
+	return result;
+}
+
+
+void BNDebuggerFreeProfilerFunctionHits(BNDebugProfilerFunctionHits* hits, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		BNDebuggerFreeString(hits[i].name);
+	}
+	delete[] hits;
+}
+
+
+bool BNDebuggerExportProfilerFoldedStacks(BNDebuggerController* controller, const char* path)
+{
+	return controller->object->GetProfiler()->ExportFoldedStacks(path);
+}
+
+
+void BNDebuggerAnnotateProfilerSamples(BNDebuggerController* controller)
+{
+	controller->object->GetProfiler()->AnnotateFunctions();
+}
+
+
 bool BNDebuggerComputeLLILExprValue(BNDebuggerController* controller, BNLowLevelILFunction* function, size_t expr,
 	uint64_t& value)
 {
@@ -1100,3 +1601,18 @@ bool BNDebuggerGetVariableValue(BNDebuggerController* controller, BNVariable* va
 {
 	return controller->object->GetVariableValue(*variable, address, size, value);
 }
+
+
+void BNDebuggerGetExprValueCacheStats(BNDebuggerController* controller, BNDebugExprValueCacheStats* stats)
+{
+	ExprValueCacheStats result = controller->object->GetExprValueCacheStats();
+	stats->hits = result.m_hits;
+	stats->misses = result.m_misses;
+	stats->entries = result.m_entries;
+}
+
+
+uint64_t BNDebuggerGetInterpretedInstructionCount(BNDebuggerController* controller)
+{
+	return controller->object->GetInterpretedInstructionCount();
+}
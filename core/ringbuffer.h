@@ -0,0 +1,86 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace BinaryNinjaDebugger {
+	// A fixed-size, lock-free, single-producer single-consumer queue. The producer is typically the adapter event
+	// thread, which must never block on the UI or the analysis. When the queue is full, new items are dropped and
+	// counted, rather than blocking the producer.
+	template <typename T>
+	class RingBuffer
+	{
+		std::vector<T> m_items;
+		size_t m_mask;
+		// m_head is only written by the producer, and m_tail only by the consumer. Both increase monotonically, and
+		// are wrapped with m_mask when indexing m_items.
+		std::atomic<size_t> m_head = 0;
+		std::atomic<size_t> m_tail = 0;
+		std::atomic<uint64_t> m_dropped = 0;
+
+		static size_t RoundUpToPowerOfTwo(size_t value)
+		{
+			size_t result = 1;
+			while (result < value)
+				result <<= 1;
+			return result;
+		}
+
+	public:
+		RingBuffer(size_t capacity) : m_items(RoundUpToPowerOfTwo(capacity)), m_mask(m_items.size() - 1) {}
+
+		size_t GetCapacity() const { return m_items.size(); }
+		uint64_t GetDroppedCount() const { return m_dropped; }
+
+		// Producer only. Returns false if the queue is full, in which case the item is dropped.
+		bool Push(T&& item)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head - m_tail.load(std::memory_order_acquire) >= m_items.size())
+			{
+				m_dropped++;
+				return false;
+			}
+
+			m_items[head & m_mask] = std::move(item);
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only. Moves up to maxCount items to the end of result, and returns the number of items moved.
+		size_t Drain(std::vector<T>& result, size_t maxCount = SIZE_MAX)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			size_t head = m_head.load(std::memory_order_acquire);
+			size_t count = std::min(head - tail, maxCount);
+			for (size_t i = 0; i < count; i++)
+				result.push_back(std::move(m_items[(tail + i) & m_mask]));
+
+			m_tail.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		bool IsEmpty() const
+		{
+			return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+		}
+	};
+};  // namespace BinaryNinjaDebugger
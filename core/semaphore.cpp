@@ -32,3 +32,13 @@ void Semaphore::Wait()
 		m_cv.wait(lock);
 	--m_count;
 }
+
+
+bool Semaphore::WaitFor(std::chrono::milliseconds timeout)
+{
+	std::unique_lock<decltype(m_mutex)> lock(m_mutex);
+	if (!m_cv.wait_for(lock, timeout, [this]() { return m_count != 0; }))
+		return false;
+	--m_count;
+	return true;
+}
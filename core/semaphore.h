@@ -16,6 +16,7 @@ limitations under the License.
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 
@@ -29,5 +30,7 @@ namespace BinaryNinjaDebugger {
 	public:
 		void Release();
 		void Wait();
+		// Returns false if the timeout elapses before the semaphore is released
+		bool WaitFor(std::chrono::milliseconds timeout);
 	};
 };  // namespace BinaryNinjaDebugger
@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+#
+# benchmarks for debugger
+#
+# Unlike the unit tests, these print their measurements rather than asserting on them, since the numbers depend heavily
+# on the machine and the debug adapter in use.
+
+import os
+import sys
+import time
+import platform
+import unittest
+
+from binaryninja import load, FunctionGraphType, LowLevelILInstruction
+try:
+    from debugger import DebuggerController, DebugStopReason
+except:
+    from binaryninja.debugger import DebuggerController, DebugStopReason
+
+from debugger_test import name_to_fpath
+
+
+def find_function(bv, name):
+    for symbol_name in [name, '_' + name]:
+        functions = bv.get_functions_by_name(symbol_name)
+        if functions:
+            return functions[0]
+    return None
+
+
+# The body of the inner loop of helloworld_loop, which is the backward branch target with the highest address in main
+def find_inner_loop(bv):
+    func = find_function(bv, 'main')
+    if func is None:
+        return None
+
+    targets = []
+    for block in func.basic_blocks:
+        for edge in block.outgoing_edges:
+            if edge.target.start < block.start:
+                targets.append(edge.target.start)
+
+    if not targets:
+        return None
+    return max(targets)
+
+
+class DebuggerBenchmark(unittest.TestCase):
+    # Always skip the base class so it will never be executed
+    @unittest.skip("do not run the base benchmark class")
+    def setUp(self) -> None:
+        self.arch = ''
+
+    def report(self, name, value, unit):
+        print(f'\n{self.arch} {name}: {value:.1f} {unit}')
+
+    def test_conditional_breakpoint_throughput(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        addr = find_inner_loop(dbg.data)
+        self.assertIsNotNone(addr)
+        dbg.add_breakpoint(addr)
+        # The condition never holds, so every hit is handled in the adapter and the target is resumed right away
+        self.assertTrue(dbg.set_breakpoint_condition(addr, f'${dbg.data.arch.stack_pointer} == 0'))
+
+        duration = 2.0
+        dbg.go()
+        time.sleep(duration)
+        dbg.pause_and_wait()
+
+        hits = dbg.get_breakpoint_hit_count(addr)
+        self.assertGreater(hits, 0)
+        self.report('conditional breakpoint hits', hits / duration, 'hits/s')
+        dbg.quit_and_wait()
+
+    def test_tracepoint_throughput(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        addr = find_inner_loop(dbg.data)
+        self.assertIsNotNone(addr)
+        sp = dbg.data.arch.stack_pointer
+        self.assertTrue(dbg.add_tracepoint(addr, f'{{{sp}}} {{[{sp}]}}'))
+        # Measure the cost of formatting and writing the records, without flooding the console
+        dbg.tracepoint_output_file = os.devnull
+
+        duration = 2.0
+        dbg.go()
+        time.sleep(duration)
+        dbg.pause_and_wait()
+
+        hits = dbg.get_tracepoint_hit_count(addr)
+        self.assertGreater(hits, 0)
+        self.report('logging tracepoint hits', hits / duration, 'hits/s')
+        dbg.quit_and_wait()
+
+    @unittest.skipIf(platform.system() == 'Windows', 'Instruction tracing is not supported on Windows')
+    def test_instruction_trace_throughput(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        addr = find_inner_loop(dbg.data)
+        self.assertIsNotNone(addr)
+        dbg.add_breakpoint(addr)
+        self.assertEqual(dbg.go_and_wait(), DebugStopReason.Breakpoint)
+        dbg.delete_breakpoint(addr)
+
+        # The baseline is the loop of single steps that the trace replaces
+        steps = 200
+        start = time.perf_counter()
+        for i in range(steps):
+            self.assertEqual(dbg.step_into_and_wait(), DebugStopReason.SingleStep)
+        elapsed = time.perf_counter() - start
+        self.report('step into loop', steps / elapsed, 'steps/s')
+
+        # The target is 100k steps/s on local Linux. Every step is still a round trip through the debug adapter, so
+        # the reported percentage shows how far the adapter is from it.
+        target = 100000
+        steps = 100000
+        start = time.perf_counter()
+        self.assertEqual(dbg.trace_instructions(steps), DebugStopReason.SingleStep)
+        elapsed = time.perf_counter() - start
+        self.assertEqual(len(dbg.instruction_trace), steps)
+        self.report('instruction trace', steps / elapsed, 'steps/s')
+        self.report('instruction trace, of the target rate', steps / elapsed * 100 / target, '%')
+
+        # Recording the registers reads the ones written by every instruction, and the memory the accessed bytes
+        steps = 10000
+        for name, registers, memory in [('registers', True, False), ('memory', False, True),
+                                        ('registers and memory', True, True)]:
+            start = time.perf_counter()
+            self.assertEqual(dbg.trace_instructions(steps, registers=registers, memory=memory),
+                             DebugStopReason.SingleStep)
+            elapsed = time.perf_counter() - start
+            self.report(f'instruction trace with {name}', steps / elapsed, 'steps/s')
+        dbg.quit_and_wait()
+
+    def test_event_callback_throughput(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+
+        # Every stdout message of the target is converted and delivered to each of these callbacks
+        callbacks = 50
+        counts = [0] * callbacks
+        def on_event(event, i):
+            counts[i] += 1
+
+        handles = []
+        for i in range(callbacks):
+            handles.append(dbg.register_event_callback(lambda event, i=i: on_event(event, i), 'benchmark'))
+
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        duration = 2.0
+        start = time.perf_counter()
+        dbg.go()
+        time.sleep(duration)
+        dbg.pause_and_wait()
+        elapsed = time.perf_counter() - start
+
+        self.assertGreater(sum(counts), 0)
+        self.report(f'event deliveries to {callbacks} callbacks', sum(counts) / elapsed, 'events/s')
+        dbg.quit_and_wait()
+        for handle in handles:
+            dbg.remove_event_callback(handle)
+
+    def test_hlil_step_latency(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        addr = find_inner_loop(dbg.data)
+        self.assertIsNotNone(addr)
+        dbg.add_breakpoint(addr)
+        self.assertEqual(dbg.go_and_wait(), DebugStopReason.Breakpoint)
+        dbg.delete_breakpoint(addr)
+
+        # The first step builds the cached HLIL instruction addresses of main, the later ones only look them up
+        steps = 50
+        start = time.perf_counter()
+        for i in range(steps):
+            self.assertEqual(dbg.step_over_and_wait(FunctionGraphType.HighLevelILFunctionGraph),
+                             DebugStopReason.SingleStep)
+        elapsed = time.perf_counter() - start
+
+        self.report('HLIL step over latency', elapsed / steps * 1000, 'ms/step')
+        dbg.quit_and_wait()
+
+    def test_expr_value_cache(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        self.assertEqual(dbg.step_into_and_wait(), DebugStopReason.SingleStep)
+
+        # Like the debugger info widget, compute every operand of every LLIL instruction of the largest function. The
+        # first pass computes the values, and the second one finds them in the cache.
+        func = max(dbg.data.functions, key=lambda f: len(f.llil.instructions) if f.llil is not None else 0)
+        operands = []
+        for instr in func.llil.instructions:
+            operands.extend(op for op in instr.operands if isinstance(op, LowLevelILInstruction))
+        self.assertGreater(len(operands), 0)
+
+        for name in ['cold', 'cached']:
+            start = time.perf_counter()
+            for op in operands:
+                dbg.compute_expr_value(op)
+            elapsed = time.perf_counter() - start
+            self.report(f'{name} expression values of {len(operands)} operands', elapsed * 1000, 'ms')
+
+        stats = dbg.expr_value_cache_stats
+        self.assertGreater(stats.hits, 0)
+        self.report('expression value cache hit rate', stats.hits * 100 / (stats.hits + stats.misses), '%')
+        dbg.quit_and_wait()
+
+
+@unittest.skipIf(platform.machine() not in ['arm64', 'aarch64'], "Only run arm64 benchmarks on arm Mac or Linux")
+class DebuggerArm64Benchmark(DebuggerBenchmark):
+    def setUp(self) -> None:
+        self.arch = 'arm64'
+
+
+@unittest.skipIf(platform.system() == 'Linux' and platform.machine() in ['arm64', 'aarch64'], 'x86 benchmarks not supported on arm64 macOS or Linux')
+class Debuggerx64Benchmark(DebuggerBenchmark):
+    def setUp(self) -> None:
+        self.arch = 'x86_64'
+
+
+def main():
+    runner = unittest.TextTestRunner(verbosity=2)
+    test_suite = unittest.defaultTestLoader.loadTestsFromModule(sys.modules[__name__])
+    runner.run(test_suite)
+
+
+if __name__ == "__main__":
+    main()
@@ -8,13 +8,16 @@ import time
 import platform
 import threading
 import subprocess
+import tempfile
 import unittest
 
-from binaryninja import load
+from binaryninja import load, FunctionGraphType, LowLevelILOperation, Settings
 try:
-    from debugger import DebuggerController, DebugStopReason
+    from debugger import DebuggerController, DebugStopReason, DebugWatchpointType, DebuggerEventType, \
+        DebuggerEventDelivery
 except:
-    from binaryninja.debugger import DebuggerController, DebugStopReason
+    from binaryninja.debugger import DebuggerController, DebugStopReason, DebugWatchpointType, DebuggerEventType, \
+        DebuggerEventDelivery
 
 # 'helloworld' -> '{BN_SOURCE_ROOT}\public\debugger\test\binaries\Windows-x64\helloworld.exe' (windows)
 # 'helloworld' -> '{BN_SOURCE_ROOT}/public/debugger/test/binaries/Darwin/arm64/helloworld' (linux, macOS)
@@ -54,6 +57,22 @@ def sleep_and_step_into(dbg):
     return dbg.step_into_and_wait()
 
 
+# The symbols in the macOS binaries have a leading underscore
+def find_function(bv, name):
+    return (bv.get_functions_by_name(name) or bv.get_functions_by_name('_' + name))[0]
+
+
+# The target of a backward branch in the function, the one with the highest address if it has several loops
+def find_loop_start(func):
+    return max(edge.target.start for block in func.basic_blocks for edge in block.outgoing_edges
+               if edge.target.start < block.start)
+
+
+# The first call from the caller to the callee
+def find_call_site(bv, caller, callee):
+    return min(site.address for site in caller.call_sites if callee.start in bv.get_callees(site.address))
+
+
 class DebuggerAPI(unittest.TestCase):
     # Always skip the base class so it will never be executed
     @unittest.skip("do not run the base test class")
@@ -109,6 +128,84 @@ class DebuggerAPI(unittest.TestCase):
             exit_code = dbg.exit_code
             self.assertIn(exit_code, expected)
 
+    def test_interpret_straight_line_code(self):
+        fpath = name_to_fpath('exitcode', self.arch)
+        bv = load(fpath)
+        settings = Settings()
+        for interpret in [True, False]:
+            settings.set_bool('debugger.interpretStraightLineCode', interpret)
+            dbg = DebuggerController(bv)
+            dbg.cmd_line = '123'
+            main = self.launch_to_function(dbg)
+
+            # Whether the prologue is interpreted or run on the target, the program must behave the same
+            block = dbg.data.get_basic_blocks_at(main.start)[0]
+            target = main.start
+            for i in range(3):
+                length = dbg.data.get_instruction_length(target)
+                if length == 0 or target + length >= block.end:
+                    break
+                target += length
+
+            if target != main.start:
+                count = dbg.interpreted_instruction_count
+                self.assertEqual(dbg.run_to_and_wait(target), DebugStopReason.Breakpoint)
+                self.assertEqual(dbg.ip, target)
+                if interpret:
+                    self.assertGreater(dbg.interpreted_instruction_count, count)
+                else:
+                    self.assertEqual(dbg.interpreted_instruction_count, count)
+
+            self.assertEqual(sleep_and_go(dbg), DebugStopReason.ProcessExited)
+            self.assertEqual(dbg.exit_code, 123)
+        settings.reset('debugger.interpretStraightLineCode')
+
+    def test_interpret_test_and_branch(self):
+        if self.arch != 'x86_64':
+            self.skipTest('The test relies on the x86_64 test instruction')
+
+        # main checks the result of strcmp with a test and a conditional branch
+        fpath = name_to_fpath('do_exception', self.arch)
+        bv = load(fpath)
+        settings = Settings()
+        settings.set_bool('debugger.interpretStraightLineCode', True)
+        dbg = DebuggerController(bv)
+        dbg.cmd_line = 'none'
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        main = find_function(dbg.data, 'main')
+        test_addr = None
+        for tokens, addr in main.instructions:
+            if tokens[0].text.strip() == 'test':
+                test_addr = addr
+                break
+        self.assertIsNotNone(test_addr)
+
+        self.break_and_go(dbg, test_addr)
+
+        block = dbg.data.get_basic_blocks_at(test_addr)[0]
+        targets = [edge.target.start for edge in block.outgoing_edges]
+        count = dbg.interpreted_instruction_count
+        self.assertEqual(dbg.run_to_and_wait(targets), DebugStopReason.Breakpoint)
+        self.assertIn(dbg.ip, targets)
+        self.assertGreater(dbg.interpreted_instruction_count, count)
+
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.ProcessExited)
+        self.assertEqual(dbg.exit_code, 0)
+        settings.reset('debugger.interpretStraightLineCode')
+
+    # Runs to a temporary breakpoint at the address
+    def break_and_go(self, dbg, address):
+        dbg.add_breakpoint(address)
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.Breakpoint)
+        dbg.delete_breakpoint(address)
+
+    # Launches the target and runs to the start of the function, which is returned
+    def launch_to_function(self, dbg, name='main'):
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        func = find_function(dbg.data, name)
+        self.break_and_go(dbg, func.start)
+        return func
+
     def expect_segfault(self, reason):
         if platform.system() == 'Linux':
             self.assertEqual(reason, DebugStopReason.SignalSegv)
@@ -127,6 +224,24 @@ class DebuggerAPI(unittest.TestCase):
         self.expect_segfault(reason)
         dbg.quit_and_wait()
 
+    @unittest.skipIf(platform.system() != 'Linux', 'Signal policies are only tested on Linux')
+    def test_signal_policies(self):
+        fpath = name_to_fpath('do_exception', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+
+        dbg.cmd_line = 'segfault'
+        dbg.signal_policies = 'segv=pass, SIGUSR1=ignore'
+        self.assertEqual(dbg.signal_policies, 'segv=pass, SIGUSR1=ignore')
+        # Invalid policies are rejected and the current ones are kept
+        dbg.signal_policies = 'SIGSEGV=deliver'
+        self.assertEqual(dbg.signal_policies, 'segv=pass, SIGUSR1=ignore')
+
+        # The signal is delivered to the target without stopping, which kills it
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.ProcessExited)
+        dbg.signal_policies = ''
+
     # # This would not work until we fix the test binary
     # def test_exception_illegalinstr(self):
     #     fpath = name_to_fpath('do_exception', self.arch)
@@ -174,6 +289,112 @@ class DebuggerAPI(unittest.TestCase):
         reason = sleep_and_go(dbg)
         self.assertEqual(reason, DebugStopReason.ProcessExited)
 
+    # Running to the next IL instruction must stop at the same places as single-stepping to it
+    def il_step_addresses(self, name, func_name, il, step_over, count, hits=1):
+        fpath = name_to_fpath(name, self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        func = find_function(dbg.data, func_name)
+        dbg.add_breakpoint(func.start)
+        for i in range(hits):
+            self.assertEqual(sleep_and_go(dbg), DebugStopReason.Breakpoint)
+        dbg.delete_breakpoint(func.start)
+
+        addresses = []
+        for i in range(count):
+            reason = dbg.step_over_and_wait(il) if step_over else dbg.step_into_and_wait(il)
+            self.assertEqual(reason, DebugStopReason.SingleStep)
+            addresses.append((dbg.ip, dbg.get_reg_value(dbg.data.arch.stack_pointer)))
+        dbg.quit_and_wait()
+        return addresses
+
+    def assert_il_step_using_breakpoints(self, name, func_name, il, step_over, count, hits=1):
+        settings = Settings()
+        try:
+            settings.set_bool('debugger.ilStepUsingBreakpoints', True)
+            with_breakpoints = self.il_step_addresses(name, func_name, il, step_over, count, hits)
+            settings.set_bool('debugger.ilStepUsingBreakpoints', False)
+            self.assertEqual(with_breakpoints, self.il_step_addresses(name, func_name, il, step_over, count, hits))
+        finally:
+            settings.reset('debugger.ilStepUsingBreakpoints')
+
+    def test_il_step_using_breakpoints(self):
+        for il in [FunctionGraphType.LowLevelILFunctionGraph, FunctionGraphType.HighLevelILFunctionGraph]:
+            self.assert_il_step_using_breakpoints('helloworld_loop', 'main', il, True, 8)
+            self.assert_il_step_using_breakpoints('helloworld_loop', 'main', il, False, 8)
+
+    def test_il_step_using_breakpoints_recursion(self):
+        # fib calls itself twice in the same HLIL instruction, so stepping over it must not stop in the nested frames.
+        # The stack pointer tells the frames apart.
+        for il in [FunctionGraphType.LowLevelILFunctionGraph, FunctionGraphType.HighLevelILFunctionGraph]:
+            self.assert_il_step_using_breakpoints('helloworld_recursion', 'fib', il, True, 8, 8)
+            self.assert_il_step_using_breakpoints('helloworld_recursion', 'fib', il, False, 8, 8)
+
+    def test_step_into_n(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+
+        # Stepping N instructions at once must end at the same place as N single steps
+        def step_from_main(step):
+            bv = load(fpath)
+            dbg = DebuggerController(bv)
+            self.launch_to_function(dbg)
+            step(dbg)
+            ip = dbg.ip
+            dbg.quit_and_wait()
+            return ip
+
+        def single_steps(dbg):
+            for i in range(20):
+                self.assertEqual(dbg.step_into_and_wait(), DebugStopReason.SingleStep)
+
+        self.assertEqual(step_from_main(lambda dbg: self.assertEqual(dbg.step_into_n_and_wait(20),
+                                                                     DebugStopReason.SingleStep)),
+                         step_from_main(single_steps))
+
+    def test_step_until(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        main = self.launch_to_function(dbg)
+
+        pc = 'rip' if self.arch == 'x86_64' else 'pc'
+        loop = find_loop_start(main)
+        self.assertEqual(dbg.step_until_and_wait(f'${pc} == {loop:#x}', 100000), DebugStopReason.SingleStep)
+        self.assertEqual(dbg.ip, loop)
+
+        # The condition never holds, so the stepping ends after max_steps instructions
+        self.assertEqual(dbg.step_until_and_wait('0', 10), DebugStopReason.SingleStep)
+        self.assertNotEqual(dbg.step_until_and_wait('$', 10), DebugStopReason.SingleStep)
+
+        dbg.quit_and_wait()
+
+    @unittest.skipIf(platform.system() == 'Windows', 'Instruction tracing is not supported on Windows')
+    def test_instruction_trace(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        main = self.launch_to_function(dbg)
+
+        start = dbg.ip
+        self.assertEqual(dbg.trace_instructions(100), DebugStopReason.SingleStep)
+        trace = dbg.instruction_trace
+        self.assertEqual(len(trace), 100)
+        self.assertEqual(trace[0], start)
+
+        loop = find_loop_start(main)
+        self.assertEqual(dbg.trace_instructions(100000, loop, True, True), DebugStopReason.SingleStep)
+        self.assertEqual(dbg.ip, loop)
+        self.assertNotIn(loop, dbg.instruction_trace)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'trace.bin')
+            self.assertTrue(dbg.export_instruction_trace(path))
+            with open(path, 'rb') as f:
+                self.assertEqual(f.read(8), b'BNDTRACE')
+
+        dbg.quit_and_wait()
+
     def test_breakpoint(self):
         fpath = name_to_fpath('helloworld', self.arch)
         bv = load(fpath)
@@ -216,11 +437,15 @@ class DebuggerAPI(unittest.TestCase):
         self.assertEqual(dbg.get_reg_value(xax), testval_a)
         dbg.set_reg_value(xbx, testval_b)
         self.assertEqual(dbg.get_reg_value(xbx), testval_b)
+        # Only the changed registers are sent to the expression parser, so check that both are up to date
+        self.assertEqual(dbg.data.parse_expression(f'${xax}'), testval_a)
+        self.assertEqual(dbg.data.parse_expression(f'${xbx}'), testval_b)
 
         dbg.set_reg_value(xax, rax)
         self.assertEqual(dbg.get_reg_value(xax), rax)
         dbg.set_reg_value(xbx, rbx)
         self.assertEqual(dbg.get_reg_value(xbx), rbx)
+        self.assertEqual(dbg.data.parse_expression(f'${xax}'), rax)
 
         dbg.quit_and_wait()
 
@@ -244,6 +469,32 @@ class DebuggerAPI(unittest.TestCase):
 
         dbg.quit_and_wait()
 
+    def test_instruction_length(self):
+        fpath = name_to_fpath('helloworld', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        arch = dbg.data.arch
+        ip = dbg.ip
+        info = arch.get_instruction_info(dbg.read_memory(ip, arch.max_instr_length), ip)
+        self.assertEqual(dbg.get_instruction_length(ip), info.length)
+        # The cached instruction is used
+        self.assertEqual(dbg.get_instruction_length(ip), info.length)
+
+        if self.arch == 'x86_64':
+            # Writing the memory drops the cached instruction
+            addr = ip + 10
+            data = dbg.read_memory(addr, 3)
+            dbg.write_memory(addr, b'\x90\x90\x90')
+            self.assertEqual(dbg.get_instruction_length(addr), 1)
+            # mov rbp, rsp
+            dbg.write_memory(addr, b'\x48\x89\xe5')
+            self.assertEqual(dbg.get_instruction_length(addr), 3)
+            dbg.write_memory(addr, data)
+
+        dbg.quit_and_wait()
+
     # @unittest.skip
     def test_thread(self):
         fpath = name_to_fpath('helloworld_thread', self.arch)
@@ -269,6 +520,27 @@ class DebuggerAPI(unittest.TestCase):
         self.assertGreater(len(threads), 1)
         dbg.quit_and_wait()
 
+    def test_stop_stages(self):
+        fpath = name_to_fpath('helloworld_thread', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        dbg.go()
+        time.sleep(1)
+        dbg.pause_and_wait()
+
+        # The threads, frames and modules are read on another thread after the stop is reported, or right away when
+        # they are asked for first, so they must be up to date once the wait returns
+        for i in range(3):
+            self.assertEqual(dbg.step_into_and_wait(), DebugStopReason.SingleStep)
+            self.assertGreater(len(dbg.threads), 1)
+            self.assertGreater(len(dbg.frames_of_thread(dbg.active_thread.tid)), 0)
+            self.assertGreater(len(dbg.modules), 0)
+            sp = dbg.data.arch.stack_pointer
+            self.assertEqual(dbg.data.parse_expression(f'${sp}'), dbg.stack_pointer)
+        dbg.quit_and_wait()
+
     @unittest.skipIf(platform.system() == 'Windows', 'Skip restart test on Windows for now')
     def test_restart(self):
         fpath = name_to_fpath('helloworld_thread', self.arch)
@@ -321,6 +593,454 @@ class DebuggerAPI(unittest.TestCase):
             reason = sleep_and_go(dbg)
             self.assertEqual(reason, DebugStopReason.ProcessExited)
 
+    @unittest.skipIf(platform.system() == 'Windows', 'Coverage is only supported by the LLDB adapter')
+    def test_coverage(self):
+        fpath = name_to_fpath('many_stdlib_calls', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        functions = [func.start for func in dbg.data.functions]
+        self.assertTrue(dbg.start_coverage(functions))
+        self.assertTrue(dbg.coverage_active)
+        blocks = dbg.coverage_blocks
+        self.assertGreater(len(blocks), 0)
+
+        # Every block costs at most one stop, so this must finish quickly
+        start = time.time()
+        reason = sleep_and_go(dbg)
+        self.assertEqual(reason, DebugStopReason.ProcessExited)
+        self.assertLess(time.time() - start, 10)
+
+        covered = dbg.covered_blocks
+        self.assertGreater(len(covered), 0)
+        self.assertTrue(set(covered).issubset(set(blocks)))
+        self.assertEqual(len(dbg.coverage_bitmap), (len(blocks) + 7) // 8)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'coverage.drcov')
+            self.assertTrue(dbg.export_coverage_drcov(path))
+            with open(path, 'rb') as f:
+                self.assertTrue(f.read().startswith(b'DRCOV VERSION: 2'))
+
+    def test_coverage_during_step_over(self):
+        fpath = name_to_fpath('helloworld_func', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        main = find_function(dbg.data, 'main')
+        hello = find_function(dbg.data, 'hello')
+        call = find_call_site(dbg.data, main, hello)
+        self.break_and_go(dbg, call)
+
+        # The coverage breakpoints in the callee are consumed without ending the step over the call
+        self.assertTrue(dbg.start_coverage([hello.start]))
+        self.assertEqual(dbg.step_over_and_wait(), DebugStopReason.SingleStep)
+        self.assertEqual(dbg.ip, call + dbg.data.get_instruction_length(call))
+        self.assertIn(hello.start, dbg.covered_blocks)
+
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.ProcessExited)
+
+    def test_call_trace(self):
+        fpath = name_to_fpath('many_stdlib_calls', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        self.assertTrue(dbg.start_call_trace())
+        self.assertTrue(dbg.call_trace_active)
+
+        start = time.time()
+        reason = sleep_and_go(dbg)
+        self.assertEqual(reason, DebugStopReason.ProcessExited)
+        self.assertLess(time.time() - start, 10)
+
+        nodes = dbg.call_tree
+        self.assertGreater(len(nodes), 0)
+        main = find_function(dbg.data, 'main')
+        main_nodes = [node for node in nodes if node.function == main.start]
+        self.assertEqual(sum(node.count for node in main_nodes), 1)
+        for node in nodes:
+            self.assertGreaterEqual(node.inclusive_calls, node.count)
+            if node.parent is not None:
+                self.assertLess(node.parent, len(nodes))
+                self.assertEqual(nodes[node.parent].tid, node.tid)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'calls.bndcalls')
+            self.assertTrue(dbg.export_call_trace(path))
+            with open(path, 'rb') as f:
+                data = f.read()
+                self.assertTrue(data.startswith(b'BNDCALLS'))
+                self.assertEqual(len(data), 24 + 32 * len(nodes))
+
+    @unittest.skipIf(platform.system() != 'Linux', 'Syscall tracing is only supported on Linux')
+    def test_syscall_trace(self):
+        if self.arch != 'x86_64':
+            self.skipTest('Only the x86_64 hello makes the syscalls directly')
+
+        # hello makes the write and exit syscalls directly
+        fpath = name_to_fpath('hello', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        self.assertTrue(dbg.start_syscall_trace())
+        self.assertTrue(dbg.syscall_trace_active)
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.ProcessExited)
+        self.assertFalse(dbg.syscall_trace_active)
+
+        records = dbg.syscall_trace
+        self.assertEqual([record.number for record in records], [1, 60])
+        write = records[0]
+        self.assertEqual(write.args[0], 1)
+        self.assertEqual(write.result, write.args[2])
+        # exit never returns
+        self.assertIsNone(records[1].result)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'syscalls.txt')
+            self.assertTrue(dbg.export_syscall_trace(path))
+            with open(path, 'r') as f:
+                lines = f.read().splitlines()
+            self.assertEqual(len(lines), 2)
+            self.assertTrue(lines[1].endswith(' = ?'))
+
+    @unittest.skipIf(platform.system() != 'Linux', 'Syscall tracing is only supported on Linux')
+    def test_syscall_trace_shared_libraries(self):
+        # The syscall numbers of write and exit_group
+        numbers = {'x86_64': (1, 231), 'arm64': (64, 94)}
+        if self.arch not in numbers:
+            self.skipTest('The shared libraries are only searched on x86_64 and aarch64')
+
+        # helloworld makes its syscalls through libc
+        fpath = name_to_fpath('helloworld', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        self.assertTrue(dbg.start_syscall_trace())
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.ProcessExited)
+
+        write_number, exit_number = numbers[self.arch]
+        records = dbg.syscall_trace
+        writes = [record for record in records if record.number == write_number]
+        self.assertGreater(len(writes), 0)
+        self.assertEqual(writes[0].result, writes[0].args[2])
+        self.assertFalse(bv.start <= writes[0].address < bv.end)
+        self.assertEqual(records[-1].number, exit_number)
+
+    def test_event_delivery(self):
+        fpath = name_to_fpath('helloworld', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+
+        events = {delivery: [] for delivery in [DebuggerEventDelivery.SynchronousEventDelivery,
+                                                DebuggerEventDelivery.QueuedEventDelivery,
+                                                DebuggerEventDelivery.CoalescedEventDelivery]}
+        def on_event(event, received):
+            received.append(event.type)
+            # Hold up the dispatcher thread, so that the later settings changes pile up and get merged
+            if received is events[DebuggerEventDelivery.QueuedEventDelivery] and \
+                    event.type == DebuggerEventType.DebuggerSettingsChangedEvent:
+                time.sleep(0.5)
+
+        handles = []
+        for delivery, received in events.items():
+            handles.append(dbg.register_event_callback(lambda event, received=received: on_event(event, received),
+                                                       'test', delivery))
+
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        for i in range(3):
+            dbg.cmd_line = ''
+        dbg.quit_and_wait()
+        dbg.flush_event_callbacks()
+
+        synchronous = events[DebuggerEventDelivery.SynchronousEventDelivery]
+        # The queued callbacks get the same events in the same order
+        self.assertEqual(events[DebuggerEventDelivery.QueuedEventDelivery], synchronous)
+        self.assertIn(DebuggerEventType.TargetStoppedEventType, synchronous)
+        self.assertEqual(synchronous.count(DebuggerEventType.DebuggerSettingsChangedEvent), 3)
+        # The repeated settings changes are merged for the coalesced callbacks
+        coalesced = events[DebuggerEventDelivery.CoalescedEventDelivery]
+        self.assertIn(DebuggerEventType.TargetStoppedEventType, coalesced)
+        self.assertLess(coalesced.count(DebuggerEventType.DebuggerSettingsChangedEvent), 3)
+
+        for handle in handles:
+            dbg.remove_event_callback(handle)
+
+    def test_command_queue(self):
+        fpath = name_to_fpath('helloworld', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        # The steps issued while the target is busy are queued rather than dropped
+        ip = dbg.ip
+        for i in range(10):
+            self.assertTrue(dbg.step_into())
+        # This runs after the queued steps, and may be merged into them
+        self.assertEqual(dbg.step_into_and_wait(), DebugStopReason.SingleStep)
+        self.assertEqual(dbg.pending_command_count, 0)
+        self.assertNotEqual(dbg.ip, ip)
+
+        self.assertEqual(dbg.cancel_pending_commands(), 0)
+        dbg.quit_and_wait()
+
+    def test_operation_timeout(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        # The target loops forever, so only the timeout ends the wait
+        dbg.operation_timeout = 1.0
+        self.assertAlmostEqual(dbg.operation_timeout, 1.0)
+        start = time.perf_counter()
+        self.assertEqual(dbg.go_and_wait(), DebugStopReason.OperationTimedOut)
+        self.assertLess(time.perf_counter() - start, 10)
+        self.assertFalse(dbg.running)
+
+        # A cancelled operation returns right away as well
+        dbg.operation_timeout = 0
+        threading.Timer(0.5, dbg.cancel_operation).start()
+        self.assertEqual(dbg.go_and_wait(), DebugStopReason.UserRequestedBreak)
+        dbg.quit_and_wait()
+
+    def test_event_mask(self):
+        fpath = name_to_fpath('helloworld', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+
+        received = []
+        handle = dbg.register_event_callback(lambda event: received.append(event.type), 'test',
+                                             event_types=[DebuggerEventType.TargetStoppedEventType,
+                                                          DebuggerEventType.TargetExitedEventType])
+
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        dbg.quit_and_wait()
+
+        self.assertIn(DebuggerEventType.TargetStoppedEventType, received)
+        for event_type in received:
+            self.assertIn(event_type, [DebuggerEventType.TargetStoppedEventType,
+                                       DebuggerEventType.TargetExitedEventType])
+        dbg.remove_event_callback(handle)
+
+    def test_profile(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        reason = dbg.profile(sample_rate=100, duration=1, max_samples=50)
+        self.assertNotIn(reason, [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+        self.assertGreater(dbg.profiler_sample_count, 0)
+        self.assertLessEqual(dbg.profiler_sample_count, 50)
+
+        main = find_function(dbg.data, 'main')
+        hits = dbg.profiler_function_hits
+        self.assertIn(main.start, [entry.function for entry in hits])
+        for entry in hits:
+            self.assertLessEqual(entry.self_samples, entry.total_samples)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'profile.folded')
+            self.assertTrue(dbg.export_profile(path))
+            with open(path, 'r') as f:
+                lines = f.read().splitlines()
+            self.assertGreater(len(lines), 0)
+            self.assertTrue(all(line.rsplit(' ', 1)[1].isdigit() for line in lines))
+
+        dbg.quit_and_wait()
+
+    def test_expr_value_cache(self):
+        fpath = name_to_fpath('helloworld', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        # Any use of the stack pointer in main
+        sp = dbg.data.arch.stack_pointer
+        main = find_function(dbg.data, 'main')
+        uses = []
+        for instr in main.llil.instructions:
+            uses.extend(instr.traverse(lambda expr: expr if expr.operation == LowLevelILOperation.LLIL_REG
+                                       and expr.src.name == sp else None))
+        self.assertGreater(len(uses), 0)
+        expr = uses[0]
+
+        self.assertEqual(dbg.compute_expr_value(expr), dbg.stack_pointer)
+        stats = dbg.expr_value_cache_stats
+        self.assertEqual(dbg.compute_expr_value(expr), dbg.stack_pointer)
+        self.assertEqual(dbg.expr_value_cache_stats.hits, stats.hits + 1)
+
+        # The cached values are dropped once the target runs
+        self.assertEqual(dbg.step_into_and_wait(), DebugStopReason.SingleStep)
+        stats = dbg.expr_value_cache_stats
+        self.assertEqual(dbg.compute_expr_value(expr), dbg.stack_pointer)
+        self.assertEqual(dbg.expr_value_cache_stats.misses, stats.misses + 1)
+        dbg.quit_and_wait()
+
+    @unittest.skipIf(platform.system() == 'Windows', 'Breakpoint conditions are not supported on Windows')
+    def test_breakpoint_condition(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        # The body of the inner loop is the backward branch target with the highest address in main
+        main = find_function(dbg.data, 'main')
+        addr = find_loop_start(main)
+        dbg.add_breakpoint(addr)
+        self.assertFalse(dbg.set_breakpoint_condition(addr, '$sp +'))
+        # Too deeply nested to be evaluated safely
+        self.assertFalse(dbg.set_breakpoint_condition(addr, '(' * 10000 + '0' + ')' * 10000))
+        self.assertFalse(dbg.set_breakpoint_condition(addr, '+'.join(['1'] * 10000)))
+        self.assertTrue(dbg.set_breakpoint_condition(addr, '0'))
+        self.assertEqual(dbg.get_breakpoint_condition(addr), '0')
+
+        # The condition never holds, so the target only stops when it is paused
+        dbg.go()
+        time.sleep(1)
+        dbg.pause_and_wait()
+        self.assertNotEqual(dbg.stop_reason, DebugStopReason.Breakpoint)
+        self.assertGreater(dbg.get_breakpoint_hit_count(addr), 0)
+
+        self.assertTrue(dbg.set_breakpoint_condition(addr, f'${dbg.data.arch.stack_pointer} != 0'))
+        reason = sleep_and_go(dbg)
+        self.assertEqual(reason, DebugStopReason.Breakpoint)
+        self.assertEqual(dbg.ip, addr)
+
+        dbg.delete_breakpoint(addr)
+        self.assertEqual(dbg.get_breakpoint_condition(addr), '')
+        dbg.quit_and_wait()
+
+    @unittest.skipIf(platform.system() != 'Linux', 'The frame layout of helloworld_loop is only known on Linux')
+    def test_watchpoint(self):
+        if self.arch != 'x86_64':
+            self.skipTest('The test relies on the x86_64 frame layout')
+
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        main = find_function(dbg.data, 'main')
+        addr = find_loop_start(main)
+        self.break_and_go(dbg, addr)
+
+        # The inner loop counter j is at rbp - 8, and it is incremented in every iteration
+        counter = dbg.get_reg_value('rbp') - 8
+        self.assertFalse(dbg.add_watchpoint(counter, 3))
+        self.assertTrue(dbg.add_watchpoint(counter, 4, DebugWatchpointType.WriteWatchpoint))
+        self.assertTrue(dbg.has_watchpoint(counter))
+        self.assertEqual(len(dbg.watchpoints), 1)
+
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.Watchpoint)
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.Watchpoint)
+
+        self.assertTrue(dbg.remove_watchpoint(counter))
+        self.assertFalse(dbg.has_watchpoint(counter))
+        dbg.quit_and_wait()
+
+    @unittest.skipIf(platform.system() != 'Linux', 'Software watchpoints are only supported on Linux')
+    def test_software_watchpoint(self):
+        if self.arch != 'x86_64':
+            self.skipTest('The test relies on the x86_64 frame layout')
+
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        main = find_function(dbg.data, 'main')
+        addr = find_loop_start(main)
+        self.break_and_go(dbg, addr)
+
+        # More watchpoints than there are debug registers, on the stack page of the loop counters. The ranges that a
+        # debug register cannot watch use page protection, and the aligned counter gets a hardware watchpoint.
+        counter = dbg.get_reg_value('rbp') - 8
+        for i in range(1, 8):
+            self.assertTrue(dbg.add_watchpoint(counter - 0x10 * i, 3, DebugWatchpointType.WriteWatchpoint, True))
+        self.assertTrue(dbg.add_watchpoint(counter, 4, DebugWatchpointType.WriteWatchpoint, True))
+        self.assertEqual(len(dbg.watchpoints), 8)
+        self.assertEqual(sorted(watchpoint.software for watchpoint in dbg.watchpoints), [False] + [True] * 7)
+
+        # The other accesses to the stack page are stepped over silently
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.Watchpoint)
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.Watchpoint)
+
+        # The software watchpoints can be removed while the target is running
+        self.assertTrue(dbg.remove_watchpoint(counter))
+        dbg.go()
+        time.sleep(0.5)
+        for i in range(1, 8):
+            self.assertTrue(dbg.remove_watchpoint(counter - 0x10 * i))
+        self.assertEqual(len(dbg.watchpoints), 0)
+        time.sleep(0.5)
+        dbg.pause_and_wait()
+        self.assertNotEqual(dbg.stop_reason, DebugStopReason.Watchpoint)
+        dbg.quit_and_wait()
+
+    @unittest.skipIf(platform.system() == 'Windows', 'Tracepoints are not supported on Windows')
+    def test_tracepoint_during_step_over(self):
+        fpath = name_to_fpath('helloworld_func', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        main = find_function(dbg.data, 'main')
+        hello = find_function(dbg.data, 'hello')
+        call = find_call_site(dbg.data, main, hello)
+        self.break_and_go(dbg, call)
+
+        # The step over the call logs the tracepoint in the callee, and still ends after the call
+        self.assertTrue(dbg.add_tracepoint(hello.start))
+        self.assertEqual(dbg.step_over_and_wait(), DebugStopReason.SingleStep)
+        self.assertEqual(dbg.ip, call + dbg.data.get_instruction_length(call))
+        self.assertEqual(dbg.get_tracepoint_hit_count(hello.start), 1)
+
+        self.assertEqual(sleep_and_go(dbg), DebugStopReason.ProcessExited)
+
+    @unittest.skipIf(platform.system() == 'Windows', 'Tracepoints are not supported on Windows')
+    def test_tracepoint(self):
+        fpath = name_to_fpath('helloworld_loop', self.arch)
+        bv = load(fpath)
+        dbg = DebuggerController(bv)
+        self.assertNotIn(dbg.launch_and_wait(), [DebugStopReason.ProcessExited, DebugStopReason.InternalError])
+
+        main = find_function(dbg.data, 'main')
+        addr = find_loop_start(main)
+        sp = dbg.data.arch.stack_pointer
+        self.assertFalse(dbg.add_tracepoint(addr, '{' + sp))
+        self.assertTrue(dbg.add_tracepoint(addr, f'sp={{{sp}}} [sp]={{[{sp}].d:d}}'))
+        self.assertEqual(len(dbg.tracepoints), 1)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'tracepoints.log')
+            dbg.tracepoint_output_file = path
+            self.assertEqual(dbg.tracepoint_output_file, path)
+
+            # The tracepoint never stops the target
+            dbg.go()
+            time.sleep(1)
+            dbg.pause_and_wait()
+            self.assertNotEqual(dbg.stop_reason, DebugStopReason.Breakpoint)
+
+            hits = dbg.get_tracepoint_hit_count(addr)
+            self.assertGreater(hits, 0)
+            with open(path, 'r') as f:
+                lines = f.readlines()
+            self.assertGreater(len(lines), 0)
+            self.assertIn(f'tracepoint {addr:#x}', lines[0])
+            self.assertIn('sp=0x', lines[0])
+
+            self.assertTrue(dbg.remove_tracepoint(addr))
+            self.assertEqual(len(dbg.tracepoints), 0)
+            dbg.tracepoint_output_file = ''
+        dbg.quit_and_wait()
+
     @unittest.skipIf(platform.system() == 'Linux', 'Cannot attach to pid unless running as root')
     def test_attach(self):
         pid = None
@@ -17,6 +17,7 @@ limitations under the License.
 #include "adaptersettings.h"
 #include "uicontext.h"
 #include "qfiledialog.h"
+#include <QMessageBox>
 
 using namespace BinaryNinjaDebuggerAPI;
 using namespace BinaryNinja;
@@ -53,6 +54,8 @@ AdapterSettingsDialog::AdapterSettingsDialog(QWidget* parent, DbgRef<DebuggerCon
 	m_pathEntry = new QLineEdit(this);
 	m_pathEntry->setMinimumWidth(800);
 	m_argumentsEntry = new QLineEdit(this);
+	m_signalPoliciesEntry = new QLineEdit(this);
+	m_signalPoliciesEntry->setPlaceholderText("SIGUSR1=pass SIGPROF=ignore");
 	m_workingDirectoryEntry = new QLineEdit(this);
 	m_terminalEmulator = new QCheckBox(this);
 
@@ -105,6 +108,8 @@ AdapterSettingsDialog::AdapterSettingsDialog(QWidget* parent, DbgRef<DebuggerCon
 	contentLayout->addLayout(workingDirLayout);
 	contentLayout->addWidget(new QLabel("Command Line Arguments"));
 	contentLayout->addWidget(m_argumentsEntry);
+	contentLayout->addWidget(new QLabel("Signal Policies"));
+	contentLayout->addWidget(m_signalPoliciesEntry);
 	contentLayout->addWidget(new QLabel("Run In Separate Terminal"));
 	contentLayout->addWidget(m_terminalEmulator);
 
@@ -131,6 +136,7 @@ AdapterSettingsDialog::AdapterSettingsDialog(QWidget* parent, DbgRef<DebuggerCon
 	m_pathEntry->setText(QString::fromStdString(m_controller->GetExecutablePath()));
 	m_terminalEmulator->setChecked(m_controller->GetRequestTerminalEmulator());
 	m_argumentsEntry->setText(QString::fromStdString(m_controller->GetCommandLineArguments()));
+	m_signalPoliciesEntry->setText(QString::fromStdString(m_controller->GetSignalPolicies()));
 	m_workingDirectoryEntry->setText(QString::fromStdString(m_controller->GetWorkingDirectory()));
 
 	selectAdapter(m_adapterEntry->currentText());
@@ -161,6 +167,15 @@ void AdapterSettingsDialog::selectAdapter(const QString& adapter)
 
 void AdapterSettingsDialog::apply()
 {
+	// Validate the signal policies first, so that nothing is changed if they are invalid
+	std::string signalPolicies = m_signalPoliciesEntry->text().toStdString();
+	if (!m_controller->SetSignalPolicies(signalPolicies))
+	{
+		QMessageBox::warning(this, "Signal Policies",
+			"Invalid signal policies. Each one should be in the form of NAME=stop|pass|ignore.");
+		return;
+	}
+
 	std::string selectedAdapter = m_adapterEntry->currentText().toStdString();
 	auto adapterType = DebugAdapterType::GetByName(selectedAdapter);
 	if (adapterType == nullptr)
@@ -170,6 +185,9 @@ void AdapterSettingsDialog::apply()
 	Ref<Metadata> data = new Metadata(selectedAdapter);
 	m_controller->GetData()->StoreMetadata("debugger.adapter_type", data);
 
+	data = new Metadata(signalPolicies);
+	m_controller->GetData()->StoreMetadata("debugger.signal_policies", data);
+
 	// We need better support for shell-style cmd arguments
 	std::string args = m_argumentsEntry->text().toStdString();
 	m_controller->SetCommandLineArguments(args);
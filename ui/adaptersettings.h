@@ -41,6 +41,7 @@ private:
 	QLineEdit* m_pathEntry;
 	QLineEdit* m_workingDirectoryEntry;
 	QLineEdit* m_argumentsEntry;
+	QLineEdit* m_signalPoliciesEntry;
 	QCheckBox* m_terminalEmulator;
 
 public:
@@ -0,0 +1,138 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "calltreedialog.h"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QVBoxLayout>
+#include <cinttypes>
+#include <map>
+
+
+using namespace BinaryNinjaDebuggerAPI;
+using namespace BinaryNinja;
+using namespace std;
+
+
+CallTreeDialog::CallTreeDialog(QWidget* parent, DbgRef<DebuggerController> controller) :
+	QDialog(parent), m_controller(controller)
+{
+	setWindowTitle("Call Tree");
+	setMinimumSize(UIContext::getScaledWindowSize(600, 500));
+	setSizeGripEnabled(true);
+
+	m_tree = new QTreeWidget(this);
+	m_tree->setHeaderLabels({"Function", "Address", "Calls", "Inclusive Calls"});
+	m_tree->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+	m_tree->setUniformRowHeights(true);
+
+	QVBoxLayout* layout = new QVBoxLayout();
+	layout->addWidget(m_tree, 1);
+
+	QHBoxLayout* buttonLayout = new QHBoxLayout();
+	buttonLayout->setContentsMargins(0, 0, 0, 0);
+
+	QPushButton* refreshButton = new QPushButton("Refresh");
+	connect(refreshButton, &QPushButton::clicked, [&]() { refresh(); });
+
+	QPushButton* exportButton = new QPushButton("Export...");
+	connect(exportButton, &QPushButton::clicked, [&]() { exportCallTrace(); });
+
+	QPushButton* closeButton = new QPushButton("Close");
+	connect(closeButton, &QPushButton::clicked, [&]() { accept(); });
+	closeButton->setDefault(true);
+
+	buttonLayout->addWidget(refreshButton);
+	buttonLayout->addWidget(exportButton);
+	buttonLayout->addStretch(1);
+	buttonLayout->addWidget(closeButton);
+
+	layout->addSpacing(10);
+	layout->addLayout(buttonLayout);
+	setLayout(layout);
+
+	refresh();
+}
+
+
+QString CallTreeDialog::functionName(uint64_t address)
+{
+	BinaryViewRef data = m_controller->GetData();
+	if (data)
+	{
+		if (auto sym = data->GetSymbolByAddress(address))
+			return QString::fromStdString(sym->GetShortName());
+	}
+
+	return QString::asprintf("sub_%" PRIx64, address);
+}
+
+
+void CallTreeDialog::refresh()
+{
+	m_tree->clear();
+
+	std::vector<DebugCallTreeNode> nodes = m_controller->GetCallTree();
+	std::map<uint32_t, QTreeWidgetItem*> threadItems;
+	std::vector<QTreeWidgetItem*> items(nodes.size(), nullptr);
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		const auto& node = nodes[i];
+		QTreeWidgetItem* parent = nullptr;
+		// A caller is always added before its callees
+		if ((node.parent != DebugCallTreeNode::InvalidIndex) && (node.parent < i))
+			parent = items[node.parent];
+
+		if (!parent)
+		{
+			auto it = threadItems.find(node.tid);
+			if (it == threadItems.end())
+			{
+				parent = new QTreeWidgetItem(m_tree, {QString::asprintf("Thread 0x%x", node.tid)});
+				threadItems[node.tid] = parent;
+			}
+			else
+			{
+				parent = it->second;
+			}
+		}
+
+		QTreeWidgetItem* item = new QTreeWidgetItem(parent);
+		item->setText(FunctionColumn, functionName(node.function));
+		item->setText(AddressColumn, QString::asprintf("0x%" PRIx64, node.function));
+		item->setText(CallsColumn, QString::number(node.count));
+		item->setText(InclusiveCallsColumn, QString::number(node.inclusiveCalls));
+		item->setTextAlignment(CallsColumn, Qt::AlignRight);
+		item->setTextAlignment(InclusiveCallsColumn, Qt::AlignRight);
+		items[i] = item;
+	}
+
+	for (auto& [tid, item] : threadItems)
+		item->setExpanded(true);
+}
+
+
+void CallTreeDialog::exportCallTrace()
+{
+	QString path = QFileDialog::getSaveFileName(this, "Export Call Trace", QString(), "Call traces (*.bndcalls)");
+	if (path.isEmpty())
+		return;
+
+	if (!m_controller->ExportCallTrace(path.toStdString()))
+		QMessageBox::warning(this, "Export Call Trace", "Failed to export the call trace to " + path);
+}
@@ -0,0 +1,51 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <QDialog>
+#include <QPushButton>
+#include <QTreeWidget>
+#include "debuggerapi.h"
+#include "ui.h"
+
+
+// Shows the per-thread call trees collected by the call tracer
+class CallTreeDialog : public QDialog
+{
+	Q_OBJECT;
+
+private:
+	DbgRef<BinaryNinjaDebuggerAPI::DebuggerController> m_controller;
+	QTreeWidget* m_tree;
+
+	QString functionName(uint64_t address);
+
+public:
+	enum ColumnHeaders
+	{
+		FunctionColumn,
+		AddressColumn,
+		CallsColumn,
+		InclusiveCallsColumn,
+	};
+
+	CallTreeDialog(QWidget* parent, DbgRef<BinaryNinjaDebuggerAPI::DebuggerController> controller);
+
+private Q_SLOTS:
+	void refresh();
+	void exportCallTrace();
+};
@@ -0,0 +1,179 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "syscalltracedialog.h"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QVBoxLayout>
+#include <cinttypes>
+
+
+using namespace BinaryNinjaDebuggerAPI;
+using namespace BinaryNinja;
+using namespace std;
+
+
+SyscallTraceDialog::SyscallTraceDialog(QWidget* parent, DbgRef<DebuggerController> controller) :
+	QDialog(parent), m_controller(controller)
+{
+	setWindowTitle("Syscall Trace");
+	setMinimumSize(UIContext::getScaledWindowSize(800, 500));
+	setSizeGripEnabled(true);
+
+	m_filter = new QLineEdit(this);
+	m_filter->setPlaceholderText("Filter by syscall name, number or thread id");
+	connect(m_filter, &QLineEdit::textChanged, [&]() { applyFilter(); });
+
+	m_table = new QTableWidget(this);
+	m_table->setColumnCount(5);
+	m_table->setHorizontalHeaderLabels({"Thread", "Address", "Syscall", "Arguments", "Result"});
+	m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+	m_table->horizontalHeader()->setStretchLastSection(true);
+	m_table->verticalHeader()->setVisible(false);
+	m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+	m_status = new QLabel(this);
+
+	QVBoxLayout* layout = new QVBoxLayout();
+	layout->addWidget(m_filter);
+	layout->addWidget(m_table, 1);
+	layout->addWidget(m_status);
+
+	QHBoxLayout* buttonLayout = new QHBoxLayout();
+	buttonLayout->setContentsMargins(0, 0, 0, 0);
+
+	m_startButton = new QPushButton(this);
+	connect(m_startButton, &QPushButton::clicked, [&]() { toggleTrace(); });
+
+	QPushButton* refreshButton = new QPushButton("Refresh");
+	connect(refreshButton, &QPushButton::clicked, [&]() { refresh(); });
+
+	QPushButton* exportButton = new QPushButton("Export...");
+	connect(exportButton, &QPushButton::clicked, [&]() { exportSyscallTrace(); });
+
+	QPushButton* closeButton = new QPushButton("Close");
+	connect(closeButton, &QPushButton::clicked, [&]() { accept(); });
+	closeButton->setDefault(true);
+
+	buttonLayout->addWidget(m_startButton);
+	buttonLayout->addWidget(refreshButton);
+	buttonLayout->addWidget(exportButton);
+	buttonLayout->addStretch(1);
+	buttonLayout->addWidget(closeButton);
+
+	layout->addSpacing(10);
+	layout->addLayout(buttonLayout);
+	setLayout(layout);
+
+	refresh();
+}
+
+
+void SyscallTraceDialog::updateStatus()
+{
+	bool active = m_controller->IsSyscallTraceActive();
+	m_startButton->setText(active ? "Stop Tracing" : "Start Tracing");
+	m_status->setText(QString("%1 syscalls, %2 dropped%3")
+						  .arg(m_table->rowCount())
+						  .arg(m_controller->GetSyscallTraceDroppedCount())
+						  .arg(active ? ", tracing" : ""));
+}
+
+
+void SyscallTraceDialog::refresh()
+{
+	std::vector<DebugSyscallRecord> records = m_controller->GetSyscallTrace();
+
+	m_table->setUpdatesEnabled(false);
+	m_table->setRowCount(0);
+	m_table->setRowCount((int)records.size());
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		const auto& record = records[i];
+		QString name = record.name.empty() ? QString::asprintf("syscall_%" PRIu64, record.number) :
+											 QString::fromStdString(record.name);
+		QString args = QString::asprintf("0x%" PRIx64 ", 0x%" PRIx64 ", 0x%" PRIx64 ", 0x%" PRIx64 ", 0x%" PRIx64
+										 ", 0x%" PRIx64,
+			record.args[0], record.args[1], record.args[2], record.args[3], record.args[4], record.args[5]);
+		QString result = record.returned ? QString::asprintf("0x%" PRIx64, record.result) : "?";
+
+		auto* threadItem = new QTableWidgetItem(QString::asprintf("0x%x", record.tid));
+		// The filter also matches the syscall number and the decimal thread id
+		threadItem->setData(Qt::UserRole, QString("%1 %2").arg(record.number).arg(record.tid));
+		m_table->setItem((int)i, ThreadColumn, threadItem);
+		m_table->setItem((int)i, AddressColumn, new QTableWidgetItem(QString::asprintf("0x%" PRIx64, record.address)));
+		m_table->setItem((int)i, SyscallColumn, new QTableWidgetItem(name));
+		m_table->setItem((int)i, ArgumentsColumn, new QTableWidgetItem(args));
+		m_table->setItem((int)i, ResultColumn, new QTableWidgetItem(result));
+	}
+	m_table->setUpdatesEnabled(true);
+
+	applyFilter();
+	updateStatus();
+}
+
+
+void SyscallTraceDialog::applyFilter()
+{
+	QString filter = m_filter->text().trimmed();
+	for (int row = 0; row < m_table->rowCount(); row++)
+	{
+		bool visible = filter.isEmpty();
+		if (!visible)
+		{
+			QString name = m_table->item(row, SyscallColumn)->text();
+			QString thread = m_table->item(row, ThreadColumn)->text();
+			QStringList numbers = m_table->item(row, ThreadColumn)->data(Qt::UserRole).toString().split(' ');
+			visible = name.contains(filter, Qt::CaseInsensitive) || (thread.compare(filter, Qt::CaseInsensitive) == 0)
+				|| numbers.contains(filter);
+		}
+		m_table->setRowHidden(row, !visible);
+	}
+}
+
+
+void SyscallTraceDialog::toggleTrace()
+{
+	if (m_controller->IsSyscallTraceActive())
+	{
+		m_controller->StopSyscallTrace();
+		refresh();
+		return;
+	}
+
+	if (!m_controller->StartSyscallTrace())
+	{
+		QMessageBox::warning(this, "Syscall Trace",
+			"Failed to start syscall tracing. The target must be a paused local Linux process, and the log has the "
+			"details.");
+		return;
+	}
+	refresh();
+}
+
+
+void SyscallTraceDialog::exportSyscallTrace()
+{
+	QString path = QFileDialog::getSaveFileName(this, "Export Syscall Trace", QString(), "Text files (*.txt)");
+	if (path.isEmpty())
+		return;
+
+	if (!m_controller->ExportSyscallTrace(path.toStdString()))
+		QMessageBox::warning(this, "Export Syscall Trace", "Failed to export the syscall trace to " + path);
+}
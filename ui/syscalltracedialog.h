@@ -0,0 +1,59 @@
+/*
+Copyright 2020-2024 Vector 35 Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <QDialog>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTableWidget>
+#include "debuggerapi.h"
+#include "ui.h"
+
+
+// Shows the syscalls recorded by the syscall trace, which can be filtered by the name, the number or the thread
+class SyscallTraceDialog : public QDialog
+{
+	Q_OBJECT;
+
+private:
+	DbgRef<BinaryNinjaDebuggerAPI::DebuggerController> m_controller;
+	QLineEdit* m_filter;
+	QTableWidget* m_table;
+	QLabel* m_status;
+	QPushButton* m_startButton;
+
+	void updateStatus();
+
+public:
+	enum ColumnHeaders
+	{
+		ThreadColumn,
+		AddressColumn,
+		SyscallColumn,
+		ArgumentsColumn,
+		ResultColumn,
+	};
+
+	SyscallTraceDialog(QWidget* parent, DbgRef<BinaryNinjaDebuggerAPI::DebuggerController> controller);
+
+private Q_SLOTS:
+	void refresh();
+	void applyFilter();
+	void toggleTrace();
+	void exportSyscallTrace();
+};
@@ -15,6 +15,8 @@ limitations under the License.
 */
 
 #include "threadframes.h"
+#include "calltreedialog.h"
+#include "syscalltracedialog.h"
 
 FrameItem::~FrameItem()
 {
@@ -412,6 +414,20 @@ void ThreadFramesWidget::makeItSoloThread()
 		m_debugger->SetActiveThread(soloTid);
 }
 
+void ThreadFramesWidget::showCallTree()
+{
+	auto dialog = new CallTreeDialog(this, m_debugger);
+	dialog->setAttribute(Qt::WA_DeleteOnClose);
+	dialog->show();
+}
+
+void ThreadFramesWidget::showSyscallTrace()
+{
+	auto dialog = new SyscallTraceDialog(this, m_debugger);
+	dialog->setAttribute(Qt::WA_DeleteOnClose);
+	dialog->show();
+}
+
 void ThreadFramesWidget::updateFonts()
 {
 	m_delegate->updateFonts();
@@ -578,6 +594,16 @@ ThreadFramesWidget::ThreadFramesWidget(QWidget* parent, ViewFrame* frame, Binary
 	m_actionHandler.bindAction(
 		actionName, UIAction([=]() { makeItSoloThread(); }, [=]() { return canSuspendOrResume(); }));
 
+	actionName = QString::fromStdString("Show Call Tree...");
+	UIAction::registerAction(actionName);
+	m_menu->addAction(actionName, "Call Trace", MENU_ORDER_NORMAL);
+	m_actionHandler.bindAction(actionName, UIAction([=]() { showCallTree(); }));
+
+	actionName = QString::fromStdString("Show Syscall Trace...");
+	UIAction::registerAction(actionName);
+	m_menu->addAction(actionName, "Call Trace", MENU_ORDER_NORMAL);
+	m_actionHandler.bindAction(actionName, UIAction([=]() { showSyscallTrace(); }));
+
 	m_menu->addAction("Copy", "Options", MENU_ORDER_NORMAL);
 	m_actionHandler.bindAction("Copy", UIAction([&]() { copy(); }, [&]() { return selectionNotEmpty(); }));
 	m_actionHandler.setActionDisplayName("Copy", [&]() {
@@ -192,6 +192,8 @@ private slots:
 	void suspendThread();
 	void resumeThread();
 	void makeItSoloThread();
+	void showCallTree();
+	void showSyscallTrace();
 	void copy();
 };
 